@@ -126,6 +126,9 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
       }
   }
 
+  noteStepStart();
+  unsigned numHandlersDispatched = 0;
+
   // Call the handler function for one readable socket:
   HandlerIterator iter(*fHandlers);
   HandlerDescriptor* handler;
@@ -151,6 +154,7 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
           // Note: we set "fLastHandledSocketNum" before calling the handler,
           // in case the handler calls "doEventLoop()" reentrantly.
       (*handler->handlerProc)(handler->clientData, resultConditionSet);
+      ++numHandlersDispatched;
       break;
     }
   }
@@ -169,6 +173,7 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
 	    // Note: we set "fLastHandledSocketNum" before calling the handler,
             // in case the handler calls "doEventLoop()" reentrantly.
 	(*handler->handlerProc)(handler->clientData, resultConditionSet);
+	++numHandlersDispatched;
 	break;
       }
     }
@@ -183,6 +188,7 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
       fTriggersAwaitingHandling &=~ fLastUsedTriggerMask;
       if (fTriggeredEventHandlers[fLastUsedTriggerNum] != NULL) {
 	(*fTriggeredEventHandlers[fLastUsedTriggerNum])(fTriggeredEventClientDatas[fLastUsedTriggerNum]);
+	++numHandlersDispatched;
       }
     } else {
       // Look for an event trigger that needs handling (making sure that we make forward progress through all possible triggers):
@@ -198,6 +204,7 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
 	  fTriggersAwaitingHandling &=~ mask;
 	  if (fTriggeredEventHandlers[i] != NULL) {
 	    (*fTriggeredEventHandlers[i])(fTriggeredEventClientDatas[i]);
+	    ++numHandlersDispatched;
 	  }
 
 	  fLastUsedTriggerMask = mask;
@@ -209,7 +216,9 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
   }
 
   // Also handle any delayed event that may have come due.
-  fDelayQueue.handleAlarm();
+  if (fDelayQueue.handleAlarm()) ++numHandlersDispatched;
+
+  noteStepEnd(numHandlersDispatched);
 }
 
 void BasicTaskScheduler
@@ -85,6 +85,30 @@ void BasicTaskScheduler0::unscheduleDelayedTask(TaskToken& prevTask) {
   delete alarmHandler;
 }
 
+Boolean BasicTaskScheduler0::getEventLoopStats(EventLoopStats& stats) const {
+  stats = fEventLoopStats;
+  stats.delayQueueDepth = fDelayQueue.numEntries();
+  return True;
+}
+
+void BasicTaskScheduler0::noteStepStart() {
+  gettimeofday(&fCurStepStartTime, NULL);
+}
+
+void BasicTaskScheduler0::noteStepEnd(unsigned numHandlersDispatched) {
+  ++fEventLoopStats.numSteps;
+  if (numHandlersDispatched == 0) return; // don't bother timing steps that did nothing
+
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+  int busyTimeUS = (timeNow.tv_sec - fCurStepStartTime.tv_sec)*1000000 + (timeNow.tv_usec - fCurStepStartTime.tv_usec);
+  if (busyTimeUS < 0) busyTimeUS = 0; // the system clock went back in time
+
+  fEventLoopStats.numHandlersDispatched += numHandlersDispatched;
+  fEventLoopStats.totBusyTimeUS += busyTimeUS;
+  if ((unsigned)busyTimeUS > fEventLoopStats.maxStepBusyTimeUS) fEventLoopStats.maxStepBusyTimeUS = busyTimeUS;
+}
+
 void BasicTaskScheduler0::doEventLoop(char volatile* watchVariable) {
   // Repeatedly loop, handling readble sockets and timed events:
   while (1) {
@@ -119,7 +119,7 @@ fLastSyncTime：最后一次同步的时间。
 
 */
 DelayQueue::DelayQueue()
-  : DelayQueueEntry(ETERNITY) {
+  : DelayQueueEntry(ETERNITY), fNumEntries(0) {
   fLastSyncTime = TimeNow();
 }
 //析构函数中有释放内存，但是还是不知道在哪里申请内存
@@ -147,6 +147,7 @@ void DelayQueue::addEntry(DelayQueueEntry* newEntry) {
   newEntry->fNext = cur;
   newEntry->fPrev = cur->fPrev;
   cur->fPrev = newEntry->fPrev->fNext = newEntry;
+  ++fNumEntries;
 }
 
 //entry：要更新的结点的指针
@@ -176,6 +177,7 @@ void DelayQueue::removeEntry(DelayQueueEntry* entry) {
   entry->fNext->fPrev = entry->fPrev;
   entry->fNext = entry->fPrev = NULL;
   // in case we should try to remove it again
+  --fNumEntries;
 }
 
 //这个才是真正的删除，通过token删除结点
@@ -192,7 +194,7 @@ DelayInterval const& DelayQueue::timeToNextAlarm() {
   return head()->fDeltaTimeRemaining;
 }
 //处理时间到的事件，也是使用回调的方式处理的。
-void DelayQueue::handleAlarm() {
+Boolean DelayQueue::handleAlarm() {
   if (head()->fDeltaTimeRemaining != DELAY_ZERO) synchronize();
 
   if (head()->fDeltaTimeRemaining == DELAY_ZERO) {
@@ -201,7 +203,10 @@ void DelayQueue::handleAlarm() {
     removeEntry(toRemove); // do this first, in case handler accesses queue
 
     toRemove->handleTimeout();
+    return True;
   }
+
+  return False;
 }
 //到遍历的方式，然后去匹配，链表只能是从头到尾遍历
 DelayQueueEntry* DelayQueue::findEntryByToken(intptr_t tokenToFind) {
@@ -92,9 +92,15 @@ public:
   virtual void deleteEventTrigger(EventTriggerId eventTriggerId);
   virtual void triggerEvent(EventTriggerId eventTriggerId, void* clientData = NULL);
 
+  virtual Boolean getEventLoopStats(EventLoopStats& stats) const;
+
 protected:
   BasicTaskScheduler0();
 
+  // Used by "SingleStep()" implementations to update our event loop statistics:
+  void noteStepStart();
+  void noteStepEnd(unsigned numHandlersDispatched);
+
 protected:
   // To implement delayed operations:
   DelayQueue fDelayQueue;
@@ -109,6 +115,10 @@ protected:
   TaskFunc* fTriggeredEventHandlers[MAX_NUM_EVENT_TRIGGERS];
   void* fTriggeredEventClientDatas[MAX_NUM_EVENT_TRIGGERS];
   unsigned fLastUsedTriggerNum; // in the range [0,MAX_NUM_EVENT_TRIGGERS)
+
+  // Event loop statistics:
+  EventLoopStats fEventLoopStats;
+  struct timeval fCurStepStartTime;
 };
 
 #endif
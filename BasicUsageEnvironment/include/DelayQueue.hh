@@ -23,6 +23,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _NET_COMMON_H
 #include "NetCommon.h"
 #endif
+#ifndef _BOOLEAN_HH
+#include "Boolean.hh"
+#endif
 
 #ifdef TIME_BASE
 typedef TIME_BASE time_base_seconds;
@@ -178,7 +181,9 @@ public:
   DelayQueueEntry* removeEntry(intptr_t tokenToFind); // but doesn't delete it
 
   DelayInterval const& timeToNextAlarm();
-  void handleAlarm();
+  Boolean handleAlarm(); // returns True iff a delayed task was handled
+
+  unsigned numEntries() const { return fNumEntries; }
 
 private:
 /*
@@ -192,6 +197,7 @@ private:
   void synchronize(); // bring the 'time remaining' fields up-to-date
 
   _EventTime fLastSyncTime;//最后一次同步的时间
+  unsigned fNumEntries;
 };
 
 #endif
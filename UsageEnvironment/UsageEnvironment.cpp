@@ -43,6 +43,10 @@ void UsageEnvironment::internalError() {
 }
 
 
+EventLoopStats::EventLoopStats()
+  : numSteps(0), numHandlersDispatched(0), totBusyTimeUS(0), maxStepBusyTimeUS(0), delayQueueDepth(0) {
+}
+
 TaskScheduler::TaskScheduler() {
 }
 
@@ -61,3 +65,7 @@ void TaskScheduler::rescheduleDelayedTask(TaskToken& task,
 void TaskScheduler::internalError() {
   abort();
 }
+
+Boolean TaskScheduler::getEventLoopStats(EventLoopStats& /*stats*/) const {
+  return False; // by default, we don't keep statistics
+}
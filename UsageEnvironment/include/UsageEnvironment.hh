@@ -103,6 +103,18 @@ typedef void TaskFunc(void* clientData);
 typedef void* TaskToken;
 typedef u_int32_t EventTriggerId;
 
+// Statistics about the operation of a "TaskScheduler"'s event loop (e.g., for monitoring):
+class EventLoopStats {
+public:
+  EventLoopStats();
+
+  u_int64_t numSteps; // number of times that we've gone through the event loop
+  u_int64_t numHandlersDispatched; // socket handlers, triggered event handlers, and delayed tasks
+  u_int64_t totBusyTimeUS; // total time spent in handlers (i.e., not waiting in "select()"), in microseconds
+  unsigned maxStepBusyTimeUS; // the longest time spent in handlers during a single step
+  unsigned delayQueueDepth; // the current number of pending delayed tasks
+};
+
 class TaskScheduler {
 public:
   virtual ~TaskScheduler();
@@ -165,6 +177,9 @@ public:
 
   virtual void internalError(); // used to 'handle' a 'should not occur'-type error condition within the library.
 
+  virtual Boolean getEventLoopStats(EventLoopStats& stats) const;
+      // Fills in "stats", if our implementation keeps such statistics.  (Returns False if it doesn't.)
+
 protected:
   TaskScheduler(); // abstract base class
 };
@@ -0,0 +1,258 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A per-environment interface for reading from files without blocking the event loop
+// Implementation
+
+#include "AsyncFileReader.hh"
+#include "InputFile.hh"
+#include "GroupsockHelper.hh" // for "gettimeofday()"
+
+#define POLL_INTERVAL 2000 // in microseconds: how often we retry reads whose data wasn't yet cached
+
+////////// DefaultAsyncFileReader //////////
+
+class DefaultAsyncFileReader: public AsyncFileReader {
+public:
+  DefaultAsyncFileReader(UsageEnvironment& env);
+  virtual ~DefaultAsyncFileReader();
+
+private: // redefined virtual functions
+  virtual void read(int fileDescriptor, u_int64_t offset, u_int8_t* to, unsigned size,
+		    completionFunc* completionFunc, void* clientData);
+  virtual void cancel(void* clientData);
+  virtual void prefetch(int fileDescriptor, u_int64_t offset, u_int64_t size);
+  virtual void noLongerCurrent();
+
+private:
+  class Request {
+  public:
+    int fileDescriptor;
+    u_int64_t offset;
+    u_int8_t* to;
+    unsigned size;
+    completionFunc* func;
+    void* clientData;
+    struct timeval firstTryTime;
+    Boolean isDone;
+    int result; // used iff "isDone"
+    Boolean isBeingCompleted; // by the current poll
+    Request* next;
+  };
+
+  static Boolean tryToRead(Request& request, Boolean mayBlock);
+  Request* removeRequestBeingCompleted();
+  void schedulePoll(unsigned delay);
+  static void pollTask(void* clientData);
+  void poll();
+  void reclaimIfIdle();
+
+private:
+  Request* fRequests; // in the order in which they were made
+  TaskToken fPollTask;
+  Boolean fPollIsImmediate, fIsPolling;
+};
+
+DefaultAsyncFileReader::DefaultAsyncFileReader(UsageEnvironment& env)
+  : AsyncFileReader(env), fRequests(NULL), fPollTask(NULL),
+    fPollIsImmediate(False), fIsPolling(False) {
+}
+
+DefaultAsyncFileReader::~DefaultAsyncFileReader() {
+  envir().taskScheduler().unscheduleDelayedTask(fPollTask);
+  while (fRequests != NULL) {
+    Request* request = fRequests;
+    fRequests = request->next;
+    delete request;
+  }
+}
+
+void DefaultAsyncFileReader::read(int fileDescriptor, u_int64_t offset, u_int8_t* to, unsigned size,
+				  completionFunc* completionFunc, void* clientData) {
+  Request* request = new Request;
+  request->fileDescriptor = fileDescriptor;
+  request->offset = offset;
+  request->to = to;
+  request->size = size;
+  request->func = completionFunc;
+  request->clientData = clientData;
+  gettimeofday(&request->firstTryTime, NULL);
+  request->isDone = False;
+  request->result = 0;
+  request->isBeingCompleted = False;
+  request->next = NULL;
+
+  Request** tail = &fRequests;
+  while (*tail != NULL) tail = &(*tail)->next;
+  *tail = request;
+
+  if (tryToRead(*request, False)) {
+    // The data was already cached.  We still complete the read from the event loop, to avoid recursion:
+    schedulePoll(0);
+  } else {
+    // Ask the OS to start fetching the data, and check again later:
+    prefetch(fileDescriptor, offset, size);
+    schedulePoll(POLL_INTERVAL);
+  }
+}
+
+void DefaultAsyncFileReader::cancel(void* clientData) {
+  Request** ptr = &fRequests;
+  while (*ptr != NULL) {
+    Request* request = *ptr;
+    if (request->clientData == clientData) {
+      *ptr = request->next;
+      delete request;
+    } else {
+      ptr = &request->next;
+    }
+  }
+
+  reclaimIfIdle();
+}
+
+void DefaultAsyncFileReader::prefetch(int fileDescriptor, u_int64_t offset, u_int64_t size) {
+  AsyncFileReader::prefetch(fileDescriptor, offset, size);
+  reclaimIfIdle(); // in case we were created just to do this
+}
+
+void DefaultAsyncFileReader::noLongerCurrent() {
+  // Another reader has been plugged in.  Finish any reads that we've started, then delete ourself:
+  reclaimIfIdle();
+}
+
+Boolean DefaultAsyncFileReader::tryToRead(Request& request, Boolean mayBlock) {
+  int result = ReadInputFileAt(request.fileDescriptor, request.offset, request.to, request.size, !mayBlock);
+  if (result == READ_WOULD_BLOCK) return False;
+
+  request.isDone = True;
+  request.result = result < 0 ? -1 : result;
+  return True;
+}
+
+DefaultAsyncFileReader::Request* DefaultAsyncFileReader::removeRequestBeingCompleted() {
+  for (Request** ptr = &fRequests; *ptr != NULL; ptr = &(*ptr)->next) {
+    Request* request = *ptr;
+    if (request->isBeingCompleted) {
+      *ptr = request->next;
+      return request;
+    }
+  }
+  return NULL;
+}
+
+void DefaultAsyncFileReader::schedulePoll(unsigned delay) {
+  if (fPollTask != NULL) {
+    if (fPollIsImmediate || delay > 0) return; // the already-scheduled poll will do
+    envir().taskScheduler().unscheduleDelayedTask(fPollTask);
+  }
+
+  fPollTask = envir().taskScheduler().scheduleDelayedTask(delay, pollTask, this);
+  fPollIsImmediate = delay == 0;
+}
+
+void DefaultAsyncFileReader::pollTask(void* clientData) {
+  ((DefaultAsyncFileReader*)clientData)->poll();
+}
+
+void DefaultAsyncFileReader::poll() {
+  fPollTask = NULL;
+  fIsPolling = True;
+
+  // Retry each read whose data wasn't cached before.  (If we've already waited too long for it, then
+  // we just read it, even if this blocks.)
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+  Request* request;
+  for (request = fRequests; request != NULL; request = request->next) {
+    if (!request->isDone) {
+      int64_t uSecondsWaited
+	= (int64_t)(timeNow.tv_sec - request->firstTryTime.tv_sec)*1000000
+	+ (timeNow.tv_usec - request->firstTryTime.tv_usec);
+      tryToRead(*request, uSecondsWaited >= (int64_t)maxWaitTime);
+    }
+    request->isBeingCompleted = request->isDone;
+  }
+
+  // Complete the reads that have now been done.  A completion function may itself start reads (which -
+  // even if their data is already cached - we leave for our next poll, so that other events aren't starved),
+  // or cancel reads (including those that we're about to complete).  So we remove each request from our
+  // list just before calling its completion function:
+  while ((request = removeRequestBeingCompleted()) != NULL) {
+    completionFunc* func = request->func;
+    void* clientData = request->clientData;
+    int result = request->result;
+    delete request;
+
+    (*func)(clientData, result);
+  }
+
+  fIsPolling = False;
+  if (fRequests != NULL) {
+    schedulePoll(POLL_INTERVAL); // for the reads that are still waiting
+  } else {
+    reclaimIfIdle();
+  }
+}
+
+void DefaultAsyncFileReader::reclaimIfIdle() {
+  if (fRequests != NULL || fIsPolling) return;
+
+  _Tables* ourTables = _Tables::getOurTables(envir(), False);
+  if (ourTables != NULL && ourTables->asyncFileReader == this) {
+    ourTables->asyncFileReader = NULL;
+    ourTables->reclaimIfPossible();
+  }
+  delete this;
+}
+
+
+////////// AsyncFileReader //////////
+
+unsigned AsyncFileReader::maxWaitTime = 2000000;
+
+AsyncFileReader& AsyncFileReader::forEnvironment(UsageEnvironment& env) {
+  _Tables* ourTables = _Tables::getOurTables(env);
+  if (ourTables->asyncFileReader == NULL) {
+    ourTables->asyncFileReader = new DefaultAsyncFileReader(env);
+  }
+  return *(AsyncFileReader*)(ourTables->asyncFileReader);
+}
+
+void AsyncFileReader::setForEnvironment(UsageEnvironment& env, AsyncFileReader* reader) {
+  _Tables* ourTables = _Tables::getOurTables(env);
+  AsyncFileReader* oldReader = (AsyncFileReader*)(ourTables->asyncFileReader);
+  if (oldReader == reader) return;
+
+  ourTables->asyncFileReader = reader;
+  if (oldReader != NULL) oldReader->noLongerCurrent();
+  if (reader == NULL) ourTables->reclaimIfPossible();
+}
+
+void AsyncFileReader::noLongerCurrent() {
+}
+
+void AsyncFileReader::prefetch(int fileDescriptor, u_int64_t offset, u_int64_t size) {
+  AdviseReadahead(fileDescriptor, offset, size);
+}
+
+AsyncFileReader::AsyncFileReader(UsageEnvironment& env)
+  : fEnv(env) {
+}
+
+AsyncFileReader::~AsyncFileReader() {
+}
@@ -19,6 +19,8 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "BitVector.hh"
+#include <NetCommon.h> // for "u_int64_t"
+#include <string.h>
 
 BitVector::BitVector(unsigned char* baseBytePtr,
 		     unsigned baseBitOffset,
@@ -40,10 +42,40 @@ static unsigned char const singleBitMask[8]
 
 #define MAX_LENGTH 32
 
+// Reads or writes (1 <= "numBits" <= MAX_LENGTH) bits at an arbitrary bit offset, a byte (rather than a bit)
+// at a time, using a 64-bit accumulator.  Only the bytes that contain the bits are accessed:
+static unsigned readBitsAt(unsigned char const* basePtr, unsigned bitOffset, unsigned numBits) {
+  unsigned char const* bytePtr = &basePtr[bitOffset/8];
+  unsigned bitRem = bitOffset%8;
+  unsigned numBytes = (bitRem + numBits + 7)/8; // <= 5
+
+  u_int64_t acc = 0;
+  for (unsigned i = 0; i < numBytes; ++i) acc = (acc<<8) | bytePtr[i];
+  acc >>= numBytes*8 - bitRem - numBits;
+
+  return (unsigned)(acc & ((((u_int64_t)1)<<numBits) - 1));
+}
+
+static void writeBitsAt(unsigned char* basePtr, unsigned bitOffset, unsigned value, unsigned numBits) {
+  unsigned char* bytePtr = &basePtr[bitOffset/8];
+  unsigned bitRem = bitOffset%8;
+  unsigned numBytes = (bitRem + numBits + 7)/8; // <= 5
+  unsigned shift = numBytes*8 - bitRem - numBits;
+
+  u_int64_t acc = 0;
+  unsigned i;
+  for (i = 0; i < numBytes; ++i) acc = (acc<<8) | bytePtr[i];
+  u_int64_t mask = ((((u_int64_t)1)<<numBits) - 1) << shift;
+  acc = (acc&~mask) | ((((u_int64_t)value)<<shift)&mask);
+  for (i = numBytes; i > 0; --i) {
+    bytePtr[i-1] = (unsigned char)acc;
+    acc >>= 8;
+  }
+}
+
 void BitVector::putBits(unsigned from, unsigned numBits) {
   if (numBits == 0) return; 
 
-  unsigned char tmpBuf[4];
   unsigned overflowingBits = 0;
 
   if (numBits > MAX_LENGTH) {
@@ -53,15 +85,11 @@ void BitVector::putBits(unsigned from, unsigned numBits) {
   if (numBits > fTotNumBits - fCurBitIndex) {
     overflowingBits = numBits - (fTotNumBits - fCurBitIndex);
   }
+  if (overflowingBits == numBits) return; // no room left
 
-  tmpBuf[0] = (unsigned char)(from>>24);
-  tmpBuf[1] = (unsigned char)(from>>16);
-  tmpBuf[2] = (unsigned char)(from>>8);
-  tmpBuf[3] = (unsigned char)from;
-
-  shiftBits(fBaseBytePtr, fBaseBitOffset + fCurBitIndex, /* to */
-	    tmpBuf, MAX_LENGTH - numBits, /* from */
-	    numBits - overflowingBits /* num bits */);
+  // Write the high-order "numBits - overflowingBits" bits of the low-order "numBits" bits of "from":
+  if (numBits < MAX_LENGTH) from &= (1<<numBits) - 1;
+  writeBitsAt(fBaseBytePtr, fBaseBitOffset + fCurBitIndex, from>>overflowingBits, numBits - overflowingBits);
   fCurBitIndex += numBits - overflowingBits;
 }
 
@@ -81,9 +109,22 @@ void BitVector::put1Bit(unsigned bit) {
 }
 
 unsigned BitVector::getBits(unsigned numBits) {
+  if (numBits > MAX_LENGTH) {
+    numBits = MAX_LENGTH;
+  }
+  unsigned result = peekBits(numBits);
+
+  if (numBits > fTotNumBits - fCurBitIndex) { /* overflow */
+    fCurBitIndex = fTotNumBits;
+  } else {
+    fCurBitIndex += numBits;
+  }
+  return result;
+}
+
+unsigned BitVector::peekBits(unsigned numBits) const {
   if (numBits == 0) return 0;
 
-  unsigned char tmpBuf[4];
   unsigned overflowingBits = 0;
 
   if (numBits > MAX_LENGTH) {
@@ -92,18 +133,12 @@ unsigned BitVector::getBits(unsigned numBits) {
 
   if (numBits > fTotNumBits - fCurBitIndex) {
     overflowingBits = numBits - (fTotNumBits - fCurBitIndex);
+    if (overflowingBits == numBits) return 0;
   }
 
-  shiftBits(tmpBuf, 0, /* to */
-	    fBaseBytePtr, fBaseBitOffset + fCurBitIndex, /* from */
-	    numBits - overflowingBits /* num bits */);
-  fCurBitIndex += numBits - overflowingBits;
-
   unsigned result
-    = (tmpBuf[0]<<24) | (tmpBuf[1]<<16) | (tmpBuf[2]<<8) | tmpBuf[3];
-  result >>= (MAX_LENGTH - numBits); // move into low-order part of word
-  result &= (0xFFFFFFFF << overflowingBits); // so any overflow bits are 0
-  return result;
+    = readBitsAt(fBaseBytePtr, fBaseBitOffset + fCurBitIndex, numBits - overflowingBits);
+  return result << overflowingBits; // so any overflow bits are 0
 }
 
 unsigned BitVector::get1Bit() {
@@ -155,29 +190,28 @@ void shiftBits(unsigned char* toBasePtr, unsigned toBitOffset,
   if (numBits == 0) return;
 
   /* Note that from and to may overlap, if from>to */
-  unsigned char const* fromBytePtr = fromBasePtr + fromBitOffset/8;
-  unsigned fromBitRem = fromBitOffset%8;
-  unsigned char* toBytePtr = toBasePtr + toBitOffset/8;
-  unsigned toBitRem = toBitOffset%8;
-
-  while (numBits-- > 0) {
-    unsigned char fromBitMask = singleBitMask[fromBitRem];
-    unsigned char fromBit = (*fromBytePtr)&fromBitMask;
-    unsigned char toBitMask = singleBitMask[toBitRem];
-
-    if (fromBit != 0) {
-      *toBytePtr |= toBitMask;
-    } else {
-      *toBytePtr &=~ toBitMask;
+  if (fromBitOffset%8 == toBitOffset%8) {
+    // Common case: The source and destination are equally aligned, so we can copy whole bytes at once.
+    // Begin with any bits before the first byte boundary:
+    unsigned numLeadingBits = (8 - toBitOffset%8)%8;
+    if (numLeadingBits > numBits) numLeadingBits = numBits;
+    if (numLeadingBits > 0) {
+      writeBitsAt(toBasePtr, toBitOffset, readBitsAt(fromBasePtr, fromBitOffset, numLeadingBits), numLeadingBits);
+      toBitOffset += numLeadingBits; fromBitOffset += numLeadingBits; numBits -= numLeadingBits;
     }
 
-    if (++fromBitRem == 8) {
-      ++fromBytePtr;
-      fromBitRem = 0;
-    }
-    if (++toBitRem == 8) {
-      ++toBytePtr;
-      toBitRem = 0;
+    unsigned numWholeBytes = numBits/8;
+    if (numWholeBytes > 0) {
+      memmove(&toBasePtr[toBitOffset/8], &fromBasePtr[fromBitOffset/8], numWholeBytes);
+      toBitOffset += 8*numWholeBytes; fromBitOffset += 8*numWholeBytes; numBits -= 8*numWholeBytes;
     }
   }
+
+  // Copy the remaining bits up to MAX_LENGTH at a time.  (Copying forwards like this is OK even if the
+  // source and destination overlap, because from>to.)
+  while (numBits > 0) {
+    unsigned n = numBits < MAX_LENGTH ? numBits : MAX_LENGTH;
+    writeBitsAt(toBasePtr, toBitOffset, readBitsAt(fromBasePtr, fromBitOffset, n), n);
+    toBitOffset += n; fromBitOffset += n; numBits -= n;
+  }
 }
@@ -22,6 +22,29 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "InputFile.hh"
 #include "GroupsockHelper.hh"
 
+#if !defined(MAPPED_WINDOW_SIZE)
+#define MAPPED_WINDOW_SIZE (2*1024*1024)
+#endif
+#define MAPPED_WINDOW_ALIGNMENT (MAPPED_WINDOW_SIZE/2)
+  // Windows start at a multiple of this (which must be a multiple of the page size), so that
+  // there's always at least this much data ahead of the read position before we need to remap.
+
+#if !defined(READAHEAD_DURATION)
+#define READAHEAD_DURATION 4 // (seconds of data, at the stream's bitrate)
+#endif
+#define MIN_READAHEAD_SIZE (256*1024)
+#define MAX_READAHEAD_SIZE (16*1024*1024)
+#define DEFAULT_READAHEAD_SIZE (2*1024*1024) // if we don't know the bitrate
+
+static u_int64_t readaheadSizeForBitrate(unsigned estBitrate/*kbps*/) {
+  if (estBitrate == 0) return DEFAULT_READAHEAD_SIZE;
+
+  u_int64_t readaheadSize = (u_int64_t)estBitrate*125*READAHEAD_DURATION; // kbps -> bytes
+  if (readaheadSize < MIN_READAHEAD_SIZE) return MIN_READAHEAD_SIZE;
+  if (readaheadSize > MAX_READAHEAD_SIZE) return MAX_READAHEAD_SIZE;
+  return readaheadSize;
+}
+
 ////////// ByteStreamFileSource //////////
 
 ByteStreamFileSource*
@@ -34,6 +57,7 @@ ByteStreamFileSource::createNew(UsageEnvironment& env, char const* fileName,
   ByteStreamFileSource* newSource
     = new ByteStreamFileSource(env, fid, preferredFrameSize, playTimePerFrame);
   newSource->fFileSize = GetFileSize(fileName, fid);
+  newSource->readAsynchronouslyIfSeekable();
 
   return newSource;
 }
@@ -46,26 +70,98 @@ ByteStreamFileSource::createNew(UsageEnvironment& env, FILE* fid,
 
   ByteStreamFileSource* newSource = new ByteStreamFileSource(env, fid, preferredFrameSize, playTimePerFrame);
   newSource->fFileSize = GetFileSize(NULL, fid);
+  newSource->readAsynchronouslyIfSeekable();
 
   return newSource;
 }
 
+u_int64_t ByteStreamFileSource::mappedMemoryBudget = 256*1024*1024;
+u_int64_t ByteStreamFileSource::fMappedMemoryInUse = 0;
+
 void ByteStreamFileSource::seekToByteAbsolute(u_int64_t byteNumber, u_int64_t numBytesToStream) {
-  SeekFile64(fFid, (int64_t)byteNumber, SEEK_SET);
+  if (fUseAsynchronousReads || fUseMemoryMapping) {
+    fReadPosition = byteNumber;
+  } else {
+    SeekFile64(fFid, (int64_t)byteNumber, SEEK_SET);
+  }
 
   fNumBytesToStream = numBytesToStream;
   fLimitNumBytesToStream = fNumBytesToStream > 0;
 }
 
 void ByteStreamFileSource::seekToByteRelative(int64_t offset, u_int64_t numBytesToStream) {
-  SeekFile64(fFid, offset, SEEK_CUR);
+  if (fUseAsynchronousReads || fUseMemoryMapping) {
+    fReadPosition = offset < 0 && (u_int64_t)(-offset) > fReadPosition ? 0 : fReadPosition + offset;
+  } else {
+    SeekFile64(fFid, offset, SEEK_CUR);
+  }
 
   fNumBytesToStream = numBytesToStream;
   fLimitNumBytesToStream = fNumBytesToStream > 0;
 }
 
 void ByteStreamFileSource::seekToEnd() {
-  SeekFile64(fFid, 0, SEEK_END);
+  if (fUseAsynchronousReads || fUseMemoryMapping) {
+    fReadPosition = fFileSize;
+  } else {
+    SeekFile64(fFid, 0, SEEK_END);
+  }
+}
+
+Boolean ByteStreamFileSource::getFileDescriptorAndPosition(int& fileDescriptor, u_int64_t& position) {
+  if (fFid == NULL || !fFidIsSeekable) return False;
+
+  if (fUseAsynchronousReads || fUseMemoryMapping) {
+    fileDescriptor = fileno(fFid);
+    position = fReadPosition;
+    return True;
+  }
+
+  int64_t curPosition = TellFile64(fFid); // takes account of any data that's been buffered by "fread()"
+  if (curPosition < 0) return False;
+
+  fileDescriptor = fileno(fFid);
+  position = (u_int64_t)curPosition;
+  return True;
+}
+
+Boolean ByteStreamFileSource::useAsynchronousReads(unsigned estBitrate) {
+  if (!fUseAsynchronousReads) {
+    if (fFid == NULL || !fFidIsSeekable || fFileSize == 0 || fileno(fFid) < 0) return False;
+
+    if (fUseMemoryMapping) {
+      unmapWindow();
+      fUseMemoryMapping = False;
+    } else {
+      int64_t curPosition = TellFile64(fFid);
+      if (curPosition < 0) return False;
+      fReadPosition = (u_int64_t)curPosition;
+    }
+    fUseAsynchronousReads = True;
+  }
+
+  setPrefetchSize(readaheadSizeForBitrate(estBitrate));
+  return True;
+}
+
+Boolean ByteStreamFileSource::useMemoryMapping(unsigned estBitrate) {
+  if (!fUseMemoryMapping) {
+    if (fFid == NULL || !fFidIsSeekable || fFileSize == 0) return False;
+
+    if (!fUseAsynchronousReads) {
+      int64_t curPosition = TellFile64(fFid);
+      if (curPosition < 0) return False;
+      fReadPosition = (u_int64_t)curPosition;
+    }
+
+    // Check that the file can be mapped at all:
+    if (!mapWindow()) return False;
+    fUseMemoryMapping = True;
+    fUseAsynchronousReads = False;
+  }
+
+  setPrefetchSize(readaheadSizeForBitrate(estBitrate));
+  return True;
 }
 
 ByteStreamFileSource::ByteStreamFileSource(UsageEnvironment& env, FILE* fid,
@@ -73,7 +169,9 @@ ByteStreamFileSource::ByteStreamFileSource(UsageEnvironment& env, FILE* fid,
 					   unsigned playTimePerFrame)
   : FramedFileSource(env, fid), fFileSize(0), fPreferredFrameSize(preferredFrameSize),
     fPlayTimePerFrame(playTimePerFrame), fLastPlayTime(0),
-    fHaveStartedReading(False), fLimitNumBytesToStream(False), fNumBytesToStream(0) {
+    fHaveStartedReading(False), fLimitNumBytesToStream(False), fNumBytesToStream(0),
+    fUseAsynchronousReads(False), fUseMemoryMapping(False), fReadPosition(0),
+    fMapping(NULL), fMappingOffset(0), fMappingSize(0) {
 #ifndef READ_FROM_FILES_SYNCHRONOUSLY
   makeSocketNonBlocking(fileno(fFid));
 #endif
@@ -82,7 +180,17 @@ ByteStreamFileSource::ByteStreamFileSource(UsageEnvironment& env, FILE* fid,
   fFidIsSeekable = FileIsSeekable(fFid);
 }
 
+void ByteStreamFileSource::readAsynchronouslyIfSeekable() {
+#ifndef READ_FROM_FILES_SYNCHRONOUSLY
+  // Seekable files are always 'readable' (so waiting for them in the event loop wouldn't help).
+  // Instead, read them without blocking:
+  useAsynchronousReads();
+#endif
+}
+
 ByteStreamFileSource::~ByteStreamFileSource() {
+  cancelFileRead();
+  unmapWindow();
   if (fFid == NULL) return;
 
 #ifndef READ_FROM_FILES_SYNCHRONOUSLY
@@ -92,7 +200,20 @@ ByteStreamFileSource::~ByteStreamFileSource() {
   CloseInputFile(fFid);
 }
 
+Boolean ByteStreamFileSource::isByteStreamFileSource() const {
+  return True;
+}
+
 void ByteStreamFileSource::doGetNextFrame() {
+  if (fUseAsynchronousReads) {
+    doReadAsynchronously();
+    return;
+  }
+  if (fUseMemoryMapping) {
+    doReadFromMappedFile();
+    return;
+  }
+
   if (feof(fFid) || ferror(fFid) || (fLimitNumBytesToStream && fNumBytesToStream == 0)) {
     handleClosure();
     return;
@@ -112,6 +233,7 @@ void ByteStreamFileSource::doGetNextFrame() {
 
 void ByteStreamFileSource::doStopGettingFrames() {
   envir().taskScheduler().unscheduleDelayedTask(nextTask());
+  cancelFileRead();
 #ifndef READ_FROM_FILES_SYNCHRONOUSLY
   envir().taskScheduler().turnOffBackgroundReadHandling(fileno(fFid));
   fHaveStartedReading = False;
@@ -150,6 +272,10 @@ void ByteStreamFileSource::doReadFromFile() {
   }
   fNumBytesToStream -= fFrameSize;
 
+  setPresentationTimeAndDeliver();
+}
+
+void ByteStreamFileSource::setPresentationTimeAndDeliver() {
   // Set the 'presentation time':
   if (fPlayTimePerFrame > 0 && fPreferredFrameSize > 0) {
     if (fPresentationTime.tv_sec == 0 && fPresentationTime.tv_usec == 0) {
@@ -172,13 +298,131 @@ void ByteStreamFileSource::doReadFromFile() {
   }
 
   // Inform the reader that he has data:
-#ifdef READ_FROM_FILES_SYNCHRONOUSLY
+  if (fUseAsynchronousReads) {
+    // The read completed from the event loop, so we can call the 'after getting' function directly:
+    FramedSource::afterGetting(this);
+    return;
+  }
+#ifndef READ_FROM_FILES_SYNCHRONOUSLY
+  if (!fUseMemoryMapping) {
+    // Because the file read was done from the event loop, we can call the
+    // 'after getting' function directly, without risk of infinite recursion:
+    FramedSource::afterGetting(this);
+    return;
+  }
+#endif
   // To avoid possible infinite recursion, we need to return to the event loop to do this:
   nextTask() = envir().taskScheduler().scheduleDelayedTask(0,
 				(TaskFunc*)FramedSource::afterGetting, this);
-#else
-  // Because the file read was done from the event loop, we can call the
-  // 'after getting' function directly, without risk of infinite recursion:
-  FramedSource::afterGetting(this);
-#endif
+}
+
+Boolean ByteStreamFileSource::limitReadToFileSize() {
+  if (fReadPosition >= fFileSize) {
+    // Check whether the file has grown (e.g., because it's still being recorded):
+    u_int64_t newFileSize = GetFileSize(NULL, fFid);
+    if (newFileSize > fFileSize) fFileSize = newFileSize;
+  }
+  if (fReadPosition >= fFileSize || (fLimitNumBytesToStream && fNumBytesToStream == 0)) {
+    handleClosure();
+    return False;
+  }
+
+  if (fLimitNumBytesToStream && fNumBytesToStream < (u_int64_t)fMaxSize) {
+    fMaxSize = (unsigned)fNumBytesToStream;
+  }
+  if (fPreferredFrameSize > 0 && fPreferredFrameSize < fMaxSize) {
+    fMaxSize = fPreferredFrameSize;
+  }
+  if (fFileSize - fReadPosition < (u_int64_t)fMaxSize) {
+    fMaxSize = (unsigned)(fFileSize - fReadPosition);
+  }
+
+  return True;
+}
+
+void ByteStreamFileSource::doReadAsynchronously() {
+  if (!limitReadToFileSize()) return;
+
+  prefetchFrom(fReadPosition);
+  readFileAsynchronously(fReadPosition, fTo, fMaxSize);
+}
+
+void ByteStreamFileSource::afterReadingFile(int result) {
+  if (result <= 0) {
+    handleClosure();
+    return;
+  }
+
+  fFrameSize = (unsigned)result;
+  fReadPosition += fFrameSize;
+  fNumBytesToStream -= fFrameSize;
+
+  setPresentationTimeAndDeliver();
+}
+
+void ByteStreamFileSource::doReadFromMappedFile() {
+  if (!limitReadToFileSize()) return;
+
+  // Ask the OS to read ahead of us:
+  prefetchFrom(fReadPosition);
+
+  fFrameSize = 0;
+  while (fFrameSize < fMaxSize) {
+    if (fMapping == NULL
+	|| fReadPosition < fMappingOffset || fReadPosition >= fMappingOffset + fMappingSize) {
+      if (!mapWindow()) {
+	// We couldn't map this window (e.g., because we're over our memory budget), so read the data instead:
+	SeekFile64(fFid, (int64_t)fReadPosition, SEEK_SET);
+	unsigned numBytesRead = fread(&fTo[fFrameSize], 1, fMaxSize - fFrameSize, fFid);
+	fFrameSize += numBytesRead;
+	fReadPosition += numBytesRead;
+	break;
+      }
+    }
+
+    u_int64_t numBytesInWindow = fMappingOffset + fMappingSize - fReadPosition;
+    unsigned numBytesToCopy = fMaxSize - fFrameSize;
+    if (numBytesInWindow < (u_int64_t)numBytesToCopy) numBytesToCopy = (unsigned)numBytesInWindow;
+
+    memmove(&fTo[fFrameSize], &fMapping[fReadPosition - fMappingOffset], numBytesToCopy);
+    fFrameSize += numBytesToCopy;
+    fReadPosition += numBytesToCopy;
+  }
+  if (fFrameSize == 0) {
+    handleClosure();
+    return;
+  }
+  fNumBytesToStream -= fFrameSize;
+
+  setPresentationTimeAndDeliver();
+}
+
+Boolean ByteStreamFileSource::mapWindow() {
+  unmapWindow();
+
+  u_int64_t offset = fReadPosition - fReadPosition%MAPPED_WINDOW_ALIGNMENT;
+  if (offset >= fFileSize) return False;
+  u_int64_t size = fFileSize - offset;
+  if (size > MAPPED_WINDOW_SIZE) size = MAPPED_WINDOW_SIZE;
+
+  if (fMappedMemoryInUse + size > mappedMemoryBudget) return False;
+
+  fMapping = MapInputFileRegion(fileno(fFid), offset, size);
+  if (fMapping == NULL) return False;
+
+  fMappingOffset = offset;
+  fMappingSize = size;
+  fMappedMemoryInUse += size;
+  AdviseSequentialAccess(fMapping, fMappingSize);
+
+  return True;
+}
+
+void ByteStreamFileSource::unmapWindow() {
+  if (fMapping == NULL) return;
+
+  UnmapInputFile(fMapping, fMappingSize);
+  fMappedMemoryInUse -= fMappingSize;
+  fMapping = NULL;
+  fMappingOffset = fMappingSize = 0;
 }
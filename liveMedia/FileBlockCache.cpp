@@ -0,0 +1,473 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A per-environment cache of file data, shared by all "FramedFileSource"s that read the same file
+// Implementation
+
+#include "FileBlockCache.hh"
+#include "InputFile.hh"
+#include <string.h>
+#if !defined(__WIN32__) && !defined(_WIN32) && !defined(_WIN32_WCE)
+#include <unistd.h>
+#define CAN_IDENTIFY_FILES 1 // using their device and inode numbers, size, and modification and change times
+#endif
+
+#define FILE_KEY_SIZE 14 // words: the file's device and inode numbers, size, and modification and change times
+    // (in seconds and nanoseconds); each 64 bits
+#define FILE_INODE_KEY_SIZE 4 // words: the part of a file's key that identifies it - rather than its version
+#define BLOCK_KEY_SIZE (FILE_KEY_SIZE+2) // words: the file's key, plus the (64-bit) block number
+
+#ifdef CAN_IDENTIFY_FILES
+static void setKeyWord(unsigned* key, unsigned wordNum, u_int64_t value) {
+  key[2*wordNum] = (unsigned)value; key[2*wordNum+1] = (unsigned)(value>>32);
+}
+
+static void fileKeyFromStat(struct stat const& sb, unsigned* key) {
+  setKeyWord(key, 0, (u_int64_t)sb.st_dev);
+  setKeyWord(key, 1, (u_int64_t)sb.st_ino);
+  setKeyWord(key, 2, (u_int64_t)sb.st_size);
+  setKeyWord(key, 3, (u_int64_t)sb.st_mtime);
+  setKeyWord(key, 5, (u_int64_t)sb.st_ctime);
+#if defined(__linux__)
+  setKeyWord(key, 4, (u_int64_t)sb.st_mtim.tv_nsec);
+  setKeyWord(key, 6, (u_int64_t)sb.st_ctim.tv_nsec);
+#elif defined(__APPLE__)
+  setKeyWord(key, 4, (u_int64_t)sb.st_mtimespec.tv_nsec);
+  setKeyWord(key, 6, (u_int64_t)sb.st_ctimespec.tv_nsec);
+#else
+  setKeyWord(key, 4, 0);
+  setKeyWord(key, 6, 0);
+#endif
+}
+#endif
+
+////////// CachedFile definition //////////
+
+class CachedFile {
+public:
+  CachedFile(FileBlockCache& cache, unsigned const* key, int fileDescriptor);
+  virtual ~CachedFile();
+
+  Boolean isUnchanged() const; // True iff the file still exists, with the same key
+
+  FileBlockCache& fCache;
+  unsigned fKey[FILE_KEY_SIZE];
+  int fFileDescriptor; // our own (duplicate) descriptor for the file, used to load its blocks
+  unsigned fRefCount; // the number of "FramedFileSource"s that have the file open
+};
+
+CachedFile::CachedFile(FileBlockCache& cache, unsigned const* key, int fileDescriptor)
+  : fCache(cache), fFileDescriptor(fileDescriptor), fRefCount(0) {
+  for (unsigned i = 0; i < FILE_KEY_SIZE; ++i) fKey[i] = key[i];
+}
+
+CachedFile::~CachedFile() {
+#ifdef CAN_IDENTIFY_FILES
+  close(fFileDescriptor);
+#endif
+}
+
+Boolean CachedFile::isUnchanged() const {
+#ifdef CAN_IDENTIFY_FILES
+  struct stat sb;
+  if (fstat(fFileDescriptor, &sb) != 0 || sb.st_nlink == 0) return False;
+
+  unsigned key[FILE_KEY_SIZE];
+  fileKeyFromStat(sb, key);
+  return memcmp(key, fKey, sizeof key) == 0;
+#else
+  return False;
+#endif
+}
+
+
+////////// FileBlockCache::Block and FileBlockCache::Waiter definitions //////////
+
+class FileBlockCache::Block {
+public:
+  Block(FileBlockCache& cache, unsigned const* key, CachedFile* file)
+    : fCache(cache), fFileOffset(((u_int64_t)key[FILE_KEY_SIZE+1]<<32 | key[FILE_KEY_SIZE])*FILE_BLOCK_SIZE),
+      fNumBytes(0), fIsLoaded(False), fRefCount(0), fLoadingFile(file), fReader(NULL), fPrev(NULL), fNext(NULL) {
+    for (unsigned i = 0; i < BLOCK_KEY_SIZE; ++i) fKey[i] = key[i];
+    fData = new u_int8_t[FILE_BLOCK_SIZE];
+  }
+  virtual ~Block() { delete[] fData; }
+
+  FileBlockCache& fCache;
+  unsigned fKey[BLOCK_KEY_SIZE];
+  u_int64_t fFileOffset;
+  u_int8_t* fData;
+  unsigned fNumBytes; // loaded so far
+  Boolean fIsLoaded;
+  unsigned fRefCount; // while this is >0 (e.g., while our data is being given to waiters), we can't be evicted
+  CachedFile* fLoadingFile; // non-NULL iff we're being loaded
+  AsyncFileReader* fReader; // non-NULL iff a read (for loading us) is outstanding
+  Block* fPrev; // in the LRU list (if we're loaded), or the list of blocks being loaded (if not)
+  Block* fNext;
+};
+
+class FileBlockCache::Waiter {
+public:
+  Block* block;
+  u_int8_t* to;
+  unsigned offsetInBlock;
+  unsigned size;
+  AsyncFileReader::completionFunc* func;
+  void* clientData;
+  Waiter* next;
+};
+
+
+////////// FileBlockCache implementation //////////
+
+void FileBlockCache::setMaxSize(UsageEnvironment& env, u_int64_t maxSize) {
+  FileBlockCache* cache = forEnvironment(env);
+  if (cache == NULL) {
+    if (maxSize == 0) return; // there's nothing to do
+
+    cache = new FileBlockCache(env);
+    _Tables::getOurTables(env)->fileBlockCache = cache;
+  }
+
+  cache->fMaxSize = maxSize;
+  cache->evictBlocksAsNeeded(0);
+  cache->reclaimIfPossible();
+}
+
+FileBlockCache* FileBlockCache::forEnvironment(UsageEnvironment& env) {
+  _Tables* ourTables = _Tables::getOurTables(env, False);
+  if (ourTables == NULL) return NULL;
+
+  return (FileBlockCache*)(ourTables->fileBlockCache);
+}
+
+double FileBlockCache::hitRate() const {
+  if (fNumLookups == 0) return 0.0;
+
+  return (double)(int64_t)(fNumHits + fNumSharedLoads)/(double)(int64_t)fNumLookups;
+}
+
+void FileBlockCache::resetStatistics() {
+  fNumLookups = fNumHits = fNumSharedLoads = fNumMisses = fNumBypasses = 0;
+  fNumBytesLoaded = fNumBlocksEvicted = 0;
+}
+
+CachedFile* FileBlockCache::openFile(UsageEnvironment& env, int fileDescriptor) {
+#ifdef CAN_IDENTIFY_FILES
+  FileBlockCache* cache = forEnvironment(env);
+  if (cache == NULL || cache->fMaxSize == 0 || fileDescriptor < 0) return NULL;
+
+  struct stat sb;
+  if (fstat(fileDescriptor, &sb) != 0 || !S_ISREG(sb.st_mode)) return NULL;
+
+  // Because the file's key includes its size and modification time, a file that has changed (even by being
+  // appended to, or being replaced by a new file that reuses its inode) gets new blocks, rather than the old ones:
+  unsigned key[FILE_KEY_SIZE];
+  fileKeyFromStat(sb, key);
+
+  CachedFile* file = (CachedFile*)(cache->fFiles->Lookup((char const*)key));
+  if (file == NULL) {
+    // This file isn't already open.  Use our own descriptor for it, because the caller's might be closed first:
+    int ourFileDescriptor = dup(fileDescriptor);
+    if (ourFileDescriptor < 0) return NULL;
+
+    file = new CachedFile(*cache, key, ourFileDescriptor);
+    cache->removeLoadedBlocksFor(key, True); // in case the file has changed since we last had it open
+    cache->fFiles->Add((char const*)(file->fKey), file);
+    ++cache->fNumOpenFiles;
+  }
+
+  ++file->fRefCount;
+  return file;
+#else
+  return NULL;
+#endif
+}
+
+void FileBlockCache::closeFile(CachedFile* file) {
+  if (file == NULL || --file->fRefCount > 0) return;
+
+  // Nobody has this file open any more.  Stop loading any of its blocks:
+  FileBlockCache& cache = file->fCache;
+  cache.cancelLoadsFor(file);
+
+  // Keep the blocks that have been loaded only if the file is still the same (so that a later "openFile()" might
+  // use them).  If it has changed, or been deleted, then its blocks can never be used again:
+  if (!file->isUnchanged()) cache.removeLoadedBlocksFor(file->fKey, False);
+  cache.fFiles->Remove((char const*)(file->fKey));
+  --cache.fNumOpenFiles;
+  delete file;
+
+  cache.reclaimIfPossible();
+}
+
+int FileBlockCache::read(CachedFile* file, u_int64_t position, u_int8_t* to, unsigned size,
+			 AsyncFileReader::completionFunc* completionFunc, void* clientData) {
+  return file->fCache.readFromBlock(file, position, to, size, completionFunc, clientData);
+}
+
+void FileBlockCache::cancel(CachedFile* file, void* clientData) {
+  FileBlockCache& cache = file->fCache;
+
+  Waiter** ptr = &cache.fWaiters;
+  while (*ptr != NULL) {
+    Waiter* waiter = *ptr;
+    if (waiter->clientData == clientData) {
+      *ptr = waiter->next;
+      delete waiter;
+    } else {
+      ptr = &waiter->next;
+    }
+  }
+}
+
+FileBlockCache::FileBlockCache(UsageEnvironment& env)
+  : fEnv(env), fMaxSize(0), fSize(0), fLRUHead(NULL), fLRUTail(NULL), fLoadingBlocks(NULL), fWaiters(NULL),
+    fNumOpenFiles(0) {
+  fFiles = HashTable::create(FILE_KEY_SIZE);
+  fBlocks = HashTable::create(BLOCK_KEY_SIZE);
+  resetStatistics();
+}
+
+FileBlockCache::~FileBlockCache() {
+  // We're deleted only when we hold no files or blocks (and thus no waiters), so our tables are empty:
+  delete fFiles;
+  delete fBlocks;
+}
+
+void FileBlockCache::reclaimIfPossible() {
+  if (fMaxSize > 0 || fNumOpenFiles > 0 || fSize > 0) return;
+
+  _Tables* ourTables = _Tables::getOurTables(fEnv, False);
+  if (ourTables != NULL) {
+    ourTables->fileBlockCache = NULL;
+    ourTables->reclaimIfPossible();
+  }
+  delete this;
+}
+
+int FileBlockCache::readFromBlock(CachedFile* file, u_int64_t position, u_int8_t* to, unsigned size,
+				  AsyncFileReader::completionFunc* completionFunc, void* clientData) {
+  u_int64_t const blockNum = position/FILE_BLOCK_SIZE;
+  unsigned const offsetInBlock = (unsigned)(position%FILE_BLOCK_SIZE);
+  if (size > FILE_BLOCK_SIZE - offsetInBlock) size = FILE_BLOCK_SIZE - offsetInBlock;
+
+  unsigned key[BLOCK_KEY_SIZE];
+  for (unsigned i = 0; i < FILE_KEY_SIZE; ++i) key[i] = file->fKey[i];
+  key[FILE_KEY_SIZE] = (unsigned)blockNum; key[FILE_KEY_SIZE+1] = (unsigned)(blockNum>>32);
+
+  ++fNumLookups;
+  Block* block = (Block*)(fBlocks->Lookup((char const*)key));
+  if (block != NULL && block->fIsLoaded) {
+    ++fNumHits;
+    useBlock(block);
+
+    if (offsetInBlock >= block->fNumBytes) return 0;
+    if (size > block->fNumBytes - offsetInBlock) size = block->fNumBytes - offsetInBlock;
+    memmove(to, &block->fData[offsetInBlock], size);
+    return (int)size;
+  }
+
+  if (block != NULL) {
+    // Someone else is already loading this block; wait for it:
+    ++fNumSharedLoads;
+  } else {
+    block = newBlock(file, key);
+    if (block == NULL) {
+      ++fNumBypasses;
+      return FILE_BLOCK_CACHE_BYPASS;
+    }
+    ++fNumMisses;
+    loadMore(block);
+  }
+
+  Waiter* waiter = new Waiter;
+  waiter->block = block;
+  waiter->to = to;
+  waiter->offsetInBlock = offsetInBlock;
+  waiter->size = size;
+  waiter->func = completionFunc;
+  waiter->clientData = clientData;
+  waiter->next = NULL;
+
+  Waiter** tail = &fWaiters;
+  while (*tail != NULL) tail = &(*tail)->next;
+  *tail = waiter;
+
+  return FILE_BLOCK_CACHE_PENDING;
+}
+
+FileBlockCache::Block* FileBlockCache::newBlock(CachedFile* file, unsigned const* key) {
+  evictBlocksAsNeeded(FILE_BLOCK_SIZE);
+  if (fSize + FILE_BLOCK_SIZE > fMaxSize) return NULL; // all of our blocks are being loaded
+
+  Block* block = new Block(*this, key, file);
+  fBlocks->Add((char const*)(block->fKey), block);
+  fSize += FILE_BLOCK_SIZE;
+
+  // Add the block to the head of our list of blocks being loaded:
+  block->fNext = fLoadingBlocks;
+  if (fLoadingBlocks != NULL) fLoadingBlocks->fPrev = block;
+  fLoadingBlocks = block;
+
+  return block;
+}
+
+void FileBlockCache::loadMore(Block* block) {
+  block->fReader = &AsyncFileReader::forEnvironment(fEnv);
+  block->fReader->read(block->fLoadingFile->fFileDescriptor, block->fFileOffset + block->fNumBytes,
+		       &block->fData[block->fNumBytes], FILE_BLOCK_SIZE - block->fNumBytes,
+		       blockLoadCompletionHandler, block);
+}
+
+void FileBlockCache::blockLoadCompletionHandler(void* clientData, int result) {
+  Block* block = (Block*)clientData;
+  block->fCache.blockLoadCompletionHandler1(block, result);
+}
+
+void FileBlockCache::blockLoadCompletionHandler1(Block* block, int result) {
+  block->fReader = NULL;
+  if (result > 0) {
+    block->fNumBytes += result;
+    fNumBytesLoaded += result;
+
+    // If we read only part of the block (e.g., because only part of it had been cached by the OS),
+    // then read the rest:
+    if (block->fNumBytes < FILE_BLOCK_SIZE) {
+      loadMore(block);
+      return;
+    }
+  }
+
+  // The block has now been loaded (perhaps only partially, if it's at the end of the file).
+  // Remove it from our list of blocks being loaded:
+  if (block->fPrev != NULL) block->fPrev->fNext = block->fNext; else fLoadingBlocks = block->fNext;
+  if (block->fNext != NULL) block->fNext->fPrev = block->fPrev;
+  block->fPrev = block->fNext = NULL;
+  block->fLoadingFile = NULL;
+  block->fIsLoaded = True;
+
+  // Give each waiter its data.  Because a waiter's completion function may cancel other waiters (e.g., by closing
+  // their sources), we remove each waiter from our list just before calling its completion function.
+  // (A completion function may also start loading other blocks, so we make sure that this one isn't evicted.)
+  ++block->fRefCount;
+  while (1) {
+    Waiter** ptr = &fWaiters;
+    while (*ptr != NULL && (*ptr)->block != block) ptr = &(*ptr)->next;
+    Waiter* waiter = *ptr;
+    if (waiter == NULL) break;
+    *ptr = waiter->next;
+
+    int waiterResult;
+    if (waiter->offsetInBlock < block->fNumBytes) {
+      unsigned numBytes = block->fNumBytes - waiter->offsetInBlock;
+      if (numBytes > waiter->size) numBytes = waiter->size;
+      memmove(waiter->to, &block->fData[waiter->offsetInBlock], numBytes);
+      waiterResult = (int)numBytes;
+    } else if (result < 0) {
+      waiterResult = -1; // the read of this waiter's data failed; don't mistake this for end-of-file
+    } else {
+      waiterResult = 0; // end-of-file
+    }
+
+    AsyncFileReader::completionFunc* func = waiter->func;
+    void* waiterClientData = waiter->clientData;
+    delete waiter;
+    (*func)(waiterClientData, waiterResult);
+  }
+  --block->fRefCount;
+
+  if (block->fNumBytes < FILE_BLOCK_SIZE) {
+    // Don't keep a partial block (the file might grow, or we might have failed to read it):
+    removeBlock(block);
+  } else {
+    useBlock(block);
+    evictBlocksAsNeeded(0); // in case our maximum size has since been reduced
+  }
+  reclaimIfPossible();
+}
+
+void FileBlockCache::cancelLoadsFor(CachedFile* file) {
+  Block* block = fLoadingBlocks;
+  while (block != NULL) {
+    Block* nextBlock = block->fNext;
+    if (block->fLoadingFile == file) removeBlock(block);
+    block = nextBlock;
+  }
+}
+
+void FileBlockCache::removeLoadedBlocksFor(unsigned const* fileKey, Boolean otherVersionsOnly) {
+  Block* block = fLRUHead;
+  while (block != NULL) {
+    Block* nextBlock = block->fNext;
+    if (block->fRefCount == 0 && memcmp(block->fKey, fileKey, FILE_INODE_KEY_SIZE*sizeof (unsigned)) == 0) {
+      Boolean const isSameVersion = memcmp(block->fKey, fileKey, FILE_KEY_SIZE*sizeof (unsigned)) == 0;
+      if (isSameVersion != otherVersionsOnly) removeBlock(block);
+    }
+    block = nextBlock;
+  }
+}
+
+void FileBlockCache::removeBlock(Block* block) {
+  if (block->fReader != NULL) block->fReader->cancel(block);
+
+  // Remove the block from whichever list it's in:
+  if (block->fPrev != NULL) {
+    block->fPrev->fNext = block->fNext;
+  } else if (fLoadingBlocks == block) {
+    fLoadingBlocks = block->fNext;
+  } else if (fLRUHead == block) {
+    fLRUHead = block->fNext;
+  }
+  if (block->fNext != NULL) {
+    block->fNext->fPrev = block->fPrev;
+  } else if (fLRUTail == block) {
+    fLRUTail = block->fPrev;
+  }
+
+  fBlocks->Remove((char const*)(block->fKey));
+  fSize -= FILE_BLOCK_SIZE;
+  delete block;
+}
+
+void FileBlockCache::evictBlocksAsNeeded(u_int64_t numBytesNeeded) {
+  Block* block = fLRUTail;
+  while (fSize + numBytesNeeded > fMaxSize && block != NULL) {
+    Block* prevBlock = block->fPrev;
+    if (block->fRefCount == 0) {
+      removeBlock(block);
+      ++fNumBlocksEvicted;
+    }
+    block = prevBlock;
+  }
+}
+
+void FileBlockCache::useBlock(Block* block) {
+  if (fLRUHead == block) return; // it's already the most recently used
+
+  // Unlink the block (if it's already in the LRU list):
+  if (block->fPrev != NULL) block->fPrev->fNext = block->fNext;
+  if (block->fNext != NULL) block->fNext->fPrev = block->fPrev;
+  if (fLRUTail == block) fLRUTail = block->fPrev;
+
+  // Then put it at the head:
+  block->fPrev = NULL;
+  block->fNext = fLRUHead;
+  if (fLRUHead != NULL) fLRUHead->fPrev = block;
+  fLRUHead = block;
+  if (fLRUTail == NULL) fLRUTail = block;
+}
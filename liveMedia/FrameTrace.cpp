@@ -0,0 +1,115 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A ring buffer that records - for each "FramedSource" - when frames were requested and delivered.
+// Implementation
+
+#include "FrameTrace.hh"
+#include "OutputFile.hh"
+#include <GroupsockHelper.hh> // for "gettimeofday()"
+
+#define DEFAULT_MAX_NUM_FRAME_TRACE_RECORDS 65536
+
+FrameTraceBuffer* FrameTraceBuffer::ourBuffer(UsageEnvironment& env, Boolean createIfNotPresent) {
+  _Tables* ourTables = _Tables::getOurTables(env, createIfNotPresent);
+  if (ourTables == NULL) return NULL;
+
+  if (ourTables->frameTraceBuffer == NULL && createIfNotPresent) {
+    ourTables->frameTraceBuffer = new FrameTraceBuffer(env, DEFAULT_MAX_NUM_FRAME_TRACE_RECORDS);
+  }
+  return (FrameTraceBuffer*)(ourTables->frameTraceBuffer);
+}
+
+void FrameTraceBuffer::close(UsageEnvironment& env) {
+  _Tables* ourTables = _Tables::getOurTables(env, False);
+  if (ourTables == NULL) return;
+
+  delete (FrameTraceBuffer*)(ourTables->frameTraceBuffer);
+  ourTables->frameTraceBuffer = NULL;
+  ourTables->reclaimIfPossible();
+}
+
+FrameTraceBuffer::FrameTraceBuffer(UsageEnvironment& env, unsigned maxNumRecords)
+  : fEnv(env), fRecords(NULL), fMaxNumRecords(0) {
+  setMaxNumRecords(maxNumRecords);
+}
+
+FrameTraceBuffer::~FrameTraceBuffer() {
+  delete[] fRecords;
+}
+
+void FrameTraceBuffer::setMaxNumRecords(unsigned maxNumRecords) {
+  if (maxNumRecords == 0) maxNumRecords = 1; // sanity check
+  if (maxNumRecords != fMaxNumRecords) {
+    delete[] fRecords;
+    fRecords = new FrameTraceRecord[maxNumRecords];
+    fMaxNumRecords = maxNumRecords;
+  }
+  reset();
+}
+
+void FrameTraceBuffer::reset() {
+  fNextIndex = fNumRecords = fNumRecordsLost = 0;
+}
+
+void FrameTraceBuffer::addRecord(Medium const& medium, FrameTraceEventType eventType, unsigned frameSize) {
+  FrameTraceRecord& record = fRecords[fNextIndex];
+
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+  record.timeSec = (u_int32_t)timeNow.tv_sec;
+  record.timeUSec = (u_int32_t)timeNow.tv_usec;
+  record.frameSize = frameSize;
+  record.eventType = (u_int8_t)eventType;
+  strncpy(record.mediumName, medium.name(), sizeof record.mediumName);
+  record.mediumName[sizeof record.mediumName - 1] = '\0';
+
+  if (++fNextIndex == fMaxNumRecords) fNextIndex = 0;
+  if (fNumRecords < fMaxNumRecords) {
+    ++fNumRecords;
+  } else {
+    ++fNumRecordsLost; // we overwrote the oldest record
+  }
+}
+
+Boolean FrameTraceBuffer::writeToFile(char const* fileName) const {
+  FILE* fid = OpenOutputFile(fEnv, fileName);
+  if (fid == NULL) return False;
+
+  Boolean result = writeToFile(fid);
+  CloseOutputFile(fid);
+  return result;
+}
+
+Boolean FrameTraceBuffer::writeToFile(FILE* fid) const {
+  FrameTraceFileHeader header;
+  memmove(header.magic, FRAME_TRACE_FILE_MAGIC, sizeof header.magic);
+  header.recordSize = sizeof (FrameTraceRecord);
+  header.numRecords = fNumRecords;
+  header.numRecordsLost = fNumRecordsLost;
+  if (fwrite(&header, sizeof header, 1, fid) != 1) return False;
+
+  // Write the records in the order in which they were added, beginning with the oldest:
+  unsigned oldestIndex = fNumRecords < fMaxNumRecords ? 0 : fNextIndex;
+  unsigned numAtEnd = fNumRecords < fMaxNumRecords ? fNumRecords : fMaxNumRecords - oldestIndex;
+  if (numAtEnd > 0 && fwrite(&fRecords[oldestIndex], sizeof (FrameTraceRecord), numAtEnd, fid) != numAtEnd) return False;
+
+  unsigned numAtStart = fNumRecords - numAtEnd;
+  if (numAtStart > 0 && fwrite(&fRecords[0], sizeof (FrameTraceRecord), numAtStart, fid) != numAtStart) return False;
+
+  return True;
+}
@@ -19,12 +19,132 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "FramedFileSource.hh"
+#include "FileBlockCache.hh"
 
 ////////// FramedFileSource //////////
 
 FramedFileSource::FramedFileSource(UsageEnvironment& env, FILE* fid)
-  : FramedSource(env), fFid(fid) {
+  : FramedSource(env), fFid(fid), fHaveOpenedCachedFile(False), fCachedFile(NULL),
+    fPendingFileReader(NULL), fIsAwaitingCache(False), fFileReadCompletionTask(NULL),
+    fFileReadPosition(0), fFileReadTo(NULL), fFileReadSize(0), fNumBytesReadFromFile(0), fFileReadResult(0),
+    fPrefetchSize(0), fPrefetchPosition(0), fNextPrefetchPosition(0) {
 }
 
 FramedFileSource::~FramedFileSource() {
+  cancelFileRead();
+  FileBlockCache::closeFile(fCachedFile);
+}
+
+void FramedFileSource::readFileAsynchronously(u_int64_t position, u_int8_t* to, unsigned size) {
+  if (!fHaveOpenedCachedFile) {
+    // Check (just once) whether we should read the file through our environment's cache:
+    fCachedFile = FileBlockCache::openFile(envir(), fileno(fFid));
+    fHaveOpenedCachedFile = True;
+  }
+
+  fFileReadPosition = position;
+  fFileReadTo = to;
+  fFileReadSize = size;
+  fNumBytesReadFromFile = 0;
+
+  if (fCachedFile != NULL) {
+    continueReadingFromCache(False);
+  } else {
+    startReadingDirectly();
+  }
+}
+
+void FramedFileSource::afterReadingFile(int /*result*/) {
+  // By default, do nothing (our subclass should have redefined this)
+}
+
+void FramedFileSource::cancelFileRead() {
+  if (fPendingFileReader != NULL) {
+    fPendingFileReader->cancel(this);
+    fPendingFileReader = NULL;
+  }
+  if (fIsAwaitingCache) {
+    FileBlockCache::cancel(fCachedFile, this);
+    fIsAwaitingCache = False;
+  }
+  envir().taskScheduler().unscheduleDelayedTask(fFileReadCompletionTask);
+}
+
+void FramedFileSource::prefetchFrom(u_int64_t position) {
+  if (fPrefetchSize == 0 || fFid == NULL) return;
+
+  if (position >= fNextPrefetchPosition || position < fPrefetchPosition) {
+    AsyncFileReader::forEnvironment(envir()).prefetch(fileno(fFid), position, fPrefetchSize);
+    fPrefetchPosition = position;
+    fNextPrefetchPosition = position + fPrefetchSize/2;
+  }
+}
+
+void FramedFileSource::continueReadingFromCache(Boolean calledFromEventLoop) {
+  // Copy data from each successive block, until we've read everything, or must wait for a block to be loaded:
+  int result = 0;
+  while (fNumBytesReadFromFile < fFileReadSize) {
+    result = FileBlockCache::read(fCachedFile, fFileReadPosition + fNumBytesReadFromFile,
+				  &fFileReadTo[fNumBytesReadFromFile], fFileReadSize - fNumBytesReadFromFile,
+				  cachedReadCompletionHandler, this);
+    if (result == FILE_BLOCK_CACHE_PENDING) {
+      fIsAwaitingCache = True;
+      return;
+    }
+    if (result == FILE_BLOCK_CACHE_BYPASS) {
+      startReadingDirectly();
+      return;
+    }
+    if (result <= 0) break; // end-of-file, or error
+
+    fNumBytesReadFromFile += result;
+  }
+
+  completeFileRead(result, calledFromEventLoop);
+}
+
+void FramedFileSource::startReadingDirectly() {
+  fPendingFileReader = &AsyncFileReader::forEnvironment(envir());
+  fPendingFileReader->read(fileno(fFid), fFileReadPosition + fNumBytesReadFromFile,
+			   &fFileReadTo[fNumBytesReadFromFile], fFileReadSize - fNumBytesReadFromFile,
+			   fileReadCompletionHandler, this);
+}
+
+void FramedFileSource::completeFileRead(int lastResult, Boolean calledFromEventLoop) {
+  fFileReadResult = fNumBytesReadFromFile > 0 ? (int)fNumBytesReadFromFile : lastResult;
+
+  if (calledFromEventLoop) {
+    afterReadingFile(fFileReadResult);
+  } else {
+    // All of the data was already in the cache.  To avoid possible infinite recursion, we need to return
+    // to the event loop before completing the read:
+    fFileReadCompletionTask
+      = envir().taskScheduler().scheduleDelayedTask(0, fileReadCompletionTask, this);
+  }
+}
+
+void FramedFileSource::cachedReadCompletionHandler(void* clientData, int result) {
+  FramedFileSource* source = (FramedFileSource*)clientData;
+  source->fIsAwaitingCache = False;
+
+  if (result > 0) {
+    source->fNumBytesReadFromFile += result;
+    source->continueReadingFromCache(True);
+  } else {
+    source->completeFileRead(result, True);
+  }
+}
+
+void FramedFileSource::fileReadCompletionHandler(void* clientData, int result) {
+  FramedFileSource* source = (FramedFileSource*)clientData;
+  source->fPendingFileReader = NULL;
+
+  if (result > 0) source->fNumBytesReadFromFile += result;
+  source->completeFileRead(result, True);
+}
+
+void FramedFileSource::fileReadCompletionTask(void* clientData) {
+  FramedFileSource* source = (FramedFileSource*)clientData;
+  source->fFileReadCompletionTask = NULL;
+  source->afterReadingFile(source->fFileReadResult);
 }
@@ -57,3 +57,7 @@ void FramedFilter::doStopGettingFrames() {
   FramedSource::doStopGettingFrames();
   if (fInputSource != NULL) fInputSource->stopGettingFrames();
 }
+
+void FramedFilter::requestKeyFrame() {
+  if (fInputSource != NULL) fInputSource->requestKeyFrame();
+}
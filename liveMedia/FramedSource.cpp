@@ -21,6 +21,14 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "FramedSource.hh"
 #include <stdlib.h>
 
+#ifdef FRAME_TRACING
+#include "FrameTrace.hh"
+#define TRACE_FRAME_EVENT(source, eventType, frameSize) \
+  FrameTraceBuffer::ourBuffer((source)->envir())->addRecord(*(source), (eventType), (frameSize))
+#else
+#define TRACE_FRAME_EVENT(source, eventType, frameSize)
+#endif
+
 ////////// FramedSource //////////
 
 FramedSource::FramedSource(UsageEnvironment& env)
@@ -74,11 +82,13 @@ void FramedSource::getNextFrame(unsigned char* to, unsigned maxSize,
   fOnCloseFunc = onCloseFunc;
   fOnCloseClientData = onCloseClientData;
   fIsCurrentlyAwaitingData = True;
+  TRACE_FRAME_EVENT(this, FRAME_TRACE_REQUESTED, maxSize);
 
   doGetNextFrame();
 }
 
 void FramedSource::afterGetting(FramedSource* source) {
+  TRACE_FRAME_EVENT(source, FRAME_TRACE_DELIVERED, source->fFrameSize);
   source->nextTask() = NULL;
   source->fIsCurrentlyAwaitingData = False;
       // indicates that we can be read again
@@ -99,6 +109,7 @@ void FramedSource::handleClosure(void* clientData) {
 }
 
 void FramedSource::handleClosure() {
+  TRACE_FRAME_EVENT(this, FRAME_TRACE_CLOSED, 0);
   fIsCurrentlyAwaitingData = False; // because we got a close instead
   if (fOnCloseFunc != NULL) {
     (*fOnCloseFunc)(fOnCloseClientData);
@@ -106,6 +117,7 @@ void FramedSource::handleClosure() {
 }
 
 void FramedSource::stopGettingFrames() {
+  TRACE_FRAME_EVENT(this, FRAME_TRACE_STOPPED, 0);
   fIsCurrentlyAwaitingData = False; // indicates that we can be read again
   fAfterGettingFunc = NULL;
   fOnCloseFunc = NULL;
@@ -120,6 +132,11 @@ void FramedSource::doStopGettingFrames() {
   // Subclasses may wish to redefine this function.
 }
 
+void FramedSource::requestKeyFrame() {
+  // By default, we can't do anything about this.  Sources that wrap an encoder
+  // should redefine this function to force the encoder to emit a key frame.
+}
+
 unsigned FramedSource::maxFrameSize() const {
   // By default, this source has no maximum frame size.
   return 0;
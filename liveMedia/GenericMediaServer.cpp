@@ -367,6 +367,26 @@ ServerMediaSession* GenericMediaServer::ServerMediaSessionIterator::next() {
 }
 
 
+////////// ClientSessionIterator implementation //////////
+
+GenericMediaServer::ClientSessionIterator
+::ClientSessionIterator(GenericMediaServer& server)
+  : fOurIterator((server.fClientSessions == NULL)
+		 ? NULL : HashTable::Iterator::create(*server.fClientSessions)) {
+}
+
+GenericMediaServer::ClientSessionIterator::~ClientSessionIterator() {
+  delete fOurIterator;
+}
+
+GenericMediaServer::ClientSession* GenericMediaServer::ClientSessionIterator::next() {
+  if (fOurIterator == NULL) return NULL;
+
+  char const* key; // dummy
+  return (ClientSession*)(fOurIterator->next(key));
+}
+
+
 ////////// UserAuthenticationDatabase implementation //////////
 
 UserAuthenticationDatabase::UserAuthenticationDatabase(char const* realm,
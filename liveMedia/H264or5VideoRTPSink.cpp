@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "H264or5VideoRTPSink.hh"
 #include "H264or5VideoStreamFramer.hh"
+#include "RTPCongestionMonitor.hh"
 
 ////////// H264or5Fragmenter definition //////////
 
@@ -33,7 +34,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 class H264or5Fragmenter: public FramedFilter {
 public:
   H264or5Fragmenter(int hNumber, UsageEnvironment& env, FramedSource* inputSource,
-		    unsigned inputBufferMax, unsigned maxOutputPacketSize);
+		    unsigned inputBufferMax, unsigned maxOutputPacketSize, RTPSink& ourSink);
   virtual ~H264or5Fragmenter();
 
   Boolean lastFragmentCompletedNALUnit() const { return fLastFragmentCompletedNALUnit; }
@@ -52,9 +53,12 @@ private:
                           struct timeval presentationTime,
                           unsigned durationInMicroseconds);
   void reset();
+  Boolean shouldDropNALUnit(u_int8_t nalUnitHeader);
+  static void readNextNALUnit(void* clientData);
 
 private:
   int fHNumber;
+  RTPSink& fOurSink;
   unsigned fInputBufferSize;
   unsigned fMaxOutputPacketSize;
   unsigned char* fInputBuffer;
@@ -62,6 +66,8 @@ private:
   unsigned fCurDataOffset;
   unsigned fSaveNumTruncatedBytes;
   Boolean fLastFragmentCompletedNALUnit;
+  Boolean fWaitingForKeyFrame; // because we dropped a reference frame
+  unsigned fDroppedDurationInMicroseconds;
 };
 
 
@@ -117,7 +123,7 @@ Boolean H264or5VideoRTPSink::continuePlaying() {
   // If not, create it now:
   if (fOurFragmenter == NULL) {
     fOurFragmenter = new H264or5Fragmenter(fHNumber, envir(), fSource, OutPacketBuffer::maxSize,
-					   ourMaxPacketSize() - 12/*RTP hdr size*/);
+					   ourMaxPacketSize() - 12/*RTP hdr size*/, *this);
   } else {
     fOurFragmenter->reassignInputSource(fSource);
   }
@@ -160,10 +166,11 @@ Boolean H264or5VideoRTPSink
 
 H264or5Fragmenter::H264or5Fragmenter(int hNumber,
 				     UsageEnvironment& env, FramedSource* inputSource,
-				     unsigned inputBufferMax, unsigned maxOutputPacketSize)
+				     unsigned inputBufferMax, unsigned maxOutputPacketSize, RTPSink& ourSink)
   : FramedFilter(env, inputSource),
-    fHNumber(hNumber),
-    fInputBufferSize(inputBufferMax+1), fMaxOutputPacketSize(maxOutputPacketSize) {
+    fHNumber(hNumber), fOurSink(ourSink),
+    fInputBufferSize(inputBufferMax+1), fMaxOutputPacketSize(maxOutputPacketSize),
+    fWaitingForKeyFrame(False), fDroppedDurationInMicroseconds(0) {
   fInputBuffer = new unsigned char[fInputBufferSize];
   reset();
 }
@@ -283,17 +290,69 @@ void H264or5Fragmenter::afterGettingFrame1(unsigned frameSize,
 					   unsigned numTruncatedBytes,
 					   struct timeval presentationTime,
 					   unsigned durationInMicroseconds) {
+  if (frameSize > 0 && shouldDropNALUnit(fInputBuffer[1])) {
+    // Don't send this NAL unit.  Instead, wait for as long as it would have taken to send, then read another one.
+    // (We also add its duration to that of the next NAL unit that we deliver, so that our sink's idea of when
+    // to send the following one stays in step.)
+    fDroppedDurationInMicroseconds += durationInMicroseconds;
+    fOurSink.congestionMonitor()->noteFrameDropped();
+    nextTask() = envir().taskScheduler().scheduleDelayedTask(durationInMicroseconds, readNextNALUnit, this);
+    return;
+  }
+
   fNumValidDataBytes += frameSize;
   fSaveNumTruncatedBytes = numTruncatedBytes;
   fPresentationTime = presentationTime;
-  fDurationInMicroseconds = durationInMicroseconds;
+  fDurationInMicroseconds = durationInMicroseconds + fDroppedDurationInMicroseconds;
+  fDroppedDurationInMicroseconds = 0;
 
   // Deliver data to the client:
   doGetNextFrame();
 }
 
+Boolean H264or5Fragmenter::shouldDropNALUnit(u_int8_t nalUnitHeader) {
+  RTPCongestionMonitor* monitor = fOurSink.congestionMonitor();
+  if (monitor == NULL) return False; // we're not responding to congestion
+
+  // We drop only 'VCL' NAL units (i.e., coded pictures), never parameter sets or SEIs:
+  Boolean isVCL, isKeyFrame, isReference;
+  if (fHNumber == 264) {
+    u_int8_t nal_unit_type = nalUnitHeader&0x1F;
+    isVCL = nal_unit_type >= 1 && nal_unit_type <= 5;
+    isKeyFrame = nal_unit_type == 5; // IDR
+    isReference = (nalUnitHeader&0x60) != 0; // nal_ref_idc != 0
+  } else { // 265
+    u_int8_t nal_unit_type = (nalUnitHeader&0x7E)>>1;
+    isVCL = nal_unit_type <= 31;
+    isKeyFrame = nal_unit_type >= 16 && nal_unit_type <= 23; // IRAP
+    isReference = nal_unit_type >= 16 || (nal_unit_type&1) != 0; // not a "..._N" (sub-layer non-reference) picture
+  }
+  if (!isVCL) return False;
+  if (isKeyFrame) {
+    fWaitingForKeyFrame = False;
+    return False;
+  }
+
+  // After dropping a reference frame, the following frames can't be decoded until the next key frame:
+  if (fWaitingForKeyFrame) return True;
+
+  unsigned level = monitor->level();
+  if (level >= CONGESTION_RESPONSE_KEY_FRAMES_ONLY) {
+    if (isReference) fWaitingForKeyFrame = True;
+    return True;
+  }
+  return level >= CONGESTION_RESPONSE_DROP_DISPOSABLE && !isReference;
+}
+
+void H264or5Fragmenter::readNextNALUnit(void* clientData) {
+  H264or5Fragmenter* fragmenter = (H264or5Fragmenter*)clientData;
+  fragmenter->nextTask() = NULL;
+  fragmenter->doGetNextFrame(); // reads a new NAL unit, because our buffer is empty
+}
+
 void H264or5Fragmenter::reset() {
   fNumValidDataBytes = fCurDataOffset = 1;
   fSaveNumTruncatedBytes = 0;
   fLastFragmentCompletedNALUnit = True;
+  fDroppedDurationInMicroseconds = 0;
 }
@@ -0,0 +1,77 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A RTP sink that sends pre-packetized payloads from a RTP hint file (delivered by a "RTPHintFileSource")
+// Implementation
+
+#include "HintedRTPSink.hh"
+#include "RTPHintFileSource.hh"
+
+HintedRTPSink* HintedRTPSink::createNew(UsageEnvironment& env, Groupsock* RTPgs, RTPHintFile* hintFile,
+					unsigned char rtpPayloadTypeIfDynamic) {
+  if (hintFile == NULL) return NULL;
+
+  // Use the payload type that was recorded in the hint file, unless it was a dynamic one:
+  unsigned char rtpPayloadType = hintFile->header().rtpPayloadType;
+  if (rtpPayloadType >= 96) rtpPayloadType = rtpPayloadTypeIfDynamic;
+
+  return new HintedRTPSink(env, RTPgs, hintFile, rtpPayloadType);
+}
+
+HintedRTPSink::HintedRTPSink(UsageEnvironment& env, Groupsock* RTPgs, RTPHintFile* hintFile,
+			     unsigned char rtpPayloadType)
+  : MultiFramedRTPSink(env, RTPgs, rtpPayloadType,
+		       hintFile->header().timestampFrequency,
+		       hintFile->header().rtpPayloadFormatName,
+		       hintFile->header().numChannels),
+    fHintFile(hintFile) {
+  // Make sure that our packets can hold the largest payload in the file:
+  unsigned const maxPacketSize = 12/*RTP header*/ + hintFile->header().maxPayloadSize;
+  if (maxPacketSize > 1456) setPacketSizes(maxPacketSize, maxPacketSize);
+}
+
+HintedRTPSink::~HintedRTPSink() {
+}
+
+Boolean HintedRTPSink::sourceIsCompatibleWithUs(MediaSource& source) {
+  // We need the payload flags that a "RTPHintFileSource" provides:
+  return source.isRTPHintFileSource();
+}
+
+void HintedRTPSink::doSpecialFrameHandling(unsigned /*fragmentationOffset*/,
+					   unsigned char* /*frameStart*/,
+					   unsigned /*numBytesInFrame*/,
+					   struct timeval framePresentationTime,
+					   unsigned /*numRemainingBytes*/) {
+  RTPHintFileSource* source = (RTPHintFileSource*)fSource;
+  if ((source->lastPayloadFlags()&RTP_HINT_MARKER) != 0) setMarkerBit();
+
+  setTimestamp(framePresentationTime);
+}
+
+Boolean HintedRTPSink::frameCanAppearAfterPacketStart(unsigned char const* /*frameStart*/,
+						      unsigned /*numBytesInFrame*/) const {
+  return False; // each payload from the hint file is a complete packet's worth
+}
+
+char const* HintedRTPSink::sdpMediaType() const {
+  return fHintFile->header().mediumName;
+}
+
+char const* HintedRTPSink::auxSDPLine() {
+  return fHintFile->auxSDPLine();
+}
@@ -20,6 +20,14 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "InputFile.hh"
 #include <string.h>
+#if !defined(__WIN32__) && !defined(_WIN32) && !defined(_WIN32_WCE)
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#define HAVE_MMAP 1
+#endif
 
 FILE* OpenInputFile(UsageEnvironment& env, char const* fileName) {
   FILE* fid;
@@ -110,3 +118,125 @@ Boolean FileIsSeekable(FILE *fid) {
   SeekFile64(fid, -1, SEEK_CUR); // seek back to where we were
   return True;
 }
+
+u_int8_t* MapInputFile(int fileDescriptor, u_int64_t fileSize) {
+  return MapInputFileRegion(fileDescriptor, 0, fileSize);
+}
+
+u_int8_t* MapInputFileRegion(int fileDescriptor, u_int64_t offset, u_int64_t size) {
+#ifdef HAVE_MMAP
+  if (fileDescriptor < 0 || size == 0) return NULL;
+  if ((u_int64_t)(size_t)size != size) return NULL; // too large for our address space
+
+  void* mapping = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, fileDescriptor, (off_t)offset);
+  if (mapping == MAP_FAILED) return NULL;
+
+  return (u_int8_t*)mapping;
+#else
+  return NULL;
+#endif
+}
+
+void UnmapInputFile(u_int8_t* mapping, u_int64_t fileSize) {
+#ifdef HAVE_MMAP
+  if (mapping != NULL) munmap(mapping, (size_t)fileSize);
+#endif
+}
+
+void AdviseSequentialAccess(u_int8_t* mapping, u_int64_t size) {
+#if defined(HAVE_MMAP) && defined(MADV_SEQUENTIAL)
+  if (mapping != NULL) madvise(mapping, (size_t)size, MADV_SEQUENTIAL);
+#endif
+}
+
+void AdviseReadahead(int fileDescriptor, u_int64_t offset, u_int64_t size) {
+#if defined(HAVE_MMAP) && defined(POSIX_FADV_WILLNEED)
+  if (fileDescriptor >= 0) posix_fadvise(fileDescriptor, (off_t)offset, (off_t)size, POSIX_FADV_WILLNEED);
+#endif
+}
+
+#ifdef HAVE_MMAP
+static Boolean dataIsCached(int fileDescriptor, u_int64_t offset, unsigned size) {
+  // Map (without touching) the pages that hold the data, and ask the OS whether they're all resident:
+  struct stat sb;
+  if (fstat(fileDescriptor, &sb) != 0) return True; // we can't tell
+  if (offset >= (u_int64_t)sb.st_size) return True; // we'll read nothing anyway
+  if (offset + size > (u_int64_t)sb.st_size) size = (unsigned)(sb.st_size - offset);
+
+  u_int64_t const pageSize = (u_int64_t)sysconf(_SC_PAGESIZE);
+  u_int64_t const start = offset - offset%pageSize;
+  size_t const length = (size_t)(offset + size - start);
+  void* mapping = mmap(NULL, length, PROT_READ, MAP_SHARED, fileDescriptor, (off_t)start);
+  if (mapping == MAP_FAILED) return True; // we can't tell
+
+  unsigned const numPages = (unsigned)((length + pageSize - 1)/pageSize);
+  char* residency = new char[numPages];
+  Boolean result = True;
+#ifdef __linux__
+  if (mincore(mapping, length, (unsigned char*)residency) == 0) {
+#else
+  if (mincore(mapping, length, residency) == 0) {
+#endif
+    for (unsigned i = 0; i < numPages; ++i) {
+      if ((residency[i]&1) == 0) {
+	result = False;
+	break;
+      }
+    }
+  }
+
+  delete[] residency;
+  munmap(mapping, length);
+  return result;
+}
+#endif
+
+#define MAX_REMEMBERED_DESCRIPTORS 1024 // we remember (for "ReadInputFileAt()") per-descriptor results only for descriptors below this
+
+int ReadInputFileAt(int fileDescriptor, u_int64_t offset, u_int8_t* to, unsigned size, Boolean onlyIfCached) {
+  if (fileDescriptor < 0) return -1;
+
+#ifdef HAVE_MMAP
+  if (onlyIfCached) {
+#ifdef RWF_NOWAIT
+    // If we can, ask the OS to read only what's already cached (in a single system call):
+    static Boolean noWaitReadsAreSupported = True;
+    static Boolean noWaitReadsFailForDescriptor[MAX_REMEMBERED_DESCRIPTORS]; // because of its file system
+    Boolean const descriptorIsRemembered = fileDescriptor < MAX_REMEMBERED_DESCRIPTORS;
+    if (noWaitReadsAreSupported
+	&& !(descriptorIsRemembered && noWaitReadsFailForDescriptor[fileDescriptor])) {
+      struct iovec iov;
+      iov.iov_base = to;
+      iov.iov_len = size;
+      ssize_t result = preadv2(fileDescriptor, &iov, 1, (off_t)offset, RWF_NOWAIT);
+      if (result >= 0) {
+	return (int)result;
+      } else if (errno == EAGAIN) {
+	return READ_WOULD_BLOCK;
+      } else if (errno == ENOSYS) {
+	noWaitReadsAreSupported = False; // the kernel is too old
+      } else if (errno == EOPNOTSUPP) {
+	// The file system (e.g., NFS or CIFS) doesn't support this.  Don't try it again for this descriptor.
+	// (If the descriptor is later reused for another file, we'll just keep checking the slow way.)
+	if (descriptorIsRemembered) noWaitReadsFailForDescriptor[fileDescriptor] = True;
+      } else {
+	return -1;
+      }
+      // Otherwise, check the cache the slow way:
+    }
+#endif
+    if (!dataIsCached(fileDescriptor, offset, size)) return READ_WOULD_BLOCK;
+  }
+
+  ssize_t result;
+  do {
+    result = pread(fileDescriptor, to, size, (off_t)offset);
+  } while (result < 0 && errno == EINTR);
+  return (int)result;
+#elif !defined(_WIN32_WCE)
+  if (_lseeki64(fileDescriptor, (__int64)offset, SEEK_SET) < 0) return -1;
+  return _read(fileDescriptor, to, size);
+#else
+  return -1;
+#endif
+}
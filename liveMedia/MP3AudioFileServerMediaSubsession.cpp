@@ -29,8 +29,15 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 MP3AudioFileServerMediaSubsession* MP3AudioFileServerMediaSubsession
 ::createNew(UsageEnvironment& env, char const* fileName, Boolean reuseFirstSource,
 	    Boolean generateADUs, Interleaving* interleaving) {
-  return new MP3AudioFileServerMediaSubsession(env, fileName, reuseFirstSource,
-					       generateADUs, interleaving);
+  MP3AudioFileServerMediaSubsession* subsession
+    = new MP3AudioFileServerMediaSubsession(env, fileName, reuseFirstSource,
+					    generateADUs, interleaving);
+
+  // Begin building (in the background, unless it can be read from a file) a table that lets each of our
+  // sources seek exactly, and know the file's exact duration.  (Until it's complete, they estimate these.)
+  subsession->fSeekTable = MP3SeekTable::createNew(env, fileName);
+
+  return subsession;
 }
 
 MP3AudioFileServerMediaSubsession
@@ -39,12 +46,13 @@ MP3AudioFileServerMediaSubsession
 				    Boolean generateADUs,
 				    Interleaving* interleaving)
   : FileServerMediaSubsession(env, fileName, reuseFirstSource),
-    fGenerateADUs(generateADUs), fInterleaving(interleaving), fFileDuration(0.0) {
+    fGenerateADUs(generateADUs), fInterleaving(interleaving), fFileDuration(0.0), fSeekTable(NULL) {
 }
 
 MP3AudioFileServerMediaSubsession
 ::~MP3AudioFileServerMediaSubsession() {
   delete fInterleaving;
+  Medium::close(fSeekTable);
 }
 
 FramedSource* MP3AudioFileServerMediaSubsession
@@ -144,6 +152,7 @@ FramedSource* MP3AudioFileServerMediaSubsession
 ::createNewStreamSource(unsigned /*clientSessionId*/, unsigned& estBitrate) {
   MP3FileSource* mp3Source = MP3FileSource::createNew(envir(), fFileName);
   if (mp3Source == NULL) return NULL;
+  mp3Source->setSeekTable(fSeekTable);
   fFileDuration = mp3Source->filePlayTime();
 
   return createNewStreamSourceCommon(mp3Source, mp3Source->fileSize(), estBitrate);
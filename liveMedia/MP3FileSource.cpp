@@ -20,13 +20,16 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "MP3FileSource.hh"
 #include "MP3StreamState.hh"
+#include "MP3SeekTable.hh"
 #include "InputFile.hh"
 
+#define MP3_FILE_BUFFER_SIZE 65536
+
 ////////// MP3FileSource //////////
 
 MP3FileSource::MP3FileSource(UsageEnvironment& env, FILE* fid)
   : FramedFileSource(env, fid),
-    fStreamState(new MP3StreamState(env)) {
+    fStreamState(new MP3StreamState(env)), fSeekTable(NULL) {
 }
 
 MP3FileSource::~MP3FileSource() {
@@ -45,6 +48,11 @@ MP3FileSource* MP3FileSource::createNew(UsageEnvironment& env, char const* fileN
 
     fid = OpenInputFile(env, fileName);
     if (fid == NULL) break;
+#if !defined(_WIN32_WCE)
+    // We read each frame's header and data separately, so have the file read in large chunks.
+    // (We do this now, because "setvbuf()" must be called before any other I/O on "fid".)
+    if (fid != stdin) setvbuf(fid, NULL, _IOFBF, MP3_FILE_BUFFER_SIZE);
+#endif
 
     newSource = new MP3FileSource(env, fid);
     if (newSource == NULL) break;
@@ -61,6 +69,8 @@ MP3FileSource* MP3FileSource::createNew(UsageEnvironment& env, char const* fileN
 }
 
 float MP3FileSource::filePlayTime() const {
+  if (fSeekTable != NULL && fSeekTable->isComplete()) return fSeekTable->duration(); // exact
+
   return fStreamState->filePlayTime();
 }
 
@@ -87,14 +97,26 @@ void MP3FileSource::seekWithinFile(double seekNPT, double streamDuration) {
     streamDuration = fileDuration - seekNPT; 
   }
 
-  float seekFraction = (float)seekNPT/fileDuration;
-  unsigned seekByteNumber = fStreamState->getByteNumberFromPositionFraction(seekFraction);
+  Boolean const useSeekTable = fSeekTable != NULL && fSeekTable->isComplete();
+  unsigned seekByteNumber;
+  if (useSeekTable) {
+    // Seek exactly to the frame that's playing at "seekNPT":
+    seekByteNumber = fSeekTable->byteNumberFromNPT(seekNPT);
+  } else {
+    float seekFraction = (float)seekNPT/fileDuration;
+    seekByteNumber = fStreamState->getByteNumberFromPositionFraction(seekFraction);
+  }
   fStreamState->seekWithinFile(seekByteNumber);
 
   fLimitNumBytesToStream = False; // by default
   if (streamDuration > 0.0) {
-    float endFraction = (float)(seekNPT + streamDuration)/fileDuration;
-    unsigned endByteNumber = fStreamState->getByteNumberFromPositionFraction(endFraction);
+    unsigned endByteNumber;
+    if (useSeekTable) {
+      endByteNumber = fSeekTable->byteNumberFromNPT(seekNPT + streamDuration);
+    } else {
+      float endFraction = (float)(seekNPT + streamDuration)/fileDuration;
+      endByteNumber = fStreamState->getByteNumberFromPositionFraction(endFraction);
+    }
     if (endByteNumber > seekByteNumber) { // sanity check
       fNumBytesToStream = endByteNumber - seekByteNumber;
       fLimitNumBytesToStream = True;
@@ -230,6 +230,15 @@ unsigned ComputeFrameSize(unsigned bitrate, unsigned samplingFreq,
   return framesize;
 }
 
+Boolean MP3HeaderIsValid(unsigned hdr) {
+  return (hdr & 0xffe00000) == 0xffe00000 // sync word
+    && (hdr & 0x00060000) != 0 // not an undefined 'layer' field
+    && (hdr & 0x0000F000) != 0 // not a 'free format' bitrate index
+    && (hdr & 0x0000F000) != 0x0000F000 // not an undefined bitrate index
+    && (hdr & 0x00000C00) != 0x00000C00 // not an undefined frequency index
+    && (hdr & 0x00000003) == 0x00000000; // 'emphasis' field not set
+}
+
 #define TRUNC_FAIRLY
 static unsigned updateSideInfoSizes(MP3SideInfo& sideInfo, Boolean isMPEG2,
 				    unsigned char const* mainDataPtr,
@@ -125,6 +125,9 @@ unsigned ComputeFrameSize(unsigned bitrate, unsigned samplingFreq,
 			  Boolean usePadding, Boolean isMPEG2,
 			  unsigned char layer);
 
+Boolean MP3HeaderIsValid(unsigned hdr);
+    // True iff "hdr" looks like the 4-byte header of a (non 'free format') MPEG audio frame
+
 Boolean GetADUInfoFromMP3Frame(unsigned char const* framePtr,
 			       unsigned totFrameSize,
 			       unsigned& hdr, unsigned& frameSize,
@@ -318,6 +318,13 @@ static void rsfscanf(unsigned char **fi, unsigned int* v) {
 #define SIZEOF_HUFFBITS 4
 #define HTN     34
 #define MXOFF   250
+#define HUFFLOOKUPBITS 8 /* # of bits decoded by a single table lookup */
+
+struct huffdeclookup {
+  unsigned short point;	/*the tree node reached after "numBits" bits	*/
+  unsigned char numBits;
+  unsigned char isLeaf;	/*if 0 (and numBits == 0), walk the tree instead*/
+};
 
 struct huffcodetab {
   char tablename[3];	/*string, containing table_description	*/
@@ -330,6 +337,8 @@ struct huffcodetab {
   unsigned char *hlen;	/*pointer to array[xlen][ylen]		*/
   unsigned char(*val)[2];/*decoder tree				*/
   unsigned int treelen;	/*length of decoder tree		*/
+  struct huffdeclookup *lookup; /*decoder lookup table, indexed by the
+				  next HUFFLOOKUPBITS bits		*/
 };
 
 static struct huffcodetab rsf_ht[HTN]; // array of all huffcodetable headers
@@ -344,6 +353,7 @@ static int read_decoder_table(unsigned char* fi) {
   for (n=0;n<HTN;n++) {
     rsf_ht[n].table = NULL;
     rsf_ht[n].hlen = NULL;
+    rsf_ht[n].lookup = NULL;
 
     /* .table number treelen xlen ylen linbits */
     do {
@@ -417,6 +427,35 @@ static int read_decoder_table(unsigned char* fi) {
   return n;
 }
 
+/* build a table that decodes the first HUFFLOOKUPBITS bits of a code in a
+   single step, rather than walking the decoder tree one bit at a time */
+static void build_decoder_lookup_table(struct huffcodetab* h) {
+  if (h->val == NULL || h->treelen == 0) return;
+
+  h->lookup = new struct huffdeclookup[1<<HUFFLOOKUPBITS];
+  for (unsigned bits = 0; bits < (1<<HUFFLOOKUPBITS); ++bits) {
+    struct huffdeclookup& e = h->lookup[bits];
+    e.point = 0; e.numBits = 0; e.isLeaf = 0; // default: walk the tree
+
+    unsigned point = 0, numBits = 0;
+    while (point < h->treelen) {
+      if (h->val[point][0] == 0) { /*end of tree*/
+	e.point = point; e.numBits = numBits; e.isLeaf = 1;
+	break;
+      }
+      if (numBits == HUFFLOOKUPBITS) { /*continue from here, in the tree*/
+	e.point = point; e.numBits = numBits;
+	break;
+      }
+
+      unsigned bit = (bits >> (HUFFLOOKUPBITS-1-numBits)) & 1;
+      ++numBits;
+      while (point < h->treelen && h->val[point][bit] >= MXOFF) point += h->val[point][bit];
+      if (point < h->treelen) point += h->val[point][bit];
+    }
+  }
+}
+
 static void initialize_huffman() {
   static Boolean huffman_initialized = False;
 
@@ -428,6 +467,13 @@ static void initialize_huffman() {
 #endif
       return;
       }
+   for (int n = 0; n < HTN; ++n) {
+     if (rsf_ht[n].ref >= 0) {
+       rsf_ht[n].lookup = rsf_ht[rsf_ht[n].ref].lookup;
+     } else {
+       build_decoder_lookup_table(&rsf_ht[n]);
+     }
+   }
    huffman_initialized = True;
 }
 
@@ -624,7 +670,16 @@ static int rsf_huffman_decoder(BitVector& bv,
   /* table 0 needs no bits */
   if (h->treelen == 0) return 0;
 
-  /* Lookup in Huffman table. */
+  /* Lookup in Huffman table.  Begin by decoding (up to) the first
+     HUFFLOOKUPBITS bits at once; then walk the tree for any more: */
+  if (h->lookup != NULL) {
+    struct huffdeclookup const& e = h->lookup[bv.peekBits(HUFFLOOKUPBITS)];
+    if (e.numBits > 0 || e.isLeaf) {
+      bv.skipBits(e.numBits);
+      point = e.point;
+      level >>= e.numBits;
+    }
+  }
 
   do {
     if (h->val[point][0]==0) {   /*end of tree*/
@@ -761,39 +816,27 @@ unsigned MP3HuffmanEncode(MP3SideInfo::gr_info_s_t const* gr,
    return i;
 }
 
-static Boolean lookupHuffmanTableEntry(struct huffcodetab const* h,
-				       HUFFBITS bits, unsigned bitsLength,
-				       unsigned char& xy) {
-  unsigned point = 0;
-  unsigned mask = 1;
-  unsigned numBitsTestedSoFar = 0;
-  do {
-    if (h->val[point][0]==0) { // end of tree
-      xy = h->val[point][1];
-      if (h->hlen[xy] == 0) { // this entry hasn't already been used
-	h->table[xy] = bits;
-	h->hlen[xy] = bitsLength;
-	return True;
-      } else { // this entry has already been seen
-	return False;
-      }
-    }
+static void addHuffmanEncodingTableEntries(struct huffcodetab* h, unsigned point,
+					   HUFFBITS bits, unsigned bitsLength) {
+  if (point >= h->treelen || bitsLength > 8*SIZEOF_HUFFBITS) return; // shouldn't happen
 
-    if (numBitsTestedSoFar++ == bitsLength) {
-      // We don't yet have enough bits for this prefix
-      return False;
-    }
-    if (bits&mask) {
-      while (h->val[point][1] >= MXOFF) point += h->val[point][1];
-      point += h->val[point][1];
-    } else {
-      while (h->val[point][0] >= MXOFF) point += h->val[point][0];
-      point += h->val[point][0];
+  if (h->val[point][0]==0) { // end of tree
+    unsigned char xy = h->val[point][1];
+    if (h->hlen[xy] == 0 || bitsLength < h->hlen[xy]) { // use the shortest code for each entry
+      h->table[xy] = bits;
+      h->hlen[xy] = bitsLength;
     }
-    mask <<= 1;
-  } while (mask || (point < h->treelen));
+    return;
+  }
 
-  return False;
+  for (unsigned bit = 0; bit <= 1; ++bit) {
+    unsigned nextPoint = point;
+    while (nextPoint < h->treelen && h->val[nextPoint][bit] >= MXOFF) nextPoint += h->val[nextPoint][bit];
+    if (nextPoint >= h->treelen) continue;
+    nextPoint += h->val[nextPoint][bit];
+
+    addHuffmanEncodingTableEntries(h, nextPoint, (bits<<1)|bit, bitsLength+1);
+  }
 }
 
 static void buildHuffmanEncodingTable(struct huffcodetab* h) {
@@ -804,37 +847,14 @@ static void buildHuffmanEncodingTable(struct huffcodetab* h) {
     h->table[i] = 0; h->hlen[i] = 0;
   }
 
-  // Look up entries for each possible bit sequence length:
-  unsigned maxNumEntries = h->xlen * h->ylen;
-  unsigned numEntries = 0;
-  unsigned powerOf2 = 1;
-  for (unsigned bitsLength = 1;
-       bitsLength <= 8*SIZEOF_HUFFBITS; ++bitsLength) {
-    powerOf2 *= 2;
-    for (HUFFBITS bits = 0; bits < powerOf2; ++bits) {
-      // Find the table value - if any - for 'bits' (length 'bitsLength'):
-      unsigned char xy;
-      if (lookupHuffmanTableEntry(h, bits, bitsLength, xy)) {
-	++numEntries;
-	if (numEntries == maxNumEntries) return; // we're done
-      }
-    }
-  }
-#ifdef DEBUG
-  fprintf(stderr, "Didn't find enough entries!\n"); // shouldn't happen
-#endif
+  // Walk the decoder tree, noting the code for each entry.  (The codes are stored
+  // most-significant-bit first, so that each can be output using a single "putBits()".)
+  addHuffmanEncodingTableEntries(h, 0, 0, 0);
 }
 
 static void lookupXYandPutBits(BitVector& bv, struct huffcodetab const* h,
 			       unsigned char xy) {
-  HUFFBITS bits = h->table[xy];
-  unsigned bitsLength = h->hlen[xy];
-
-  // Note that "bits" is in reverse order, so read them from right-to-left:
-  while (bitsLength-- > 0) {
-    bv.put1Bit(bits&0x00000001);
-    bits >>= 1;
-  }
+  bv.putBits(h->table[xy], h->hlen[xy]);
 }
 
 static void putLinbits(BitVector& bv, struct huffcodetab const* h,
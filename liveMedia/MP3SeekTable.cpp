@@ -0,0 +1,253 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A table of the byte offsets of each frame in a MPEG (1 or 2) audio file, allowing exact seeking
+// by time - even within VBR files that have no Xing 'table of contents'.
+// Implementation
+
+#include "MP3SeekTable.hh"
+#include "MP3Internals.hh"
+#include "InputFile.hh"
+#include "OutputFile.hh"
+
+#define MILLION 1000000
+#define SCAN_BUFFER_SIZE 262144
+#define NUM_FRAMES_PER_SCAN_TASK 2000
+
+MP3SeekTable* MP3SeekTable::createNew(UsageEnvironment& env, char const* mp3FileName,
+				      Boolean scanInBackground) {
+  FILE* fid = OpenInputFile(env, mp3FileName);
+  if (fid == NULL) return NULL;
+
+  MP3SeekTable* seekTable = new MP3SeekTable(env, fid, (unsigned)GetFileSize(mp3FileName, fid));
+
+  // First, try to read the table from a 'sidecar' file:
+  unsigned const mp3FileNameLen = strlen(mp3FileName);
+  char* sidecarFileName = new char[mp3FileNameLen + 2];
+  sprintf(sidecarFileName, "%sx", mp3FileName);
+  Boolean haveReadTable = seekTable->readFromFile(sidecarFileName);
+  delete[] sidecarFileName;
+
+  if (haveReadTable) {
+    seekTable->finishScan(); // we don't need to scan the MP3 file
+  } else if (scanInBackground) {
+    seekTable->fScanTask = env.taskScheduler().scheduleDelayedTask(0, (TaskFunc*)scanTask, seekTable);
+  } else {
+    while (!seekTable->isComplete()) seekTable->scanSomeFrames();
+  }
+
+  return seekTable;
+}
+
+MP3SeekTable::MP3SeekTable(UsageEnvironment& env, FILE* mp3Fid, unsigned mp3FileSize)
+  : Medium(env),
+    fFileSize(mp3FileSize), fFrameOffsets(NULL), fNumFrames(0), fFrameOffsetsArraySize(0),
+    fFrameDurationInMicroseconds(0),
+    fScanFid(mp3Fid), fScanTask(NULL), fScanBuffer(new u_int8_t[SCAN_BUFFER_SIZE]),
+    fScanBufferFileOffset(0), fScanBufferSize(0), fScanOffset(0), fNumBytesSkipped(0) {
+}
+
+MP3SeekTable::~MP3SeekTable() {
+  finishScan();
+  delete[] fFrameOffsets;
+}
+
+float MP3SeekTable::duration() const {
+  return fNumFrames*(fFrameDurationInMicroseconds/(float)MILLION);
+}
+
+unsigned MP3SeekTable::byteNumberFromNPT(double npt) const {
+  if (npt <= 0.0 || fFrameDurationInMicroseconds == 0) return fNumFrames > 0 ? fFrameOffsets[0] : 0;
+
+  double frameNum = (npt*MILLION)/fFrameDurationInMicroseconds;
+  if (frameNum >= fNumFrames) return fFileSize;
+
+  return fFrameOffsets[(unsigned)frameNum];
+}
+
+// The table's file format is a sequence of 4-byte little-endian values: the size of the MP3 file,
+// followed by the byte offset of each frame:
+
+Boolean MP3SeekTable::writeToFile(char const* fileName) {
+  if (!isComplete()) return False;
+
+  FILE* fid = OpenOutputFile(envir(), fileName);
+  if (fid == NULL) return False;
+
+  Boolean success = True;
+  for (unsigned i = 0; i <= fNumFrames; ++i) {
+    u_int32_t value = i == 0 ? fFileSize : fFrameOffsets[i-1];
+    u_int8_t buf[4];
+    buf[0] = value; buf[1] = value>>8; buf[2] = value>>16; buf[3] = value>>24;
+    if (fwrite(buf, 1, 4, fid) != 4) {
+      success = False;
+      break;
+    }
+  }
+
+  CloseOutputFile(fid);
+  return success;
+}
+
+Boolean MP3SeekTable::readFromFile(char const* fileName) {
+  u_int64_t tableFileSize = GetFileSize(fileName, NULL);
+  if (tableFileSize < 8 || tableFileSize%4 != 0) return False;
+
+  FILE* fid = OpenInputFile(envir(), fileName);
+  if (fid == NULL) return False;
+
+  Boolean success = False;
+  do {
+    unsigned const numValues = (unsigned)(tableFileSize/4);
+    u_int8_t buf[4];
+    unsigned i;
+    for (i = 0; i < numValues; ++i) {
+      if (fread(buf, 1, 4, fid) != 4) break;
+      u_int32_t value = (buf[3]<<24)|(buf[2]<<16)|(buf[1]<<8)|buf[0];
+
+      if (i == 0) {
+	if (value != fFileSize) break; // the table is for a different (version of the) MP3 file
+      } else {
+	if (value >= fFileSize || (fNumFrames > 0 && value <= fFrameOffsets[fNumFrames-1])) break; // bad table
+	addFrame(value);
+      }
+    }
+    if (i < numValues) break;
+
+    // Get the frame duration from the first frame's header (which also checks that the table matches the file):
+    if (SeekFile64(fScanFid, fFrameOffsets[0], SEEK_SET) != 0) break;
+    if (fread(buf, 1, 4, fScanFid) != 4) break;
+    if (!setFrameDuration((buf[0]<<24)|(buf[1]<<16)|(buf[2]<<8)|buf[3])) break;
+
+    success = True;
+  } while (0);
+
+  CloseInputFile(fid);
+  if (!success) fNumFrames = 0;
+  return success;
+}
+
+Boolean MP3SeekTable::setFrameDuration(unsigned hdr) {
+  if (!MP3HeaderIsValid(hdr)) return False;
+
+  MP3FrameParams fr;
+  fr.hdr = hdr;
+  fr.setParamsFromHeader();
+
+  // Use the same frame duration as "MP3StreamState":
+  unsigned const numSamples = 1152;
+  unsigned const freq = fr.samplingFreq*(1 + fr.isMPEG2);
+  if (freq == 0) return False;
+  fFrameDurationInMicroseconds = ((numSamples*2*MILLION)/freq + 1)/2; // rounds to nearest integer
+
+  return True;
+}
+
+void MP3SeekTable::scanTask(void* clientData) {
+  MP3SeekTable* seekTable = (MP3SeekTable*)clientData;
+  seekTable->fScanTask = NULL;
+  seekTable->scanSomeFrames();
+  if (!seekTable->isComplete()) {
+    seekTable->fScanTask
+      = seekTable->envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)scanTask, seekTable);
+  }
+}
+
+void MP3SeekTable::scanSomeFrames() {
+  for (unsigned i = 0; i < NUM_FRAMES_PER_SCAN_TASK; ++i) {
+    if (!scanNextFrame()) {
+      finishScan();
+      break;
+    }
+  }
+}
+
+Boolean MP3SeekTable::scanNextFrame() {
+  // Find the next frame the same way that "MP3StreamState::findNextFrame()" does, so that the frames
+  // in our table are the same as those that "MP3FileSource" delivers:
+  while (1) {
+    if (!haveScanBytes(4)) return False;
+    u_int8_t const* p = &fScanBuffer[fScanOffset - fScanBufferFileOffset];
+    unsigned hdr = (p[0]<<24)|(p[1]<<16)|(p[2]<<8)|p[3];
+
+    if (MP3HeaderIsValid(hdr)) {
+      if (fScanOffset + 4 >= fFileSize) return False; // the frame has no data
+
+      MP3FrameParams fr;
+      fr.hdr = hdr;
+      fr.setParamsFromHeader();
+      if (fNumFrames == 0 && !setFrameDuration(hdr)) return False;
+
+      addFrame(fScanOffset);
+      fScanOffset += 4 + fr.frameSize;
+      fNumBytesSkipped = 0;
+      return True;
+    }
+
+    if (hdr == ('R'<<24)+('I'<<16)+('F'<<8)+'F') {
+      // Skip over a RIFF header:
+      fScanOffset += 70;
+      fNumBytesSkipped = 0;
+    } else if ((hdr&0xFFFFFF00) == ('I'<<24)+('D'<<16)+('3'<<8)) {
+      // Skip over an ID3 header:
+      if (!haveScanBytes(10)) return False;
+      p = &fScanBuffer[fScanOffset - fScanBufferFileOffset];
+      unsigned tagSize = ((p[6]&0x7F)<<21) + ((p[7]&0x7F)<<14) + ((p[8]&0x7F)<<7) + (p[9]&0x7F);
+      fScanOffset += 10 + tagSize;
+      fNumBytesSkipped = 0;
+    } else {
+      // Try again, from the next byte (but give up after 20,000 bytes):
+      if (fNumBytesSkipped++ >= 20000) return False;
+      ++fScanOffset;
+    }
+  }
+}
+
+Boolean MP3SeekTable::haveScanBytes(unsigned numBytes) {
+  if (fScanOffset >= fScanBufferFileOffset
+      && fScanOffset + numBytes <= fScanBufferFileOffset + fScanBufferSize) return True;
+
+  // Refill our buffer, starting at "fScanOffset":
+  if (fScanOffset >= fFileSize || SeekFile64(fScanFid, fScanOffset, SEEK_SET) != 0) return False;
+  fScanBufferFileOffset = fScanOffset;
+  fScanBufferSize = fread(fScanBuffer, 1, SCAN_BUFFER_SIZE, fScanFid);
+
+  return numBytes <= fScanBufferSize;
+}
+
+void MP3SeekTable::finishScan() {
+  envir().taskScheduler().unscheduleDelayedTask(fScanTask);
+  if (fScanFid != NULL) {
+    CloseInputFile(fScanFid);
+    fScanFid = NULL;
+  }
+  delete[] fScanBuffer; fScanBuffer = NULL;
+}
+
+void MP3SeekTable::addFrame(unsigned byteNumber) {
+  if (fNumFrames == fFrameOffsetsArraySize) {
+    // Enlarge our array:
+    unsigned newArraySize = fFrameOffsetsArraySize == 0 ? 1024 : 2*fFrameOffsetsArraySize;
+    u_int32_t* newFrameOffsets = new u_int32_t[newArraySize];
+    for (unsigned i = 0; i < fNumFrames; ++i) newFrameOffsets[i] = fFrameOffsets[i];
+    delete[] fFrameOffsets;
+    fFrameOffsets = newFrameOffsets;
+    fFrameOffsetsArraySize = newArraySize;
+  }
+
+  fFrameOffsets[fNumFrames++] = byteNumber;
+}
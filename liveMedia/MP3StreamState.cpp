@@ -57,6 +57,7 @@ void MP3StreamState::assignStream(FILE* fid, unsigned fileSize) {
     fFidIsReallyASocket = 0;
     fFileSize = fileSize;
   }
+  fFidIsSeekableFile = !fFidIsReallyASocket && fFileSize > 0;
   fNumFramesInFile = 0; // until we know otherwise
   fIsVBR = fHasXingTOC = False; // ditto
 
@@ -214,13 +215,7 @@ Boolean MP3StreamState::findNextFrame() {
 #ifdef DEBUG_PARSE
     fprintf(stderr, "init_resync: fr().hdr: 0x%08x\n", fr().hdr);
 #endif
-    if (   (fr().hdr & 0xffe00000) != 0xffe00000
-	|| (fr().hdr & 0x00060000) == 0 // undefined 'layer' field
-	|| (fr().hdr & 0x0000F000) == 0 // 'free format' bitrate index
-	|| (fr().hdr & 0x0000F000) == 0x0000F000 // undefined bitrate index
-	|| (fr().hdr & 0x00000C00) == 0x00000C00 // undefined frequency index
-	|| (fr().hdr & 0x00000003) != 0x00000000 // 'emphasis' field unexpectedly set
-       ) {
+    if (!MP3HeaderIsValid(fr().hdr)) {
       /* RSF: Do the following test even if we're not at the
 	 start of the file, in case we have two or more
 	 separate MP3 files cat'ed together:
@@ -385,7 +380,7 @@ unsigned MP3StreamState::readFromStream(unsigned char* buf,
     return totBytesRead;
   } else {
 #ifndef _WIN32_WCE
-    waitUntilSocketIsReadable(fEnv, (int)fileno(fFid));
+    if (!fFidIsSeekableFile) waitUntilSocketIsReadable(fEnv, (int)fileno(fFid));
 #endif
     return fread(buf, 1, numChars, fFid);
   }
@@ -76,6 +76,7 @@ private:
   UsageEnvironment& fEnv;
   FILE* fFid;
   Boolean fFidIsReallyASocket;
+  Boolean fFidIsSeekableFile; // if so, it's always readable, and we read it with a large buffer
   unsigned fFileSize;
   unsigned fNumFramesInFile;
   unsigned fPresentationTimeScale;
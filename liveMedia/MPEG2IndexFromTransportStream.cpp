@@ -103,6 +103,26 @@ UsageEnvironment& operator<<(UsageEnvironment& env, IndexRecord& r) {
 }
 #endif
 
+static void packIndexRecord(IndexRecord& r, u_int8_t* to) {
+  to[0] = (u_int8_t)(r.recordType());
+  to[1] = r.startOffset();
+  to[2] = r.size();
+  // Deliver the PCR, as 24 bits (integer part; little endian) + 8 bits (fractional part)
+  float pcr = r.pcr();
+  unsigned pcr_int = (unsigned)pcr;
+  u_int8_t pcr_frac = (u_int8_t)(256*(pcr-pcr_int));
+  to[3] = (unsigned char)(pcr_int);
+  to[4] = (unsigned char)(pcr_int>>8);
+  to[5] = (unsigned char)(pcr_int>>16);
+  to[6] = (unsigned char)(pcr_frac);
+  // Deliver the transport packet number (in little-endian order):
+  unsigned long tpn = r.transportPacketNumber();
+  to[7] = (unsigned char)(tpn);
+  to[8] = (unsigned char)(tpn>>8);
+  to[9] = (unsigned char)(tpn>>16);
+  to[10] = (unsigned char)(tpn>>24);
+}
+
 
 ////////// MPEG2IFrameIndexFromTransportStream implementation //////////
 
@@ -132,7 +152,9 @@ MPEG2IFrameIndexFromTransportStream
     fPMT_PID(0x10), fVideo_PID(0xE0), // default values
     fParseBufferSize(PARSE_BUFFER_SIZE),
     fParseBufferFrameStart(0), fParseBufferParseEnd(4), fParseBufferDataEnd(0),
-    fHeadIndexRecord(NULL), fTailIndexRecord(NULL) {
+    fNumInitialBadBytes(0),
+    fHeadIndexRecord(NULL), fTailIndexRecord(NULL),
+    fParseBufferOverflowed(False), fReportWarnings(True) {
   fParseBuffer = new unsigned char[fParseBufferSize];
 }
 
@@ -158,6 +180,7 @@ void MPEG2IFrameIndexFromTransportStream::doGetNextFrame() {
     compactParseBuffer();
     if (fParseBufferSize - fParseBufferDataEnd < TRANSPORT_PACKET_SIZE) {
       envir() << "ERROR: parse buffer full; increase MAX_FRAME_SIZE\n";
+      fParseBufferOverflowed = True;
       // Treat this as if the input source ended:
       handleInputClosure1();
       return;
@@ -197,28 +220,39 @@ void MPEG2IFrameIndexFromTransportStream
     return;
   }
 
+  if (!analyzeTransportPacket(fInputBuffer, True)) {
+    // Handle this as if the source ended:
+    handleInputClosure1();
+    return;
+  }
+
+  // Try again:
+  doGetNextFrame();
+}
+
+Boolean MPEG2IFrameIndexFromTransportStream
+::analyzeTransportPacket(unsigned char const* pkt, Boolean saveVideoData) {
   ++fInputTransportPacketCounter;
 
   // Figure out how much of this Transport Packet contains PES data:
-  u_int8_t adaptation_field_control = (fInputBuffer[3]&0x30)>>4;
+  u_int8_t adaptation_field_control = (pkt[3]&0x30)>>4;
   u_int8_t totalHeaderSize
-    = adaptation_field_control <= 1 ? 4 : 5 + fInputBuffer[4];
+    = adaptation_field_control <= 1 ? 4 : 5 + pkt[4];
   if ((adaptation_field_control == 2 && totalHeaderSize != TRANSPORT_PACKET_SIZE) ||
       (adaptation_field_control == 3 && totalHeaderSize >= TRANSPORT_PACKET_SIZE)) {
-    envir() << "Bad \"adaptation_field_length\": " << fInputBuffer[4] << "\n";
-    doGetNextFrame();
-    return;
+    if (fReportWarnings) envir() << "Bad \"adaptation_field_length\": " << pkt[4] << "\n";
+    return True;
   }
 
   // Check for a PCR:
-  if (totalHeaderSize > 5 && (fInputBuffer[5]&0x10) != 0) {
+  if (totalHeaderSize > 5 && (pkt[5]&0x10) != 0) {
     // There's a PCR:
     u_int32_t pcrBaseHigh
-      = (fInputBuffer[6]<<24)|(fInputBuffer[7]<<16)
-      |(fInputBuffer[8]<<8)|fInputBuffer[9];
+      = (pkt[6]<<24)|(pkt[7]<<16)
+      |(pkt[8]<<8)|pkt[9];
     float pcr = pcrBaseHigh/45000.0f;
-    if ((fInputBuffer[10]&0x80) != 0) pcr += 1/90000.0f; // add in low-bit (if set)
-    unsigned short pcrExt = ((fInputBuffer[10]&0x01)<<8) | fInputBuffer[11];
+    if ((pkt[10]&0x80) != 0) pcr += 1/90000.0f; // add in low-bit (if set)
+    unsigned short pcrExt = ((pkt[10]&0x01)<<8) | pkt[11];
     pcr += pcrExt/27000000.0f;
 
     if (!fHaveSeenFirstPCR) {
@@ -227,59 +261,60 @@ void MPEG2IFrameIndexFromTransportStream
     } else if (pcr < fLastPCR) {
       // The PCR timestamp has gone backwards.  Display a warning about this
       // (because it indicates buggy Transport Stream data), and compensate for it.
-      envir() << "\nWarning: At about " << fLastPCR-fFirstPCR
-	      << " seconds into the file, the PCR timestamp decreased - from "
-	      << fLastPCR << " to " << pcr << "\n";
+      if (fReportWarnings) {
+	envir() << "\nWarning: At about " << fLastPCR-fFirstPCR
+		<< " seconds into the file, the PCR timestamp decreased - from "
+		<< fLastPCR << " to " << pcr << "\n";
+      }
       fFirstPCR -= (fLastPCR - pcr);
     }
     fLastPCR = pcr;
   }
 
   // Get the PID from the packet, and check for special tables: the PAT and PMT:
-  u_int16_t PID = ((fInputBuffer[1]&0x1F)<<8) | fInputBuffer[2];
+  u_int16_t PID = ((pkt[1]&0x1F)<<8) | pkt[2];
   if (PID == PAT_PID) {
-    analyzePAT(&fInputBuffer[totalHeaderSize], TRANSPORT_PACKET_SIZE-totalHeaderSize);
+    analyzePAT(&pkt[totalHeaderSize], TRANSPORT_PACKET_SIZE-totalHeaderSize);
   } else if (PID == fPMT_PID) {
-    analyzePMT(&fInputBuffer[totalHeaderSize], TRANSPORT_PACKET_SIZE-totalHeaderSize);
+    analyzePMT(&pkt[totalHeaderSize], TRANSPORT_PACKET_SIZE-totalHeaderSize);
   }
 
   // Ignore transport packets for non-video programs,
   // or packets with no data, or packets that duplicate the previous packet:
-  u_int8_t continuity_counter = fInputBuffer[3]&0x0F;
+  u_int8_t continuity_counter = pkt[3]&0x0F;
   if ((PID != fVideo_PID) ||
       !(adaptation_field_control == 1 || adaptation_field_control == 3) ||
       continuity_counter == fLastContinuityCounter) {
-    doGetNextFrame();
-    return;
+    return True;
   }
   fLastContinuityCounter = continuity_counter;
 
   // Also, if this is the start of a PES packet, then skip over the PES header:
-  Boolean payload_unit_start_indicator = (fInputBuffer[1]&0x40) != 0;
+  Boolean payload_unit_start_indicator = (pkt[1]&0x40) != 0;
   if (payload_unit_start_indicator && totalHeaderSize < TRANSPORT_PACKET_SIZE - 8 
-      && fInputBuffer[totalHeaderSize] == 0x00 && fInputBuffer[totalHeaderSize+1] == 0x00
-      && fInputBuffer[totalHeaderSize+2] == 0x01) {
-    u_int8_t PES_header_data_length = fInputBuffer[totalHeaderSize+8];
+      && pkt[totalHeaderSize] == 0x00 && pkt[totalHeaderSize+1] == 0x00
+      && pkt[totalHeaderSize+2] == 0x01) {
+    u_int8_t PES_header_data_length = pkt[totalHeaderSize+8];
     totalHeaderSize += 9 + PES_header_data_length;
     if (totalHeaderSize >= TRANSPORT_PACKET_SIZE) {
-      envir() << "Unexpectedly large PES header size: " << PES_header_data_length << "\n";
+      if (fReportWarnings) {
+	envir() << "Unexpectedly large PES header size: " << PES_header_data_length << "\n";
+      }
       // Handle this as if the source ended:
-      handleInputClosure1();
-      return;
+      return False;
     }
   }
+  if (!saveVideoData) return True;
 
   // The remaining data is Video Elementary Stream data.  Add it to our parse buffer:
   unsigned vesSize = TRANSPORT_PACKET_SIZE - totalHeaderSize;
-  memmove(&fParseBuffer[fParseBufferDataEnd], &fInputBuffer[totalHeaderSize], vesSize);
+  memmove(&fParseBuffer[fParseBufferDataEnd], &pkt[totalHeaderSize], vesSize);
   fParseBufferDataEnd += vesSize;
 
   // And add a new index record noting where it came from:
   addToTail(new IndexRecord(totalHeaderSize, vesSize, fInputTransportPacketCounter,
 			    fLastPCR - fFirstPCR));
-
-  // Try again:
-  doGetNextFrame();
+  return True;
 }
 
 void MPEG2IFrameIndexFromTransportStream::handleInputClosure(void* clientData) {
@@ -296,6 +331,16 @@ void MPEG2IFrameIndexFromTransportStream::handleInputClosure(void* clientData) {
 #define VOP_START_CODE 0xB6			// MPEG-4
 
 void MPEG2IFrameIndexFromTransportStream::handleInputClosure1() {
+  if (appendEndOfStreamCode()) {
+    // Try again:
+    doGetNextFrame();
+  } else {
+    // Handle closure in the regular way:
+    handleClosure();
+  }
+}
+
+Boolean MPEG2IFrameIndexFromTransportStream::appendEndOfStreamCode() {
   if (++fClosureNumber == 1 && fParseBufferDataEnd > fParseBufferFrameStart
       && fParseBufferDataEnd <= fParseBufferSize - 4) {
     // This is the first time we saw EOF, and there's still data remaining to be
@@ -305,17 +350,89 @@ void MPEG2IFrameIndexFromTransportStream::handleInputClosure1() {
     fParseBuffer[fParseBufferDataEnd++] = 0;
     fParseBuffer[fParseBufferDataEnd++] = 1;
     fParseBuffer[fParseBufferDataEnd++] = PICTURE_START_CODE;
+    return True;
+  }
 
-    // Try again:
-    doGetNextFrame();
-  } else {
-    // Handle closure in the regular way:
-    handleClosure();
+  return False;
+}
+
+Boolean MPEG2IFrameIndexFromTransportStream
+::indexTransportPacket(unsigned char const* pkt, Boolean analyzeOnly) {
+  if (pkt[0] != TRANSPORT_SYNC_BYTE) {
+    if (fReportWarnings) envir() << "Bad TS sync byte: 0x" << pkt[0] << "\n";
+    return False;
   }
+  if (analyzeOnly) return analyzeTransportPacket(pkt, False);
+
+  // Make sure that there's room for the packet's data, as "doGetNextFrame()" does:
+  if (fParseBufferSize - fParseBufferDataEnd < TRANSPORT_PACKET_SIZE) {
+    compactParseBuffer();
+    if (fParseBufferSize - fParseBufferDataEnd < TRANSPORT_PACKET_SIZE) {
+      envir() << "ERROR: parse buffer full; increase MAX_FRAME_SIZE\n";
+      fParseBufferOverflowed = True;
+      return False;
+    }
+  }
+
+  return analyzeTransportPacket(pkt, True);
+}
+
+Boolean MPEG2IFrameIndexFromTransportStream::indexEndOfStream() {
+  return appendEndOfStreamCode();
+}
+
+Boolean MPEG2IFrameIndexFromTransportStream::getNextIndexRecord(u_int8_t* to) {
+  do {
+    IndexRecord* head = removeParsedIndexRecord();
+    if (head != NULL) {
+      packIndexRecord(*head, to);
+      delete head;
+      return True;
+    }
+  } while (parseFrame());
+
+  return False;
+}
+
+void MPEG2IFrameIndexFromTransportStream::getStreamState(StreamState& state) const {
+  state.lastTransportPacketNumber = fInputTransportPacketCounter;
+  state.firstPCR = fFirstPCR;
+  state.lastPCR = fLastPCR;
+  state.haveSeenFirstPCR = fHaveSeenFirstPCR;
+  state.PMT_PID = fPMT_PID;
+  state.video_PID = fVideo_PID;
+  state.lastContinuityCounter = fLastContinuityCounter;
+  state.isH264 = fIsH264;
+  state.isH265 = fIsH265;
+  state.closureNumber = fClosureNumber;
+}
+
+void MPEG2IFrameIndexFromTransportStream::setStreamState(StreamState const& state) {
+  fInputTransportPacketCounter = state.lastTransportPacketNumber;
+  fFirstPCR = state.firstPCR;
+  fLastPCR = state.lastPCR;
+  fHaveSeenFirstPCR = state.haveSeenFirstPCR;
+  fPMT_PID = state.PMT_PID;
+  fVideo_PID = state.video_PID;
+  fLastContinuityCounter = state.lastContinuityCounter;
+  fIsH264 = state.isH264;
+  fIsH265 = state.isH265;
+  fClosureNumber = state.closureNumber;
+}
+
+Boolean MPEG2IFrameIndexFromTransportStream
+::streamStatesAreEqual(StreamState const& s1, StreamState const& s2) {
+  return s1.lastTransportPacketNumber == s2.lastTransportPacketNumber
+    && s1.firstPCR == s2.firstPCR && s1.lastPCR == s2.lastPCR
+    && s1.haveSeenFirstPCR == s2.haveSeenFirstPCR
+    && s1.PMT_PID == s2.PMT_PID && s1.video_PID == s2.video_PID
+    && s1.lastContinuityCounter == s2.lastContinuityCounter
+    && s1.isH264 == s2.isH264 && s1.isH265 == s2.isH265
+    && s1.closureNumber == s2.closureNumber;
 }
 
 void MPEG2IFrameIndexFromTransportStream
-::analyzePAT(unsigned char* pkt, unsigned size) {
+::analyzePAT(unsigned char const* pkt, unsigned size) {
   // Get the PMT_PID:
   while (size >= 17) { // The table is large enough
     u_int16_t program_number = (pkt[9]<<8) | pkt[10];
@@ -329,7 +446,7 @@ void MPEG2IFrameIndexFromTransportStream
 }
 
 void MPEG2IFrameIndexFromTransportStream
-::analyzePMT(unsigned char* pkt, unsigned size) {
+::analyzePMT(unsigned char const* pkt, unsigned size) {
   // Scan the "elementary_PID"s in the map, until we see the first video stream.
 
   // First, get the "section_length", to get the table's size:
@@ -362,54 +479,43 @@ void MPEG2IFrameIndexFromTransportStream
   }
 }
 
-Boolean MPEG2IFrameIndexFromTransportStream::deliverIndexRecord() {
-  IndexRecord* head = fHeadIndexRecord;
-  if (head == NULL) return False;
+IndexRecord* MPEG2IFrameIndexFromTransportStream::removeParsedIndexRecord() {
+  while (1) {
+    IndexRecord* head = fHeadIndexRecord;
+    if (head == NULL) return NULL;
 
-  // Check whether the head record has been parsed yet:
-  if (head->recordType() == RECORD_UNPARSED) return False;
+    // Check whether the head record has been parsed yet:
+    if (head->recordType() == RECORD_UNPARSED) return NULL;
 
-  // Remove the head record (the one whose data we'll be delivering):
-  IndexRecord* next = head->next();
-  head->unlink();
-  if (next == head) {
-    fHeadIndexRecord = fTailIndexRecord = NULL;
-  } else {
-    fHeadIndexRecord = next;
-  }
+    // Remove the head record (the one whose data we'll be delivering):
+    IndexRecord* next = head->next();
+    head->unlink();
+    if (next == head) {
+      fHeadIndexRecord = fTailIndexRecord = NULL;
+    } else {
+      fHeadIndexRecord = next;
+    }
+
+    if (head->recordType() != RECORD_JUNK) return head;
 
-  if (head->recordType() == RECORD_JUNK) {
-    // Don't actually deliver the data to the client:
+    // Don't actually deliver the data to the client; try the next record instead:
     delete head;
-    // Try to deliver the next record instead:
-    return deliverIndexRecord();
   }
+}
+
+Boolean MPEG2IFrameIndexFromTransportStream::deliverIndexRecord() {
+  IndexRecord* head = removeParsedIndexRecord();
+  if (head == NULL) return False;
 
   // Deliver data from the head record:
 #ifdef DEBUG
   envir() << "delivering: " << *head << "\n";
 #endif
-  if (fMaxSize < 11) {
+  if (fMaxSize < INDEX_RECORD_SIZE) {
     fFrameSize = 0;
   } else {
-    fTo[0] = (u_int8_t)(head->recordType());
-    fTo[1] = head->startOffset();
-    fTo[2] = head->size();
-    // Deliver the PCR, as 24 bits (integer part; little endian) + 8 bits (fractional part)
-    float pcr = head->pcr();
-    unsigned pcr_int = (unsigned)pcr;
-    u_int8_t pcr_frac = (u_int8_t)(256*(pcr-pcr_int));
-    fTo[3] = (unsigned char)(pcr_int);
-    fTo[4] = (unsigned char)(pcr_int>>8);
-    fTo[5] = (unsigned char)(pcr_int>>16);
-    fTo[6] = (unsigned char)(pcr_frac);
-    // Deliver the transport packet number (in little-endian order):
-    unsigned long tpn = head->transportPacketNumber();
-    fTo[7] = (unsigned char)(tpn);
-    fTo[8] = (unsigned char)(tpn>>8);
-    fTo[9] = (unsigned char)(tpn>>16);
-    fTo[10] = (unsigned char)(tpn>>24);
-    fFrameSize = 11;
+    packIndexRecord(*head, fTo);
+    fFrameSize = INDEX_RECORD_SIZE;
   }
 
   // Free the (former) head record (as we're now done with it):
@@ -430,7 +536,6 @@ Boolean MPEG2IFrameIndexFromTransportStream::parseFrame() {
 
   // Inspect the frame's initial 4-byte code, to make sure it starts with a system code:
   if (fParseBufferDataEnd-fParseBufferFrameStart < 4) return False; // not enough data
-  unsigned numInitialBadBytes = 0;
   unsigned char const* p = &fParseBuffer[fParseBufferFrameStart];
   if (!(p[0] == 0 && p[1] == 0 && p[2] == 1)) {
     // There's no system code at the beginning.  Parse until we find one:
@@ -441,7 +546,9 @@ Boolean MPEG2IFrameIndexFromTransportStream::parseFrame() {
     unsigned char nextCode;
     if (!parseToNextCode(nextCode)) return False;
 
-    numInitialBadBytes = fParseBufferParseEnd - fParseBufferFrameStart;
+    // Note: We remember the number of bad bytes, because we might not get to parse the
+    // (rest of the) frame until a later call:
+    fNumInitialBadBytes += fParseBufferParseEnd - fParseBufferFrameStart;
     fParseBufferFrameStart = fParseBufferParseEnd;
     fParseBufferParseEnd += 4; // skip over the code that we just saw
     p = &fParseBuffer[fParseBufferFrameStart];
@@ -554,6 +661,8 @@ Boolean MPEG2IFrameIndexFromTransportStream::parseFrame() {
 
   // There is now a parsed 'frame', from "fParseBufferFrameStart"
   // to "fParseBufferParseEnd". Tag the corresponding index records to note this:
+  unsigned numInitialBadBytes = fNumInitialBadBytes;
+  fNumInitialBadBytes = 0;
   unsigned frameSize = fParseBufferParseEnd - fParseBufferFrameStart + numInitialBadBytes;
 #ifdef DEBUG
   envir() << "parsed " << recordTypeStr[curRecordType] << "; length "
@@ -45,9 +45,8 @@ MPEG2TransportFileServerMediaSubsession
 					  MPEG2TransportStreamIndexFile* indexFile,
 					  Boolean reuseFirstSource)
   : FileServerMediaSubsession(env, fileName, reuseFirstSource),
-    fIndexFile(indexFile), fDuration(0.0), fClientSessionHashTable(NULL) {
+    fIndexFile(indexFile), fClientSessionHashTable(NULL) {
   if (fIndexFile != NULL) { // we support 'trick play'
-    fDuration = fIndexFile->getPlayingDuration();
     fClientSessionHashTable = HashTable::create(ONE_WORD_HASH_KEYS);
   }
 }
@@ -166,12 +165,16 @@ FramedSource* MPEG2TransportFileServerMediaSubsession
   fFileSize = fileSource->fileSize();
 
   // Use the file size and the duration to estimate the stream's bitrate:
-  if (fFileSize > 0 && fDuration > 0.0) {
-    estBitrate = (unsigned)((int64_t)fFileSize/(125*fDuration) + 0.5); // kbps, rounded
+  float const fileDuration = duration();
+  if (fFileSize > 0 && fileDuration > 0.0) {
+    estBitrate = (unsigned)((int64_t)fFileSize/(125*fileDuration) + 0.5); // kbps, rounded
   } else {
     estBitrate = 5000; // kbps, estimate
   }
 
+  // Read the file without blocking (even if it's on slow storage), and have the OS fetch data ahead of us,
+  // based on the bitrate:
+  fileSource->useAsynchronousReads(estBitrate);
 
   // Create a framer for the Transport Stream:
   MPEG2TransportStreamFramer* framer
@@ -200,7 +203,7 @@ RTPSink* MPEG2TransportFileServerMediaSubsession
 }
 
 void MPEG2TransportFileServerMediaSubsession::testScaleFactor(float& scale) {
-  if (fIndexFile != NULL && fDuration > 0.0) {
+  if (fIndexFile != NULL && duration() > 0.0) {
     // We support any integral scale, other than 0
     int iScale = scale < 0.0 ? (int)(scale - 0.5f) : (int)(scale + 0.5f); // round
     if (iScale == 0) iScale = 1;
@@ -211,7 +214,12 @@ void MPEG2TransportFileServerMediaSubsession::testScaleFactor(float& scale) {
 }
 
 float MPEG2TransportFileServerMediaSubsession::duration() const {
-  return fDuration;
+  if (fIndexFile == NULL) return 0.0f;
+
+  // The index file might still be growing (if the Transport Stream file is still being recorded),
+  // so pick up any new index records before computing the duration:
+  fIndexFile->checkForNewIndexRecords();
+  return fIndexFile->getPlayingDuration();
 }
 
 ClientTrickPlayState* MPEG2TransportFileServerMediaSubsession
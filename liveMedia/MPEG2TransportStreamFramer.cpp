@@ -24,6 +24,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include <GroupsockHelper.hh> // for "gettimeofday()"
 
 #define TRANSPORT_PACKET_SIZE 188
+#define NUM_PIDS 0x2000
 
 ////////// Definitions of constants that control the behavior of this code /////////
 
@@ -48,6 +49,11 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #define PCR_PERIOD_VARIATION_RATIO 0.5
 #endif
 
+#if !defined(MAX_PCR_INTERVAL)
+#define MAX_PCR_INTERVAL 1.0 // (seconds)
+  // When CBR pacing, a larger (or negative) gap between successive PCRs is treated as a discontinuity
+#endif
+
 ////////// PIDStatus //////////
 
 class PIDStatus {
@@ -75,20 +81,33 @@ MPEG2TransportStreamFramer
   : FramedFilter(env, inputSource),
     fTSPacketCount(0), fTSPacketDurationEstimate(0.0), fTSPCRCount(0),
     fLimitNumTSPacketsToStream(False), fNumTSPacketsToStream(0),
-    fLimitTSPacketsToStreamByPCR(False), fPCRLimit(0.0) {
-  fPIDStatusTable = HashTable::create(ONE_WORD_HASH_KEYS);
+    fLimitTSPacketsToStreamByPCR(False), fPCRLimit(0.0),
+    fNumTSPacketsPerPacedFrame(0) {
+  fPIDStatusTable = new PIDStatus*[NUM_PIDS];
+  for (unsigned i = 0; i < NUM_PIDS; ++i) fPIDStatusTable[i] = NULL;
+  clearPIDStatusTable(); // also resets our pacing state
 }
 
 MPEG2TransportStreamFramer::~MPEG2TransportStreamFramer() {
   clearPIDStatusTable();
-  delete fPIDStatusTable;
+  delete[] fPIDStatusTable;
+}
+
+Boolean MPEG2TransportStreamFramer::isMPEG2TransportStreamFramer() const {
+  return True;
 }
 
 void MPEG2TransportStreamFramer::clearPIDStatusTable() {
-  PIDStatus* pidStatus;
-  while ((pidStatus = (PIDStatus*)fPIDStatusTable->RemoveNext()) != NULL) {
-    delete pidStatus;
+  for (unsigned i = 0; i < NUM_PIDS; ++i) {
+    delete fPIDStatusTable[i]; fPIDStatusTable[i] = NULL;
   }
+
+  fPacingPID = -1;
+  fPacingPCR = fPacingClock = 0.0;
+  fPacingPacketNum = 0;
+  fPacingPacketDuration = 0.0;
+  fPacingTime = 0.0;
+  fHavePacingTime = False;
 }
 
 void MPEG2TransportStreamFramer::setNumTSPacketsToStream(unsigned long numTSRecordsToStream) {
@@ -101,6 +120,10 @@ void MPEG2TransportStreamFramer::setPCRLimit(float pcrLimit) {
   fLimitTSPacketsToStreamByPCR = pcrLimit != 0.0;
 }
 
+void MPEG2TransportStreamFramer::enableCBRPacing(unsigned numTSPacketsPerFrame) {
+  fNumTSPacketsPerPacedFrame = numTSPacketsPerFrame;
+}
+
 void MPEG2TransportStreamFramer::doGetNextFrame() {
   if (fLimitNumTSPacketsToStream) {
     if (fNumTSPacketsToStream == 0) {
@@ -111,6 +134,13 @@ void MPEG2TransportStreamFramer::doGetNextFrame() {
       fMaxSize = fNumTSPacketsToStream*TRANSPORT_PACKET_SIZE;
     }
   }
+  if (fNumTSPacketsPerPacedFrame > 0) {
+    if (fNumTSPacketsPerPacedFrame*TRANSPORT_PACKET_SIZE < fMaxSize) {
+      fMaxSize = fNumTSPacketsPerPacedFrame*TRANSPORT_PACKET_SIZE;
+    } else if (fMaxSize >= TRANSPORT_PACKET_SIZE) {
+      fMaxSize -= fMaxSize%TRANSPORT_PACKET_SIZE; // so that we read only whole packets
+    }
+  }
 
   // Read directly from our input source into our client's buffer:
   fFrameSize = 0;
@@ -136,11 +166,34 @@ void MPEG2TransportStreamFramer
   framer->afterGettingFrame1(frameSize, presentationTime);
 }
 
+void MPEG2TransportStreamFramer::handleInputClosure(void* clientData) {
+  MPEG2TransportStreamFramer* framer = (MPEG2TransportStreamFramer*)clientData;
+  framer->handleInputClosure1();
+}
+
+void MPEG2TransportStreamFramer::handleInputClosure1() {
+  if (fFrameSize > 0) {
+    // Our input closed while we were filling a CBR-paced frame.  Deliver what we already have, as a final
+    // (short) frame; we'll be told of the closure again when we next read:
+    afterGettingFrame1(0, fPresentationTime);
+  } else {
+    handleClosure();
+  }
+}
+
 #define TRANSPORT_SYNC_BYTE 0x47
 
 void MPEG2TransportStreamFramer::afterGettingFrame1(unsigned frameSize,
 						    struct timeval presentationTime) {
   fFrameSize += frameSize;
+  if (fNumTSPacketsPerPacedFrame > 0 && frameSize > 0 && fFrameSize < fMaxSize) {
+    // When CBR pacing, we deliver only full frames (except at the end of the stream).  Read more:
+    fPresentationTime = presentationTime; // in case our input closes before we can fill the frame
+    fInputSource->getNextFrame(&fTo[fFrameSize], fMaxSize - fFrameSize,
+			       afterGettingFrame, this,
+			       handleInputClosure, this);
+    return;
+  }
   unsigned const numTSPackets = fFrameSize/TRANSPORT_PACKET_SIZE;
   fNumTSPacketsToStream -= numTSPackets;
   fFrameSize = numTSPackets*TRANSPORT_PACKET_SIZE; // an integral # of TS packets
@@ -185,8 +238,12 @@ void MPEG2TransportStreamFramer::afterGettingFrame1(unsigned frameSize,
     }
   }
 
-  fDurationInMicroseconds
-    = numTSPackets * (unsigned)(fTSPacketDurationEstimate*1000000);
+  if (fNumTSPacketsPerPacedFrame > 0 && fPacingPacketDuration > 0.0) {
+    fDurationInMicroseconds = pacedFrameDuration(numTSPackets);
+  } else {
+    fDurationInMicroseconds
+      = numTSPackets * (unsigned)(fTSPacketDurationEstimate*1000000);
+  }
 
   // Complete the delivery to our client:
   afterGetting(this);
@@ -229,13 +286,14 @@ Boolean MPEG2TransportStreamFramer::updateTSPacketDurationEstimate(unsigned char
 
   unsigned pid = ((pkt[1]&0x1F)<<8) | pkt[2];
 
+  if (fNumTSPacketsPerPacedFrame > 0) updatePacingClock(pid, clock, discontinuity_indicator != 0);
+
   // Check whether we already have a record of a PCR for this PID:
-  PIDStatus* pidStatus = (PIDStatus*)(fPIDStatusTable->Lookup((char*)pid));
+  PIDStatus* pidStatus = fPIDStatusTable[pid];
 
   if (pidStatus == NULL) {
     // We're seeing this PID's PCR for the first time:
-    pidStatus = new PIDStatus(clock, timeNow);
-    fPIDStatusTable->Add((char*)pid, pidStatus);
+    pidStatus = fPIDStatusTable[pid] = new PIDStatus(clock, timeNow);
 #ifdef DEBUG_PCR
     fprintf(stderr, "PID 0x%x, FIRST PCR 0x%08x+%d:%03x == %f @ %f, pkt #%lu\n", pid, pcrBaseHigh, pkt[10]>>7, pcrExt, clock, timeNow, fTSPacketCount);
 #endif
@@ -288,3 +346,59 @@ Boolean MPEG2TransportStreamFramer::updateTSPacketDurationEstimate(unsigned char
 
   return True;
 }
+
+void MPEG2TransportStreamFramer::updatePacingClock(u_int16_t pid, double clock, Boolean isDiscontinuity) {
+  if (fPacingPID < 0) {
+    // This is the first PCR that we've seen; we pace from this PID's PCRs from now on.
+    // (PCRs on different PIDs can come from unrelated clocks.)
+    fPacingPID = pid;
+    fPacingPCR = fPacingClock = clock;
+    fPacingPacketNum = fTSPacketCount;
+    return;
+  }
+  if (pid != fPacingPID) return;
+
+  int64_t packetsSinceLast = (int64_t)(fTSPacketCount - fPacingPacketNum);
+  double pcrDelta = clock - fPacingPCR;
+  if (isDiscontinuity || pcrDelta <= 0.0 || pcrDelta > MAX_PCR_INTERVAL) {
+    // The PCR has jumped (or wrapped around).  Keep our timeline continuous, by extrapolating
+    // at the previous rate:
+    pcrDelta = packetsSinceLast*fPacingPacketDuration;
+  } else if (packetsSinceLast > 0) {
+    fPacingPacketDuration = pcrDelta/packetsSinceLast;
+  }
+
+  fPacingPCR = clock;
+  fPacingClock += pcrDelta;
+  fPacingPacketNum = fTSPacketCount;
+}
+
+unsigned MPEG2TransportStreamFramer::pacedFrameDuration(unsigned numTSPackets) {
+  // Interpolate (from the last PCR) the time at which the packet that follows this frame is due:
+  int64_t packetsSinceLastPCR = (int64_t)(fTSPacketCount - fPacingPacketNum);
+  double nextFrameTime = fPacingClock + (packetsSinceLastPCR+1)*fPacingPacketDuration;
+
+  if (!fHavePacingTime) {
+    fPacingTime = nextFrameTime - numTSPackets*fPacingPacketDuration;
+    fHavePacingTime = True;
+  }
+
+  // Our duration is the time from where the previous frame's duration left off.  Because we accumulate
+  // durations this way (rather than per-packet estimates), errors don't build up over time:
+  double duration = nextFrameTime - fPacingTime;
+  if (duration < 0.0) {
+    duration = 0.0; // we're behind the PCR timeline (e.g., because its rate dropped)
+  } else if (duration > MAX_PCR_INTERVAL) {
+    // Something's wrong (we must have missed a discontinuity); resynchronize:
+    duration = numTSPackets*fPacingPacketDuration;
+    fPacingTime = nextFrameTime - duration;
+  }
+
+  unsigned durationInMicroseconds = (unsigned)(duration*1000000);
+  fPacingTime += durationInMicroseconds/1000000.0; // so that rounding errors don't accumulate either
+#ifdef DEBUG_PCR
+  fprintf(stderr, "paced frame of %d packets: duration %d us (packet duration %f)\n", numTSPackets, durationInMicroseconds, fPacingPacketDuration);
+#endif
+
+  return durationInMicroseconds;
+}
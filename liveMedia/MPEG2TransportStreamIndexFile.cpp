@@ -25,10 +25,12 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "InputFile.hh"
 
 MPEG2TransportStreamIndexFile
-::MPEG2TransportStreamIndexFile(UsageEnvironment& env, char const* indexFileName)
+::MPEG2TransportStreamIndexFile(UsageEnvironment& env, char const* indexFileName, Boolean useMemoryMapping)
   : Medium(env),
     fFileName(strDup(indexFileName)), fFid(NULL), fMPEGVersion(0), fCurrentIndexRecordNum(0),
-    fCachedPCR(0.0f), fCachedTSPacketNumber(0), fNumIndexRecords(0) {
+    fCachedPCR(0.0f), fCachedTSPacketNumber(0), fNumIndexRecords(0),
+    fMappedIndexRecords(NULL), fMappedSize(0), fFrameStartRecordNums(NULL), fNumFrameStarts(0),
+    fHaveTriedToBuildFrameStartTable(False), fUseMemoryMapping(useMemoryMapping) {
   // Get the file size, to determine how many index records it contains:
   u_int64_t indexFileSize = GetFileSize(indexFileName, NULL);
   if (indexFileSize % INDEX_RECORD_SIZE != 0) {
@@ -38,25 +40,27 @@ MPEG2TransportStreamIndexFile
 	<< INDEX_RECORD_SIZE << ")\n";
   }
   fNumIndexRecords = (unsigned long)(indexFileSize/INDEX_RECORD_SIZE);
+
+  mapIndexRecords();
 }
 
 MPEG2TransportStreamIndexFile* MPEG2TransportStreamIndexFile
-::createNew(UsageEnvironment& env, char const* indexFileName) {
+::createNew(UsageEnvironment& env, char const* indexFileName, Boolean useMemoryMapping) {
   if (indexFileName == NULL) return NULL;
-  MPEG2TransportStreamIndexFile* indexFile
-    = new MPEG2TransportStreamIndexFile(env, indexFileName);
 
-  // Reject empty or non-existent index files:
-  if (indexFile->getPlayingDuration() == 0.0f) {
-    delete indexFile;
-    indexFile = NULL;
-  }
+  // Reject non-existent index files.  (An index file that exists, but is - so far - empty is OK,
+  // because it might still be growing, if its Transport Stream file is still being recorded.)
+  FILE* fid = OpenInputFile(env, indexFileName);
+  if (fid == NULL) return NULL;
+  CloseInputFile(fid);
 
-  return indexFile;
+  return new MPEG2TransportStreamIndexFile(env, indexFileName, useMemoryMapping);
 }
 
 MPEG2TransportStreamIndexFile::~MPEG2TransportStreamIndexFile() {
   closeFid();
+  UnmapInputFile(fMappedIndexRecords, fMappedSize);
+  delete[] fFrameStartRecordNums;
   delete[] fFileName;
 }
 
@@ -209,12 +213,61 @@ Boolean MPEG2TransportStreamIndexFile
   return True;
 }
 
+Boolean MPEG2TransportStreamIndexFile::findNextFrameStart(unsigned long& indexRecordNum, int direction) {
+  if (indexRecordNum >= fNumIndexRecords) return False; // we're already off one end of the index file
+  if (!buildFrameStartTable()) return True; // we can't do better than the caller reading each record in turn
+
+  // Binary search for the first table entry >= "indexRecordNum":
+  unsigned long lo = 0, hi = fNumFrameStarts;
+  while (lo < hi) {
+    unsigned long mid = lo + (hi-lo)/2;
+    if (fFrameStartRecordNums[mid] < indexRecordNum) lo = mid+1; else hi = mid;
+  }
+
+  if (direction > 0) {
+    if (lo == fNumFrameStarts) return False;
+    indexRecordNum = fFrameStartRecordNums[lo];
+  } else {
+    if (lo < fNumFrameStarts && fFrameStartRecordNums[lo] == indexRecordNum) return True;
+    if (lo == 0) return False;
+    indexRecordNum = fFrameStartRecordNums[lo-1];
+  }
+  return True;
+}
+
 float MPEG2TransportStreamIndexFile::getPlayingDuration() {
   if (fNumIndexRecords == 0 || !readOneIndexRecord(fNumIndexRecords-1)) return 0.0f;
 
   return pcrFromBuf();
 }
 
+Boolean MPEG2TransportStreamIndexFile::checkForNewIndexRecords() {
+  u_int64_t indexFileSize = GetFileSize(fFileName, NULL);
+  unsigned long numIndexRecords = (unsigned long)(indexFileSize/INDEX_RECORD_SIZE);
+      // (Any partial record at the end of the file is still being written; ignore it for now.)
+  if (numIndexRecords <= fNumIndexRecords) return False;
+
+  unsigned long oldNumIndexRecords = fNumIndexRecords;
+  fNumIndexRecords = numIndexRecords;
+
+  // Remap the index file, to include the new records:
+  closeFid();
+  UnmapInputFile(fMappedIndexRecords, fMappedSize);
+  fMappedIndexRecords = NULL; fMappedSize = 0;
+  mapIndexRecords();
+
+  // If we've already built our frame start table, then add the new records' frame starts to it:
+  if (fHaveTriedToBuildFrameStartTable) {
+    if (fFrameStartRecordNums != NULL) {
+      addToFrameStartTable(oldNumIndexRecords);
+    } else {
+      fHaveTriedToBuildFrameStartTable = False; // try again later, now that there are more records
+    }
+  }
+
+  return True;
+}
+
 int MPEG2TransportStreamIndexFile::mpegVersion() {
   if (fMPEGVersion != 0) return fMPEGVersion; // we already know it
 
@@ -246,6 +299,13 @@ Boolean MPEG2TransportStreamIndexFile::seekToIndexRecord(unsigned long indexReco
 }
 
 Boolean MPEG2TransportStreamIndexFile::readIndexRecord(unsigned long indexRecordNum) {
+  if (fMappedIndexRecords != NULL) {
+    if (indexRecordNum >= fNumIndexRecords) return False;
+
+    memmove(fBuf, &fMappedIndexRecords[indexRecordNum*INDEX_RECORD_SIZE], INDEX_RECORD_SIZE);
+    return True;
+  }
+
   do {
     if (!seekToIndexRecord(indexRecordNum)) break;
     if (fread(fBuf, INDEX_RECORD_SIZE, 1, fFid) != 1) break;
@@ -271,6 +331,55 @@ void MPEG2TransportStreamIndexFile::closeFid() {
   }
 }
 
+Boolean MPEG2TransportStreamIndexFile::buildFrameStartTable() {
+  if (!fHaveTriedToBuildFrameStartTable) {
+    fHaveTriedToBuildFrameStartTable = True;
+    addToFrameStartTable(0);
+  }
+
+  return fFrameStartRecordNums != NULL;
+}
+
+void MPEG2TransportStreamIndexFile::addToFrameStartTable(unsigned long fromIndexRecordNum) {
+  if (fMappedIndexRecords == NULL) {
+    // We can no longer keep the table up-to-date, so don't use it:
+    delete[] fFrameStartRecordNums; fFrameStartRecordNums = NULL;
+    fNumFrameStarts = 0;
+    return;
+  }
+
+  // First, count the new frame starts, then record them (after any that we already have):
+  unsigned long i, numNewFrameStarts = 0;
+  for (i = fromIndexRecordNum; i < fNumIndexRecords; ++i) {
+    if (isFrameStart(fMappedIndexRecords[i*INDEX_RECORD_SIZE])) ++numNewFrameStarts;
+  }
+
+  unsigned long numFrameStarts = fNumFrameStarts + numNewFrameStarts;
+  unsigned long* frameStartRecordNums = new unsigned long[numFrameStarts == 0 ? 1 : numFrameStarts];
+  for (i = 0; i < fNumFrameStarts; ++i) frameStartRecordNums[i] = fFrameStartRecordNums[i];
+  delete[] fFrameStartRecordNums; fFrameStartRecordNums = frameStartRecordNums;
+
+  for (i = fromIndexRecordNum; i < fNumIndexRecords; ++i) {
+    if (isFrameStart(fMappedIndexRecords[i*INDEX_RECORD_SIZE])) {
+      fFrameStartRecordNums[fNumFrameStarts++] = i;
+    }
+  }
+}
+
+void MPEG2TransportStreamIndexFile::mapIndexRecords() {
+  // If we can, map the index file into memory, so that index record lookups (which are frequent during 'trick play')
+  // don't each need a seek+read:
+  if (fUseMemoryMapping && fNumIndexRecords > 0) {
+    FILE* fid = OpenInputFile(envir(), fFileName);
+    if (fid != NULL) {
+      fMappedSize = (u_int64_t)fNumIndexRecords*INDEX_RECORD_SIZE;
+      fMappedIndexRecords = MapInputFile(fileno(fid), fMappedSize);
+      if (fMappedIndexRecords == NULL) fMappedSize = 0;
+      CloseInputFile(fid);
+    }
+  }
+}
+
 float MPEG2TransportStreamIndexFile::pcrFromBuf() {
   unsigned pcr_int = (fBuf[5]<<16) | (fBuf[4]<<8) | fBuf[3];
   u_int8_t pcr_frac = fBuf[6];
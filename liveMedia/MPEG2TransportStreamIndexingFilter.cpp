@@ -0,0 +1,174 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A filter that passes a Transport Stream through unchanged (e.g., to a "FileSink" that's
+// recording it), while also writing an index file (".tsx") for the Transport Stream as it grows.
+// Implementation
+
+#include "MPEG2TransportStreamIndexingFilter.hh"
+#include "MPEG2IndexFromTransportStream.hh"
+#include "OutputFile.hh"
+
+MPEG2TransportStreamIndexingFilter*
+MPEG2TransportStreamIndexingFilter::createNew(UsageEnvironment& env,
+					      FramedSource* inputSource,
+					      char const* indexFileName) {
+  FILE* indexFid = OpenOutputFile(env, indexFileName);
+  if (indexFid == NULL) return NULL;
+
+  return new MPEG2TransportStreamIndexingFilter(env, inputSource, indexFid);
+}
+
+MPEG2TransportStreamIndexingFilter
+::MPEG2TransportStreamIndexingFilter(UsageEnvironment& env,
+				     FramedSource* inputSource, FILE* indexFid)
+  : FramedFilter(env, inputSource),
+    fIndexer(MPEG2IFrameIndexFromTransportStream::createNew(env, NULL)),
+    fIndexFid(indexFid), fHaveFinishedIndexing(False), fPartialPacketSize(0),
+    fPendingIndexRecords(NULL), fPendingIndexRecordsSize(0), fPendingIndexRecordsBufferSize(0) {
+}
+
+MPEG2TransportStreamIndexingFilter::~MPEG2TransportStreamIndexingFilter() {
+  // If the recording was stopped before the input source ended, index what we have:
+  finishIndexing();
+  writePendingIndexRecords();
+
+  Medium::close(fIndexer);
+  CloseOutputFile(fIndexFid);
+  delete[] fPendingIndexRecords;
+}
+
+void MPEG2TransportStreamIndexingFilter::doGetNextFrame() {
+  // Our downstream object has now handled the data that we delivered last time (e.g., a "FileSink" has
+  // written it to the Transport Stream file), so it's now safe to write the index records for that data:
+  writePendingIndexRecords();
+
+  // Read new data directly into the client's buffer:
+  fInputSource->getNextFrame(fTo, fMaxSize, afterGettingFrame, this,
+			     handleInputClosure, this);
+}
+
+void MPEG2TransportStreamIndexingFilter
+::afterGettingFrame(void* clientData, unsigned frameSize,
+		    unsigned numTruncatedBytes,
+		    struct timeval presentationTime,
+		    unsigned durationInMicroseconds) {
+  MPEG2TransportStreamIndexingFilter* filter = (MPEG2TransportStreamIndexingFilter*)clientData;
+  filter->afterGettingFrame1(frameSize, numTruncatedBytes,
+			     presentationTime, durationInMicroseconds);
+}
+
+void MPEG2TransportStreamIndexingFilter
+::afterGettingFrame1(unsigned frameSize,
+		     unsigned numTruncatedBytes,
+		     struct timeval presentationTime,
+		     unsigned durationInMicroseconds) {
+  indexData(fTo, frameSize);
+
+  // Deliver the data, unchanged:
+  fFrameSize = frameSize;
+  fNumTruncatedBytes = numTruncatedBytes;
+  fPresentationTime = presentationTime;
+  fDurationInMicroseconds = durationInMicroseconds;
+  afterGetting(this);
+}
+
+void MPEG2TransportStreamIndexingFilter::handleInputClosure(void* clientData) {
+  MPEG2TransportStreamIndexingFilter* filter = (MPEG2TransportStreamIndexingFilter*)clientData;
+  filter->handleInputClosure1();
+}
+
+void MPEG2TransportStreamIndexingFilter::handleInputClosure1() {
+  finishIndexing();
+  writePendingIndexRecords();
+
+  handleClosure();
+}
+
+void MPEG2TransportStreamIndexingFilter::indexData(unsigned char const* data, unsigned dataSize) {
+  if (fHaveFinishedIndexing) return;
+
+  // Input frames need not consist of whole Transport Stream packets.  First, complete any partial packet
+  // that was left over from the previous frame:
+  if (fPartialPacketSize > 0) {
+    unsigned numBytesToCopy = TRANSPORT_PACKET_SIZE - fPartialPacketSize;
+    if (numBytesToCopy > dataSize) numBytesToCopy = dataSize;
+    memmove(&fPartialPacket[fPartialPacketSize], data, numBytesToCopy);
+    fPartialPacketSize += numBytesToCopy;
+    data += numBytesToCopy; dataSize -= numBytesToCopy;
+    if (fPartialPacketSize < TRANSPORT_PACKET_SIZE) return;
+
+    fPartialPacketSize = 0;
+    indexPacket(fPartialPacket);
+  }
+
+  // Then, index each complete packet in place:
+  while (dataSize >= TRANSPORT_PACKET_SIZE && !fHaveFinishedIndexing) {
+    indexPacket(data);
+    data += TRANSPORT_PACKET_SIZE; dataSize -= TRANSPORT_PACKET_SIZE;
+  }
+
+  // Finally, save any remaining data, for next time:
+  if (!fHaveFinishedIndexing) {
+    memmove(fPartialPacket, data, dataSize);
+    fPartialPacketSize = dataSize;
+  }
+}
+
+void MPEG2TransportStreamIndexingFilter::indexPacket(unsigned char const* pkt) {
+  if (!fIndexer->indexTransportPacket(pkt)) {
+    // Handle a bad packet the same way that "MPEG2IFrameIndexFromTransportStream" does when reading
+    // from an input source, so that our index file is the same as one made after the recording:
+    if (!fIndexer->indexEndOfStream()) fHaveFinishedIndexing = True;
+  }
+  saveIndexRecords();
+}
+
+void MPEG2TransportStreamIndexingFilter::finishIndexing() {
+  if (fHaveFinishedIndexing) return;
+  fHaveFinishedIndexing = True;
+
+  // Any final partial packet is ignored.  Index any video data that remains unparsed:
+  if (fIndexer->indexEndOfStream()) saveIndexRecords();
+}
+
+void MPEG2TransportStreamIndexingFilter::saveIndexRecords() {
+  while (1) {
+    if (fPendingIndexRecordsSize + INDEX_RECORD_SIZE > fPendingIndexRecordsBufferSize) {
+      // Enlarge our buffer:
+      unsigned newBufferSize
+	= fPendingIndexRecordsBufferSize == 0 ? 64*INDEX_RECORD_SIZE : 2*fPendingIndexRecordsBufferSize;
+      u_int8_t* newBuffer = new u_int8_t[newBufferSize];
+      memmove(newBuffer, fPendingIndexRecords, fPendingIndexRecordsSize);
+      delete[] fPendingIndexRecords;
+      fPendingIndexRecords = newBuffer;
+      fPendingIndexRecordsBufferSize = newBufferSize;
+    }
+
+    if (!fIndexer->getNextIndexRecord(&fPendingIndexRecords[fPendingIndexRecordsSize])) break;
+    fPendingIndexRecordsSize += INDEX_RECORD_SIZE;
+  }
+}
+
+void MPEG2TransportStreamIndexingFilter::writePendingIndexRecords() {
+  if (fPendingIndexRecordsSize == 0) return;
+
+  // Write (and flush) the records, so that they're immediately visible to readers of the index file:
+  fwrite(fPendingIndexRecords, 1, fPendingIndexRecordsSize, fIndexFid);
+  fflush(fIndexFid);
+  fPendingIndexRecordsSize = 0;
+}
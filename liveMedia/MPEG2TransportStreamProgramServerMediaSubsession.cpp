@@ -0,0 +1,62 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A 'ServerMediaSubsession' object that creates new, unicast, "RTPSink"s
+// on demand, from one program of a MPEG-2 Transport Stream multiplex
+// (using a "MPEG2TransportStreamProgramSplitter" that may be shared by many such subsessions)
+// Implementation
+
+#include "MPEG2TransportStreamProgramServerMediaSubsession.hh"
+#include "MPEG2TransportStreamFramer.hh"
+#include "SimpleRTPSink.hh"
+
+MPEG2TransportStreamProgramServerMediaSubsession*
+MPEG2TransportStreamProgramServerMediaSubsession
+::createNew(UsageEnvironment& env, MPEG2TransportStreamProgramSplitter& splitter,
+	    u_int16_t programNumber) {
+  return new MPEG2TransportStreamProgramServerMediaSubsession(env, splitter, programNumber);
+}
+
+MPEG2TransportStreamProgramServerMediaSubsession
+::MPEG2TransportStreamProgramServerMediaSubsession(UsageEnvironment& env,
+						   MPEG2TransportStreamProgramSplitter& splitter,
+						   u_int16_t programNumber)
+  : OnDemandServerMediaSubsession(env, True/*reuseFirstSource*/),
+    fSplitter(splitter), fProgramNumber(programNumber) {
+}
+
+MPEG2TransportStreamProgramServerMediaSubsession
+::~MPEG2TransportStreamProgramServerMediaSubsession() {
+}
+
+FramedSource* MPEG2TransportStreamProgramServerMediaSubsession
+::createNewStreamSource(unsigned/* clientSessionId*/, unsigned& estBitrate) {
+  estBitrate = 5000; // kbps, estimate
+
+  // All clients of this program share one output of the splitter:
+  FramedSource* programSource = fSplitter.newProgramSource(fProgramNumber);
+  if (programSource == NULL) return NULL;
+
+  return MPEG2TransportStreamFramer::createNew(envir(), programSource);
+}
+
+RTPSink* MPEG2TransportStreamProgramServerMediaSubsession
+::createNewRTPSink(Groupsock* rtpGroupsock, unsigned char /*rtpPayloadTypeIfDynamic*/, FramedSource* /*inputSource*/) {
+  return SimpleRTPSink::createNew(envir(), rtpGroupsock,
+				  33, 90000, "video", "MP2T",
+				  1, True, False /*no 'M' bit*/);
+}
@@ -0,0 +1,617 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// Splits a MPEG-2 Transport Stream multiplex - in a single pass - into separate output
+// Transport Streams, one per program (or into raw packet streams, one per PID)
+// Implementation
+
+#include "MPEG2TransportStreamProgramSplitter.hh"
+#include "MPEG2TransportStreamMultiplexor.hh" // for calculateCRC()
+
+#define TRANSPORT_PACKET_SIZE 188
+#define TRANSPORT_SYNC_BYTE 0x47
+#define NUM_PIDS 0x2000
+#define PAT_PID 0x0000
+#define NULL_PID 0x1FFF
+#define MAX_PSI_SECTION_SIZE 1024
+#define INPUT_BUFFER_NUM_PACKETS 100 // we read up to this many packets at a time
+#define INPUT_BUFFER_SIZE (INPUT_BUFFER_NUM_PACKETS*TRANSPORT_PACKET_SIZE)
+
+////////// PIDEntry and ProgramInfo definitions //////////
+
+// Each incoming packet is handled by indexing "fPIDTable" with its PID.  The entry lists the
+// outputs that want the packet, and tells us whether we need to parse it ourself (PAT or PMT).
+// The table is rebuilt only when the programs or the outputs change.
+class MPEG2TransportStreamProgramSplitter::PIDEntry {
+public:
+  PIDEntry()
+    : outputs(NULL), numOutputs(0), isPSI(False),
+      section(NULL), sectionSize(0), sectionExpectedSize(0) {
+  }
+  virtual ~PIDEntry() { delete[] outputs; delete[] section; }
+
+  void reset() { delete[] outputs; outputs = NULL; numOutputs = 0; isPSI = False; }
+  void addOutput(MPEG2TransportStreamSplitterOutput* output);
+
+  MPEG2TransportStreamSplitterOutput** outputs;
+  unsigned numOutputs;
+  Boolean isPSI;
+
+  // For reassembling PSI sections that span more than one packet:
+  unsigned char* section; // allocated when first needed
+  unsigned sectionSize, sectionExpectedSize;
+};
+
+void MPEG2TransportStreamProgramSplitter::PIDEntry
+::addOutput(MPEG2TransportStreamSplitterOutput* output) {
+  if (numOutputs > 0 && outputs[numOutputs-1] == output) return; // a PID can be listed twice in a program
+
+  MPEG2TransportStreamSplitterOutput** newOutputs
+    = new MPEG2TransportStreamSplitterOutput*[numOutputs+1];
+  for (unsigned i = 0; i < numOutputs; ++i) newOutputs[i] = outputs[i];
+  newOutputs[numOutputs++] = output;
+  delete[] outputs; outputs = newOutputs;
+}
+
+class MPEG2TransportStreamProgramSplitter::ProgramInfo {
+public:
+  ProgramInfo(u_int16_t programNumber, u_int16_t pmtPID)
+    : programNumber(programNumber), pmtPID(pmtPID), pcrPID(NULL_PID),
+      esPIDs(NULL), numESPIDs(0), pmtVersion(-1),
+      isInPAT(True), hasBeenAnnounced(False) {
+  }
+  virtual ~ProgramInfo() { delete[] esPIDs; }
+
+  u_int16_t programNumber, pmtPID, pcrPID;
+  u_int16_t* esPIDs;
+  unsigned numESPIDs;
+  int pmtVersion; // -1 until we've seen the program's PMT
+  Boolean isInPAT, hasBeenAnnounced;
+};
+
+
+////////// MPEG2TransportStreamProgramSplitter implementation //////////
+
+MPEG2TransportStreamProgramSplitter* MPEG2TransportStreamProgramSplitter
+::createNew(UsageEnvironment& env, FramedSource* inputSource,
+	    Boolean inputSourceIsLive, unsigned maxQueuedPacketsPerOutput) {
+  if (inputSource == NULL) return NULL;
+  if (maxQueuedPacketsPerOutput < INPUT_BUFFER_NUM_PACKETS) {
+    maxQueuedPacketsPerOutput = INPUT_BUFFER_NUM_PACKETS;
+  }
+
+  MPEG2TransportStreamProgramSplitter* splitter
+    = new MPEG2TransportStreamProgramSplitter(env, inputSource, inputSourceIsLive,
+					      maxQueuedPacketsPerOutput);
+  splitter->readInput();
+  return splitter;
+}
+
+MPEG2TransportStreamProgramSplitter
+::MPEG2TransportStreamProgramSplitter(UsageEnvironment& env, FramedSource* inputSource,
+				      Boolean inputSourceIsLive, unsigned maxQueuedPacketsPerOutput)
+  : Medium(env),
+    fInputSource(inputSource), fInputSourceIsLive(inputSourceIsLive),
+    fMaxQueuedPacketsPerOutput(maxQueuedPacketsPerOutput),
+    fNumLeftoverBytes(0), fIsReadingInput(False), fIsProcessingInput(False), fInputIsClosed(False),
+    fPrograms(HashTable::create(ONE_WORD_HASH_KEYS)), fPATVersion(-1), fTransportStreamId(0),
+    fOutputs(NULL), fNewProgramHandler(NULL), fNewProgramHandlerClientData(NULL) {
+  fInputBuffer = new unsigned char[INPUT_BUFFER_SIZE];
+  fPIDTable = new PIDEntry[NUM_PIDS];
+  fPIDTable[PAT_PID].isPSI = True;
+}
+
+MPEG2TransportStreamProgramSplitter::~MPEG2TransportStreamProgramSplitter() {
+  // Our outputs may outlive us; tell them that we've gone away:
+  for (MPEG2TransportStreamSplitterOutput* output = fOutputs; output != NULL; output = output->fNext) {
+    output->fSplitter = NULL;
+    if (output->isCurrentlyAwaitingData()) output->scheduleDelivery(); // to signal closure
+  }
+
+  Medium::close(fInputSource);
+
+  ProgramInfo* program;
+  while ((program = (ProgramInfo*)fPrograms->RemoveNext()) != NULL) delete program;
+  delete fPrograms;
+  delete[] fPIDTable;
+  delete[] fInputBuffer;
+}
+
+FramedSource* MPEG2TransportStreamProgramSplitter::newProgramSource(u_int16_t programNumber) {
+  if (programNumber == 0) return NULL; // program_number 0 denotes the network PID, not a program
+
+  return addOutput(new MPEG2TransportStreamSplitterOutput(envir(), *this, programNumber, 0));
+}
+
+FramedSource* MPEG2TransportStreamProgramSplitter::newPIDSource(u_int16_t pid) {
+  if (pid >= NUM_PIDS) return NULL;
+
+  return addOutput(new MPEG2TransportStreamSplitterOutput(envir(), *this, 0, pid));
+}
+
+void MPEG2TransportStreamProgramSplitter
+::setNewProgramHandler(MPEG2TransportStreamNewProgramHandler* handler, void* clientData) {
+  fNewProgramHandler = handler;
+  fNewProgramHandlerClientData = clientData;
+}
+
+unsigned MPEG2TransportStreamProgramSplitter::numPrograms() const {
+  return fPrograms->numEntries();
+}
+
+void MPEG2TransportStreamProgramSplitter::readInput() {
+  if (fIsReadingInput || fIsProcessingInput || fInputIsClosed) return;
+
+  // A non-live input is read only when there's a need for more data - and only when each output has room
+  // for every packet that we might read (so that, unlike with a live input, no packets get dropped):
+  if (!fInputSourceIsLive && ((programTableIsComplete() && !someOutputNeedsData()) || someOutputQueueIsFull())) {
+    return;
+  }
+
+  fIsReadingInput = True;
+  fInputSource->getNextFrame(&fInputBuffer[fNumLeftoverBytes], INPUT_BUFFER_SIZE - fNumLeftoverBytes,
+			     afterGettingInput, this,
+			     handleInputClosure, this);
+}
+
+void MPEG2TransportStreamProgramSplitter
+::afterGettingInput(void* clientData, unsigned frameSize,
+		    unsigned /*numTruncatedBytes*/,
+		    struct timeval /*presentationTime*/,
+		    unsigned /*durationInMicroseconds*/) {
+  MPEG2TransportStreamProgramSplitter* splitter = (MPEG2TransportStreamProgramSplitter*)clientData;
+  splitter->afterGettingInput1(frameSize);
+}
+
+void MPEG2TransportStreamProgramSplitter::afterGettingInput1(unsigned frameSize) {
+  fIsReadingInput = False;
+  fIsProcessingInput = True;
+
+  unsigned numBytes = fNumLeftoverBytes + frameSize;
+  unsigned i = 0;
+  while (numBytes - i >= TRANSPORT_PACKET_SIZE) {
+    if (fInputBuffer[i] != TRANSPORT_SYNC_BYTE) {
+      ++i; // we've lost sync; look for the next sync byte
+      continue;
+    }
+
+    handlePacket(&fInputBuffer[i]);
+    i += TRANSPORT_PACKET_SIZE;
+  }
+
+  // Keep any partial packet for next time:
+  fNumLeftoverBytes = numBytes - i;
+  memmove(fInputBuffer, &fInputBuffer[i], fNumLeftoverBytes);
+
+  fIsProcessingInput = False;
+  readInput();
+}
+
+void MPEG2TransportStreamProgramSplitter::handleInputClosure(void* clientData) {
+  MPEG2TransportStreamProgramSplitter* splitter = (MPEG2TransportStreamProgramSplitter*)clientData;
+  splitter->handleInputClosure1();
+}
+
+void MPEG2TransportStreamProgramSplitter::handleInputClosure1() {
+  fIsReadingInput = False;
+  fInputIsClosed = True;
+
+  // Each output signals closure once it has delivered the rest of its queue:
+  for (MPEG2TransportStreamSplitterOutput* output = fOutputs; output != NULL; output = output->fNext) {
+    if (output->isCurrentlyAwaitingData()) output->scheduleDelivery();
+  }
+}
+
+void MPEG2TransportStreamProgramSplitter::handlePacket(u_int8_t const* packet) {
+  u_int16_t pid = ((packet[1]&0x1F)<<8) | packet[2];
+
+  if (fPIDTable[pid].isPSI) parsePSIPacket(pid, packet); // note: this might rebuild "fPIDTable"
+
+  PIDEntry& entry = fPIDTable[pid];
+  for (unsigned i = 0; i < entry.numOutputs; ++i) entry.outputs[i]->enqueuePacket(packet);
+}
+
+void MPEG2TransportStreamProgramSplitter::parsePSIPacket(u_int16_t pid, u_int8_t const* packet) {
+  if ((packet[1]&0x80) != 0) return; // transport_error_indicator
+
+  u_int8_t const adaptation_field_control = (packet[3]&0x30)>>4;
+  if ((adaptation_field_control&0x1) == 0) return; // no payload
+
+  unsigned offset = 4;
+  if ((adaptation_field_control&0x2) != 0) offset += 1 + packet[4];
+  if (offset >= TRANSPORT_PACKET_SIZE) return;
+
+  u_int8_t const* payload = &packet[offset];
+  unsigned payloadSize = TRANSPORT_PACKET_SIZE - offset;
+  PIDEntry& entry = fPIDTable[pid];
+
+  if ((packet[1]&0x40) == 0) { // payload_unit_start_indicator is not set
+    // This payload continues a section (if any) that began in an earlier packet:
+    if (entry.sectionSize > 0) addToSection(entry, payload, payloadSize);
+    return;
+  }
+
+  unsigned pointer_field = payload[0];
+  ++payload; --payloadSize;
+  if (pointer_field > payloadSize) {
+    entry.sectionSize = 0;
+    return;
+  }
+
+  // The bytes before the "pointer_field" end the section (if any) that began earlier:
+  if (entry.sectionSize > 0) addToSection(entry, payload, pointer_field);
+  entry.sectionSize = 0;
+  payload += pointer_field; payloadSize -= pointer_field;
+
+  // Then, one or more sections begin (until we see stuffing):
+  while (payloadSize >= 3 && payload[0] != 0xFF) {
+    unsigned sectionSize = 3 + (((payload[1]&0x0F)<<8) | payload[2]);
+    if (sectionSize > MAX_PSI_SECTION_SIZE) return; // bad data
+
+    if (sectionSize > payloadSize) {
+      // The section continues in later packets:
+      if (entry.section == NULL) entry.section = new unsigned char[MAX_PSI_SECTION_SIZE];
+      memmove(entry.section, payload, payloadSize);
+      entry.sectionSize = payloadSize;
+      entry.sectionExpectedSize = sectionSize;
+      return;
+    }
+
+    parseSection(pid, payload, sectionSize);
+    payload += sectionSize; payloadSize -= sectionSize;
+  }
+}
+
+void MPEG2TransportStreamProgramSplitter
+::addToSection(PIDEntry& entry, u_int8_t const* data, unsigned dataSize) {
+  unsigned numBytesNeeded = entry.sectionExpectedSize - entry.sectionSize;
+  if (dataSize > numBytesNeeded) dataSize = numBytesNeeded;
+
+  memmove(&entry.section[entry.sectionSize], data, dataSize);
+  entry.sectionSize += dataSize;
+
+  if (entry.sectionSize == entry.sectionExpectedSize) {
+    entry.sectionSize = 0;
+    parseSection(&entry - fPIDTable, entry.section, entry.sectionExpectedSize);
+  }
+}
+
+void MPEG2TransportStreamProgramSplitter
+::parseSection(u_int16_t pid, u_int8_t const* section, unsigned sectionSize) {
+  if (sectionSize < 12) return; // too short for a PAT or PMT
+  if ((section[1]&0x80) == 0) return; // section_syntax_indicator is not set
+  if ((section[5]&0x01) == 0) return; // current_next_indicator is not set: the section is not yet applicable
+  if (calculateCRC(section, sectionSize) != 0) return; // the section (including its CRC_32) is corrupt
+
+  u_int8_t const table_id = section[0];
+  if (table_id == 0x00 && pid == PAT_PID) {
+    parsePAT(section, sectionSize);
+  } else if (table_id == 0x02) {
+    parsePMT(section, sectionSize);
+  }
+}
+
+void MPEG2TransportStreamProgramSplitter::parsePAT(u_int8_t const* section, unsigned sectionSize) {
+  int version_number = (section[5]&0x3E)>>1;
+  Boolean isCompleteTable = section[7] == 0; // last_section_number
+  if (isCompleteTable && version_number == fPATVersion) return; // nothing has changed
+
+#ifdef DEBUG
+  fprintf(stderr, "MPEG2TransportStreamProgramSplitter: new PAT (version %d)\n", version_number);
+#endif
+  fPATVersion = version_number;
+  fTransportStreamId = (section[3]<<8) | section[4];
+
+  HashTable::Iterator* iter;
+  ProgramInfo* program;
+  char const* key;
+  if (isCompleteTable) {
+    iter = HashTable::Iterator::create(*fPrograms);
+    while ((program = (ProgramInfo*)iter->next(key)) != NULL) program->isInPAT = False;
+    delete iter;
+  }
+
+  for (unsigned i = 8; i + 4 <= sectionSize - 4/*CRC_32*/; i += 4) {
+    u_int16_t program_number = (section[i]<<8) | section[i+1];
+    u_int16_t program_map_PID = ((section[i+2]&0x1F)<<8) | section[i+3];
+    if (program_number == 0) continue; // this is the network PID
+
+    program = lookupProgram(program_number);
+    if (program == NULL) {
+      program = new ProgramInfo(program_number, program_map_PID);
+      fPrograms->Add((char const*)(long)program_number, program);
+    } else if (program->pmtPID != program_map_PID) {
+      program->pmtPID = program_map_PID;
+      program->pmtVersion = -1;
+    }
+    program->isInPAT = True;
+  }
+
+  if (isCompleteTable) {
+    // Forget any programs that are no longer in the multiplex:
+    ProgramInfo** oldPrograms = new ProgramInfo*[fPrograms->numEntries()];
+    unsigned numOldPrograms = 0;
+    iter = HashTable::Iterator::create(*fPrograms);
+    while ((program = (ProgramInfo*)iter->next(key)) != NULL) {
+      if (!program->isInPAT) oldPrograms[numOldPrograms++] = program;
+    }
+    delete iter;
+
+    for (unsigned j = 0; j < numOldPrograms; ++j) {
+      fPrograms->Remove((char const*)(long)oldPrograms[j]->programNumber);
+      delete oldPrograms[j];
+    }
+    delete[] oldPrograms;
+  }
+
+  rebuildPIDTable();
+}
+
+void MPEG2TransportStreamProgramSplitter::parsePMT(u_int8_t const* section, unsigned sectionSize) {
+  u_int16_t program_number = (section[3]<<8) | section[4];
+  ProgramInfo* program = lookupProgram(program_number);
+  if (program == NULL) return; // we haven't yet seen this program in a PAT
+
+  int version_number = (section[5]&0x3E)>>1;
+  if (version_number == program->pmtVersion) return; // nothing has changed
+
+#ifdef DEBUG
+  fprintf(stderr, "MPEG2TransportStreamProgramSplitter: new PMT (version %d) for program %d\n", version_number, program_number);
+#endif
+  program->pmtVersion = version_number;
+  program->pcrPID = ((section[8]&0x1F)<<8) | section[9];
+
+  delete[] program->esPIDs;
+  program->esPIDs = new u_int16_t[(sectionSize-12)/5];
+  program->numESPIDs = 0;
+
+  unsigned i = 12 + (((section[10]&0x0F)<<8) | section[11]); // skip over the program_info descriptors
+  while (i + 5 <= sectionSize - 4/*CRC_32*/) {
+    program->esPIDs[program->numESPIDs++] = ((section[i+1]&0x1F)<<8) | section[i+2];
+    i += 5 + (((section[i+3]&0x0F)<<8) | section[i+4]); // skip over the ES_info descriptors
+  }
+
+  rebuildPIDTable();
+
+  if (!program->hasBeenAnnounced) {
+    program->hasBeenAnnounced = True;
+    if (fNewProgramHandler != NULL) (*fNewProgramHandler)(fNewProgramHandlerClientData, program_number);
+  }
+}
+
+MPEG2TransportStreamProgramSplitter::ProgramInfo* MPEG2TransportStreamProgramSplitter
+::lookupProgram(u_int16_t programNumber) const {
+  return (ProgramInfo*)fPrograms->Lookup((char const*)(long)programNumber);
+}
+
+Boolean MPEG2TransportStreamProgramSplitter::programTableIsComplete() const {
+  if (fPATVersion < 0) return False;
+
+  HashTable::Iterator* iter = HashTable::Iterator::create(*fPrograms);
+  ProgramInfo* program;
+  char const* key;
+  Boolean result = True;
+  while ((program = (ProgramInfo*)iter->next(key)) != NULL) {
+    if (program->pmtVersion < 0) {
+      result = False;
+      break;
+    }
+  }
+  delete iter;
+
+  return result;
+}
+
+Boolean MPEG2TransportStreamProgramSplitter::someOutputNeedsData() const {
+  for (MPEG2TransportStreamSplitterOutput* output = fOutputs; output != NULL; output = output->fNext) {
+    if (output->isCurrentlyAwaitingData() && output->fNumQueuedPackets == 0) return True;
+  }
+
+  return False;
+}
+
+Boolean MPEG2TransportStreamProgramSplitter::someOutputQueueIsFull() const {
+  // An output's queue is 'full' if it might not have room for all of the packets from one input buffer:
+  for (MPEG2TransportStreamSplitterOutput* output = fOutputs; output != NULL; output = output->fNext) {
+    if (output->fQueueSize - output->fNumQueuedPackets < INPUT_BUFFER_NUM_PACKETS) return True;
+  }
+
+  return False;
+}
+
+void MPEG2TransportStreamProgramSplitter::rebuildPIDTable() {
+  unsigned pid;
+  for (pid = 0; pid < NUM_PIDS; ++pid) fPIDTable[pid].reset();
+
+  // We parse the PAT, and each program's PMT, ourself:
+  fPIDTable[PAT_PID].isPSI = True;
+  HashTable::Iterator* iter = HashTable::Iterator::create(*fPrograms);
+  ProgramInfo* program;
+  char const* key;
+  while ((program = (ProgramInfo*)iter->next(key)) != NULL) fPIDTable[program->pmtPID].isPSI = True;
+  delete iter;
+
+  for (MPEG2TransportStreamSplitterOutput* output = fOutputs; output != NULL; output = output->fNext) {
+    if (output->fProgramNumber == 0) {
+      // A per-PID output:
+      fPIDTable[output->fPID].addOutput(output);
+      continue;
+    }
+
+    // A per-program output gets the PAT (which it replaces with its own), PMT, PCR and elementary streams:
+    fPIDTable[PAT_PID].addOutput(output);
+    program = lookupProgram(output->fProgramNumber);
+    if (program == NULL) continue; // we don't know this program yet
+
+    output->setPMTPID(program->pmtPID);
+    fPIDTable[program->pmtPID].addOutput(output);
+    if (program->pcrPID != NULL_PID) fPIDTable[program->pcrPID].addOutput(output);
+    for (unsigned i = 0; i < program->numESPIDs; ++i) fPIDTable[program->esPIDs[i]].addOutput(output);
+  }
+}
+
+FramedSource* MPEG2TransportStreamProgramSplitter
+::addOutput(MPEG2TransportStreamSplitterOutput* output) {
+  output->fNext = fOutputs;
+  fOutputs = output;
+  rebuildPIDTable();
+
+  return output;
+}
+
+void MPEG2TransportStreamProgramSplitter
+::removeOutput(MPEG2TransportStreamSplitterOutput* output) {
+  for (MPEG2TransportStreamSplitterOutput** ptr = &fOutputs; *ptr != NULL; ptr = &((*ptr)->fNext)) {
+    if (*ptr == output) {
+      *ptr = output->fNext;
+      break;
+    }
+  }
+  rebuildPIDTable();
+  readInput(); // in case we'd stopped reading (a non-live input) because this output's queue was full
+}
+
+
+////////// MPEG2TransportStreamSplitterOutput implementation //////////
+
+MPEG2TransportStreamSplitterOutput
+::MPEG2TransportStreamSplitterOutput(UsageEnvironment& env,
+				     MPEG2TransportStreamProgramSplitter& splitter,
+				     u_int16_t programNumber, u_int16_t pid)
+  : FramedSource(env),
+    fSplitter(&splitter), fNext(NULL), fProgramNumber(programNumber), fPID(pid), fPMTPID(NULL_PID),
+    fHavePATPacket(False), fPATVersion(0), fPATContinuityCounter(0),
+    fQueueSize(splitter.fMaxQueuedPacketsPerOutput), fQueueHead(0), fNumQueuedPackets(0),
+    fNumPacketsDropped(0) {
+  fQueue = new unsigned char[fQueueSize*TRANSPORT_PACKET_SIZE];
+}
+
+MPEG2TransportStreamSplitterOutput::~MPEG2TransportStreamSplitterOutput() {
+  envir().taskScheduler().unscheduleDelayedTask(nextTask());
+  if (fSplitter != NULL) fSplitter->removeOutput(this);
+  delete[] fQueue;
+}
+
+void MPEG2TransportStreamSplitterOutput::setPMTPID(u_int16_t pmtPID) {
+  if (fHavePATPacket && pmtPID == fPMTPID) return; // our PAT is unchanged
+
+  fPMTPID = pmtPID;
+  if (fHavePATPacket) fPATVersion = (fPATVersion+1)&0x1F;
+  fHavePATPacket = True;
+
+  // Construct a PAT that lists only our program:
+  unsigned char* pat = fPATPacket;
+  *pat++ = TRANSPORT_SYNC_BYTE;
+  *pat++ = 0x40; // payload_unit_start_indicator; PID (high bits) == 0
+  *pat++ = 0x00; // PID (low bits) == 0
+  *pat++ = 0x10; // payload only; continuity_counter (set when the packet is queued)
+  *pat++ = 0; // pointer_field
+  unsigned char* section = pat;
+  *pat++ = 0x00; // table_id
+  *pat++ = 0xB0; // section_syntax_indicator; 0; reserved, section_length (high)
+  *pat++ = 13; // section_length (low)
+  u_int16_t transportStreamId = fSplitter == NULL ? 1 : fSplitter->transportStreamId();
+  *pat++ = transportStreamId>>8; *pat++ = transportStreamId;
+  *pat++ = 0xC1 | (fPATVersion<<1); // reserved; version_number; current_next_indicator
+  *pat++ = 0; // section_number
+  *pat++ = 0; // last_section_number
+  *pat++ = fProgramNumber>>8; *pat++ = fProgramNumber;
+  *pat++ = 0xE0 | (fPMTPID>>8); *pat++ = fPMTPID; // reserved; program_map_PID
+  u_int32_t crc = calculateCRC(section, pat - section);
+  *pat++ = crc>>24; *pat++ = crc>>16; *pat++ = crc>>8; *pat++ = crc;
+  memset(pat, 0xFF, &fPATPacket[TRANSPORT_PACKET_SIZE] - pat); // stuffing
+}
+
+void MPEG2TransportStreamSplitterOutput::enqueuePacket(u_int8_t const* packet) {
+  if (fProgramNumber != 0 && (packet[1]&0x1F) == 0 && packet[2] == 0) {
+    // This is the multiplex's PAT.  Replace it with our own (once for each PAT that starts here):
+    if (!fHavePATPacket || (packet[1]&0x40) == 0) return;
+
+    fPATPacket[3] = 0x10 | fPATContinuityCounter;
+    fPATContinuityCounter = (fPATContinuityCounter+1)&0x0F;
+    packet = fPATPacket;
+  }
+
+  if (fNumQueuedPackets == fQueueSize) {
+    ++fNumPacketsDropped;
+    return;
+  }
+
+  unsigned tail = (fQueueHead + fNumQueuedPackets)%fQueueSize;
+  memmove(&fQueue[tail*TRANSPORT_PACKET_SIZE], packet, TRANSPORT_PACKET_SIZE);
+  ++fNumQueuedPackets;
+
+  if (isCurrentlyAwaitingData()) scheduleDelivery();
+}
+
+void MPEG2TransportStreamSplitterOutput::scheduleDelivery() {
+  // We deliver from a separate task, so that our reader never runs in the middle of our
+  // splitter's processing of an input buffer:
+  if (nextTask() == NULL) {
+    nextTask() = envir().taskScheduler().scheduleDelayedTask(0, deliver, this);
+  }
+}
+
+void MPEG2TransportStreamSplitterOutput::deliver(void* clientData) {
+  MPEG2TransportStreamSplitterOutput* output = (MPEG2TransportStreamSplitterOutput*)clientData;
+  output->nextTask() = NULL;
+  if (!output->isCurrentlyAwaitingData()) return;
+
+  output->doGetNextFrame();
+}
+
+void MPEG2TransportStreamSplitterOutput::doGetNextFrame() {
+  if (fNumQueuedPackets > 0) {
+    deliverQueuedPackets();
+  } else if (fSplitter == NULL || fSplitter->fInputIsClosed) {
+    handleClosure();
+  } else {
+    fSplitter->readInput(); // in case the input is read only on demand
+  }
+}
+
+void MPEG2TransportStreamSplitterOutput::doStopGettingFrames() {
+  envir().taskScheduler().unscheduleDelayedTask(nextTask());
+}
+
+void MPEG2TransportStreamSplitterOutput::deliverQueuedPackets() {
+  unsigned numPackets = fMaxSize/TRANSPORT_PACKET_SIZE;
+  if (numPackets == 0) {
+    // Our reader's buffer is too small for a packet; deliver as much of one as we can:
+    fFrameSize = fMaxSize;
+    fNumTruncatedBytes = TRANSPORT_PACKET_SIZE - fMaxSize;
+    memmove(fTo, &fQueue[fQueueHead*TRANSPORT_PACKET_SIZE], fFrameSize);
+    numPackets = 1;
+  } else {
+    if (numPackets > fNumQueuedPackets) numPackets = fNumQueuedPackets;
+
+    // Copy the packets out of our ring buffer (in at most two pieces):
+    unsigned numPackets1 = fQueueSize - fQueueHead;
+    if (numPackets1 > numPackets) numPackets1 = numPackets;
+    memmove(fTo, &fQueue[fQueueHead*TRANSPORT_PACKET_SIZE], numPackets1*TRANSPORT_PACKET_SIZE);
+    memmove(&fTo[numPackets1*TRANSPORT_PACKET_SIZE], fQueue, (numPackets-numPackets1)*TRANSPORT_PACKET_SIZE);
+    fFrameSize = numPackets*TRANSPORT_PACKET_SIZE;
+    fNumTruncatedBytes = 0;
+  }
+  fQueueHead = (fQueueHead + numPackets)%fQueueSize;
+  fNumQueuedPackets -= numPackets;
+  if (fSplitter != NULL) fSplitter->readInput(); // in case we'd stopped reading (a non-live input) because we were full
+
+  gettimeofday(&fPresentationTime, NULL);
+  fDurationInMicroseconds = 0; // a downstream "MPEG2TransportStreamFramer" computes this from the PCRs
+  FramedSource::afterGetting(this);
+}
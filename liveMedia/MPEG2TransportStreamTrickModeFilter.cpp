@@ -23,6 +23,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "MPEG2TransportStreamTrickModeFilter.hh"
 #include <ByteStreamFileSource.hh>
+#include "InputFile.hh"
 
 // Define the following to be True if we want the output file to have the same frame rate as the original file.
 //    (Because the output file contains I-frames only, this means that each I-frame will appear in the output file
@@ -34,25 +35,38 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 MPEG2TransportStreamTrickModeFilter* MPEG2TransportStreamTrickModeFilter
 ::createNew(UsageEnvironment& env, FramedSource* inputSource,
-	    MPEG2TransportStreamIndexFile* indexFile, int scale) {
-  return new MPEG2TransportStreamTrickModeFilter(env, inputSource, indexFile, scale);
+	    MPEG2TransportStreamIndexFile* indexFile, int scale, Boolean useMemoryMapping) {
+  return new MPEG2TransportStreamTrickModeFilter(env, inputSource, indexFile, scale, useMemoryMapping);
 }
 
 MPEG2TransportStreamTrickModeFilter
 ::MPEG2TransportStreamTrickModeFilter(UsageEnvironment& env, FramedSource* inputSource,
-				      MPEG2TransportStreamIndexFile* indexFile, int scale)
+				      MPEG2TransportStreamIndexFile* indexFile, int scale, Boolean useMemoryMapping)
   : FramedFilter(env, inputSource),
     fHaveStarted(False), fIndexFile(indexFile), fScale(scale), fDirection(1),
     fState(SKIPPING_FRAME), fFrameCount(0),
     fNextIndexRecordNum(0), fNextTSPacketNum(0),
-    fCurrentTSPacketNum((unsigned long)(-1)), fUseSavedFrameNextTime(False) {
+    fCurrentTSPacketNum((unsigned long)(-1)), fUseSavedFrameNextTime(False),
+    fMappedTSFile(NULL), fMappedTSFileSize(0) {
   if (fScale < 0) { // reverse play
     fScale = -fScale;
     fDirection = -1;
   }
+
+  // If we can, map the input Transport Stream file into memory, so that we can deliver data from it
+  // without having to seek+read each Transport Stream packet that we need:
+  if (useMemoryMapping && inputSource != NULL && inputSource->isByteStreamFileSource()) {
+    ByteStreamFileSource* tsFile = (ByteStreamFileSource*)inputSource;
+    int fd; u_int64_t position;
+    if (tsFile->getFileDescriptorAndPosition(fd, position)) {
+      fMappedTSFileSize = tsFile->fileSize();
+      fMappedTSFile = MapInputFile(fd, fMappedTSFileSize);
+    }
+  }
 }
 
 MPEG2TransportStreamTrickModeFilter::~MPEG2TransportStreamTrickModeFilter() {
+  UnmapInputFile(fMappedTSFile, fMappedTSFileSize);
 }
 
 Boolean MPEG2TransportStreamTrickModeFilter::seekTo(unsigned long tsPacketNumber,
@@ -62,11 +76,6 @@ Boolean MPEG2TransportStreamTrickModeFilter::seekTo(unsigned long tsPacketNumber
   return True;
 }
 
-#define isIFrameStart(type) ((type) == 0x81/*actually, a VSH*/ || (type) == 0x85/*actually, a SPS, for H.264*/ || (type) == 0x8B/*actually, a VPS, for H.265*/)
-  // This relies upon I-frames always being preceded by a VSH+GOP (for MPEG-2 data),
-  // by a SPS (for H.264 data), or by a VPS (for H.265 data)
-#define isNonIFrameStart(type) ((type) == 0x83 || (type) == 0x88/*for H.264*/ || (type) == 0x8E/*for H.265*/)
-
 void MPEG2TransportStreamTrickModeFilter::doGetNextFrame() {
   //  fprintf(stderr, "#####DGNF1\n");
   // If our client's buffer size is too small, then deliver
@@ -78,7 +87,20 @@ void MPEG2TransportStreamTrickModeFilter::doGetNextFrame() {
     return;
   }
 
+  if (haveNextIndexRecord()) {
+    attemptDeliveryToClient();
+  } else {
+    // We ran off the end of the index file.  Handle this the same way as if the input Transport Stream source ended:
+    onSourceClosure1();
+  }
+}
+
+Boolean MPEG2TransportStreamTrickModeFilter::haveNextIndexRecord() {
   while (1) {
+    // When skipping, jump straight to the next index record that begins a frame (if our index file lets us):
+    if (fState == SKIPPING_FRAME && fHaveStarted
+	&& !fIndexFile->findNextFrameStart(fNextIndexRecordNum, fDirection)) return False;
+
     // Get the next record from our index file.
     // This tells us the type of frame this data is, which Transport Stream packet
     // (from the input source) the data comes from, and where in the Transport Stream
@@ -91,18 +113,14 @@ void MPEG2TransportStreamTrickModeFilter::doGetNextFrame() {
 					   fDesiredDataSize, recordPCR,
 					   recordType)) {
       // We ran off the end of the index file.  If we're not delivering a
-      // pre-saved frame, then handle this the same way as if the
-      // input Transport Stream source ended.
-      if (fState != DELIVERING_SAVED_FRAME) {
-	onSourceClosure1();
-	return;
-      }
+      // pre-saved frame, then we have nothing more to deliver.
+      if (fState != DELIVERING_SAVED_FRAME) return False;
       endOfIndexFile = True;
     } else if (!fHaveStarted) {
       fFirstPCR = recordPCR;
       fHaveStarted = True;
     }
-    //    fprintf(stderr, "#####read index record %ld: ts %ld: %c, PCR %f\n", fNextIndexRecordNum, fDesiredTSPacketNum, isIFrameStart(recordType) ? 'I' : isNonIFrameStart(recordType) ? 'j' : 'x', recordPCR);
+    //    fprintf(stderr, "#####read index record %ld: ts %ld: %c, PCR %f\n", fNextIndexRecordNum, fDesiredTSPacketNum, MPEG2TransportStreamIndexFile::isIFrameStart(recordType) ? 'I' : MPEG2TransportStreamIndexFile::isNonIFrameStart(recordType) ? 'j' : 'x', recordPCR);
     fNextIndexRecordNum
       += (fState == DELIVERING_SAVED_FRAME) ? 1 : fDirection;
 
@@ -111,7 +129,7 @@ void MPEG2TransportStreamTrickModeFilter::doGetNextFrame() {
     case SKIPPING_FRAME:
     case SAVING_AND_DELIVERING_FRAME: {
       //      if (fState == SKIPPING_FRAME) fprintf(stderr, "\tSKIPPING_FRAME\n"); else fprintf(stderr, "\tSAVING_AND_DELIVERING_FRAME\n");//#####
-      if (isIFrameStart(recordType)) {
+      if (MPEG2TransportStreamIndexFile::isIFrameStart(recordType)) {
 	// Save a record of this frame:
 	fSavedFrameIndexRecordStart = fNextIndexRecordNum - fDirection;
 	fUseSavedFrameNextTime = True;
@@ -124,8 +142,7 @@ void MPEG2TransportStreamTrickModeFilter::doGetNextFrame() {
 	    fState = SAVING_AND_DELIVERING_FRAME;
 	    //	    fprintf(stderr, "\tdelivering\n");//#####
 	    fDesiredDataPCR = recordPCR; // use this frame's PCR
-	    attemptDeliveryToClient();
-	    return;
+	    return True;
 	  } else {
 	    // Deliver this frame, then resume normal scanning:
 	    // (This relies on the index records having begun with an I-frame.)
@@ -140,7 +157,7 @@ void MPEG2TransportStreamTrickModeFilter::doGetNextFrame() {
 	  // No frame is needed now:
 	  fState = SKIPPING_FRAME;
 	}
-      } else if (isNonIFrameStart(recordType)) {
+      } else if (MPEG2TransportStreamIndexFile::isNonIFrameStart(recordType)) {
 	if ((fFrameCount++)%fScale == 0 && fUseSavedFrameNextTime) {
 	  // A frame is due now, so begin delivering the one that we had saved:
 	  // (This relies on the index records having begun with an I-frame.)
@@ -160,8 +177,7 @@ void MPEG2TransportStreamTrickModeFilter::doGetNextFrame() {
 	if (fState == SAVING_AND_DELIVERING_FRAME) {
 	  //	  fprintf(stderr, "\tdelivering\n");//#####
 	  fDesiredDataPCR = recordPCR; // use this frame's PCR
-	  attemptDeliveryToClient();
-	  return;
+	  return True;
 	}
       }
       break;
@@ -169,9 +185,9 @@ void MPEG2TransportStreamTrickModeFilter::doGetNextFrame() {
     case DELIVERING_SAVED_FRAME: {
       //      fprintf(stderr, "\tDELIVERING_SAVED_FRAME\n");//#####
       if (endOfIndexFile
-	  || (isIFrameStart(recordType)
+	  || (MPEG2TransportStreamIndexFile::isIFrameStart(recordType)
 	      && fNextIndexRecordNum-1 != fSavedFrameIndexRecordStart)
-	  || isNonIFrameStart(recordType)) {
+	  || MPEG2TransportStreamIndexFile::isNonIFrameStart(recordType)) {
 	//	fprintf(stderr, "\tended delivery of saved frame\n");//#####
 	// We've reached the end of the saved frame, so revert to the
 	// original sequence of index records:
@@ -181,8 +197,7 @@ void MPEG2TransportStreamTrickModeFilter::doGetNextFrame() {
       } else {
 	// Continue delivering:
 	//	fprintf(stderr, "\tdelivering\n");//#####
-	attemptDeliveryToClient();
-	return;
+	return True;
       }
       break;
     }
@@ -196,7 +211,9 @@ void MPEG2TransportStreamTrickModeFilter::doStopGettingFrames() {
 }
 
 void MPEG2TransportStreamTrickModeFilter::attemptDeliveryToClient() {
-  if (fCurrentTSPacketNum == fDesiredTSPacketNum) {
+  if (canDeliverFromMappedFile(fDesiredTSPacketNum, fDesiredDataOffset, fDesiredDataSize)) {
+    deliverFromMappedFile();
+  } else if (fCurrentTSPacketNum == fDesiredTSPacketNum) {
     //    fprintf(stderr, "\t\tdelivering ts %d:%d, %d bytes, PCR %f\n", fCurrentTSPacketNum, fDesiredDataOffset, fDesiredDataSize, fDesiredDataPCR);//#####
     // We already have the Transport Packet that we want.  Deliver its data:
     memmove(fTo, &fInputBuffer[fDesiredDataOffset], fDesiredDataSize);
@@ -215,6 +232,45 @@ void MPEG2TransportStreamTrickModeFilter::attemptDeliveryToClient() {
   }
 }
 
+Boolean MPEG2TransportStreamTrickModeFilter
+::canDeliverFromMappedFile(unsigned long tsPacketNum, u_int8_t dataOffset, u_int8_t dataSize) const {
+  return fMappedTSFile != NULL && dataOffset + dataSize <= TRANSPORT_PACKET_SIZE
+    && ((u_int64_t)tsPacketNum+1)*TRANSPORT_PACKET_SIZE <= fMappedTSFileSize;
+}
+
+void MPEG2TransportStreamTrickModeFilter::deliverFromMappedFile() {
+  // Deliver the desired data directly from the mapped file:
+  memmove(fTo, &fMappedTSFile[(u_int64_t)fDesiredTSPacketNum*TRANSPORT_PACKET_SIZE + fDesiredDataOffset],
+	  fDesiredDataSize);
+  fFrameSize = fDesiredDataSize;
+
+  // Then, for as long as the client's buffer has room, also deliver the data from the following index records,
+  // provided that they continue the frame that we're delivering.  (In each 'delivering' state, we'd otherwise
+  // read these records - forwards - and deliver each of them separately.)
+  while (1) {
+    unsigned long tsPacketNum;
+    u_int8_t dataOffset, dataSize, recordType;
+    float recordPCR;
+    if (!fIndexFile->readIndexRecordValues(fNextIndexRecordNum, tsPacketNum, dataOffset, dataSize,
+					   recordPCR, recordType)) break;
+    if (MPEG2TransportStreamIndexFile::isFrameStart(recordType)) break; // a new frame begins here
+    if (fFrameSize + dataSize > fMaxSize || !canDeliverFromMappedFile(tsPacketNum, dataOffset, dataSize)) break;
+
+    memmove(&fTo[fFrameSize], &fMappedTSFile[(u_int64_t)tsPacketNum*TRANSPORT_PACKET_SIZE + dataOffset], dataSize);
+    fFrameSize += dataSize;
+    ++fNextIndexRecordNum;
+  }
+
+  float deliveryPCR = fDirection*(fDesiredDataPCR - fFirstPCR)/fScale;
+  if (deliveryPCR < 0.0) deliveryPCR = 0.0;
+  fPresentationTime.tv_sec = (unsigned long)deliveryPCR;
+  fPresentationTime.tv_usec
+    = (unsigned long)((deliveryPCR - fPresentationTime.tv_sec)*1000000.0f);
+
+  // Complete delivery to the client (after returning to the event loop, to avoid infinite recursion):
+  nextTask() = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)FramedSource::afterGetting, this);
+}
+
 void MPEG2TransportStreamTrickModeFilter::seekToTransportPacket(unsigned long tsPacketNum) {
   if (tsPacketNum == fNextTSPacketNum) return; // we're already there
 
@@ -98,14 +98,17 @@ _Tables* _Tables::getOurTables(UsageEnvironment& env, Boolean createIfNotPresent
 }
 
 void _Tables::reclaimIfPossible() {
-  if (mediaTable == NULL && socketTable == NULL) {
+  if (mediaTable == NULL && socketTable == NULL && rtcpReportScheduler == NULL
+      && frameTraceBuffer == NULL && serverPortAllocator == NULL && asyncFileReader == NULL
+      && fileBlockCache == NULL) {
     fEnv.liveMediaPriv = NULL;
     delete this;
   }
 }
 
 _Tables::_Tables(UsageEnvironment& env)
-  : mediaTable(NULL), socketTable(NULL), fEnv(env) {
+  : mediaTable(NULL), socketTable(NULL), rtcpReportScheduler(NULL), frameTraceBuffer(NULL),
+    serverPortAllocator(NULL), asyncFileReader(NULL), fileBlockCache(NULL), fEnv(env) {
 }
 
 _Tables::~_Tables() {
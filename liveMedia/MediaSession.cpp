@@ -207,6 +207,7 @@ Boolean MediaSession::initializeWithSDP(char const* sdpDescription) {
       if (subsession->parseSDPLine_b(sdpLine)) continue;
       if (subsession->parseSDPAttribute_rtpmap(sdpLine)) continue;
       if (subsession->parseSDPAttribute_rtcpmux(sdpLine)) continue;
+      if (subsession->parseSDPAttribute_rtcpfb(sdpLine)) continue;
       if (subsession->parseSDPAttribute_control(sdpLine)) continue;
       if (subsession->parseSDPAttribute_range(sdpLine)) continue;
       if (subsession->parseSDPAttribute_fmtp(sdpLine)) continue;
@@ -599,7 +600,7 @@ MediaSubsession::MediaSubsession(MediaSession& parent)
     fConnectionEndpointName(NULL),
     fClientPortNum(0), fRTPPayloadFormat(0xFF),
     fSavedSDPLines(NULL), fMediumName(NULL), fCodecName(NULL), fProtocolName(NULL),
-    fRTPTimestampFrequency(0), fMultiplexRTCPWithRTP(False), fControlPath(NULL),
+    fRTPTimestampFrequency(0), fMultiplexRTCPWithRTP(False), fSenderSupportsNACKs(False), fControlPath(NULL),
     fSourceFilterAddr(parent.sourceFilterAddr()), fBandwidth(0),
     fPlayStartTime(0.0), fPlayEndTime(0.0), fAbsStartTime(NULL), fAbsEndTime(NULL),
     fVideoWidth(0), fVideoHeight(0), fVideoFPS(0), fNumChannels(1), fScale(1.0f), fNPT_PTS_Offset(0.0f),
@@ -837,6 +838,7 @@ Boolean MediaSubsession::initiate(int useSpecialRTPoffset) {
 	env().setResultMsg("Failed to create RTCP instance");
 	break;
       }
+      if (fSenderSupportsNACKs) fRTCPInstance->enableNACKs();
     }
 
     return True;
@@ -1058,6 +1060,21 @@ Boolean MediaSubsession::parseSDPAttribute_rtcpmux(char const* sdpLine) {
   return False;
 }
 
+Boolean MediaSubsession::parseSDPAttribute_rtcpfb(char const* sdpLine) {
+  // Check for a "a=rtcp-fb:<fmt> nack" line (RFC 4585), which means that the sender will retransmit lost packets.
+  // (Other feedback types, such as "nack pli", are accepted but ignored.)
+  if (strncmp(sdpLine, "a=rtcp-fb:", 10) != 0) return False;
+
+  char const* p = &sdpLine[10];
+  while (*p != '\0' && *p != ' ') ++p; // skip over <fmt>
+  while (*p == ' ') ++p;
+  if (strncmp(p, "nack", 4) == 0 && (p[4] == '\0' || p[4] == '\r' || p[4] == '\n')) {
+    fSenderSupportsNACKs = True;
+  }
+
+  return True;
+}
+
 Boolean MediaSubsession::parseSDPAttribute_control(char const* sdpLine) {
   // Check for a "a=control:<control-path>" line:
   Boolean parseSuccess = False;
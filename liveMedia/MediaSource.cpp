@@ -67,6 +67,15 @@ Boolean MediaSource::isAMRAudioSource() const {
 Boolean MediaSource::isMPEG2TransportStreamMultiplexor() const {
   return False; // default implementation
 }
+Boolean MediaSource::isMPEG2TransportStreamFramer() const {
+  return False; // default implementation
+}
+Boolean MediaSource::isByteStreamFileSource() const {
+  return False; // default implementation
+}
+Boolean MediaSource::isRTPHintFileSource() const {
+  return False; // default implementation
+}
 
 Boolean MediaSource::lookupByName(UsageEnvironment& env,
 				  char const* sourceName,
@@ -250,6 +250,7 @@ void MultiFramedRTPSink
   }    
 
   if (numTruncatedBytes > 0) {
+    ++fNumTruncatedFrames;
     unsigned const bufferSize = fOutBuf->totalBytesAvailable();
     envir() << "MultiFramedRTPSink::afterGettingFrame1(): The input frame data was too large for our buffer size ("
 	    << bufferSize << ").  "
@@ -369,9 +370,11 @@ void MultiFramedRTPSink::sendPacketIfNecessary() {
     if ((our_random()%10) != 0) // simulate 10% packet loss #####
 #endif
       if (!fRTPInterface.sendPacket(fOutBuf->packet(), fOutBuf->curPacketSize())) {
+	++fNumPacketsDropped;
 	// if failure handler has been specified, call it
 	if (fOnSendErrorFunc != NULL) (*fOnSendErrorFunc)(fOnSendErrorData);
       }
+    noteSentPacket(fOutBuf->packet(), fOutBuf->curPacketSize()); // in case it needs to be retransmitted
     ++fPacketCount;
     fTotalOctetCount += fOutBuf->curPacketSize();
     fOctetCount += fOutBuf->curPacketSize()
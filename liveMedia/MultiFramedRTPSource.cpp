@@ -45,9 +45,21 @@ public:
   }
   Boolean isEmpty() const { return fHeadPacket == NULL; }
 
-  void setThresholdTime(unsigned uSeconds) { fThresholdTime = uSeconds; }
+  void setThresholdTime(unsigned uSeconds) { fThresholdTime = uSeconds; fAdaptThresholdTime = False; }
+  void setAdaptiveThresholdTime(unsigned minUSeconds, unsigned maxUSeconds);
+  unsigned thresholdTime() const { return fThresholdTime; }
+  Boolean adaptsThresholdTime() const { return fAdaptThresholdTime; }
+  void noteJitter(unsigned jitterUSeconds) { fJitterEstimate = jitterUSeconds; }
+  unsigned numLatePacketsDropped() const { return fNumLatePacketsDropped; }
   void resetHaveSeenFirstPacket() { fHaveSeenFirstPacket = False; }
 
+private:
+  void advanceNextExpectedSeqNo(unsigned short newNextExpectedSeqNo, Boolean gaveUpOnSkippedPackets);
+  void noteReorderingDelay(unsigned uSeconds) {
+    if (uSeconds > fReorderingDelayEstimate) fReorderingDelayEstimate = uSeconds; // track peaks immediately
+  }
+  void adaptThresholdTime(struct timeval const& timeNow);
+
 private:
   BufferedPacketFactory* fPacketFactory;
   unsigned fThresholdTime; // uSeconds
@@ -58,6 +70,17 @@ private:
   BufferedPacket* fSavedPacket;
       // to avoid calling new/free in the common case
   Boolean fSavedPacketFree;
+
+  // Used to count late packets, and to adapt the threshold time:
+  Boolean fAdaptThresholdTime;
+  unsigned fMinThresholdTime, fMaxThresholdTime; // uSeconds; used if "fAdaptThresholdTime"
+  double fReorderingDelayEstimate; // uSeconds; a peak estimate that decays over time
+  unsigned fJitterEstimate; // uSeconds
+  struct timeval fLastAdaptationTime;
+  u_int64_t fGivenUpSeqNos;
+      // bit i is set iff we gave up waiting for the packet with seq num "fNextExpectedSeqNo-1-i"
+  struct timeval fTimeOfLastGiveUp;
+  unsigned fNumLatePacketsDropped;
 };
 
 
@@ -68,7 +91,8 @@ MultiFramedRTPSource
 		       unsigned char rtpPayloadFormat,
 		       unsigned rtpTimestampFrequency,
 		       BufferedPacketFactory* packetFactory)
-  : RTPSource(env, RTPgs, rtpPayloadFormat, rtpTimestampFrequency) {
+  : RTPSource(env, RTPgs, rtpPayloadFormat, rtpTimestampFrequency),
+    fPacketToInject(NULL), fPacketToInjectSize(0) {
   reset();
   fReorderingBuffer = new ReorderingPacketBuffer(packetFactory);
 
@@ -215,11 +239,32 @@ void MultiFramedRTPSource::doGetNextFrame1() {
   }
 }
 
+void MultiFramedRTPSource::injectPacket(unsigned char const* packet, unsigned packetSize) {
+  if (fPacketReadInProgress != NULL) return; // we're in the middle of reading a packet (over TCP); can't do this now
+
+  fPacketToInject = packet; fPacketToInjectSize = packetSize;
+  networkReadHandler1();
+  fPacketToInject = NULL;
+}
+
 void MultiFramedRTPSource
 ::setPacketReorderingThresholdTime(unsigned uSeconds) {
   fReorderingBuffer->setThresholdTime(uSeconds);
 }
 
+void MultiFramedRTPSource
+::setAdaptivePacketReorderingThresholdTime(unsigned minUSeconds, unsigned maxUSeconds) {
+  fReorderingBuffer->setAdaptiveThresholdTime(minUSeconds, maxUSeconds);
+}
+
+unsigned MultiFramedRTPSource::packetReorderingThresholdTime() const {
+  return fReorderingBuffer->thresholdTime();
+}
+
+unsigned MultiFramedRTPSource::numLatePacketsDropped() const {
+  return fReorderingBuffer->numLatePacketsDropped();
+}
+
 #define ADVANCE(n) do { bPacket->skip(n); } while (0)
 
 void MultiFramedRTPSource::networkReadHandler(MultiFramedRTPSource* source, int /*mask*/) {
@@ -238,7 +283,11 @@ void MultiFramedRTPSource::networkReadHandler1() {
   do {
     struct sockaddr_in fromAddress;
     Boolean packetReadWasIncomplete = fPacketReadInProgress != NULL;
-    if (!bPacket->fillInData(fRTPInterface, fromAddress, packetReadWasIncomplete)) {
+    if (fPacketToInject != NULL) {
+      // We're being given a packet directly (see "injectPacket()"), rather than reading one from the network:
+      if (!bPacket->fillInData(fPacketToInject, fPacketToInjectSize)) break;
+      memset(&fromAddress, 0, sizeof fromAddress);
+    } else if (!bPacket->fillInData(fRTPInterface, fromAddress, packetReadWasIncomplete)) {
       if (bPacket->bytesAvailable() == 0) { // should not happen??
 	envir() << "MultiFramedRTPSource internal error: Hit limit when reading incoming packet over TCP\n";
       }
@@ -305,7 +354,8 @@ void MultiFramedRTPSource::networkReadHandler1() {
     }
 
     // The rest of the packet is the usable data.  Record and save it:
-    if (rtpSSRC != fLastReceivedSSRC) {
+    Boolean SSRCHasChanged = rtpSSRC != fLastReceivedSSRC;
+    if (SSRCHasChanged) {
       // The SSRC of incoming packets has changed.  Unfortunately we don't yet handle streams that contain multiple SSRCs,
       // but we can handle a single-SSRC stream where the SSRC changes occasionally:
       fLastReceivedSSRC = rtpSSRC;
@@ -322,6 +372,13 @@ void MultiFramedRTPSource::networkReadHandler1() {
 			  timestampFrequency(),
 			  usableInJitterCalculation, presentationTime,
 			  hasBeenSyncedUsingRTCP, bPacket->dataSize());
+    if (fReorderingBuffer->adaptsThresholdTime() && timestampFrequency() > 0) {
+      // Tell the reordering buffer about the current interarrival jitter (converted from timestamp units):
+      RTPReceptionStats* stats = receptionStatsDB().lookup(rtpSSRC);
+      if (stats != NULL) {
+	fReorderingBuffer->noteJitter((unsigned)((stats->jitter()*1000000.0)/timestampFrequency()));
+      }
+    }
 
     // Fill in the rest of the packet descriptor, and store it:
     struct timeval timeNow;
@@ -330,6 +387,7 @@ void MultiFramedRTPSource::networkReadHandler1() {
 			      hasBeenSyncedUsingRTCP, rtpMarkerBit,
 			      timeNow);
     if (!fReorderingBuffer->storePacket(bPacket)) break;
+    noteIncomingSeqNum(rtpSeqNo, SSRCHasChanged); // lets us report any gap in the sequence numbers
 
     readSuccess = True;
   } while (0);
@@ -405,6 +463,15 @@ Boolean BufferedPacket::fillInData(RTPInterface& rtpInterface, struct sockaddr_i
   return True;
 }
 
+Boolean BufferedPacket::fillInData(unsigned char const* packet, unsigned packetSize) {
+  reset();
+  if (packetSize > bytesAvailable()) return False;
+
+  memmove(&fBuf[fTail], packet, packetSize);
+  fTail += packetSize;
+  return True;
+}
+
 void BufferedPacket
 ::assignMiscParams(unsigned short rtpSeqNo, unsigned rtpTimestamp,
 		   struct timeval presentationTime,
@@ -488,7 +555,11 @@ BufferedPacket* BufferedPacketFactory
 ReorderingPacketBuffer
 ::ReorderingPacketBuffer(BufferedPacketFactory* packetFactory)
   : fThresholdTime(100000) /* default reordering threshold: 100 ms */,
-    fHaveSeenFirstPacket(False), fHeadPacket(NULL), fTailPacket(NULL), fSavedPacket(NULL), fSavedPacketFree(True) {
+    fHaveSeenFirstPacket(False), fHeadPacket(NULL), fTailPacket(NULL), fSavedPacket(NULL), fSavedPacketFree(True),
+    fAdaptThresholdTime(False), fMinThresholdTime(0), fMaxThresholdTime(0),
+    fReorderingDelayEstimate(0.0), fJitterEstimate(0), fGivenUpSeqNos(0), fNumLatePacketsDropped(0) {
+  fLastAdaptationTime.tv_sec = fLastAdaptationTime.tv_usec = 0;
+  fTimeOfLastGiveUp.tv_sec = fTimeOfLastGiveUp.tv_usec = 0;
   fPacketFactory = (packetFactory == NULL)
     ? (new BufferedPacketFactory)
     : packetFactory;
@@ -506,6 +577,60 @@ void ReorderingPacketBuffer::reset() {
   fHeadPacket = fTailPacket = fSavedPacket = NULL;
 }
 
+void ReorderingPacketBuffer::setAdaptiveThresholdTime(unsigned minUSeconds, unsigned maxUSeconds) {
+  if (minUSeconds > maxUSeconds) { unsigned tmp = minUSeconds; minUSeconds = maxUSeconds; maxUSeconds = tmp; }
+  fMinThresholdTime = minUSeconds; fMaxThresholdTime = maxUSeconds;
+
+  // Start from the current (fixed) threshold time, and adapt from there:
+  fReorderingDelayEstimate = fThresholdTime;
+  gettimeofday(&fLastAdaptationTime, NULL);
+  fAdaptThresholdTime = True;
+  adaptThresholdTime(fLastAdaptationTime);
+}
+
+static unsigned uSecondsBetween(struct timeval const& from, struct timeval const& to) {
+  int uSeconds = (to.tv_sec - from.tv_sec)*1000000 + (to.tv_usec - from.tv_usec);
+  return uSeconds < 0 ? 0 : (unsigned)uSeconds;
+}
+
+#define REORDERING_DELAY_DECAY_TIME 8.0 /* seconds */
+#define REORDERING_DELAY_MARGIN 1.25
+#define JITTER_MULTIPLE 3.0
+
+void ReorderingPacketBuffer::adaptThresholdTime(struct timeval const& timeNow) {
+  // Let the reordering delay estimate decay, so that the threshold time comes back down once packets stop
+  // being reordered:
+  double elapsed = (timeNow.tv_sec - fLastAdaptationTime.tv_sec)
+    + (timeNow.tv_usec - fLastAdaptationTime.tv_usec)/1000000.0;
+  if (elapsed >= REORDERING_DELAY_DECAY_TIME) {
+    fReorderingDelayEstimate = 0.0;
+  } else if (elapsed > 0.0) {
+    fReorderingDelayEstimate -= fReorderingDelayEstimate*elapsed/REORDERING_DELAY_DECAY_TIME;
+  }
+  fLastAdaptationTime = timeNow;
+
+  // Wait a little longer than the reordering delay that we've seen recently, and long enough to ride out
+  // normal interarrival jitter:
+  double newThresholdTime = fReorderingDelayEstimate*REORDERING_DELAY_MARGIN;
+  if (newThresholdTime < JITTER_MULTIPLE*fJitterEstimate) newThresholdTime = JITTER_MULTIPLE*fJitterEstimate;
+
+  if (newThresholdTime < fMinThresholdTime) newThresholdTime = fMinThresholdTime;
+  else if (newThresholdTime > fMaxThresholdTime) newThresholdTime = fMaxThresholdTime;
+  fThresholdTime = (unsigned)newThresholdTime;
+}
+
+void ReorderingPacketBuffer
+::advanceNextExpectedSeqNo(unsigned short newNextExpectedSeqNo, Boolean gaveUpOnSkippedPackets) {
+  unsigned short numSkipped = newNextExpectedSeqNo - fNextExpectedSeqNo;
+  if (numSkipped >= 64) {
+    fGivenUpSeqNos = gaveUpOnSkippedPackets ? ~(u_int64_t)0 : 0;
+  } else {
+    fGivenUpSeqNos <<= numSkipped;
+    if (gaveUpOnSkippedPackets) fGivenUpSeqNos |= (((u_int64_t)1)<<numSkipped) - 1;
+  }
+  fNextExpectedSeqNo = newNextExpectedSeqNo;
+}
+
 BufferedPacket* ReorderingPacketBuffer::getFreePacket(MultiFramedRTPSource* ourSource) {
   if (fSavedPacket == NULL) { // we're being called for the first time
     fSavedPacket = fPacketFactory->createNewPacket(ourSource);
@@ -525,13 +650,27 @@ Boolean ReorderingPacketBuffer::storePacket(BufferedPacket* bPacket) {
 
   if (!fHaveSeenFirstPacket) {
     fNextExpectedSeqNo = rtpSeqNo; // initialization
+    fGivenUpSeqNos = 0;
     bPacket->isFirstPacket() = True;
     fHaveSeenFirstPacket = True;
   }
+  if (fAdaptThresholdTime) adaptThresholdTime(bPacket->timeReceived());
 
   // Ignore this packet if its sequence number is less than the one
   // that we're looking for (in this case, it's been excessively delayed).
-  if (seqNumLT(rtpSeqNo, fNextExpectedSeqNo)) return False;
+  if (seqNumLT(rtpSeqNo, fNextExpectedSeqNo)) {
+    // If this is a packet that we gave up waiting for (rather than a duplicate of one that we've already
+    // delivered), count it, and note how much longer we would have had to wait for it:
+    unsigned short distance = fNextExpectedSeqNo - 1 - rtpSeqNo;
+    if (distance < 64 && (fGivenUpSeqNos&(((u_int64_t)1)<<distance)) != 0) {
+      fGivenUpSeqNos &=~ (((u_int64_t)1)<<distance);
+      ++fNumLatePacketsDropped;
+      if (fAdaptThresholdTime) {
+	noteReorderingDelay(fThresholdTime + uSecondsBetween(fTimeOfLastGiveUp, bPacket->timeReceived()));
+      }
+    }
+    return False;
+  }
 
   if (fTailPacket == NULL) {
     // Common case: There are no packets in the queue; this will be the first one:
@@ -567,6 +706,12 @@ Boolean ReorderingPacketBuffer::storePacket(BufferedPacket* bPacket) {
     afterPtr = afterPtr->nextPacket();
   }
 
+  // ASSERT: afterPtr != NULL (because this packet precedes "fTailPacket")
+  // Note how long this packet arrived after the (later) packet that follows it:
+  if (fAdaptThresholdTime) {
+    noteReorderingDelay(uSecondsBetween(afterPtr->timeReceived(), bPacket->timeReceived()));
+  }
+
   // Link our new packet between "beforePtr" and "afterPtr":
   bPacket->nextPacket() = afterPtr;
   if (beforePtr == NULL) {
@@ -581,7 +726,7 @@ Boolean ReorderingPacketBuffer::storePacket(BufferedPacket* bPacket) {
 void ReorderingPacketBuffer::releaseUsedPacket(BufferedPacket* packet) {
   // ASSERT: packet == fHeadPacket
   // ASSERT: fNextExpectedSeqNo == packet->rtpSeqNo()
-  ++fNextExpectedSeqNo; // because we're finished with this packet now
+  advanceNextExpectedSeqNo(fNextExpectedSeqNo+1, False); // because we're finished with this packet now
 
   fHeadPacket = fHeadPacket->nextPacket();
   if (!fHeadPacket) { 
@@ -609,19 +754,20 @@ BufferedPacket* ReorderingPacketBuffer
   // our time threshold has been exceeded, then forget it, and return
   // the head packet instead:
   Boolean timeThresholdHasBeenExceeded;
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
   if (fThresholdTime == 0) {
     timeThresholdHasBeenExceeded = True; // optimization
   } else {
-    struct timeval timeNow;
-    gettimeofday(&timeNow, NULL);
     unsigned uSecondsSinceReceived
       = (timeNow.tv_sec - fHeadPacket->timeReceived().tv_sec)*1000000
       + (timeNow.tv_usec - fHeadPacket->timeReceived().tv_usec);
     timeThresholdHasBeenExceeded = uSecondsSinceReceived > fThresholdTime;
   }
   if (timeThresholdHasBeenExceeded) {
-    fNextExpectedSeqNo = fHeadPacket->rtpSeqNo();
+    advanceNextExpectedSeqNo(fHeadPacket->rtpSeqNo(), True);
         // we've given up on earlier packets now
+    fTimeOfLastGiveUp = timeNow;
     packetLossPreceded = True;
     return fHeadPacket;
   }
@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "OnDemandServerMediaSubsession.hh"
+#include "ServerPortAllocator.hh"
 #include <GroupsockHelper.hh>
 
 OnDemandServerMediaSubsession
@@ -30,8 +31,12 @@ OnDemandServerMediaSubsession
   : ServerMediaSubsession(env),
     fSDPLines(NULL), fReuseFirstSource(reuseFirstSource),
     fMultiplexRTCPWithRTP(multiplexRTCPWithRTP), fLastStreamToken(NULL),
-    fAppHandlerTask(NULL), fAppHandlerClientData(NULL) {
+    fAppHandlerTask(NULL), fAppHandlerClientData(NULL),
+    fUseSharedServerPorts(False), fSharedRTPgs(NULL), fSharedRTCPgs(NULL),
+    fSharedServerRTPPort(0), fSharedServerRTCPPort(0), fNumSharedGroupsockUsers(0),
+    fEnableCongestionResponse(False), fEnableRetransmissions(False) {
   fDestinationsHashTable = HashTable::create(ONE_WORD_HASH_KEYS);
+  fSharedRTCPClientTable = new AddressPortLookupTable;
   if (fMultiplexRTCPWithRTP) {
     fInitialPortNum = initialPortNum;
   } else {
@@ -53,6 +58,12 @@ OnDemandServerMediaSubsession::~OnDemandServerMediaSubsession() {
     delete destinations;
   }
   delete fDestinationsHashTable;
+
+  if (fNumSharedGroupsockUsers > 0) { // shouldn't happen, but just in case
+    fNumSharedGroupsockUsers = 1;
+    releaseSharedGroupsocks();
+  }
+  delete fSharedRTCPClientTable;
 }
 
 char const*
@@ -121,55 +132,51 @@ void OnDemandServerMediaSubsession
     Groupsock* rtcpGroupsock = NULL;
 
     if (clientRTPPort.num() != 0 || tcpSocketNum >= 0) { // Normal case: Create destinations
+      // Our environment's "ServerPortAllocator" tells us which server port number(s) to try, so that we
+      // don't have to try each port in turn, skipping over those that are being used by other streams:
       portNumBits serverPortNum;
       if (clientRTCPPort.num() == 0) {
 	// We're streaming raw UDP (not RTP). Create a single groupsock:
 	NoReuse dummy(envir()); // ensures that we skip over ports that are already in use
-	for (serverPortNum = fInitialPortNum; ; ++serverPortNum) {
+	while (ServerPortAllocator::allocate(envir(), fInitialPortNum, 1, False, serverPortNum)) {
 	  struct in_addr dummyAddr; dummyAddr.s_addr = 0;
 	  
 	  serverRTPPort = serverPortNum;
 	  rtpGroupsock = createGroupsock(dummyAddr, serverRTPPort);
 	  if (rtpGroupsock->socketNum() >= 0) break; // success
+
+	  delete rtpGroupsock; rtpGroupsock = NULL;
+	  ServerPortAllocator::markUnavailable(envir(), serverPortNum);
 	}
 
-	udpSink = BasicUDPSink::createNew(envir(), rtpGroupsock);
+	if (rtpGroupsock != NULL) udpSink = BasicUDPSink::createNew(envir(), rtpGroupsock);
       } else {
-	// Normal case: We're streaming RTP (over UDP or TCP).  Create a pair of
-	// groupsocks (RTP and RTCP), with adjacent port numbers (RTP port number even).
-	// (If we're multiplexing RTCP and RTP over the same port number, it can be odd or even.)
-	NoReuse dummy(envir()); // ensures that we skip over ports that are already in use
-	for (portNumBits serverPortNum = fInitialPortNum; ; ++serverPortNum) {
-	  struct in_addr dummyAddr; dummyAddr.s_addr = 0;
-
-	  serverRTPPort = serverPortNum;
-	  rtpGroupsock = createGroupsock(dummyAddr, serverRTPPort);
-	  if (rtpGroupsock->socketNum() < 0) {
-	    delete rtpGroupsock;
-	    continue; // try again
-	  }
-
-	  if (fMultiplexRTCPWithRTP) {
-	    // Use the RTP 'groupsock' object for RTCP as well:
-	    serverRTCPPort = serverRTPPort;
-	    rtcpGroupsock = rtpGroupsock;
-	  } else {
-	    // Create a separate 'groupsock' object (with the next (odd) port number) for RTCP:
-	    serverRTCPPort = ++serverPortNum;
-	    rtcpGroupsock = createGroupsock(dummyAddr, serverRTCPPort);
-	    if (rtcpGroupsock->socketNum() < 0) {
-	      delete rtpGroupsock;
-	      delete rtcpGroupsock;
-	      continue; // try again
-	    }
+	// Normal case: We're streaming RTP (over UDP or TCP).  Create a pair of groupsocks (RTP and RTCP):
+	if (fUseSharedServerPorts && !fReuseFirstSource && tcpSocketNum < 0) {
+	  // All of our RTP-over-UDP clients share the same pair of groupsocks (created for the first of them):
+	  if (fNumSharedGroupsockUsers == 0) {
+	    createRTPandRTCPGroupsocks(fSharedRTPgs, fSharedRTCPgs, fSharedServerRTPPort, fSharedServerRTCPPort);
+	    if (fSharedRTPgs != NULL) startReadingSharedRTCPGroupsock();
 	  }
+	  if (fSharedRTPgs != NULL) ++fNumSharedGroupsockUsers;
 
-	  break; // success
+	  rtpGroupsock = fSharedRTPgs; rtcpGroupsock = fSharedRTCPgs;
+	  serverRTPPort = fSharedServerRTPPort; serverRTCPPort = fSharedServerRTCPPort;
+	} else {
+	  createRTPandRTCPGroupsocks(rtpGroupsock, rtcpGroupsock, serverRTPPort, serverRTCPPort);
 	}
 
-	unsigned char rtpPayloadType = 96 + trackNumber()-1; // if dynamic
-	rtpSink = createNewRTPSink(rtpGroupsock, rtpPayloadType, mediaSource);
-	if (rtpSink != NULL && rtpSink->estimatedBitrate() > 0) streamBitrate = rtpSink->estimatedBitrate();
+	if (rtpGroupsock != NULL) {
+	  unsigned char rtpPayloadType = 96 + trackNumber()-1; // if dynamic
+	  rtpSink = createNewRTPSink(rtpGroupsock, rtpPayloadType, mediaSource);
+	  if (rtpSink != NULL && rtpSink->estimatedBitrate() > 0) streamBitrate = rtpSink->estimatedBitrate();
+	  if (rtpSink != NULL && fEnableCongestionResponse) rtpSink->enableCongestionResponse();
+	  if (rtpSink != NULL && fEnableRetransmissions) rtpSink->enableRetransmissions();
+	  if (rtpSink != NULL && rtpGroupsock == fSharedRTPgs) {
+	    // Our RTP packets must go only to this client:
+	    rtpSink->setUnicastDestination(destinationAddr, clientRTPPort);
+	  }
+	}
       }
 
       // Turn off the destinations for each groupsock.  They'll get set later
@@ -182,6 +189,7 @@ void OnDemandServerMediaSubsession
 	// specified bandwidth and at least 50 KB
 	unsigned rtpBufSize = streamBitrate * 25 / 2; // 1 kbps * 0.1 s = 12.5 bytes
 	if (rtpBufSize < 50 * 1024) rtpBufSize = 50 * 1024;
+	if (rtpGroupsock == fSharedRTPgs) rtpBufSize *= fNumSharedGroupsockUsers; // it's being used by each of them
 	increaseSendBufferTo(envir(), rtpGroupsock->socketNum(), rtpBufSize);
       }
     }
@@ -392,6 +400,90 @@ void OnDemandServerMediaSubsession::closeStreamSource(FramedSource *inputSource)
   Medium::close(inputSource);
 }
 
+void OnDemandServerMediaSubsession
+::createRTPandRTCPGroupsocks(Groupsock*& rtpGroupsock, Groupsock*& rtcpGroupsock,
+			     Port& serverRTPPort, Port& serverRTCPPort) {
+  // Create a pair of groupsocks (RTP and RTCP), with adjacent port numbers (RTP port number even).
+  // (If we're multiplexing RTCP and RTP over the same port number, it can be odd or even.)
+  rtpGroupsock = rtcpGroupsock = NULL;
+  NoReuse dummy(envir()); // ensures that we skip over ports that are already in use
+  unsigned const numPorts = fMultiplexRTCPWithRTP ? 1 : 2;
+  portNumBits serverPortNum;
+  while (ServerPortAllocator::allocate(envir(), fInitialPortNum, numPorts, !fMultiplexRTCPWithRTP,
+				       serverPortNum)) {
+    struct in_addr dummyAddr; dummyAddr.s_addr = 0;
+
+    serverRTPPort = serverPortNum;
+    rtpGroupsock = createGroupsock(dummyAddr, serverRTPPort);
+    if (rtpGroupsock->socketNum() < 0) {
+      delete rtpGroupsock; rtpGroupsock = NULL;
+      if (numPorts == 2) ServerPortAllocator::release(envir(), serverPortNum+1);
+      ServerPortAllocator::markUnavailable(envir(), serverPortNum);
+      continue; // try again
+    }
+
+    if (fMultiplexRTCPWithRTP) {
+      // Use the RTP 'groupsock' object for RTCP as well:
+      serverRTCPPort = serverRTPPort;
+      rtcpGroupsock = rtpGroupsock;
+    } else {
+      // Create a separate 'groupsock' object (with the next (odd) port number) for RTCP:
+      serverRTCPPort = ++serverPortNum;
+      rtcpGroupsock = createGroupsock(dummyAddr, serverRTCPPort);
+      if (rtcpGroupsock->socketNum() < 0) {
+	delete rtpGroupsock; rtpGroupsock = NULL;
+	delete rtcpGroupsock; rtcpGroupsock = NULL;
+	ServerPortAllocator::release(envir(), serverPortNum-1);
+	ServerPortAllocator::markUnavailable(envir(), serverPortNum);
+	continue; // try again
+      }
+    }
+
+    break; // success
+  }
+}
+
+void OnDemandServerMediaSubsession::startReadingSharedRTCPGroupsock() {
+  // (This is also called after each new client's "RTCPInstance" is created, because its constructor will have
+  //  taken over the handling of the socket.)
+  envir().taskScheduler()
+    .turnOnBackgroundReadHandling(fSharedRTCPgs->socketNum(),
+				  (TaskScheduler::BackgroundHandlerProc*)&incomingSharedRTCPHandler, this);
+}
+
+void OnDemandServerMediaSubsession
+::incomingSharedRTCPHandler(OnDemandServerMediaSubsession* subsession, int /*mask*/) {
+  subsession->incomingSharedRTCPHandler1();
+}
+
+void OnDemandServerMediaSubsession::incomingSharedRTCPHandler1() {
+  unsigned char packet[1500];
+  unsigned packetSize;
+  struct sockaddr_in fromAddress;
+  if (!fSharedRTCPgs->handleRead(packet, sizeof packet, packetSize, fromAddress) || packetSize == 0) return;
+
+  // Give the packet to the stream of the client that it came from (if any):
+  StreamState* streamState
+    = (StreamState*)(fSharedRTCPClientTable->Lookup(fromAddress.sin_addr.s_addr, (~0),
+						     Port(ntohs(fromAddress.sin_port))));
+  if (streamState != NULL && streamState->rtcpInstance() != NULL) {
+    streamState->rtcpInstance()->injectReport(packet, packetSize, fromAddress);
+  }
+}
+
+void OnDemandServerMediaSubsession::releaseSharedGroupsocks() {
+  if (fNumSharedGroupsockUsers == 0 || --fNumSharedGroupsockUsers > 0) return;
+
+  // Nobody else is using the shared groupsocks now, so close them:
+  envir().taskScheduler().turnOffBackgroundReadHandling(fSharedRTCPgs->socketNum());
+  ServerPortAllocator::release(envir(), ntohs(fSharedServerRTPPort.num()));
+  if (fSharedRTCPgs != fSharedRTPgs) ServerPortAllocator::release(envir(), ntohs(fSharedServerRTCPPort.num()));
+
+  if (fSharedRTCPgs != fSharedRTPgs) delete fSharedRTCPgs;
+  delete fSharedRTPgs;
+  fSharedRTPgs = fSharedRTCPgs = NULL;
+}
+
 Groupsock* OnDemandServerMediaSubsession
 ::createGroupsock(struct in_addr const& addr, Port port) {
   // Default implementation; may be redefined by subclasses:
@@ -429,6 +521,12 @@ void OnDemandServerMediaSubsession
   AddressString ipAddressStr(fServerAddressForSDP);
   char* rtpmapLine = rtpSink->rtpmapLine();
   char const* rtcpmuxLine = fMultiplexRTCPWithRTP ? "a=rtcp-mux\r\n" : "";
+  char rtcpFBLines[60];
+  if (fEnableRetransmissions) {
+    sprintf(rtcpFBLines, "a=rtcp-fb:%d nack\r\na=rtcp-fb:%d nack pli\r\n", rtpPayloadType, rtpPayloadType);
+  } else {
+    rtcpFBLines[0] = '\0';
+  }
   char const* rangeLine = rangeSDPLine();
   char const* auxSDPLine = getAuxSDPLine(rtpSink, inputSource);
   if (auxSDPLine == NULL) auxSDPLine = "";
@@ -441,6 +539,7 @@ void OnDemandServerMediaSubsession
     "%s"
     "%s"
     "%s"
+    "%s"
     "a=control:%s\r\n";
   unsigned sdpFmtSize = strlen(sdpFmt)
     + strlen(mediaType) + 5 /* max short len */ + 3 /* max char len */
@@ -448,6 +547,7 @@ void OnDemandServerMediaSubsession
     + 20 /* max int len */
     + strlen(rtpmapLine)
     + strlen(rtcpmuxLine)
+    + strlen(rtcpFBLines)
     + strlen(rangeLine)
     + strlen(auxSDPLine)
     + strlen(trackId());
@@ -460,6 +560,7 @@ void OnDemandServerMediaSubsession
 	  estBitrate, // b=AS:<bandwidth>
 	  rtpmapLine, // a=rtpmap:... (if present)
 	  rtcpmuxLine, // a=rtcp-mux:... (if present)
+	  rtcpFBLines, // a=rtcp-fb:... (if present)
 	  rangeLine, // a=range:... (if present)
 	  auxSDPLine, // optional extra SDP line
 	  trackId()); // a=control:<track-id>
@@ -514,6 +615,12 @@ void StreamState
     fRTCPInstance = fMaster.createRTCP(fRTCPgs, fTotalBW, (unsigned char*)fMaster.fCNAME, fRTPSink);
         // Note: This starts RTCP running automatically
     fRTCPInstance->setAppHandler(fMaster.fAppHandlerTask, fMaster.fAppHandlerClientData);
+
+    if (usesSharedGroupsocks() && !dests->isTCP) {
+      // Our RTCP packets must go only to this client, and incoming RTCP packets will be given to us:
+      fRTCPInstance->setUnicastDestination(dests->addr, dests->rtcpPort);
+      fMaster.startReadingSharedRTCPGroupsock();
+    }
   }
 
   if (dests->isTCP) {
@@ -530,6 +637,14 @@ void StreamState
       fRTCPInstance->setSpecificRRHandler(dests->tcpSocketNum, dests->rtcpChannelId,
 					  rtcpRRHandler, rtcpRRHandlerClientData);
     }
+  } else if (usesSharedGroupsocks()) {
+    // Our 'groupsocks' are shared, so don't give them any destinations (we send to this client only);
+    // instead, note which client's incoming RTCP packets are for us:
+    fMaster.fSharedRTCPClientTable->Add(dests->addr.s_addr, (~0), dests->rtcpPort, this);
+    if (fRTCPInstance != NULL) {
+      fRTCPInstance->setSpecificRRHandler(dests->addr.s_addr, dests->rtcpPort,
+					  rtcpRRHandler, rtcpRRHandlerClientData);
+    }
   } else {
     // Tell the RTP and RTCP 'groupsocks' about this destination
     // (in case they don't already have it):
@@ -589,6 +704,11 @@ void StreamState::endPlaying(Destinations* dests, unsigned clientSessionId) {
       fRTCPInstance->removeStreamSocket(dests->tcpSocketNum, dests->rtcpChannelId);
       fRTCPInstance->unsetSpecificRRHandler(dests->tcpSocketNum, dests->rtcpChannelId);
     }
+  } else if (usesSharedGroupsocks()) {
+    fMaster.fSharedRTCPClientTable->Remove(dests->addr.s_addr, (~0), dests->rtcpPort);
+    if (fRTCPInstance != NULL) {
+      fRTCPInstance->unsetSpecificRRHandler(dests->addr.s_addr, dests->rtcpPort);
+    }
   } else {
     // Tell the RTP and RTCP 'groupsocks' to stop using these destinations:
     if (fRTPgs != NULL) fRTPgs->removeDestination(clientSessionId);
@@ -615,7 +735,15 @@ void StreamState::reclaim() {
   fMaster.closeStreamSource(fMediaSource); fMediaSource = NULL;
   if (fMaster.fLastStreamToken == this) fMaster.fLastStreamToken = NULL;
 
-  delete fRTPgs;
-  if (fRTCPgs != fRTPgs) delete fRTCPgs;
+  if (usesSharedGroupsocks()) {
+    fMaster.releaseSharedGroupsocks();
+  } else {
+    // Give back the server port number(s) that our 'groupsocks' were using:
+    if (fRTPgs != NULL) ServerPortAllocator::release(fMaster.envir(), ntohs(fServerRTPPort.num()));
+    if (fRTCPgs != NULL && fRTCPgs != fRTPgs) ServerPortAllocator::release(fMaster.envir(), ntohs(fServerRTCPPort.num()));
+
+    delete fRTPgs;
+    if (fRTCPgs != fRTPgs) delete fRTCPgs;
+  }
   fRTPgs = NULL; fRTCPgs = NULL;
 }
@@ -21,6 +21,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "RTCP.hh"
 #include "GroupsockHelper.hh"
 #include "rtcp_from_spec.h"
+#include <math.h>
 #if defined(__WIN32__) || defined(_WIN32) || defined(_QNX4)
 #define snprintf _snprintf
 #endif
@@ -31,34 +32,41 @@ class RTCPMemberDatabase {
 public:
   RTCPMemberDatabase(RTCPInstance& ourRTCPInstance)
     : fOurRTCPInstance(ourRTCPInstance), fNumMembers(1 /*ourself*/),
-      fTable(HashTable::create(ONE_WORD_HASH_KEYS)) {
+      fMembers(NULL), fNumEntries(0), fArraySize(0), fLastLookedUpIndex(0) {
   }
 
   virtual ~RTCPMemberDatabase() {
-	delete fTable;
+	delete[] fMembers;
   }
 
   Boolean isMember(u_int32_t ssrc) const {
-    return fTable->Lookup((char*)(long)ssrc) != NULL;
+    Boolean wasFound;
+    (void)lookupIndex(ssrc, wasFound);
+    return wasFound;
   }
 
   Boolean noteMembership(u_int32_t ssrc, unsigned curTimeCount) {
-    Boolean isNew = !isMember(ssrc);
+    Boolean wasFound;
+    unsigned i = lookupIndex(ssrc, wasFound);
 
-    if (isNew) {
+    if (!wasFound) {
       ++fNumMembers;
+      insertAt(i, ssrc);
     }
 
     // Record the current time, so we can age stale members
-    fTable->Add((char*)(long)ssrc, (void*)(long)curTimeCount);
+    fMembers[i].timeCount = curTimeCount;
 
-    return isNew;
+    return !wasFound;
   }
 
   Boolean remove(u_int32_t ssrc) {
-    Boolean wasPresent = fTable->Remove((char*)(long)ssrc);
+    Boolean wasPresent;
+    unsigned i = lookupIndex(ssrc, wasPresent);
     if (wasPresent) {
       --fNumMembers;
+      --fNumEntries;
+      memmove(&fMembers[i], &fMembers[i+1], (fNumEntries-i)*sizeof (Member));
     }
     return wasPresent;
   }
@@ -69,46 +77,86 @@ public:
 
   void reapOldMembers(unsigned threshold);
 
+private:
+  unsigned lookupIndex(u_int32_t ssrc, Boolean& wasFound) const;
+  void insertAt(unsigned i, u_int32_t ssrc);
+
 private:
   RTCPInstance& fOurRTCPInstance;
   unsigned fNumMembers;
-  HashTable* fTable;
+
+  // The members (other than ourself) are kept in a compact array, sorted by SSRC:
+  struct Member {
+    u_int32_t ssrc;
+    unsigned timeCount;
+  };
+  Member* fMembers;
+  unsigned fNumEntries, fArraySize;
+  mutable unsigned fLastLookedUpIndex; // fast path for repeated reports from the same SSRC
 };
 
-void RTCPMemberDatabase::reapOldMembers(unsigned threshold) {
-  Boolean foundOldMember;
-  u_int32_t oldSSRC = 0;
+unsigned RTCPMemberDatabase::lookupIndex(u_int32_t ssrc, Boolean& wasFound) const {
+  if (fLastLookedUpIndex < fNumEntries && fMembers[fLastLookedUpIndex].ssrc == ssrc) {
+    wasFound = True;
+    return fLastLookedUpIndex;
+  }
 
-  do {
-    foundOldMember = False;
+  unsigned lo = 0, hi = fNumEntries;
+  while (lo < hi) {
+    unsigned mid = (lo + hi)/2;
+    if (fMembers[mid].ssrc == ssrc) {
+      wasFound = True;
+      fLastLookedUpIndex = mid;
+      return mid;
+    } else if (fMembers[mid].ssrc < ssrc) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  wasFound = False;
+  return lo;
+}
+
+void RTCPMemberDatabase::insertAt(unsigned i, u_int32_t ssrc) {
+  if (fNumEntries == fArraySize) {
+    // Grow the array:
+    unsigned newSize = fArraySize == 0 ? 4 : 2*fArraySize;
+    Member* newMembers = new Member[newSize];
+    if (fNumEntries > 0) memmove(newMembers, fMembers, fNumEntries*sizeof (Member));
+    delete[] fMembers;
+    fMembers = newMembers;
+    fArraySize = newSize;
+  }
+
+  memmove(&fMembers[i+1], &fMembers[i], (fNumEntries-i)*sizeof (Member));
+  fMembers[i].ssrc = ssrc;
+  fMembers[i].timeCount = 0;
+  ++fNumEntries;
+}
 
-    HashTable::Iterator* iter
-      = HashTable::Iterator::create(*fTable);
-    uintptr_t timeCount;
-    char const* key;
-    while ((timeCount = (uintptr_t)(iter->next(key))) != 0) {
+void RTCPMemberDatabase::reapOldMembers(unsigned threshold) {
+  // Walk the array backwards, so that removing an entry (which shifts down only the entries
+  // after it) doesn't disturb the walk:
+  for (unsigned i = fNumEntries; i > 0; --i) {
+    Member const& member = fMembers[i-1];
 #ifdef DEBUG
-      fprintf(stderr, "reap: checking SSRC 0x%lx: %ld (threshold %d)\n", (unsigned long)key, timeCount, threshold);
+    fprintf(stderr, "reap: checking SSRC 0x%x: %d (threshold %d)\n", member.ssrc, member.timeCount, threshold);
 #endif
-      if (timeCount < (uintptr_t)threshold) { // this SSRC is old
-        uintptr_t ssrc = (uintptr_t)key;
-        oldSSRC = (u_int32_t)ssrc;
-        foundOldMember = True;
-      }
-    }
-    delete iter;
-
-    if (foundOldMember) {
+    if (member.timeCount < threshold) { // this SSRC is old
+      u_int32_t oldSSRC = member.ssrc;
 #ifdef DEBUG
-        fprintf(stderr, "reap: removing SSRC 0x%x\n", oldSSRC);
+      fprintf(stderr, "reap: removing SSRC 0x%x\n", oldSSRC);
 #endif
-	fOurRTCPInstance.removeSSRC(oldSSRC, True);
+      fOurRTCPInstance.removeSSRC(oldSSRC, True);
+      if (i > fNumEntries) i = fNumEntries + 1; // in case more than one entry went away
     }
-  } while (foundOldMember);
+  }
 }
 
 
-////////// RTCPInstance //////////
+////////// RTCPReportScheduler //////////
 
 static double dTimeNow() {
     struct timeval timeNow;
@@ -116,6 +164,192 @@ static double dTimeNow() {
     return (double) (timeNow.tv_sec + timeNow.tv_usec/1000000.0);
 }
 
+// Rather than have each "RTCPInstance" schedule its own delayed task for its next report (which - for a server
+// with thousands of sessions - would make the environment's delay queue very long), all "RTCPInstance"s
+// in an environment share a single delayed task.  Their next report times are kept in a binary min-heap, and each
+// time the task fires, we handle all instances whose reports are now due, in a single pass.
+
+class RTCPReportScheduler {
+public:
+  static RTCPReportScheduler* ourScheduler(UsageEnvironment& env, Boolean createIfNotPresent = True);
+
+  void schedule(RTCPInstance* instance, double nextTime);
+  void unschedule(RTCPInstance* instance);
+
+private:
+  RTCPReportScheduler(UsageEnvironment& env);
+  virtual ~RTCPReportScheduler();
+
+  void reclaimIfPossible();
+
+  void siftUp(unsigned i);
+  void siftDown(unsigned i);
+  void place(unsigned i, RTCPInstance* instance) {
+    fHeap[i] = instance;
+    instance->fReportSchedulerIndex = (int)i;
+  }
+  void removeAt(unsigned i);
+
+  void updateTimer();
+  static void timeoutHandler(void* clientData);
+  void timeoutHandler1();
+
+private:
+  UsageEnvironment& fEnv;
+  RTCPInstance** fHeap;
+  unsigned fNumScheduled, fHeapSize;
+  TaskToken fTimerTask;
+  double fTimerTime;
+  Boolean fIsHandlingTimeout;
+};
+
+RTCPReportScheduler* RTCPReportScheduler::ourScheduler(UsageEnvironment& env, Boolean createIfNotPresent) {
+  _Tables* ourTables = _Tables::getOurTables(env, createIfNotPresent);
+  if (ourTables == NULL) return NULL;
+
+  if (ourTables->rtcpReportScheduler == NULL && createIfNotPresent) {
+    ourTables->rtcpReportScheduler = new RTCPReportScheduler(env);
+  }
+  return (RTCPReportScheduler*)(ourTables->rtcpReportScheduler);
+}
+
+RTCPReportScheduler::RTCPReportScheduler(UsageEnvironment& env)
+  : fEnv(env), fHeap(NULL), fNumScheduled(0), fHeapSize(0),
+    fTimerTask(NULL), fTimerTime(0.0), fIsHandlingTimeout(False) {
+}
+
+RTCPReportScheduler::~RTCPReportScheduler() {
+  fEnv.taskScheduler().unscheduleDelayedTask(fTimerTask);
+  delete[] fHeap;
+}
+
+void RTCPReportScheduler::reclaimIfPossible() {
+  if (fNumScheduled > 0 || fIsHandlingTimeout) return;
+
+  _Tables* ourTables = _Tables::getOurTables(fEnv, False);
+  if (ourTables != NULL) {
+    ourTables->rtcpReportScheduler = NULL;
+    ourTables->reclaimIfPossible();
+  }
+  delete this;
+}
+
+void RTCPReportScheduler::schedule(RTCPInstance* instance, double nextTime) {
+  instance->fNextReportTime = nextTime;
+
+  if (instance->fReportSchedulerIndex >= 0) {
+    // The instance is already scheduled; just move it to its new place in the heap:
+    siftUp((unsigned)instance->fReportSchedulerIndex);
+    siftDown((unsigned)instance->fReportSchedulerIndex);
+  } else {
+    if (fNumScheduled == fHeapSize) {
+      // Grow the heap:
+      unsigned newSize = fHeapSize == 0 ? 16 : 2*fHeapSize;
+      RTCPInstance** newHeap = new RTCPInstance*[newSize];
+      for (unsigned i = 0; i < fNumScheduled; ++i) newHeap[i] = fHeap[i];
+      delete[] fHeap;
+      fHeap = newHeap;
+      fHeapSize = newSize;
+    }
+    place(fNumScheduled, instance);
+    siftUp(fNumScheduled++);
+  }
+
+  updateTimer();
+}
+
+void RTCPReportScheduler::unschedule(RTCPInstance* instance) {
+  if (instance->fReportSchedulerIndex >= 0) {
+    removeAt((unsigned)instance->fReportSchedulerIndex);
+    updateTimer();
+  }
+
+  reclaimIfPossible();
+}
+
+void RTCPReportScheduler::siftUp(unsigned i) {
+  RTCPInstance* instance = fHeap[i];
+  while (i > 0) {
+    unsigned parent = (i-1)/2;
+    if (fHeap[parent]->fNextReportTime <= instance->fNextReportTime) break;
+    place(i, fHeap[parent]);
+    i = parent;
+  }
+  place(i, instance);
+}
+
+void RTCPReportScheduler::siftDown(unsigned i) {
+  RTCPInstance* instance = fHeap[i];
+  while (1) {
+    unsigned child = 2*i + 1;
+    if (child >= fNumScheduled) break;
+    if (child+1 < fNumScheduled && fHeap[child+1]->fNextReportTime < fHeap[child]->fNextReportTime) ++child;
+    if (instance->fNextReportTime <= fHeap[child]->fNextReportTime) break;
+    place(i, fHeap[child]);
+    i = child;
+  }
+  place(i, instance);
+}
+
+void RTCPReportScheduler::removeAt(unsigned i) {
+  fHeap[i]->fReportSchedulerIndex = -1;
+
+  if (--fNumScheduled > i) {
+    // Move the last entry into the vacated slot, and restore the heap property:
+    RTCPInstance* movedInstance = fHeap[fNumScheduled];
+    place(i, movedInstance);
+    siftUp(i);
+    siftDown((unsigned)movedInstance->fReportSchedulerIndex);
+  }
+}
+
+void RTCPReportScheduler::updateTimer() {
+  if (fIsHandlingTimeout) return; // the timer will get updated when we're done
+
+  if (fNumScheduled == 0) {
+    fEnv.taskScheduler().unscheduleDelayedTask(fTimerTask);
+    return;
+  }
+
+  double earliestTime = fHeap[0]->fNextReportTime;
+  if (fTimerTask != NULL && fTimerTime <= earliestTime) return; // the existing timer will fire in time
+
+  // (Re)schedule our timer for the earliest report time.  (If the earliest report time later moves further
+  // into the future, we just let the existing timer fire early; it'll then get rescheduled.)
+  fEnv.taskScheduler().unscheduleDelayedTask(fTimerTask);
+  double secondsToDelay = earliestTime - dTimeNow();
+  if (secondsToDelay < 0) secondsToDelay = 0;
+  int64_t usToGo = (int64_t)ceil(secondsToDelay * 1000000); // round up, so that we don't wake up too soon
+  fTimerTime = earliestTime;
+  fTimerTask = fEnv.taskScheduler().scheduleDelayedTask(usToGo, timeoutHandler, this);
+}
+
+void RTCPReportScheduler::timeoutHandler(void* clientData) {
+  ((RTCPReportScheduler*)clientData)->timeoutHandler1();
+}
+
+void RTCPReportScheduler::timeoutHandler1() {
+  fTimerTask = NULL;
+  fIsHandlingTimeout = True;
+
+  // Handle each instance whose report is now due.  (We limit this to the number of instances that were
+  // scheduled when we started, in case an instance reschedules itself for a time that's already passed.)
+  double timeNow = dTimeNow();
+  unsigned numToHandle = fNumScheduled;
+  while (fNumScheduled > 0 && numToHandle-- > 0 && fHeap[0]->fNextReportTime <= timeNow) {
+    RTCPInstance* instance = fHeap[0];
+    removeAt(0);
+    instance->onExpire1(); // this will usually reschedule "instance"
+  }
+
+  fIsHandlingTimeout = False;
+  updateTimer();
+  reclaimIfPossible();
+}
+
+
+////////// RTCPInstance //////////
+
 static unsigned const maxRTCPPacketSize = 1456;
 	// bytes (1500, minus some allowance for IP, UDP, UMTP headers)
 static unsigned const preferredRTCPPacketSize = 1000; // bytes
@@ -128,7 +362,7 @@ RTCPInstance::RTCPInstance(UsageEnvironment& env, Groupsock* RTCPgs,
   : Medium(env), fRTCPInterface(this, RTCPgs), fTotSessionBW(totSessionBW),
     fSink(sink), fSource(source), fIsSSMSource(isSSMSource),
     fCNAME(RTCP_SDES_CNAME, cname), fOutgoingReportCount(1),
-    fAveRTCPSize(0), fIsInitial(1), fPrevNumMembers(0),
+    fAveRTCPSize(0), fIsInitial(1), fReportSchedulerIndex(-1), fPrevNumMembers(0),
     fLastSentSize(0), fLastReceivedSize(0), fLastReceivedSSRC(0),
     fTypeOfEvent(EVENT_UNKNOWN), fTypeOfPacket(PACKET_UNKNOWN_TYPE),
     fHaveJustSentPacket(False), fLastPacketSentSize(0),
@@ -136,7 +370,7 @@ RTCPInstance::RTCPInstance(UsageEnvironment& env, Groupsock* RTCPgs,
     fSRHandlerTask(NULL), fSRHandlerClientData(NULL),
     fRRHandlerTask(NULL), fRRHandlerClientData(NULL),
     fSpecificRRHandlerTable(NULL),
-    fAppHandlerTask(NULL), fAppHandlerClientData(NULL) {
+    fAppHandlerTask(NULL), fAppHandlerClientData(NULL), fNACKsAreEnabled(False) {
 #ifdef DEBUG
   fprintf(stderr, "RTCPInstance[%p]::RTCPInstance()\n", this);
 #endif
@@ -188,6 +422,11 @@ RTCPInstance::~RTCPInstance() {
   fTypeOfEvent = EVENT_BYE; // not used, but...
   sendBYE();
 
+  RTCPReportScheduler* reportScheduler = RTCPReportScheduler::ourScheduler(envir(), False);
+  if (reportScheduler != NULL) reportScheduler->unschedule(this);
+
+  enableNACKs(False);
+
   if (fSource != NULL && fSource->RTPgs() == fRTCPInterface.gs()) {
     // We were receiving RTCP reports that were multiplexed with RTP, so tell the RTP source
     // to stop giving them to us:
@@ -375,6 +614,52 @@ void RTCPInstance::sendAppPacket(u_int8_t subtype, char const* name,
   sendBuiltPacket();
 }
 
+void RTCPInstance::sendNACK(u_int16_t firstLostSeqNum, unsigned numLostPackets) {
+  if (fSource == NULL || numLostPackets == 0) return;
+
+  // Each 'FCI' word names a lost packet ("PID"), followed by a bitmask ("BLP") of up to 16 more lost packets:
+  unsigned const maxNumFCIs = 16;
+  u_int32_t fci[maxNumFCIs];
+  unsigned numFCIs = 0;
+  while (numLostPackets > 0 && numFCIs < maxNumFCIs) {
+    unsigned numInThisFCI = numLostPackets > 17 ? 17 : numLostPackets;
+    u_int16_t blp = (u_int16_t)((1<<(numInThisFCI-1)) - 1);
+    fci[numFCIs++] = (firstLostSeqNum<<16)|blp;
+    firstLostSeqNum += numInThisFCI;
+    numLostPackets -= numInThisFCI;
+  }
+
+  addFeedbackPrefix(RTCP_PT_RTPFB, 1/*generic NACK*/, numFCIs);
+  for (unsigned i = 0; i < numFCIs; ++i) fOutBuf->enqueueWord(fci[i]);
+  sendBuiltPacket();
+}
+
+void RTCPInstance::sendPLI() {
+  if (fSource == NULL) return;
+
+  addFeedbackPrefix(RTCP_PT_PSFB, 1/*PLI*/, 0);
+  sendBuiltPacket();
+}
+
+void RTCPInstance::enableNACKs(Boolean enable) {
+  if (fSource == NULL || enable == fNACKsAreEnabled) return;
+
+  if (enable) {
+    fSource->setPacketLossHandler(packetLossHandler, this);
+  } else {
+    fSource->setPacketLossHandler(NULL, NULL);
+  }
+  fNACKsAreEnabled = enable;
+}
+
+void RTCPInstance::packetLossHandler(void* clientData, u_int16_t firstLostSeqNum, unsigned numLostPackets) {
+  RTCPInstance* instance = (RTCPInstance*)clientData;
+#ifdef DEBUG
+  fprintf(stderr, "RTCPInstance[%p]: sending NACK for %u packet(s), beginning with seq num %u\n", instance, numLostPackets, firstLostSeqNum);
+#endif
+  instance->sendNACK(firstLostSeqNum, numLostPackets);
+}
+
 void RTCPInstance::setStreamSocket(int sockNum,
 				   unsigned char streamChannelId) {
   // Turn off background read handling:
@@ -523,11 +808,13 @@ void RTCPInstance
     // Check the RTCP packet for validity:
     // It must at least contain a header (4 bytes), and this header
     // must be version=2, with no padding bit, and a payload type of
-    // SR (200), RR (201), or APP (204):
+    // SR (200), RR (201), APP (204), or - for 'reduced-size' RTCP (RFC 5506) - RTPFB (205) or PSFB (206):
     if (packetSize < 4) break;
     unsigned rtcpHdr = ntohl(*(u_int32_t*)pkt);
     if ((rtcpHdr & 0xE0FE0000) != (0x80000000 | (RTCP_PT_SR<<16)) &&
-	(rtcpHdr & 0xE0FF0000) != (0x80000000 | (RTCP_PT_APP<<16))) {
+	(rtcpHdr & 0xE0FF0000) != (0x80000000 | (RTCP_PT_APP<<16)) &&
+	(rtcpHdr & 0xE0FF0000) != (0x80000000 | (RTCP_PT_RTPFB<<16)) &&
+	(rtcpHdr & 0xE0FF0000) != (0x80000000 | (RTCP_PT_PSFB<<16))) {
 #ifdef DEBUG
       fprintf(stderr, "rejected bad RTCP packet: header 0x%08x\n", rtcpHdr);
 #endif
@@ -571,13 +858,15 @@ void RTCPInstance
 	  unsigned NTPmsw = ntohl(*(u_int32_t*)pkt); ADVANCE(4);
 	  unsigned NTPlsw = ntohl(*(u_int32_t*)pkt); ADVANCE(4);
 	  unsigned rtpTimestamp = ntohl(*(u_int32_t*)pkt); ADVANCE(4);
+	  unsigned senderPacketCount = ntohl(*(u_int32_t*)pkt); ADVANCE(4);
+	  unsigned senderOctetCount = ntohl(*(u_int32_t*)pkt); ADVANCE(4);
 	  if (fSource != NULL) {
 	    RTPReceptionStatsDB& receptionStats
 	      = fSource->receptionStatsDB();
 	    receptionStats.noteIncomingSR(reportSenderSSRC,
-					  NTPmsw, NTPlsw, rtpTimestamp);
+					  NTPmsw, NTPlsw, rtpTimestamp,
+					  senderPacketCount, senderOctetCount);
 	  }
-	  ADVANCE(8); // skip over packet count, octet count
 
 	  // If a 'SR handler' was set, call it now:
 	  if (fSRHandlerTask != NULL) (*fSRHandlerTask)(fSRHandlerClientData);
@@ -751,14 +1040,39 @@ void RTCPInstance
 	}
         case RTCP_PT_RTPFB: {
 #ifdef DEBUG
-	  fprintf(stderr, "RTPFB(unhandled)\n");
+	  fprintf(stderr, "RTPFB\n");
 #endif
+	  if (length < 4) break;
+	  u_int32_t mediaSSRC = ntohl(*(u_int32_t*)pkt);
+	  if (rc == 1/*generic NACK*/ && fSink != NULL && mediaSSRC == fSink->SSRC()) {
+	    // Each 'FCI' word is a lost packet's seq num, followed by a bitmask of (up to 16) more lost packets:
+	    for (unsigned i = 4; i + 4 <= length; i += 4) {
+	      fSink->noteIncomingNACK((pkt[i]<<8)|pkt[i+1], (pkt[i+2]<<8)|pkt[i+3]);
+	    }
+	  }
 	  subPacketOK = True;
 	  break;
 	}
         case RTCP_PT_PSFB: {
 #ifdef DEBUG
-	  fprintf(stderr, "PSFB(unhandled)\n");
+	  fprintf(stderr, "PSFB\n");
+#endif
+	  if (length < 4) break;
+	  if (fSink != NULL) {
+	    u_int32_t mediaSSRC = ntohl(*(u_int32_t*)pkt);
+	    if (rc == 1/*PLI*/ && mediaSSRC == fSink->SSRC()) {
+	      fSink->noteIncomingKeyFrameRequest();
+	    } else if (rc == 4/*FIR*/) {
+	      // Each 'FCI' entry (8 bytes) begins with the SSRC of a media sender that should send a key frame:
+	      for (unsigned i = 4; i + 8 <= length; i += 8) {
+		if (ntohl(*(u_int32_t*)&pkt[i]) == fSink->SSRC()) {
+		  fSink->noteIncomingKeyFrameRequest();
+		  break;
+		}
+	      }
+	    }
+	  }
+#ifdef DEBUG
 	  // Temporary code to show "Receiver Estimated Maximum Bitrate" (REMB) feedback reports:
 	  //#####
 	  if (length >= 12 && pkt[4] == 'R' && pkt[5] == 'E' && pkt[6] == 'M' && pkt[7] == 'B') {
@@ -932,6 +1246,24 @@ void RTCPInstance::sendBYE(char const* reason) {
   sendBuiltPacket();
 }
 
+void RTCPInstance::addFeedbackPrefix(unsigned char packetType, u_int8_t fmt, unsigned numFCIWords) {
+  // ASSERT: fSource != NULL
+  // A feedback message must be sent as part of a compound RTCP packet (RFC 4585, section 3.1), so we begin with
+  // an empty "RR" (so as not to disturb the reception stats that our next regular report will use), and a "SDES":
+  fOutBuf->enqueueWord(0x80000000|(RTCP_PT_RR<<16)|1);
+  fOutBuf->enqueueWord(fSource->SSRC());
+  addSDES();
+
+  // Then the feedback message's header: V,P,FMT,PT,length, and the SSRCs of the packet sender and media source:
+  u_int32_t rtcpHdr = 0x80000000; // version 2, no padding
+  rtcpHdr |= (fmt&0x1F)<<24;
+  rtcpHdr |= (packetType<<16);
+  rtcpHdr |= 2 + numFCIWords; // length field
+  fOutBuf->enqueueWord(rtcpHdr);
+  fOutBuf->enqueueWord(fSource->SSRC());
+  fOutBuf->enqueueWord(fSource->lastReceivedSSRC());
+}
+
 void RTCPInstance::sendBuiltPacket() {
 #ifdef DEBUG
   fprintf(stderr, "sending RTCP packet\n");
@@ -1217,26 +1549,18 @@ void RTCPInstance::addBYE(char const* reason) {
 }
 
 void RTCPInstance::schedule(double nextTime) {
-  fNextReportTime = nextTime;
-
-  double secondsToDelay = nextTime - dTimeNow();
-  if (secondsToDelay < 0) secondsToDelay = 0;
 #ifdef DEBUG
-  fprintf(stderr, "schedule(%f->%f)\n", secondsToDelay, nextTime);
+  fprintf(stderr, "schedule(%f->%f)\n", nextTime - dTimeNow(), nextTime);
 #endif
-  int64_t usToGo = (int64_t)(secondsToDelay * 1000000);
-  nextTask() = envir().taskScheduler().scheduleDelayedTask(usToGo,
-				(TaskFunc*)RTCPInstance::onExpire, this);
+  RTCPReportScheduler::ourScheduler(envir())->schedule(this, nextTime);
 }
 
 void RTCPInstance::reschedule(double nextTime) {
-  envir().taskScheduler().unscheduleDelayedTask(nextTask());
+  // Note: "schedule()" also handles the case where we're already scheduled
   schedule(nextTime);
 }
 
 void RTCPInstance::onExpire1() {
-  nextTask() = NULL;
-
   // Note: fTotSessionBW is kbits per second
   double rtcpBW = 0.05*fTotSessionBW*1024/8; // -> bytes per second
 
@@ -0,0 +1,120 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A per-"RTPSink" monitor that decides how much (if at all) the sender should reduce what it sends
+// Implementation
+
+#include "RTPCongestionMonitor.hh"
+#include "RTPSink.hh"
+#include <GroupsockHelper.hh>
+
+#define TCP_CHECK_INTERVAL_USECS 100000 // how often we check the TCP send queue depth
+
+RTPCongestionMonitor::RTPCongestionMonitor(RTPSink& rtpSink)
+  : fOurRTPSink(rtpSink),
+    fHighLossRatio(26/*~10%*/), fLowLossRatio(5/*~2%*/),
+    fHighJitterMs(100), fTCPSendQueueThreshold(200000), fNumGoodReportsToRelax(2),
+    fRRLevel(CONGESTION_RESPONSE_NONE), fNumGoodReports(0),
+    fPrevJitterMs(0), fNumJitterRises(0),
+    fTCPLevel(CONGESTION_RESPONSE_NONE), fPrevNumTCPBlockingSends(rtpSink.numTCPBlockingSends()),
+    fCurrentLevel(CONGESTION_RESPONSE_NONE),
+    fLevelChangeHandler(NULL), fLevelChangeHandlerClientData(NULL),
+    fNumFramesDropped(0) {
+  fLastTCPCheckTime.tv_sec = fLastTCPCheckTime.tv_usec = 0;
+}
+
+RTPCongestionMonitor::~RTPCongestionMonitor() {
+}
+
+unsigned RTPCongestionMonitor::level() {
+  checkForLevelChange();
+  return fCurrentLevel;
+}
+
+void RTPCongestionMonitor
+::setLevelChangeHandler(CongestionLevelChangeHandler* handler, void* clientData) {
+  fLevelChangeHandler = handler;
+  fLevelChangeHandlerClientData = clientData;
+}
+
+void RTPCongestionMonitor::noteIncomingRR(RTPTransmissionStats const& stats) {
+  u_int8_t lossRatio = stats.packetLossRatio();
+  unsigned const frequency = fOurRTPSink.rtpTimestampFrequency();
+  unsigned jitterMs = frequency == 0 ? 0 : (unsigned)(((u_int64_t)stats.jitter()*1000)/frequency);
+
+  // Note whether the jitter has been rising (by at least 25%) over consecutive reports:
+  if (jitterMs > fPrevJitterMs + fPrevJitterMs/4) ++fNumJitterRises; else fNumJitterRises = 0;
+  fPrevJitterMs = jitterMs;
+
+  Boolean jitterIsHigh = jitterMs >= fHighJitterMs || (fNumJitterRises >= 2 && jitterMs >= fHighJitterMs/2);
+  if (lossRatio >= fHighLossRatio || jitterIsHigh) {
+    // Things are bad; respond more strongly:
+    if (fRRLevel < CONGESTION_RESPONSE_KEY_FRAMES_ONLY) ++fRRLevel;
+    fNumGoodReports = 0;
+  } else if (lossRatio <= fLowLossRatio && fNumJitterRises == 0) {
+    // Things are good; after enough of these, relax our response:
+    if (++fNumGoodReports >= fNumGoodReportsToRelax) {
+      if (fRRLevel > CONGESTION_RESPONSE_NONE) --fRRLevel;
+      fNumGoodReports = 0;
+    }
+  } else {
+    fNumGoodReports = 0;
+  }
+#ifdef DEBUG
+  fprintf(stderr, "RTPCongestionMonitor[%p]: RR loss %d/256, jitter %u ms => RR level %u\n",
+	  this, lossRatio, jitterMs, fRRLevel);
+#endif
+
+  checkForLevelChange();
+}
+
+unsigned RTPCongestionMonitor::tcpLevel() {
+  // Checking the TCP send queue needs a system call, so we don't do this too often:
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+  int64_t uSecsSinceLastCheck = (int64_t)(timeNow.tv_sec - fLastTCPCheckTime.tv_sec)*1000000
+    + (timeNow.tv_usec - fLastTCPCheckTime.tv_usec);
+  if (uSecsSinceLastCheck >= 0 && uSecsSinceLastCheck < TCP_CHECK_INTERVAL_USECS) return fTCPLevel;
+  fLastTCPCheckTime = timeNow;
+
+  unsigned queueDepth = fOurRTPSink.tcpSendQueueDepth();
+  unsigned numBlockingSends = fOurRTPSink.numTCPBlockingSends();
+  Boolean sendsHaveBlocked = numBlockingSends != fPrevNumTCPBlockingSends;
+  fPrevNumTCPBlockingSends = numBlockingSends;
+
+  if (queueDepth >= fTCPSendQueueThreshold || sendsHaveBlocked) {
+    fTCPLevel = CONGESTION_RESPONSE_KEY_FRAMES_ONLY;
+  } else if (queueDepth >= fTCPSendQueueThreshold/4) {
+    fTCPLevel = CONGESTION_RESPONSE_DROP_DISPOSABLE;
+  } else {
+    fTCPLevel = CONGESTION_RESPONSE_NONE;
+  }
+
+  return fTCPLevel;
+}
+
+void RTPCongestionMonitor::checkForLevelChange() {
+  unsigned newLevel = tcpLevel();
+  if (fRRLevel > newLevel) newLevel = fRRLevel;
+  if (newLevel == fCurrentLevel) return;
+
+#ifdef DEBUG
+  fprintf(stderr, "RTPCongestionMonitor[%p]: level %u => %u\n", this, fCurrentLevel, newLevel);
+#endif
+  fCurrentLevel = newLevel;
+  if (fLevelChangeHandler != NULL) (*fLevelChangeHandler)(fLevelChangeHandlerClientData, newLevel);
+}
@@ -0,0 +1,329 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// RTP 'hint files': pre-packetized RTP payloads (with their timestamps and marker bits) for a media file
+// Implementation
+
+#include "RTPHintFile.hh"
+#include "InputFile.hh"
+#include "OutputFile.hh"
+#include <GroupsockHelper.hh>
+#include <sys/stat.h>
+
+static Boolean getSourceFileStatus(char const* sourceFileName, u_int64_t& size, int64_t& modTime) {
+  struct stat sb;
+  if (sourceFileName == NULL || stat(sourceFileName, &sb) != 0) {
+    size = 0; modTime = 0;
+    return False;
+  }
+
+  size = (u_int64_t)sb.st_size;
+  modTime = (int64_t)sb.st_mtime;
+  return True;
+}
+
+////////// RTPHintFile //////////
+
+RTPHintFile* RTPHintFile::createNew(UsageEnvironment& env, char const* hintFileName,
+				    char const* sourceFileName) {
+  FILE* fid = OpenInputFile(env, hintFileName);
+  if (fid == NULL) return NULL;
+
+  u_int64_t fileSize = GetFileSize(hintFileName, fid);
+  u_int8_t* mapping = NULL;
+  if (fileSize >= RTP_HINT_FILE_HEADER_SIZE) mapping = MapInputFile(fileno(fid), fileSize);
+  CloseInputFile(fid);
+  if (mapping == NULL) {
+    env.setResultMsg("Failed to map the hint file \"", hintFileName, "\"");
+    return NULL;
+  }
+
+  // Sanity-check the header, and the extents of the record table and aux SDP line:
+  RTPHintFileHeader const* header = (RTPHintFileHeader const*)mapping;
+  Boolean isValid
+    = strncmp(header->magic, RTP_HINT_FILE_MAGIC, 4) == 0
+    && header->version == RTP_HINT_FILE_VERSION
+    && header->headerSize == RTP_HINT_FILE_HEADER_SIZE
+    && header->recordSize == sizeof (RTPHintRecord)
+    && header->recordsOffset%8 == 0
+    && header->recordsOffset <= fileSize
+    && header->numRecords <= (fileSize - header->recordsOffset)/sizeof (RTPHintRecord)
+    && header->auxSDPLineOffset <= fileSize
+    && header->auxSDPLineSize <= fileSize - header->auxSDPLineOffset
+    && (header->auxSDPLineSize == 0 || mapping[header->auxSDPLineOffset + header->auxSDPLineSize - 1] == '\0')
+    && header->mediumName[sizeof header->mediumName - 1] == '\0'
+    && header->rtpPayloadFormatName[sizeof header->rtpPayloadFormatName - 1] == '\0';
+  if (isValid) {
+    // Check that each record's payload lies before the record table:
+    RTPHintRecord const* records = (RTPHintRecord const*)&mapping[header->recordsOffset];
+    for (unsigned i = 0; i < header->numRecords; ++i) {
+      if (records[i].payloadOffset > header->recordsOffset
+	  || records[i].payloadSize > header->recordsOffset - records[i].payloadOffset) {
+	isValid = False;
+	break;
+      }
+    }
+  }
+  if (!isValid) {
+    UnmapInputFile(mapping, fileSize);
+    env.setResultMsg("\"", hintFileName, "\" is not a valid RTP hint file");
+    return NULL;
+  }
+
+  if (sourceFileName != NULL) {
+    // Check that the media file hasn't changed since the hint file was built:
+    u_int64_t sourceFileSize; int64_t sourceFileModTime;
+    if (!getSourceFileStatus(sourceFileName, sourceFileSize, sourceFileModTime)
+	|| sourceFileSize != header->sourceFileSize || sourceFileModTime != header->sourceFileModTime) {
+      UnmapInputFile(mapping, fileSize);
+      env.setResultMsg("\"", hintFileName, "\" is out of date");
+      return NULL;
+    }
+  }
+
+  return new RTPHintFile(env, mapping, fileSize);
+}
+
+RTPHintFile::RTPHintFile(UsageEnvironment& env, u_int8_t* mapping, u_int64_t fileSize)
+  : Medium(env),
+    fMapping(mapping), fFileSize(fileSize), fHeader((RTPHintFileHeader const*)mapping),
+    fRecords((RTPHintRecord const*)&mapping[fHeader->recordsOffset]) {
+}
+
+RTPHintFile::~RTPHintFile() {
+  UnmapInputFile(fMapping, fFileSize);
+}
+
+char const* RTPHintFile::auxSDPLine() const {
+  if (fHeader->auxSDPLineSize <= 1) return NULL;
+
+  return (char const*)&fMapping[fHeader->auxSDPLineOffset];
+}
+
+unsigned RTPHintFile::lookupRecordNumFromNPT(double& npt) const {
+  unsigned numRecs = numRecords();
+  if (numRecs == 0 || npt <= 0.0) {
+    npt = 0.0;
+    return 0;
+  }
+
+  // Binary search for the last record whose presentation time is <= "npt":
+  u_int64_t const targetUSecs = (u_int64_t)(npt*1000000.0);
+  unsigned lo = 0, hi = numRecs; // the answer is in [lo, hi)
+  while (hi - lo > 1) {
+    unsigned mid = lo + (hi - lo)/2;
+    if (fRecords[mid].presentationTimeUSecs <= targetUSecs) lo = mid; else hi = mid;
+  }
+
+  // Then back up to the nearest random access point:
+  while (lo > 0 && (fRecords[lo].flags&RTP_HINT_RANDOM_ACCESS) == 0) --lo;
+
+  npt = fRecords[lo].presentationTimeUSecs/1000000.0;
+  return lo;
+}
+
+
+////////// RTPHintFileWriter //////////
+
+RTPHintFileWriter* RTPHintFileWriter
+::createNew(UsageEnvironment& env, char const* hintFileName, char const* rtpPayloadFormatName,
+	    char const* sourceFileName) {
+  // Note the media file's size and modification time now, before we start reading it:
+  u_int64_t sourceFileSize; int64_t sourceFileModTime;
+  (void)getSourceFileStatus(sourceFileName, sourceFileSize, sourceFileModTime);
+
+  FILE* fid = OpenOutputFile(env, hintFileName);
+  if (fid == NULL) return NULL;
+
+  // Reserve space for the header (which we write last):
+  RTPHintFileHeader header;
+  memset(&header, 0, sizeof header);
+  if (fwrite(&header, sizeof header, 1, fid) != 1) {
+    env.setResultMsg("Failed to write to \"", hintFileName, "\"");
+    CloseOutputFile(fid);
+    return NULL;
+  }
+
+  // We never send to this address; it's just needed to construct the "Groupsock":
+  struct in_addr dummyAddr;
+  dummyAddr.s_addr = our_inet_addr("127.0.0.1");
+
+  return new RTPHintFileWriter(env, dummyAddr, fid, rtpPayloadFormatName, sourceFileSize, sourceFileModTime);
+}
+
+RTPHintFileWriter::RTPHintFileWriter(UsageEnvironment& env, struct in_addr const& dummyAddr, FILE* fid,
+				     char const* rtpPayloadFormatName,
+				     u_int64_t sourceFileSize, int64_t sourceFileModTime)
+  : Groupsock(env, dummyAddr, Port(0), 255),
+    fFid(fid), fCodec(0), fNextPayloadOffset(sizeof (RTPHintFileHeader)), fMaxPayloadSize(0),
+    fHaveSeenPacket(False), fWriteFailed(False), fPrevTimestamp(0), fTimestampOffset(0),
+    fCurFrameStartRecordNum(0), fNumFrames(0),
+    fSourceFileSize(sourceFileSize), fSourceFileModTime(sourceFileModTime),
+    fRecords(NULL), fNumRecords(0), fRecordsSize(0) {
+  if (rtpPayloadFormatName != NULL) {
+    if (strcmp(rtpPayloadFormatName, "H264") == 0) fCodec = 264;
+    else if (strcmp(rtpPayloadFormatName, "H265") == 0) fCodec = 265;
+  }
+}
+
+RTPHintFileWriter::~RTPHintFileWriter() {
+  if (fFid != NULL) CloseOutputFile(fFid);
+  delete[] fRecords;
+}
+
+Boolean RTPHintFileWriter::output(UsageEnvironment& /*env*/, unsigned char* buffer, unsigned bufferSize,
+				  DirectedNetInterface* /*interfaceNotToFwdBackTo*/) {
+  // Parse the RTP header, to find the payload, marker bit and timestamp:
+  if (bufferSize < 12 || (buffer[0]&0xC0) != 0x80) return True; // not a RTP packet; ignore it
+  unsigned headerSize = 12 + 4*(buffer[0]&0x0F);
+  if ((buffer[0]&0x10) != 0) { // there's a RTP header extension
+    if (bufferSize < headerSize + 4) return True;
+    headerSize += 4 + 4*((buffer[headerSize+2]<<8)|buffer[headerSize+3]);
+  }
+  unsigned payloadSize = bufferSize < headerSize ? 0 : bufferSize - headerSize;
+  if ((buffer[0]&0x20) != 0 && payloadSize > 0) { // there's padding
+    unsigned numPaddingBytes = buffer[bufferSize-1];
+    payloadSize = numPaddingBytes > payloadSize ? 0 : payloadSize - numPaddingBytes;
+  }
+  if (payloadSize == 0 || payloadSize > 0xFFFF) return True;
+  u_int8_t const* payload = &buffer[headerSize];
+
+  u_int32_t timestamp = (buffer[4]<<24)|(buffer[5]<<16)|(buffer[6]<<8)|buffer[7];
+  Boolean isFrameStart = !fHaveSeenPacket || timestamp != fPrevTimestamp;
+  if (fHaveSeenPacket) fTimestampOffset += (int32_t)(timestamp - fPrevTimestamp);
+  fPrevTimestamp = timestamp;
+  fHaveSeenPacket = True;
+
+  RTPHintRecord rec;
+  memset(&rec, 0, sizeof rec);
+  rec.payloadOffset = fNextPayloadOffset;
+  rec.presentationTimeUSecs = fTimestampOffset < 0 ? 0 : (u_int64_t)fTimestampOffset;
+  rec.payloadSize = (u_int16_t)payloadSize;
+  if ((buffer[1]&0x80) != 0) rec.flags |= RTP_HINT_MARKER;
+  if (isFrameStart) {
+    rec.flags |= RTP_HINT_FRAME_START;
+    fCurFrameStartRecordNum = fNumRecords;
+    ++fNumFrames;
+  }
+  addRecord(rec);
+
+  // For H.264/5, a frame is a random access point if any of its packets carries a key frame (or parameter set);
+  // for other formats, every frame is:
+  if (fCodec == 0 ? isFrameStart : isRandomAccessPayload(payload, payloadSize)) {
+    fRecords[fCurFrameStartRecordNum].flags |= RTP_HINT_RANDOM_ACCESS;
+  }
+
+  if (fwrite(payload, 1, payloadSize, fFid) != payloadSize) fWriteFailed = True;
+  fNextPayloadOffset += payloadSize;
+  if (payloadSize > fMaxPayloadSize) fMaxPayloadSize = payloadSize;
+
+  return True;
+}
+
+Boolean RTPHintFileWriter::isRandomAccessPayload(u_int8_t const* payload, unsigned payloadSize) const {
+  if (fCodec == 264) {
+    u_int8_t nalUnitType = payload[0]&0x1F;
+    if (nalUnitType == 24/*STAP-A*/ && payloadSize >= 4) {
+      nalUnitType = payload[3]&0x1F; // the first aggregated NAL unit
+    } else if (nalUnitType == 28/*FU-A*/ && payloadSize >= 2) {
+      if ((payload[1]&0x80) == 0) return False; // not the first fragment
+      nalUnitType = payload[1]&0x1F;
+    }
+    return nalUnitType == 5/*IDR*/ || nalUnitType == 7/*SPS*/;
+  } else { // H.265
+    if (payloadSize < 2) return False;
+    u_int8_t nalUnitType = (payload[0]&0x7E)>>1;
+    if (nalUnitType == 48/*AP*/ && payloadSize >= 5) {
+      nalUnitType = (payload[4]&0x7E)>>1; // the first aggregated NAL unit
+    } else if (nalUnitType == 49/*FU*/ && payloadSize >= 3) {
+      if ((payload[2]&0x80) == 0) return False; // not the first fragment
+      nalUnitType = payload[2]&0x3F;
+    }
+    return (nalUnitType >= 16 && nalUnitType <= 21)/*IRAP*/ || (nalUnitType >= 32 && nalUnitType <= 34)/*VPS,SPS,PPS*/;
+  }
+}
+
+void RTPHintFileWriter::addRecord(RTPHintRecord const& rec) {
+  if (fNumRecords == fRecordsSize) {
+    // Grow the table:
+    unsigned newSize = fRecordsSize == 0 ? 1024 : 2*fRecordsSize;
+    RTPHintRecord* newRecords = new RTPHintRecord[newSize];
+    if (fRecords != NULL) memmove(newRecords, fRecords, fNumRecords*sizeof (RTPHintRecord));
+    delete[] fRecords;
+    fRecords = newRecords;
+    fRecordsSize = newSize;
+  }
+  fRecords[fNumRecords++] = rec;
+}
+
+Boolean RTPHintFileWriter::finishHintFile(RTPSink& sink) {
+  if (fFid == NULL) return False;
+
+  // Convert the records' timestamp offsets to microseconds:
+  unsigned const frequency = sink.rtpTimestampFrequency();
+  for (unsigned i = 0; i < fNumRecords; ++i) {
+    fRecords[i].presentationTimeUSecs = (fRecords[i].presentationTimeUSecs*1000000)/frequency;
+  }
+
+  // Write the record table (8-byte aligned), followed by the aux SDP line:
+  u_int8_t const zeros[8] = {0,0,0,0,0,0,0,0};
+  unsigned alignment = (unsigned)((8 - fNextPayloadOffset%8)%8);
+  if (alignment > 0 && fwrite(zeros, 1, alignment, fFid) != alignment) fWriteFailed = True;
+  u_int64_t recordsOffset = fNextPayloadOffset + alignment;
+  if (fNumRecords > 0 && fwrite(fRecords, sizeof (RTPHintRecord), fNumRecords, fFid) != fNumRecords) {
+    fWriteFailed = True;
+  }
+  u_int64_t auxSDPLineOffset = recordsOffset + fNumRecords*sizeof (RTPHintRecord);
+
+  char const* auxSDPLine = sink.auxSDPLine();
+  unsigned auxSDPLineSize = auxSDPLine == NULL ? 0 : strlen(auxSDPLine) + 1;
+  if (auxSDPLineSize > 0 && fwrite(auxSDPLine, 1, auxSDPLineSize, fFid) != auxSDPLineSize) fWriteFailed = True;
+
+  // Fill in the header, and write it at the start of the file:
+  RTPHintFileHeader header;
+  memset(&header, 0, sizeof header);
+  memmove(header.magic, RTP_HINT_FILE_MAGIC, 4);
+  header.version = RTP_HINT_FILE_VERSION;
+  header.headerSize = sizeof header;
+  header.recordSize = sizeof (RTPHintRecord);
+  header.recordsOffset = recordsOffset;
+  header.auxSDPLineOffset = auxSDPLineOffset;
+  header.numRecords = fNumRecords;
+  header.maxPayloadSize = fMaxPayloadSize;
+  if (fNumRecords > 0) {
+    // The duration is the last frame's presentation time, plus the average frame duration:
+    u_int64_t lastPT = fRecords[fNumRecords-1].presentationTimeUSecs;
+    header.durationUSecs = lastPT + (fNumFrames > 1 ? lastPT/(fNumFrames-1) : 0);
+  }
+  header.totalPayloadBytes = fNextPayloadOffset - sizeof header;
+  header.timestampFrequency = frequency;
+  header.auxSDPLineSize = auxSDPLineSize;
+  header.rtpPayloadType = sink.rtpPayloadType();
+  header.numChannels = sink.numChannels();
+  strncpy(header.mediumName, sink.sdpMediaType(), sizeof header.mediumName - 1);
+  strncpy(header.rtpPayloadFormatName, sink.rtpPayloadFormatName(), sizeof header.rtpPayloadFormatName - 1);
+  header.sourceFileSize = fSourceFileSize;
+  header.sourceFileModTime = fSourceFileModTime;
+
+  if (SeekFile64(fFid, 0, SEEK_SET) != 0 || fwrite(&header, sizeof header, 1, fFid) != 1) fWriteFailed = True;
+
+  CloseOutputFile(fFid);
+  fFid = NULL;
+
+  if (fWriteFailed) env().setResultMsg("Failed to write the hint file");
+  return !fWriteFailed;
+}
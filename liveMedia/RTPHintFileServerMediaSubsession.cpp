@@ -0,0 +1,72 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A 'ServerMediaSubsession' object that creates new, unicast, "RTPSink"s
+// on demand, from a RTP hint file (i.e., from payloads that were packetized in advance)
+// Implementation
+
+#include "RTPHintFileServerMediaSubsession.hh"
+#include "RTPHintFileSource.hh"
+#include "HintedRTPSink.hh"
+
+RTPHintFileServerMediaSubsession*
+RTPHintFileServerMediaSubsession::createNew(UsageEnvironment& env, char const* hintFileName,
+					    Boolean reuseFirstSource, char const* sourceFileName) {
+  RTPHintFile* hintFile = RTPHintFile::createNew(env, hintFileName, sourceFileName);
+  if (hintFile == NULL) return NULL;
+
+  return new RTPHintFileServerMediaSubsession(env, hintFileName, hintFile, reuseFirstSource);
+}
+
+RTPHintFileServerMediaSubsession
+::RTPHintFileServerMediaSubsession(UsageEnvironment& env, char const* hintFileName,
+				   RTPHintFile* hintFile, Boolean reuseFirstSource)
+  : FileServerMediaSubsession(env, hintFileName, reuseFirstSource),
+    fHintFile(hintFile) {
+}
+
+RTPHintFileServerMediaSubsession::~RTPHintFileServerMediaSubsession() {
+  Medium::close(fHintFile);
+}
+
+void RTPHintFileServerMediaSubsession
+::seekStreamSource(FramedSource* inputSource, double& seekNPT, double /*streamDuration*/, u_int64_t& numBytes) {
+  RTPHintFileSource* hintFileSource = (RTPHintFileSource*)inputSource;
+  hintFileSource->seekToTime(seekNPT);
+  numBytes = 0; // we don't limit the number of bytes to stream
+}
+
+float RTPHintFileServerMediaSubsession::duration() const {
+  return (float)fHintFile->duration();
+}
+
+FramedSource* RTPHintFileServerMediaSubsession
+::createNewStreamSource(unsigned /*clientSessionId*/, unsigned& estBitrate) {
+  RTPHintFileHeader const& header = fHintFile->header();
+  estBitrate = header.durationUSecs == 0 ? 500
+    : (unsigned)((header.totalPayloadBytes*8*1000)/header.durationUSecs); // kbps
+  if (estBitrate == 0) estBitrate = 1;
+
+  return RTPHintFileSource::createNew(envir(), fHintFile);
+}
+
+RTPSink* RTPHintFileServerMediaSubsession
+::createNewRTPSink(Groupsock* rtpGroupsock,
+		   unsigned char rtpPayloadTypeIfDynamic,
+		   FramedSource* /*inputSource*/) {
+  return HintedRTPSink::createNew(envir(), rtpGroupsock, fHintFile, rtpPayloadTypeIfDynamic);
+}
@@ -0,0 +1,89 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A source that delivers - one at a time - the pre-packetized RTP payloads from a RTP hint file.
+// Implementation
+
+#include "RTPHintFileSource.hh"
+#include <GroupsockHelper.hh>
+
+RTPHintFileSource* RTPHintFileSource::createNew(UsageEnvironment& env, RTPHintFile* hintFile) {
+  if (hintFile == NULL) return NULL;
+
+  return new RTPHintFileSource(env, hintFile);
+}
+
+RTPHintFileSource::RTPHintFileSource(UsageEnvironment& env, RTPHintFile* hintFile)
+  : FramedSource(env),
+    fHintFile(hintFile), fNextRecordNum(0), fNeedBaseTime(True), fBasePTUSecs(0), fLastPayloadFlags(0) {
+}
+
+RTPHintFileSource::~RTPHintFileSource() {
+}
+
+void RTPHintFileSource::seekToTime(double& seekNPT) {
+  fNextRecordNum = fHintFile->lookupRecordNumFromNPT(seekNPT);
+  fNeedBaseTime = True;
+}
+
+Boolean RTPHintFileSource::isRTPHintFileSource() const {
+  return True;
+}
+
+void RTPHintFileSource::doGetNextFrame() {
+  if (fNextRecordNum >= fHintFile->numRecords()) {
+    handleClosure();
+    return;
+  }
+
+  RTPHintRecord const& rec = fHintFile->record(fNextRecordNum++);
+
+  // The payload is already mapped into memory, so just copy it:
+  if (rec.payloadSize > fMaxSize) {
+    fFrameSize = fMaxSize;
+    fNumTruncatedBytes = rec.payloadSize - fMaxSize;
+  } else {
+    fFrameSize = rec.payloadSize;
+    fNumTruncatedBytes = 0;
+  }
+  memmove(fTo, fHintFile->payload(rec), fFrameSize);
+  fLastPayloadFlags = rec.flags;
+
+  // Presentation times are relative to 'wall clock' time at the start of (each) play:
+  if (fNeedBaseTime) {
+    gettimeofday(&fBaseTime, NULL);
+    fBasePTUSecs = rec.presentationTimeUSecs;
+    fNeedBaseTime = False;
+  }
+  u_int64_t uSecs = rec.presentationTimeUSecs < fBasePTUSecs ? 0 : rec.presentationTimeUSecs - fBasePTUSecs;
+  fPresentationTime.tv_sec = fBaseTime.tv_sec + (long)(uSecs/1000000);
+  fPresentationTime.tv_usec = fBaseTime.tv_usec + (long)(uSecs%1000000);
+  if (fPresentationTime.tv_usec >= 1000000) {
+    ++fPresentationTime.tv_sec;
+    fPresentationTime.tv_usec -= 1000000;
+  }
+
+  // Pace our delivery by the presentation time of the next payload:
+  fDurationInMicroseconds = 0;
+  if (fNextRecordNum < fHintFile->numRecords()) {
+    u_int64_t nextPT = fHintFile->record(fNextRecordNum).presentationTimeUSecs;
+    if (nextPT > rec.presentationTimeUSecs) fDurationInMicroseconds = (unsigned)(nextPT - rec.presentationTimeUSecs);
+  }
+
+  // Because the payloads are in memory, we can call our 'after getting' function directly:
+  FramedSource::afterGetting(this);
+}
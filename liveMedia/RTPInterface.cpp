@@ -23,6 +23,10 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "RTPInterface.hh"
 #include <GroupsockHelper.hh>
 #include <stdio.h>
+#if defined(__linux__)
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
+#endif
 
 ////////// Helper Functions - Definition //////////
 
@@ -119,7 +123,8 @@ RTPInterface::RTPInterface(Medium* owner, Groupsock* gs)
     fTCPStreams(NULL),
     fNextTCPReadSize(0), fNextTCPReadStreamSocketNum(-1),
     fNextTCPReadStreamChannelId(0xFF), fReadHandlerProc(NULL),
-    fAuxReadHandlerFunc(NULL), fAuxReadHandlerClientData(NULL) {
+    fAuxReadHandlerFunc(NULL), fAuxReadHandlerClientData(NULL),
+    fNumTCPBlockingSends(0), fHaveUnicastDestination(False), fUnicastDestinationPort(0) {
   // Make the socket non-blocking, even though it will be read from only asynchronously, when packets arrive.
   // The reason for this is that, in some OSs, reads on a blocking socket can (allegedly) sometimes block,
   // even if the socket was previously reported (e.g., by "select()") as having data available.
@@ -213,11 +218,23 @@ void RTPInterface::clearServerRequestAlternativeByteHandler(UsageEnvironment& en
   setServerRequestAlternativeByteHandler(env, socketNum, NULL, NULL);
 }
 
+void RTPInterface::setUnicastDestination(struct in_addr const& addr, Port const& port) {
+  fHaveUnicastDestination = True;
+  fUnicastDestinationAddr = addr;
+  fUnicastDestinationPort = port;
+}
+
 Boolean RTPInterface::sendPacket(unsigned char* packet, unsigned packetSize) {
   Boolean success = True; // we'll return False instead if any of the sends fail
 
   // Normal case: Send as a UDP packet:
-  if (!fGS->output(envir(), packet, packetSize)) success = False;
+  if (fHaveUnicastDestination) {
+    // Our groupsock is shared, so send only to our own destination:
+    if (!fGS->write(fUnicastDestinationAddr.s_addr, fUnicastDestinationPort.num(), fGS->ttl(),
+		    packet, packetSize)) success = False;
+  } else {
+    if (!fGS->output(envir(), packet, packetSize)) success = False;
+  }
 
   // Also, send over each of our TCP sockets:
   tcpStreamRecord* nextStream;
@@ -235,8 +252,10 @@ Boolean RTPInterface::sendPacket(unsigned char* packet, unsigned packetSize) {
 void RTPInterface
 ::startNetworkReading(TaskScheduler::BackgroundHandlerProc* handlerProc) {
   // Normal case: Arrange to read UDP packets:
-  envir().taskScheduler().
-    turnOnBackgroundReadHandling(fGS->socketNum(), handlerProc, fOwner);
+  if (!fHaveUnicastDestination) {
+    envir().taskScheduler().
+      turnOnBackgroundReadHandling(fGS->socketNum(), handlerProc, fOwner);
+  }
 
   // Also, receive RTP over TCP, on each of our TCP connections:
   fReadHandlerProc = handlerProc;
@@ -300,9 +319,24 @@ Boolean RTPInterface::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
   return readSuccess;
 }
 
+unsigned RTPInterface::tcpSendQueueDepth() const {
+  unsigned result = 0;
+#if defined(__linux__) && defined(SIOCOUTQ)
+  for (tcpStreamRecord* streams = fTCPStreams; streams != NULL; streams = streams->fNext) {
+    int numBytesQueued;
+    if (ioctl(streams->fStreamSocketNum, SIOCOUTQ, &numBytesQueued) == 0 && numBytesQueued > 0) {
+      result += (unsigned)numBytesQueued;
+    }
+  }
+#endif
+  return result;
+}
+
 void RTPInterface::stopNetworkReading() {
   // Normal case
-  if (fGS != NULL) envir().taskScheduler().turnOffBackgroundReadHandling(fGS->socketNum());
+  if (fGS != NULL && !fHaveUnicastDestination) {
+    envir().taskScheduler().turnOffBackgroundReadHandling(fGS->socketNum());
+  }
 
   // Also turn off read handling on each of our TCP connections:
   for (tcpStreamRecord* streams = fTCPStreams; streams != NULL; streams = streams->fNext) {
@@ -361,6 +395,7 @@ Boolean RTPInterface::sendDataOverTCP(int socketNum, u_int8_t const* data, unsig
       // the capacity of the TCP connection!).
       // Force this data write to succeed, by blocking if necessary until it does:
       unsigned numBytesRemainingToSend = dataSize - numBytesSentSoFar;
+      ++fNumTCPBlockingSends;
 #ifdef DEBUG_SEND
       fprintf(stderr, "sendDataOverTCP: resending %d-byte send (blocking)\n", numBytesRemainingToSend); fflush(stderr);
 #endif
@@ -0,0 +1,71 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A ring of recently sent (or received) RTP packets, indexed by RTP sequence number
+// Implementation
+
+#include "RTPPacketHistory.hh"
+#include "GroupsockHelper.hh"
+#include <string.h>
+
+// Packets are stored at index (RTP sequence number) % (ring size).  Each slot's buffer is allocated once, and reused.
+
+RTPPacketHistory::RTPPacketHistory(unsigned maxNumPackets, unsigned maxPacketAgeMs)
+  : fNumSlots(maxNumPackets == 0 ? 1 : maxNumPackets), fMaxPacketAgeMs(maxPacketAgeMs) {
+  fSlots = new Slot[fNumSlots];
+  for (unsigned i = 0; i < fNumSlots; ++i) {
+    fSlots[i].data = NULL;
+    fSlots[i].size = fSlots[i].bufferSize = 0;
+    fSlots[i].seqNum = 0;
+  }
+}
+
+RTPPacketHistory::~RTPPacketHistory() {
+  for (unsigned i = 0; i < fNumSlots; ++i) delete[] fSlots[i].data;
+  delete[] fSlots;
+}
+
+void RTPPacketHistory::savePacket(unsigned char const* packet, unsigned packetSize) {
+  if (packetSize < 12) return; // not a RTP packet
+
+  u_int16_t seqNum = (packet[2]<<8)|packet[3];
+  Slot& slot = fSlots[seqNum%fNumSlots];
+  if (packetSize > slot.bufferSize) {
+    delete[] slot.data;
+    slot.data = new unsigned char[packetSize];
+    slot.bufferSize = packetSize;
+  }
+  memmove(slot.data, packet, packetSize);
+  slot.size = packetSize;
+  slot.seqNum = seqNum;
+  if (fMaxPacketAgeMs > 0) gettimeofday(&slot.timeSaved, NULL);
+}
+
+unsigned char const* RTPPacketHistory::lookupPacket(u_int16_t seqNum, unsigned& packetSize) const {
+  Slot const& slot = fSlots[seqNum%fNumSlots];
+  if (slot.size == 0 || slot.seqNum != seqNum) return NULL;
+
+  if (fMaxPacketAgeMs > 0) {
+    struct timeval timeNow;
+    gettimeofday(&timeNow, NULL);
+    int ageMs = (timeNow.tv_sec - slot.timeSaved.tv_sec)*1000 + (timeNow.tv_usec - slot.timeSaved.tv_usec)/1000;
+    if (ageMs > (int)fMaxPacketAgeMs) return NULL; // too old to be useful
+  }
+
+  packetSize = slot.size;
+  return slot.data;
+}
@@ -19,6 +19,8 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "RTPSink.hh"
+#include "RTPCongestionMonitor.hh"
+#include "RTPPacketHistory.hh"
 #include "GroupsockHelper.hh"
 
 ////////// RTPSink //////////
@@ -51,8 +53,11 @@ RTPSink::RTPSink(UsageEnvironment& env,
   : MediaSink(env), fRTPInterface(this, rtpGS),
     fRTPPayloadType(rtpPayloadType),
     fPacketCount(0), fOctetCount(0), fTotalOctetCount(0),
+    fNumPacketsDropped(0), fNumTruncatedFrames(0),
     fTimestampFrequency(rtpTimestampFrequency), fNextTimestampHasBeenPreset(False), fEnableRTCPReports(True),
-    fNumChannels(numChannels), fEstimatedBitrate(0) {
+    fNumChannels(numChannels), fEstimatedBitrate(0), fCongestionMonitor(NULL),
+    fPacketHistory(NULL), fNumNACKedPackets(0), fNumPacketsRetransmitted(0), fNumKeyFrameRequests(0),
+    fSentPacketHandlerFunc(NULL), fSentPacketHandlerClientData(NULL) {
   fRTPPayloadFormatName
     = strDup(rtpPayloadFormatName == NULL ? "???" : rtpPayloadFormatName);
   gettimeofday(&fCreationTime, NULL);
@@ -67,6 +72,8 @@ RTPSink::RTPSink(UsageEnvironment& env,
 }
 
 RTPSink::~RTPSink() {
+  delete fPacketHistory;
+  delete fCongestionMonitor;
   delete fTransmissionStatsDB;
   delete[] (char*)fRTPPayloadFormatName;
   fRTPInterface.forgetOurGroupsock();
@@ -128,6 +135,47 @@ void RTPSink::resetPresentationTimes() {
   fInitialPresentationTime.tv_usec = fMostRecentPresentationTime.tv_usec = 0;
 }
 
+void RTPSink::enableCongestionResponse(Boolean enable) {
+  if (enable) {
+    if (fCongestionMonitor == NULL) fCongestionMonitor = new RTPCongestionMonitor(*this);
+  } else {
+    delete fCongestionMonitor; fCongestionMonitor = NULL;
+  }
+}
+
+void RTPSink::enableRetransmissions(unsigned maxNumPackets, unsigned maxPacketAgeMs) {
+  delete fPacketHistory; fPacketHistory = NULL;
+  if (maxNumPackets > 0) fPacketHistory = new RTPPacketHistory(maxNumPackets, maxPacketAgeMs);
+}
+
+void RTPSink::noteSentPacket(unsigned char const* packet, unsigned packetSize) {
+  if (fPacketHistory != NULL) fPacketHistory->savePacket(packet, packetSize);
+  if (fSentPacketHandlerFunc != NULL) (*fSentPacketHandlerFunc)(fSentPacketHandlerClientData, packet, packetSize);
+}
+
+void RTPSink::noteIncomingNACK(u_int16_t firstSeqNum, u_int16_t bitmaskOfFollowingLostPackets) {
+  // Each generic NACK (RFC 4585, section 6.2.1) names a lost packet, and (in a bitmask) up to 16 more after it:
+  for (unsigned i = 0; i <= 16; ++i) {
+    if (i > 0 && (bitmaskOfFollowingLostPackets&(1<<(i-1))) == 0) continue;
+    u_int16_t seqNum = firstSeqNum + i;
+    ++fNumNACKedPackets;
+    if (fPacketHistory == NULL) continue;
+
+    unsigned packetSize;
+    unsigned char const* packet = fPacketHistory->lookupPacket(seqNum, packetSize);
+    if (packet == NULL) continue;
+#ifdef DEBUG
+    fprintf(stderr, "RTPSink[%p]: retransmitting packet with seq num %u\n", this, seqNum);
+#endif
+    if (fRTPInterface.sendPacket((unsigned char*)packet, packetSize)) ++fNumPacketsRetransmitted;
+  }
+}
+
+void RTPSink::noteIncomingKeyFrameRequest() {
+  ++fNumKeyFrameRequests;
+  if (fSource != NULL) fSource->requestKeyFrame();
+}
+
 char const* RTPSink::sdpMediaType() const {
   return "data";
   // default SDP media (m=) type, unless redefined by subclasses
@@ -306,6 +354,9 @@ void RTPTransmissionStats
   if (fTotalPacketCount_lo < prevTotalPacketCount_lo) { // wrap around
     ++fTotalPacketCount_hi;
   }
+
+  // If our sink responds to congestion, let it know about this report:
+  if (fOurRTPSink.congestionMonitor() != NULL) fOurRTPSink.congestionMonitor()->noteIncomingRR(*this);
 }
 
 unsigned RTPTransmissionStats::roundTripDelay() const {
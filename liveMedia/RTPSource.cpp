@@ -44,6 +44,19 @@ Boolean RTPSource::hasBeenSynchronizedUsingRTCP() {
   return fCurPacketHasBeenSynchronizedUsingRTCP;
 }
 
+void RTPSource::setAdaptivePacketReorderingThresholdTime(unsigned /*minUSeconds*/, unsigned maxUSeconds) {
+  // Default implementation: Use a fixed threshold time:
+  setPacketReorderingThresholdTime(maxUSeconds);
+}
+
+unsigned RTPSource::packetReorderingThresholdTime() const {
+  return 0; // default implementation: unknown
+}
+
+unsigned RTPSource::numLatePacketsDropped() const {
+  return 0; // default implementation: not counted
+}
+
 Boolean RTPSource::isRTPSource() const {
   return True;
 }
@@ -56,7 +69,9 @@ RTPSource::RTPSource(UsageEnvironment& env, Groupsock* RTPgs,
     fCurPacketHasBeenSynchronizedUsingRTCP(False), fLastReceivedSSRC(0),
     fRTCPInstanceForMultiplexedRTCPPackets(NULL),
     fRTPPayloadFormat(rtpPayloadFormat), fTimestampFrequency(rtpTimestampFrequency),
-    fSSRC(our_random32()), fEnableRTCPReports(True) {
+    fSSRC(our_random32()), fEnableRTCPReports(True),
+    fPacketLossHandlerFunc(NULL), fPacketLossHandlerClientData(NULL), fMaxPacketLossToReport(0),
+    fHaveSeenSeqNum(False), fHighestSeqNumSeen(0) {
   fReceptionStatsDB = new RTPReceptionStatsDB();
 }
 
@@ -64,6 +79,20 @@ RTPSource::~RTPSource() {
   delete fReceptionStatsDB;
 }
 
+void RTPSource::noteIncomingSeqNum(u_int16_t seqNum, Boolean SSRCHasChanged) {
+  if (fHaveSeenSeqNum && !SSRCHasChanged) {
+    if (!seqNumLT(fHighestSeqNumSeen, seqNum)) return; // a reordered (or retransmitted) packet; not a new gap
+
+    u_int16_t numLostPackets = seqNum - fHighestSeqNumSeen - 1;
+    if (numLostPackets > 0 && numLostPackets <= fMaxPacketLossToReport && fPacketLossHandlerFunc != NULL) {
+      (*fPacketLossHandlerFunc)(fPacketLossHandlerClientData, fHighestSeqNumSeen + 1, numLostPackets);
+    }
+  }
+
+  fHighestSeqNumSeen = seqNum;
+  fHaveSeenSeqNum = True;
+}
+
 void RTPSource::getAttributes() const {
   envir().setResultMsg(""); // Fix later to get attributes from  header #####
 }
@@ -72,29 +101,27 @@ void RTPSource::getAttributes() const {
 ////////// RTPReceptionStatsDB //////////
 
 RTPReceptionStatsDB::RTPReceptionStatsDB()
-  : fTable(HashTable::create(ONE_WORD_HASH_KEYS)), fTotNumPacketsReceived(0) {
+  : fStats(NULL), fNumStats(0), fStatsArraySize(0), fLastLookedUpStats(NULL),
+    fTotNumPacketsReceived(0) {
   reset();
 }
 
 void RTPReceptionStatsDB::reset() {
   fNumActiveSourcesSinceLastReset = 0;
 
-  Iterator iter(*this);
-  RTPReceptionStats* stats;
-  while ((stats = iter.next()) != NULL) {
-    stats->reset();
+  for (unsigned i = 0; i < fNumStats; ++i) {
+    fStats[i]->reset();
   }
 }
 
 RTPReceptionStatsDB::~RTPReceptionStatsDB() {
-  // First, remove and delete all stats records from the table:
-  RTPReceptionStats* stats;
-  while ((stats = (RTPReceptionStats*)fTable->RemoveNext()) != NULL) {
-    delete stats;
+  // First, delete all stats records:
+  for (unsigned i = 0; i < fNumStats; ++i) {
+    delete fStats[i];
   }
 
-  // Then, delete the table itself:
-  delete fTable;
+  // Then, delete the array itself:
+  delete[] fStats;
 }
 
 void RTPReceptionStatsDB
@@ -127,7 +154,8 @@ void RTPReceptionStatsDB
 void RTPReceptionStatsDB
 ::noteIncomingSR(u_int32_t SSRC,
 		 u_int32_t ntpTimestampMSW, u_int32_t ntpTimestampLSW,
-		 u_int32_t rtpTimestamp) {
+		 u_int32_t rtpTimestamp,
+		 u_int32_t senderPacketCount, u_int32_t senderOctetCount) {
   RTPReceptionStats* stats = lookup(SSRC);
   if (stats == NULL) {
     // This is the first time we've heard of this SSRC.
@@ -137,50 +165,95 @@ void RTPReceptionStatsDB
     add(SSRC, stats);
   }
 
-  stats->noteIncomingSR(ntpTimestampMSW, ntpTimestampLSW, rtpTimestamp);
+  stats->noteIncomingSR(ntpTimestampMSW, ntpTimestampLSW, rtpTimestamp,
+			senderPacketCount, senderOctetCount);
 }
 
 void RTPReceptionStatsDB::removeRecord(u_int32_t SSRC) {
-  RTPReceptionStats* stats = lookup(SSRC);
-  if (stats != NULL) {
-    long SSRC_long = (long)SSRC;
-    fTable->Remove((char const*)SSRC_long);
-    delete stats;
-  }
+  Boolean wasFound;
+  unsigned i = lookupIndex(SSRC, wasFound);
+  if (!wasFound) return;
+
+  RTPReceptionStats* stats = fStats[i];
+  --fNumStats;
+  memmove(&fStats[i], &fStats[i+1], (fNumStats-i)*sizeof (RTPReceptionStats*));
+  if (fLastLookedUpStats == stats) fLastLookedUpStats = NULL;
+  delete stats;
 }
 
 RTPReceptionStatsDB::Iterator
 ::Iterator(RTPReceptionStatsDB& receptionStatsDB)
-  : fIter(HashTable::Iterator::create(*(receptionStatsDB.fTable))) {
+  : fOurDB(receptionStatsDB), fNextIndex(0) {
 }
 
 RTPReceptionStatsDB::Iterator::~Iterator() {
-  delete fIter;
 }
 
 RTPReceptionStats*
 RTPReceptionStatsDB::Iterator::next(Boolean includeInactiveSources) {
-  char const* key; // dummy
-
   // If asked, skip over any sources that haven't been active
   // since the last reset:
-  RTPReceptionStats* stats;
-  do {
-    stats = (RTPReceptionStats*)(fIter->next(key));
-  } while (stats != NULL && !includeInactiveSources
-	   && stats->numPacketsReceivedSinceLastReset() == 0);
+  while (fNextIndex < fOurDB.fNumStats) {
+    RTPReceptionStats* stats = fOurDB.fStats[fNextIndex++];
+    if (includeInactiveSources || stats->numPacketsReceivedSinceLastReset() > 0) return stats;
+  }
 
-  return stats;
+  return NULL;
 }
 
 RTPReceptionStats* RTPReceptionStatsDB::lookup(u_int32_t SSRC) const {
-  long SSRC_long = (long)SSRC;
-  return (RTPReceptionStats*)(fTable->Lookup((char const*)SSRC_long));
+  // Fast path: the same SSRC as last time (the usual case):
+  if (fLastLookedUpStats != NULL && fLastLookedUpStats->SSRC() == SSRC) return fLastLookedUpStats;
+
+  Boolean wasFound;
+  unsigned i = lookupIndex(SSRC, wasFound);
+  if (!wasFound) return NULL;
+
+  fLastLookedUpStats = fStats[i];
+  return fLastLookedUpStats;
 }
 
 void RTPReceptionStatsDB::add(u_int32_t SSRC, RTPReceptionStats* stats) {
-  long SSRC_long = (long)SSRC;
-  fTable->Add((char const*)SSRC_long, stats);
+  Boolean wasFound;
+  unsigned i = lookupIndex(SSRC, wasFound);
+  if (wasFound) { // replace the existing record
+    if (fLastLookedUpStats == fStats[i]) fLastLookedUpStats = NULL;
+    fStats[i] = stats;
+    return;
+  }
+
+  if (fNumStats == fStatsArraySize) {
+    // Grow the array:
+    unsigned newSize = fStatsArraySize == 0 ? 4 : 2*fStatsArraySize;
+    RTPReceptionStats** newStats = new RTPReceptionStats*[newSize];
+    if (fNumStats > 0) memmove(newStats, fStats, fNumStats*sizeof (RTPReceptionStats*));
+    delete[] fStats;
+    fStats = newStats;
+    fStatsArraySize = newSize;
+  }
+
+  memmove(&fStats[i+1], &fStats[i], (fNumStats-i)*sizeof (RTPReceptionStats*));
+  fStats[i] = stats;
+  ++fNumStats;
+}
+
+unsigned RTPReceptionStatsDB::lookupIndex(u_int32_t SSRC, Boolean& wasFound) const {
+  unsigned lo = 0, hi = fNumStats;
+  while (lo < hi) {
+    unsigned mid = (lo + hi)/2;
+    u_int32_t midSSRC = fStats[mid]->SSRC();
+    if (midSSRC == SSRC) {
+      wasFound = True;
+      return mid;
+    } else if (midSSRC < SSRC) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  wasFound = False;
+  return lo;
 }
 
 ////////// RTPReceptionStats //////////
@@ -209,6 +282,7 @@ void RTPReceptionStats::init(u_int32_t SSRC) {
   fJitter = 0.0;
   fLastReceivedSR_NTPmsw = fLastReceivedSR_NTPlsw = 0;
   fLastReceivedSR_time.tv_sec = fLastReceivedSR_time.tv_usec = 0;
+  fLastReceivedSR_senderPacketCount = fLastReceivedSR_senderOctetCount = 0;
   fLastPacketReceptionTime.tv_sec = fLastPacketReceptionTime.tv_usec = 0;
   fMinInterPacketGapUS = 0x7FFFFFFF;
   fMaxInterPacketGapUS = 0;
@@ -368,9 +442,12 @@ void RTPReceptionStats
 
 void RTPReceptionStats::noteIncomingSR(u_int32_t ntpTimestampMSW,
 				       u_int32_t ntpTimestampLSW,
-				       u_int32_t rtpTimestamp) {
+				       u_int32_t rtpTimestamp,
+				       u_int32_t senderPacketCount, u_int32_t senderOctetCount) {
   fLastReceivedSR_NTPmsw = ntpTimestampMSW;
   fLastReceivedSR_NTPlsw = ntpTimestampLSW;
+  fLastReceivedSR_senderPacketCount = senderPacketCount;
+  fLastReceivedSR_senderOctetCount = senderOctetCount;
 
   gettimeofday(&fLastReceivedSR_time, NULL);
 
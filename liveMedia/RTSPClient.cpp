@@ -38,6 +38,16 @@ RTSPClient* RTSPClient::createNew(UsageEnvironment& env, char const* rtspURL,
 
 unsigned RTSPClient::sendDescribeCommand(responseHandler* responseHandler, Authenticator* authenticator) {
   if (fCurrentAuthenticator < authenticator) fCurrentAuthenticator = *authenticator;
+  if (fCachedSDPDescription != NULL) {
+    // Don't send anything to the server; instead, arrange for the response to be handled (using our cached
+    // SDP description) from the event loop, just as if it had arrived from the server:
+    RequestRecord* request = new RequestRecord(++fCSeq, "DESCRIBE", responseHandler);
+    fRequestsAwaitingCachedResponse.enqueue(request);
+    if (fCachedDescribeResponseTask == NULL) {
+      fCachedDescribeResponseTask = envir().taskScheduler().scheduleDelayedTask(0, handleCachedDescribeResponse, this);
+    }
+    return request->cseq();
+  }
   return sendRequest(new RequestRecord(++fCSeq, "DESCRIBE", responseHandler));
 }
 
@@ -64,6 +74,37 @@ unsigned RTSPClient::sendSetupCommand(MediaSubsession& subsession, responseHandl
   return sendRequest(new RequestRecord(++fCSeq, "SETUP", responseHandler, NULL, &subsession, booleanFlags));
 }
 
+unsigned RTSPClient::sendSetupAndPlayCommands(MediaSession& session, responseHandler* responseHandler,
+					      Boolean streamUsingTCP, double start, double end, float scale,
+					      Authenticator* authenticator) {
+  if (fCurrentAuthenticator < authenticator) fCurrentAuthenticator = *authenticator;
+
+  // Find the first subsession that has been initiated:
+  MediaSubsessionIterator iter(session);
+  MediaSubsession* subsession;
+  while ((subsession = iter.next()) != NULL && subsession->readSource() == NULL) {}
+  if (subsession == NULL) {
+    envir().setResultMsg("No subsessions have been initiated");
+    RequestRecord request(0, "SETUP", responseHandler);
+    handleRequestError(&request);
+    return 0;
+  }
+
+  fPipelinedSession = &session;
+  fPipelinedResponseHandler = responseHandler;
+  fPipelinedStreamUsingTCP = streamUsingTCP;
+  fPipelinedStart = start; fPipelinedEnd = end; fPipelinedScale = scale;
+  fNumPipelinedSETUPsPending = 1;
+  fPipelinedPLAYWasSent = False;
+  fPipelinedResultCode = 0;
+  delete[] fPipelinedResultString; fPipelinedResultString = NULL;
+
+  // Send a "SETUP" for this first subsession only.  We can't send the remaining "SETUP"s until its response arrives,
+  // because they need to include the session id that the server chooses.  (Otherwise, the server would create a
+  // separate session for each subsession, and our aggregate "PLAY" would not apply to all of them.)
+  return sendSetupCommand(*subsession, continueAfterPipelinedSETUP, False, streamUsingTCP);
+}
+
 unsigned RTSPClient::sendPlayCommand(MediaSession& session, responseHandler* responseHandler,
                                      double start, double end, float scale,
                                      Authenticator* authenticator) {
@@ -197,7 +238,8 @@ Boolean RTSPClient::changeResponseHandler(unsigned cseq, responseHandler* newRes
   RequestRecord* request;
   if ((request = fRequestsAwaitingConnection.findByCSeq(cseq)) != NULL
       || (request = fRequestsAwaitingHTTPTunneling.findByCSeq(cseq)) != NULL
-      || (request = fRequestsAwaitingResponse.findByCSeq(cseq)) != NULL) {
+      || (request = fRequestsAwaitingResponse.findByCSeq(cseq)) != NULL
+      || (request = fRequestsAwaitingCachedResponse.findByCSeq(cseq)) != NULL) {
     request->handler() = newResponseHandler;
     return True;
   }
@@ -340,6 +382,11 @@ Boolean RTSPClient::parseRTSPURL(UsageEnvironment& env, char const* url,
   return False;
 }
 
+void RTSPClient::setCachedSDPDescription(char const* sdpDescription, char const* baseURL) {
+  delete[] fCachedSDPDescription; fCachedSDPDescription = strDup(sdpDescription);
+  if (sdpDescription != NULL && baseURL != NULL) setBaseURL(baseURL);
+}
+
 void RTSPClient::setUserAgentString(char const* userAgentName) {
   if (userAgentName == NULL) return;
 
@@ -363,7 +410,11 @@ RTSPClient::RTSPClient(UsageEnvironment& env, char const* rtspURL,
     fTunnelOverHTTPPortNum(tunnelOverHTTPPortNum),
     fUserAgentHeaderStr(NULL), fUserAgentHeaderStrLen(0),
     fInputSocketNum(-1), fOutputSocketNum(-1), fBaseURL(NULL), fTCPStreamIdCount(0),
-    fLastSessionId(NULL), fSessionTimeoutParameter(0), fSessionCookieCounter(0), fHTTPTunnelingConnectionIsPending(False) {
+    fLastSessionId(NULL), fSessionTimeoutParameter(0), fSessionCookieCounter(0), fHTTPTunnelingConnectionIsPending(False),
+    fPipelinedSession(NULL), fPipelinedResponseHandler(NULL), fPipelinedStreamUsingTCP(False),
+    fPipelinedStart(0.0), fPipelinedEnd(-1.0), fPipelinedScale(1.0f), fNumPipelinedSETUPsPending(0),
+    fPipelinedPLAYWasSent(False), fPipelinedResultCode(0), fPipelinedResultString(NULL),
+    fCachedSDPDescription(NULL), fCachedDescribeResponseTask(NULL) {
   setBaseURL(rtspURL);
 
   fResponseBuffer = new char[responseBufferSize+1];
@@ -400,6 +451,7 @@ RTSPClient::~RTSPClient() {
 
   delete[] fResponseBuffer;
   delete[] fUserAgentHeaderStr;
+  delete[] fCachedSDPDescription;
 }
 
 void RTSPClient::reset() {
@@ -408,8 +460,13 @@ void RTSPClient::reset() {
   fRequestsAwaitingConnection.reset();
   fRequestsAwaitingHTTPTunneling.reset();
   fRequestsAwaitingResponse.reset();
+  fRequestsAwaitingCachedResponse.reset();
+  envir().taskScheduler().unscheduleDelayedTask(fCachedDescribeResponseTask);
   fServerAddress = 0;
 
+  fPipelinedSession = NULL; fPipelinedResponseHandler = NULL;
+  delete[] fPipelinedResultString; fPipelinedResultString = NULL;
+
   setBaseURL(NULL);
 
   fCurrentAuthenticator.reset();
@@ -1693,23 +1750,24 @@ void RTSPClient::handleResponseBytes(int newBytesRead) {
 	    envir().setResultMsg("Bad \"CSeq:\" header: \"", lineStart, "\"");
 	    break;
 	  }
-	  // Find the handler function for "cseq":
-	  RequestRecord* request;
-	  while ((request = fRequestsAwaitingResponse.dequeue()) != NULL) {
-	    if (request->cseq() < cseq) { // assumes that the CSeq counter will never wrap around
-	      // We never received (and will never receive) a response for this handler, so delete it:
+	  // Find the handler function for "cseq".  (If there's none, then no handler was registered for this response,
+	  // so ignore it - leaving any requests that are still awaiting responses in place.)
+	  if (fRequestsAwaitingResponse.findByCSeq(cseq) != NULL) {
+	    RequestRecord* request;
+	    while ((request = fRequestsAwaitingResponse.dequeue()) != NULL) {
+	      if (request->cseq() == cseq) {
+		// This is the handler that we want. Remove its record, but remember it, so that we can later call its handler:
+		foundRequest = request;
+		break;
+	      }
+
+	      // Because the server handles (pipelined) requests in order, we never received (and will never receive)
+	      // a response for this earlier handler, so delete it:
 	      if (fVerbosityLevel >= 1 && strcmp(request->commandName(), "POST") != 0) {
 		envir() << "WARNING: The server did not respond to our \"" << request->commandName() << "\" request (CSeq: "
 			<< request->cseq() << ").  The server appears to be buggy (perhaps not handling pipelined requests properly).\n";
 	      }
 	      delete request;
-	    } else if (request->cseq() == cseq) {
-	      // This is the handler that we want. Remove its record, but remember it, so that we can later call its handler:
-	      foundRequest = request;
-	      break;
-	    } else { // request->cseq() > cseq
-	      // No handler was registered for this response, so ignore it.
-	      break;
 	    }
 	  }
 	} else if (checkForHeader(lineStart, "Content-Length:", 15, headerParamsStr)) {
@@ -1770,7 +1828,7 @@ void RTSPClient::handleResponseBytes(int newBytesRead) {
       }
       if (!reachedEndOfHeaders) break; // an error occurred
       
-      if (foundRequest == NULL) {
+      if (foundRequest == NULL && cseq == 0) {
 	// Hack: The response didn't have a "CSeq:" header; assume it's for our most recent request:
 	foundRequest = fRequestsAwaitingResponse.dequeue();
       }
@@ -1902,6 +1960,115 @@ void RTSPClient::handleResponseBytes(int newBytesRead) {
 }
 
 
+void RTSPClient::sendPipelinedSetupAndPlayCommands() {
+  // We now know the server's session id, so send "SETUP"s for all of the remaining (initiated) subsessions,
+  // followed by an aggregate "PLAY", without waiting for any responses.  The server handles these in order:
+  fPipelinedPLAYWasSent = True;
+
+  MediaSubsessionIterator iter(*fPipelinedSession);
+  MediaSubsession* subsession;
+  while ((subsession = iter.next()) != NULL) {
+    if (subsession->readSource() == NULL || subsession->sessionId() != NULL) continue; // not initiated, or already set up
+
+    ++fNumPipelinedSETUPsPending;
+    sendSetupCommand(*subsession, continueAfterPipelinedSETUP, False, fPipelinedStreamUsingTCP);
+    if (fPipelinedSession == NULL) return; // we've already finished (because of a failure)
+  }
+  if (fNumPipelinedSETUPsPending == 0) sendDummyUDPPackets(*fPipelinedSession); // hack to improve NAT traversal
+
+  sendRequest(new RequestRecord(++fCSeq, "PLAY", continueAfterPipelinedPLAY, fPipelinedSession, NULL, 0,
+				fPipelinedStart, fPipelinedEnd, fPipelinedScale));
+}
+
+void RTSPClient::finishPipelinedSetupAndPlay(int resultCode, char* resultString) {
+  responseHandler* handler = fPipelinedResponseHandler;
+  fPipelinedSession = NULL; fPipelinedResponseHandler = NULL;
+  if (resultString == fPipelinedResultString) fPipelinedResultString = NULL; // because we're passing it on
+
+  if (handler != NULL) {
+    (*handler)(this, resultCode, resultString);
+  } else {
+    delete[] resultString;
+  }
+}
+
+void RTSPClient::continueAfterPipelinedSETUP(RTSPClient* rtspClient, int resultCode, char* resultString) {
+  rtspClient->continueAfterPipelinedSETUP1(resultCode, resultString);
+}
+
+void RTSPClient::continueAfterPipelinedSETUP1(int resultCode, char* resultString) {
+  if (fPipelinedSession == NULL) { // we're no longer doing a "sendSetupAndPlayCommands()"
+    delete[] resultString;
+    return;
+  }
+
+  --fNumPipelinedSETUPsPending;
+  if (resultCode != 0 && fPipelinedResultCode == 0) {
+    // Remember this (first) error, to report later:
+    fPipelinedResultCode = resultCode;
+    fPipelinedResultString = resultString;
+  } else {
+    delete[] resultString;
+  }
+
+  if (!fPipelinedPLAYWasSent) {
+    // This was the response to our first "SETUP":
+    if (fPipelinedResultCode != 0) {
+      finishPipelinedSetupAndPlay(fPipelinedResultCode, fPipelinedResultString);
+    } else {
+      sendPipelinedSetupAndPlayCommands();
+    }
+  } else if (fNumPipelinedSETUPsPending == 0) {
+    // All of our "SETUP"s have now been handled.  (The "PLAY" has already been sent, but the server won't have
+    // started streaming before it sees it, so this should still be early enough to be useful.)
+    sendDummyUDPPackets(*fPipelinedSession); // hack to improve NAT traversal
+  }
+}
+
+void RTSPClient::continueAfterPipelinedPLAY(RTSPClient* rtspClient, int resultCode, char* resultString) {
+  rtspClient->continueAfterPipelinedPLAY1(resultCode, resultString);
+}
+
+void RTSPClient::continueAfterPipelinedPLAY1(int resultCode, char* resultString) {
+  if (fPipelinedSession == NULL) { // we're no longer doing a "sendSetupAndPlayCommands()"
+    delete[] resultString;
+    return;
+  }
+
+  if (fPipelinedResultCode != 0) {
+    // Report the first "SETUP" error instead:
+    delete[] resultString;
+    finishPipelinedSetupAndPlay(fPipelinedResultCode, fPipelinedResultString);
+  } else {
+    finishPipelinedSetupAndPlay(resultCode, resultString);
+  }
+}
+
+void RTSPClient::handleCachedDescribeResponse(void* clientData) {
+  ((RTSPClient*)clientData)->handleCachedDescribeResponse1();
+}
+
+void RTSPClient::handleCachedDescribeResponse1() {
+  fCachedDescribeResponseTask = NULL;
+
+  RequestRecord* request = fRequestsAwaitingCachedResponse.dequeue();
+  if (request == NULL) return;
+  if (!fRequestsAwaitingCachedResponse.isEmpty()) {
+    // Handle the rest later (because the handler that we're about to call might delete us):
+    fCachedDescribeResponseTask = envir().taskScheduler().scheduleDelayedTask(0, handleCachedDescribeResponse, this);
+  }
+
+  if (fCachedSDPDescription == NULL) {
+    // Our cached SDP description has since been cleared, so send the "DESCRIBE" to the server after all:
+    sendRequest(request);
+    return;
+  }
+
+  responseHandler* handler = request->handler();
+  delete request;
+  if (handler != NULL) (*handler)(this, 0, strDup(fCachedSDPDescription));
+}
+
 ////////// RTSPClient::RequestRecord implementation //////////
 
 RTSPClient::RequestRecord::RequestRecord(unsigned cseq, char const* commandName, responseHandler* handler,
@@ -0,0 +1,271 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A RTSP server
+// Implementation of "RTSPServer::generateMetricsReport()"
+
+#include "RTSPServer.hh"
+#include "RTCP.hh"
+#if defined(__WIN32__) || defined(_WIN32) || defined(_QNX4)
+#define snprintf _snprintf
+#endif
+
+// A simple, growable text buffer, used to build the report:
+class MetricsReportBuffer {
+public:
+  MetricsReportBuffer()
+    : fBufferSize(10000), fDataSize(0) {
+    fBuffer = new char[fBufferSize];
+    fBuffer[0] = '\0';
+  }
+  virtual ~MetricsReportBuffer() { delete[] fBuffer; }
+
+  void append(char const* str) {
+    unsigned len = strlen(str);
+    if (fDataSize + len + 1 > fBufferSize) {
+      unsigned newBufferSize = 2*fBufferSize;
+      if (newBufferSize < fDataSize + len + 1) newBufferSize = fDataSize + len + 1;
+      char* newBuffer = new char[newBufferSize];
+      memmove(newBuffer, fBuffer, fDataSize);
+      delete[] fBuffer;
+      fBuffer = newBuffer;
+      fBufferSize = newBufferSize;
+    }
+    memmove(&fBuffer[fDataSize], str, len+1);
+    fDataSize += len;
+  }
+
+  void appendFamilyHeader(char const* name, char const* type, char const* help) {
+    char line[300];
+    snprintf(line, sizeof line, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    append(line);
+  }
+
+  void appendSample(char const* name, char const* labels, double value) {
+    char line[500];
+    if (labels == NULL || labels[0] == '\0') {
+      snprintf(line, sizeof line, "%s %.15g\n", name, value);
+    } else {
+      snprintf(line, sizeof line, "%s{%s} %.15g\n", name, labels, value);
+    }
+    append(line);
+  }
+
+  char* getResult() { // returns the buffer, which the caller must delete[]
+    char* result = fBuffer;
+    fBuffer = NULL;
+    return result;
+  }
+
+private:
+  char* fBuffer;
+  unsigned fBufferSize, fDataSize;
+};
+
+// Copies "str" to "to", escaping it for use as a Prometheus label value (and truncating if necessary):
+static void escapeLabelValue(char const* str, char* to, unsigned toMaxSize) {
+  unsigned i = 0;
+  if (str != NULL) {
+    for (; *str != '\0' && i+2 < toMaxSize; ++str) {
+      char c = *str;
+      if (c == '"' || c == '\\') {
+	to[i++] = '\\';
+	to[i++] = c;
+      } else if (c == '\n') {
+	to[i++] = '\\';
+	to[i++] = 'n';
+      } else {
+	to[i++] = c;
+      }
+    }
+  }
+  to[i] = '\0';
+}
+
+// The data that we report for each track of each stream.  (We don't report each client session separately,
+// because that would publish its session id - which could then be used to control the session - and would
+// give each metric an unbounded number of label values.)
+struct streamMetricsRecord {
+  char labels[300];
+  unsigned numRTPStreams;
+  double numPacketsSent, numOctetsSent, numPacketsDropped, numTruncatedFrames;
+  double numPacketsLost, tcpSendQueueDepth, numTCPBlockingSends;
+};
+
+// Returns the number of packets lost, as reported (in RTCP "RR" packets) by the receiver of "rtpSink" that
+// has reported the most loss:
+static int maxNumPacketsLostReported(RTPSink const& rtpSink) {
+  int result = 0;
+  Boolean haveStats = False;
+  RTPTransmissionStatsDB::Iterator statsIter(rtpSink.transmissionStatsDB());
+  RTPTransmissionStats* stats;
+  while ((stats = statsIter.next()) != NULL) {
+    // This is a signed 24-bit value:
+    int numLost = (int)(stats->totNumPacketsLost()&0xFFFFFF);
+    if (numLost&0x800000) numLost -= 0x1000000;
+    if (!haveStats || numLost > result) result = numLost;
+    haveStats = True;
+  }
+  return result;
+}
+
+char* RTSPServer::generateMetricsReport() {
+  MetricsReportBuffer report;
+
+  // First, report on our event loop (if our task scheduler keeps statistics about it):
+  EventLoopStats eventLoopStats;
+  if (envir().taskScheduler().getEventLoopStats(eventLoopStats)) {
+    report.appendFamilyHeader("live555_event_loop_steps_total", "counter",
+			      "Number of iterations of the event loop.");
+    report.appendSample("live555_event_loop_steps_total", NULL, (double)eventLoopStats.numSteps);
+    report.appendFamilyHeader("live555_event_loop_handlers_dispatched_total", "counter",
+			      "Number of socket handlers, triggered events and delayed tasks handled by the event loop.");
+    report.appendSample("live555_event_loop_handlers_dispatched_total", NULL, (double)eventLoopStats.numHandlersDispatched);
+    report.appendFamilyHeader("live555_event_loop_busy_seconds_total", "counter",
+			      "Time spent in event loop handlers (i.e., not waiting for events).");
+    report.appendSample("live555_event_loop_busy_seconds_total", NULL, eventLoopStats.totBusyTimeUS/1000000.0);
+    report.appendFamilyHeader("live555_event_loop_max_step_busy_seconds", "gauge",
+			      "The longest time spent in handlers during a single event loop iteration.");
+    report.appendSample("live555_event_loop_max_step_busy_seconds", NULL, eventLoopStats.maxStepBusyTimeUS/1000000.0);
+    report.appendFamilyHeader("live555_delay_queue_depth", "gauge",
+			      "Number of pending delayed tasks.");
+    report.appendSample("live555_delay_queue_depth", NULL, (double)eventLoopStats.delayQueueDepth);
+  }
+
+  // Then, report on our "ServerMediaSession"s:
+  report.appendFamilyHeader("live555_client_sessions", "gauge", "Number of client sessions.");
+  report.appendSample("live555_client_sessions", NULL, (double)numClientSessions());
+
+  report.appendFamilyHeader("live555_stream_client_sessions", "gauge",
+			    "Number of client sessions using each stream.");
+  {
+    ServerMediaSessionIterator iter(*this);
+    ServerMediaSession* serverMediaSession;
+    while ((serverMediaSession = iter.next()) != NULL) {
+      char streamName[200];
+      escapeLabelValue(serverMediaSession->streamName(), streamName, sizeof streamName);
+      char labels[250];
+      snprintf(labels, sizeof labels, "stream=\"%s\"", streamName);
+      report.appendSample("live555_stream_client_sessions", labels, (double)serverMediaSession->referenceCount());
+    }
+  }
+
+  // Then, total the RTP streams being sent for each track of each stream.  (A RTP stream that's shared by several
+  // client sessions - e.g., because "reuseFirstSource" was True - is counted just once.)
+  unsigned numRecords = 0, maxNumRecords = 16;
+  streamMetricsRecord* records = new streamMetricsRecord[maxNumRecords];
+  HashTable* recordIndexes = HashTable::create(STRING_HASH_KEYS); // maps labels to 1 + index into "records"
+  HashTable* rtpSinksSeen = HashTable::create(ONE_WORD_HASH_KEYS);
+  {
+    ClientSessionIterator iter(*this);
+    RTSPClientSession* clientSession;
+    while ((clientSession = (RTSPClientSession*)(iter.next())) != NULL) {
+      char streamName[200];
+      escapeLabelValue(clientSession->fOurServerMediaSession == NULL ? NULL
+		       : clientSession->fOurServerMediaSession->streamName(),
+		       streamName, sizeof streamName);
+
+      for (unsigned i = 0; i < clientSession->fNumStreamStates; ++i) {
+	ServerMediaSubsession* subsession = clientSession->fStreamStates[i].subsession;
+	if (subsession == NULL || clientSession->fStreamStates[i].streamToken == NULL) continue;
+
+	RTPSink const* rtpSink = NULL;
+	RTCPInstance const* rtcpInstance = NULL;
+	subsession->getRTPSinkandRTCP(clientSession->fStreamStates[i].streamToken, rtpSink, rtcpInstance);
+	if (rtpSink == NULL || rtpSinksSeen->Lookup((char const*)rtpSink) != NULL) continue;
+	rtpSinksSeen->Add((char const*)rtpSink, (void*)rtpSink);
+
+	char trackId[50];
+	escapeLabelValue(subsession->trackId(), trackId, sizeof trackId);
+	char labels[sizeof records[0].labels];
+	snprintf(labels, sizeof labels, "stream=\"%s\",track=\"%s\"", streamName, trackId);
+
+	streamMetricsRecord* record;
+	unsigned long recordIndex = (unsigned long)(recordIndexes->Lookup(labels));
+	if (recordIndex != 0) {
+	  record = &records[recordIndex-1];
+	} else {
+	  if (numRecords == maxNumRecords) {
+	    streamMetricsRecord* newRecords = new streamMetricsRecord[2*maxNumRecords];
+	    memmove(newRecords, records, numRecords*sizeof (streamMetricsRecord));
+	    delete[] records;
+	    records = newRecords;
+	    maxNumRecords *= 2;
+	  }
+	  record = &records[numRecords++];
+	  memset(record, 0, sizeof *record);
+	  memmove(record->labels, labels, sizeof labels);
+	  recordIndexes->Add(labels, (void*)(unsigned long)numRecords);
+	}
+
+	++record->numRTPStreams;
+	record->numPacketsSent += rtpSink->numPacketsSent();
+	record->numOctetsSent += rtpSink->numOctetsSent();
+	record->numPacketsDropped += rtpSink->numPacketsDropped();
+	record->numTruncatedFrames += rtpSink->numTruncatedFrames();
+	record->numPacketsLost += maxNumPacketsLostReported(*rtpSink);
+	record->tcpSendQueueDepth += rtpSink->tcpSendQueueDepth();
+	record->numTCPBlockingSends += rtpSink->numTCPBlockingSends();
+      }
+    }
+  }
+  delete rtpSinksSeen;
+  delete recordIndexes;
+
+  // And report on each of them.  (Because these are totals over the RTP streams that are currently being sent,
+  // they can decrease - when a client session ends - so they're reported as gauges, rather than counters.)
+  report.appendFamilyHeader("live555_rtp_streams", "gauge", "Number of RTP streams being sent.");
+  for (unsigned i = 0; i < numRecords; ++i) {
+    report.appendSample("live555_rtp_streams", records[i].labels, (double)records[i].numRTPStreams);
+  }
+  report.appendFamilyHeader("live555_rtp_packets_sent", "gauge", "Number of RTP packets sent, by the current RTP streams.");
+  for (unsigned i = 0; i < numRecords; ++i) {
+    report.appendSample("live555_rtp_packets_sent", records[i].labels, records[i].numPacketsSent);
+  }
+  report.appendFamilyHeader("live555_rtp_payload_bytes_sent", "gauge", "Number of RTP payload bytes sent, by the current RTP streams.");
+  for (unsigned i = 0; i < numRecords; ++i) {
+    report.appendSample("live555_rtp_payload_bytes_sent", records[i].labels, records[i].numOctetsSent);
+  }
+  report.appendFamilyHeader("live555_rtp_packets_dropped", "gauge",
+			    "Number of RTP packets that could not be sent, by the current RTP streams.");
+  for (unsigned i = 0; i < numRecords; ++i) {
+    report.appendSample("live555_rtp_packets_dropped", records[i].labels, records[i].numPacketsDropped);
+  }
+  report.appendFamilyHeader("live555_rtp_truncated_frames", "gauge",
+			    "Number of input frames that were truncated because they were too large for the RTP sink's buffer, by the current RTP streams.");
+  for (unsigned i = 0; i < numRecords; ++i) {
+    report.appendSample("live555_rtp_truncated_frames", records[i].labels, records[i].numTruncatedFrames);
+  }
+  report.appendFamilyHeader("live555_rtp_packets_lost_reported", "gauge",
+			    "Packets lost by the current RTP streams, as reported in RTCP RR packets (for each, the most reported by any receiver).  Can be negative, if duplicates were received.");
+  for (unsigned i = 0; i < numRecords; ++i) {
+    report.appendSample("live555_rtp_packets_lost_reported", records[i].labels, records[i].numPacketsLost);
+  }
+  report.appendFamilyHeader("live555_rtp_tcp_send_queue_bytes", "gauge",
+			    "Number of bytes queued (unsent) in the OS's TCP send buffers (for RTP-over-TCP streams).");
+  for (unsigned i = 0; i < numRecords; ++i) {
+    report.appendSample("live555_rtp_tcp_send_queue_bytes", records[i].labels, records[i].tcpSendQueueDepth);
+  }
+  report.appendFamilyHeader("live555_rtp_tcp_blocking_sends", "gauge",
+			    "Number of times that a TCP send buffer filled up, so that sending had to block, by the current RTP-over-TCP streams.");
+  for (unsigned i = 0; i < numRecords; ++i) {
+    report.appendSample("live555_rtp_tcp_blocking_sends", records[i].labels, records[i].numTCPBlockingSends);
+  }
+  delete[] records;
+
+  return report.getResult();
+}
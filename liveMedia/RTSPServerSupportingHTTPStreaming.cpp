@@ -21,6 +21,8 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "RTSPServer.hh"
 #include "RTSPServerSupportingHTTPStreaming.hh"
 #include "RTSPCommon.hh"
+#include "ByteStreamFileSource.hh"
+#include "FramedFilter.hh"
 #ifndef _WIN32_WCE
 #include <sys/stat.h>
 #endif
@@ -38,10 +40,17 @@ RTSPServerSupportingHTTPStreaming::createNew(UsageEnvironment& env, Port rtspPor
 RTSPServerSupportingHTTPStreaming
 ::RTSPServerSupportingHTTPStreaming(UsageEnvironment& env, int ourSocket, Port rtspPort,
 				    UserAuthenticationDatabase* authDatabase, unsigned reclamationTestSeconds)
-  : RTSPServer(env, ourSocket, rtspPort, authDatabase, reclamationTestSeconds) {
+  : RTSPServer(env, ourSocket, rtspPort, authDatabase, reclamationTestSeconds),
+    fMetricsURLSuffix(NULL) {
 }
 
 RTSPServerSupportingHTTPStreaming::~RTSPServerSupportingHTTPStreaming() {
+  delete[] fMetricsURLSuffix;
+}
+
+void RTSPServerSupportingHTTPStreaming::setMetricsURLSuffix(char const* urlSuffix) {
+  delete[] fMetricsURLSuffix;
+  fMetricsURLSuffix = strDup(urlSuffix);
 }
 
 GenericMediaServer::ClientConnection*
@@ -78,6 +87,13 @@ static char const* lastModifiedHeader(char const* fileName) {
 
 void RTSPServerSupportingHTTPStreaming::RTSPClientConnectionSupportingHTTPStreaming
 ::handleHTTPCmd_StreamingGET(char const* urlSuffix, char const* /*fullRequestStr*/) {
+  // First, check whether this is a request for our metrics report:
+  char const* metricsURLSuffix = ((RTSPServerSupportingHTTPStreaming&)fOurServer).fMetricsURLSuffix;
+  if (metricsURLSuffix != NULL && strcmp(urlSuffix, metricsURLSuffix) == 0) {
+    handleHTTPCmd_MetricsGET();
+    return;
+  }
+
   // If "urlSuffix" ends with "?segment=<offset-in-seconds>,<duration-in-seconds>", then strip this off, and send the
   // specified segment.  Otherwise, construct and send a playlist that consists of segments from the specified file.
   do {
@@ -153,6 +169,18 @@ void RTSPServerSupportingHTTPStreaming::RTSPClientConnectionSupportingHTTPStream
       fStreamSource = subsession->getStreamSource(streamToken);
       if (fStreamSource != NULL) {
 	if (fTCPSink == NULL) fTCPSink = TCPStreamSink::createNew(envir(), fClientOutputSocket);
+
+	// If the source is a Transport Stream file (possibly through a "MPEG2TransportStreamFramer", which passes the data
+	// through unchanged), then send the data directly from the file, so that we don't have to copy it:
+	FramedSource* fileSource = fStreamSource;
+	if (fileSource->isMPEG2TransportStreamFramer()) fileSource = ((FramedFilter*)fileSource)->inputSource();
+	int fileDescriptor;
+	u_int64_t filePosition;
+	if (fileSource != NULL && fileSource->isByteStreamFileSource()
+	    && ((ByteStreamFileSource*)fileSource)->getFileDescriptorAndPosition(fileDescriptor, filePosition)) {
+	  fTCPSink->sendFromFileDirectly(fileDescriptor, filePosition, numTSBytesToStream);
+	}
+
 	fTCPSink->startPlaying(*fStreamSource, afterStreaming, this);
       }
     } while(0);
@@ -254,6 +282,37 @@ void RTSPServerSupportingHTTPStreaming::RTSPClientConnectionSupportingHTTPStream
   fTCPSink->startPlaying(*fPlaylistSource, afterStreaming, this);
 }
 
+void RTSPServerSupportingHTTPStreaming::RTSPClientConnectionSupportingHTTPStreaming::handleHTTPCmd_MetricsGET() {
+  char* report = ((RTSPServerSupportingHTTPStreaming&)fOurServer).generateMetricsReport();
+  unsigned reportLen = strlen(report);
+
+  // Construct our response:
+  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+	   "HTTP/1.1 200 OK\r\n"
+	   "%s"
+	   "Server: LIVE555 Streaming Media v%s\r\n"
+	   "Cache-Control: no-cache\r\n"
+	   "Content-Length: %d\r\n"
+	   "Content-Type: text/plain; version=0.0.4\r\n"
+	   "\r\n",
+	   dateHeader(),
+	   LIVEMEDIA_LIBRARY_VERSION_STRING,
+	   reportLen);
+
+  // Send the response header now, because we're about to add more data (the report):
+  send(fClientOutputSocket, (char const*)fResponseBuffer, strlen((char*)fResponseBuffer), 0);
+  fResponseBuffer[0] = '\0'; // We've already sent the response.  This tells the calling code not to send it again.
+
+  // Then, stream the report over the TCP socket (as we do for a playlist):
+  if (fPlaylistSource != NULL) { // sanity check
+    if (fTCPSink != NULL) fTCPSink->stopPlaying();
+    Medium::close(fPlaylistSource);
+  }
+  fPlaylistSource = ByteStreamMemoryBufferSource::createNew(envir(), (u_int8_t*)report, reportLen);
+  if (fTCPSink == NULL) fTCPSink = TCPStreamSink::createNew(envir(), fClientOutputSocket);
+  fTCPSink->startPlaying(*fPlaylistSource, afterStreaming, this);
+}
+
 void RTSPServerSupportingHTTPStreaming::RTSPClientConnectionSupportingHTTPStreaming::afterStreaming(void* clientData) {
    RTSPServerSupportingHTTPStreaming::RTSPClientConnectionSupportingHTTPStreaming* clientConnection
     = (RTSPServerSupportingHTTPStreaming::RTSPClientConnectionSupportingHTTPStreaming*)clientData;
@@ -0,0 +1,458 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// Forward error correction (FEC) for RTP streams, using XOR parity packets, as in SMPTE 2022-1
+// Implementation
+
+#include "SMPTE2022FEC.hh"
+#include "RTPPacketHistory.hh"
+#include "GroupsockHelper.hh"
+#include <string.h>
+
+// Each FEC packet is a RTP packet (payload type 96; SSRC 0) whose header's P, X, CC and M fields are the XOR of those
+// of the media packets that it protects, followed by a 16-byte FEC header, then the XOR of the media packets' data
+// (everything after the fixed 12-byte RTP header, zero-padded to the longest).  The FEC header is:
+//     SNBase low bits (16) | Length recovery (16) | E (1) | PT recovery (7) | Mask (24) | TS recovery (32) |
+//     X (1) | D (1) | type (3) | index (3) | Offset (8) | NA (8) | SNBase ext bits (8)
+// where the protected media packets are SNBase, SNBase+Offset, ..., SNBase+(NA-1)*Offset.
+
+#define FEC_RTP_PAYLOAD_TYPE 96
+#define FEC_HEADER_SIZE 16
+#define MAX_FEC_PACKET_SIZE 65536
+#define NUM_PENDING_FEC_PACKETS 256
+
+static void xorInto(unsigned char* to, unsigned char const* from, unsigned numBytes) {
+  // XOR 16 bytes at a time - as 4 32-bit words, loaded and stored using "memcpy()" (because the data need not be
+  // aligned), which compilers turn into plain word (or SIMD) instructions - then any remaining bytes:
+  while (numBytes >= 16) {
+    u_int32_t t[4], f[4];
+    memcpy(t, to, 16); memcpy(f, from, 16);
+    t[0] ^= f[0]; t[1] ^= f[1]; t[2] ^= f[2]; t[3] ^= f[3];
+    memcpy(to, t, 16);
+    to += 16; from += 16; numBytes -= 16;
+  }
+  while (numBytes-- > 0) *to++ ^= *from++;
+}
+
+////////// FECAccumulator //////////
+// The running XOR of the media packets in one row or column.
+
+class FECAccumulator {
+public:
+  FECAccumulator();
+  virtual ~FECAccumulator();
+
+  void addPacket(unsigned char const* packet, unsigned packetSize);
+  void reset() { numPackets = 0; dataSize = 0; }
+
+public:
+  unsigned numPackets;
+  u_int16_t snBase;
+  u_int8_t byte0Recovery, byte1Recovery; // XOR of the 1st 2 bytes of the RTP headers (P,X,CC, and M,PT)
+  u_int16_t lengthRecovery;
+  u_int32_t timestampRecovery, lastTimestamp;
+  unsigned char* data;
+  unsigned dataSize, dataBufferSize;
+};
+
+FECAccumulator::FECAccumulator()
+  : numPackets(0), snBase(0), byte0Recovery(0), byte1Recovery(0), lengthRecovery(0),
+    timestampRecovery(0), lastTimestamp(0), data(NULL), dataSize(0), dataBufferSize(0) {
+}
+
+FECAccumulator::~FECAccumulator() {
+  delete[] data;
+}
+
+void FECAccumulator::addPacket(unsigned char const* packet, unsigned packetSize) {
+  // ASSERT: packetSize >= 12
+  unsigned packetDataSize = packetSize - 12;
+  u_int32_t timestamp = (packet[4]<<24)|(packet[5]<<16)|(packet[6]<<8)|packet[7];
+
+  if (packetDataSize > dataBufferSize) {
+    unsigned char* newData = new unsigned char[packetDataSize];
+    if (numPackets > 0) memmove(newData, data, dataSize);
+    delete[] data; data = newData;
+    dataBufferSize = packetDataSize;
+  }
+
+  if (numPackets == 0) {
+    // This is the first packet in the group, so just copy it (rather than XORing it with zeros):
+    snBase = (packet[2]<<8)|packet[3];
+    byte0Recovery = packet[0]; byte1Recovery = packet[1];
+    lengthRecovery = packetDataSize;
+    timestampRecovery = timestamp;
+    memmove(data, &packet[12], packetDataSize);
+    dataSize = packetDataSize;
+  } else {
+    byte0Recovery ^= packet[0]; byte1Recovery ^= packet[1];
+    lengthRecovery ^= packetDataSize;
+    timestampRecovery ^= timestamp;
+    if (packetDataSize > dataSize) {
+      // Shorter packets are treated as if padded with zeros:
+      memset(&data[dataSize], 0, packetDataSize - dataSize);
+      dataSize = packetDataSize;
+    }
+    xorInto(data, &packet[12], packetDataSize);
+  }
+  lastTimestamp = timestamp;
+  ++numPackets;
+}
+
+////////// SMPTE2022FECEncoder //////////
+
+SMPTE2022FECEncoder*
+SMPTE2022FECEncoder::createNew(UsageEnvironment& env, RTPSink& mediaSink,
+			       Groupsock* columnFECGroupsock, Groupsock* rowFECGroupsock,
+			       unsigned numColumns, unsigned numRows) {
+  if (numColumns == 0 || numColumns > 255 || numRows == 0 || numRows > 255) {
+    env.setResultMsg("SMPTE2022FECEncoder: the numbers of columns and rows must each be in the range [1,255]");
+    return NULL;
+  }
+
+  return new SMPTE2022FECEncoder(env, mediaSink, columnFECGroupsock, rowFECGroupsock, numColumns, numRows);
+}
+
+SMPTE2022FECEncoder
+::SMPTE2022FECEncoder(UsageEnvironment& env, RTPSink& mediaSink,
+		      Groupsock* columnFECGroupsock, Groupsock* rowFECGroupsock,
+		      unsigned numColumns, unsigned numRows)
+  : Medium(env),
+    fMediaSink(mediaSink), fColumnFECGroupsock(columnFECGroupsock), fRowFECGroupsock(rowFECGroupsock),
+    fNumColumns(numColumns), fNumRows(numRows), fHaveMatrixBase(False), fMatrixBaseSeqNum(0),
+    fNextColumnFECSeqNum((u_int16_t)our_random()), fNextRowFECSeqNum((u_int16_t)our_random()),
+    fOutBuf(NULL), fOutBufSize(0), fNumFECPacketsSent(0) {
+  fColumnAccumulators = new FECAccumulator[fNumColumns];
+  fRowAccumulator = new FECAccumulator;
+
+  fMediaSink.setSentPacketHandler(sentPacketHandler, this);
+}
+
+SMPTE2022FECEncoder::~SMPTE2022FECEncoder() {
+  fMediaSink.setSentPacketHandler(NULL, NULL);
+
+  delete[] fOutBuf;
+  delete fRowAccumulator;
+  delete[] fColumnAccumulators;
+}
+
+void SMPTE2022FECEncoder
+::sentPacketHandler(void* clientData, unsigned char const* packet, unsigned packetSize) {
+  SMPTE2022FECEncoder* encoder = (SMPTE2022FECEncoder*)clientData;
+  encoder->handleSentPacket(packet, packetSize);
+}
+
+void SMPTE2022FECEncoder::handleSentPacket(unsigned char const* packet, unsigned packetSize) {
+  if (packetSize < 12) return; // not a RTP packet
+
+  // Figure out where this packet lies within the current matrix:
+  u_int16_t seqNum = (packet[2]<<8)|packet[3];
+  unsigned const matrixSize = fNumColumns*fNumRows;
+  if (!fHaveMatrixBase) {
+    fMatrixBaseSeqNum = seqNum;
+    fHaveMatrixBase = True;
+  }
+  unsigned index = (u_int16_t)(seqNum - fMatrixBaseSeqNum);
+  if (index >= matrixSize) {
+    if (index < 2*matrixSize) {
+      // Normal case: This packet begins (or lies within) the next matrix:
+      fMatrixBaseSeqNum += matrixSize;
+      index -= matrixSize;
+    } else {
+      // There was a discontinuity in the sequence numbers; start again (and forget any partial rows or columns):
+      fMatrixBaseSeqNum = seqNum;
+      index = 0;
+    }
+  }
+  unsigned column = index%fNumColumns;
+  unsigned row = index/fNumColumns;
+
+  if (fColumnFECGroupsock != NULL) {
+    FECAccumulator& columnAccumulator = fColumnAccumulators[column];
+    if (row == 0) columnAccumulator.reset();
+    columnAccumulator.addPacket(packet, packetSize);
+    if (row == fNumRows-1) sendFECPacket(columnAccumulator, False);
+  }
+  if (fRowFECGroupsock != NULL) {
+    if (column == 0) fRowAccumulator->reset();
+    fRowAccumulator->addPacket(packet, packetSize);
+    if (column == fNumColumns-1) sendFECPacket(*fRowAccumulator, True);
+  }
+}
+
+void SMPTE2022FECEncoder::sendFECPacket(FECAccumulator& accumulator, Boolean isRow) {
+  unsigned const numExpected = isRow ? fNumColumns : fNumRows;
+  if (accumulator.numPackets != numExpected) { // we missed some packets (after a discontinuity)
+    accumulator.reset();
+    return;
+  }
+
+  unsigned const fecPacketSize = 12 + FEC_HEADER_SIZE + accumulator.dataSize;
+  if (fecPacketSize > fOutBufSize) {
+    delete[] fOutBuf;
+    fOutBuf = new unsigned char[fecPacketSize];
+    fOutBufSize = fecPacketSize;
+  }
+  unsigned char* p = fOutBuf;
+
+  // The RTP header:
+  u_int16_t seqNum = isRow ? fNextRowFECSeqNum++ : fNextColumnFECSeqNum++;
+  *p++ = 0x80|(accumulator.byte0Recovery&0x3F); // version 2; P, X, CC recovery
+  *p++ = (accumulator.byte1Recovery&0x80)|FEC_RTP_PAYLOAD_TYPE; // M recovery; PT
+  *p++ = seqNum>>8; *p++ = seqNum;
+  u_int32_t timestamp = accumulator.lastTimestamp;
+  *p++ = timestamp>>24; *p++ = timestamp>>16; *p++ = timestamp>>8; *p++ = timestamp;
+  *p++ = 0; *p++ = 0; *p++ = 0; *p++ = 0; // SSRC
+
+  // The FEC header:
+  *p++ = accumulator.snBase>>8; *p++ = accumulator.snBase;
+  *p++ = accumulator.lengthRecovery>>8; *p++ = accumulator.lengthRecovery;
+  *p++ = 0x80|(accumulator.byte1Recovery&0x7F); // E; PT recovery
+  *p++ = 0; *p++ = 0; *p++ = 0; // mask
+  u_int32_t tsRecovery = accumulator.timestampRecovery;
+  *p++ = tsRecovery>>24; *p++ = tsRecovery>>16; *p++ = tsRecovery>>8; *p++ = tsRecovery;
+  *p++ = isRow ? 0x40 : 0x00; // X=0; D (0: column; 1: row); type=0 (XOR); index=0
+  *p++ = isRow ? 1 : fNumColumns; // offset
+  *p++ = isRow ? fNumColumns : fNumRows; // NA
+  *p++ = 0; // SNBase ext bits
+
+  // The FEC payload:
+  memmove(p, accumulator.data, accumulator.dataSize);
+
+  Groupsock* gs = isRow ? fRowFECGroupsock : fColumnFECGroupsock;
+  if (gs->output(envir(), fOutBuf, fecPacketSize)) ++fNumFECPacketsSent;
+  accumulator.reset();
+}
+
+////////// PendingFECPacket //////////
+// A received FEC packet that may still be needed to recover a lost media packet.
+
+class PendingFECPacket {
+public:
+  PendingFECPacket() : data(NULL), size(0), bufferSize(0), isPending(False) {}
+  virtual ~PendingFECPacket() { delete[] data; }
+
+  u_int16_t snBase() const { return (data[12]<<8)|data[13]; }
+  u_int16_t lengthRecovery() const { return (data[14]<<8)|data[15]; }
+  u_int8_t ptRecovery() const { return data[16]&0x7F; }
+  u_int32_t timestampRecovery() const { return (data[20]<<24)|(data[21]<<16)|(data[22]<<8)|data[23]; }
+  unsigned offset() const { return data[25]; }
+  unsigned numProtected() const { return data[26]; }
+  unsigned char const* payload() const { return &data[12+FEC_HEADER_SIZE]; }
+  unsigned payloadSize() const { return size - (12+FEC_HEADER_SIZE); }
+
+public:
+  unsigned char* data;
+  unsigned size, bufferSize;
+  Boolean isPending;
+};
+
+////////// SMPTE2022FECDecoder //////////
+
+SMPTE2022FECDecoder*
+SMPTE2022FECDecoder::createNew(UsageEnvironment& env, MultiFramedRTPSource& mediaSource,
+			       Groupsock* columnFECGroupsock, Groupsock* rowFECGroupsock,
+			       unsigned maxNumMediaPacketsToKeep) {
+  return new SMPTE2022FECDecoder(env, mediaSource, columnFECGroupsock, rowFECGroupsock, maxNumMediaPacketsToKeep);
+}
+
+SMPTE2022FECDecoder
+::SMPTE2022FECDecoder(UsageEnvironment& env, MultiFramedRTPSource& mediaSource,
+		      Groupsock* columnFECGroupsock, Groupsock* rowFECGroupsock,
+		      unsigned maxNumMediaPacketsToKeep)
+  : Medium(env),
+    fMediaSource(mediaSource), fColumnFECGroupsock(columnFECGroupsock), fRowFECGroupsock(rowFECGroupsock),
+    fNextPendingFECPacketIndex(0), fNumPendingFECPackets(0), fRecoveryTask(NULL),
+    fHaveSeenMediaPacket(False), fHighestSeqNumSeen(0), fNumFECPacketsReceived(0), fNumPacketsRecovered(0) {
+  fMediaPackets = new RTPPacketHistory(maxNumMediaPacketsToKeep);
+  fPendingFECPackets = new PendingFECPacket[NUM_PENDING_FEC_PACKETS];
+  fRecoveredPacket = new unsigned char[MAX_FEC_PACKET_SIZE];
+
+  fMediaSource.setAuxilliaryReadHandler(incomingMediaPacketHandler, this);
+  if (fColumnFECGroupsock != NULL) {
+    makeSocketNonBlocking(fColumnFECGroupsock->socketNum());
+    increaseReceiveBufferTo(env, fColumnFECGroupsock->socketNum(), 50*1024);
+    envir().taskScheduler().turnOnBackgroundReadHandling(fColumnFECGroupsock->socketNum(),
+	(TaskScheduler::BackgroundHandlerProc*)&incomingColumnFECPacketHandler, this);
+  }
+  if (fRowFECGroupsock != NULL) {
+    makeSocketNonBlocking(fRowFECGroupsock->socketNum());
+    increaseReceiveBufferTo(env, fRowFECGroupsock->socketNum(), 50*1024);
+    envir().taskScheduler().turnOnBackgroundReadHandling(fRowFECGroupsock->socketNum(),
+	(TaskScheduler::BackgroundHandlerProc*)&incomingRowFECPacketHandler, this);
+  }
+}
+
+SMPTE2022FECDecoder::~SMPTE2022FECDecoder() {
+  envir().taskScheduler().unscheduleDelayedTask(fRecoveryTask);
+  if (fRowFECGroupsock != NULL) {
+    envir().taskScheduler().turnOffBackgroundReadHandling(fRowFECGroupsock->socketNum());
+  }
+  if (fColumnFECGroupsock != NULL) {
+    envir().taskScheduler().turnOffBackgroundReadHandling(fColumnFECGroupsock->socketNum());
+  }
+  fMediaSource.setAuxilliaryReadHandler(NULL, NULL);
+
+  delete[] fRecoveredPacket;
+  delete[] fPendingFECPackets;
+  delete fMediaPackets;
+}
+
+void SMPTE2022FECDecoder
+::incomingMediaPacketHandler(void* clientData, unsigned char* packet, unsigned& packetSize) {
+  SMPTE2022FECDecoder* decoder = (SMPTE2022FECDecoder*)clientData;
+  if (packetSize < 12 || (packet[1]&0x7F) != decoder->fMediaSource.rtpPayloadFormat()) return; // e.g., muxed RTCP
+
+  decoder->fMediaPackets->savePacket(packet, packetSize);
+
+  u_int16_t seqNum = (packet[2]<<8)|packet[3];
+  if (!decoder->fHaveSeenMediaPacket || seqNumLT(decoder->fHighestSeqNumSeen, seqNum)) {
+    decoder->fHighestSeqNumSeen = seqNum;
+    decoder->fHaveSeenMediaPacket = True;
+  }
+
+  // If some FEC packets are waiting for media packets to become overdue, try them again - but not right now,
+  // because we're being called from within the media source's network read handler:
+  if (decoder->fNumPendingFECPackets > 0 && decoder->fRecoveryTask == NULL) {
+    decoder->fRecoveryTask
+      = decoder->envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)tryToRecoverPackets, decoder);
+  }
+}
+
+void SMPTE2022FECDecoder::incomingColumnFECPacketHandler(SMPTE2022FECDecoder* decoder, int /*mask*/) {
+  decoder->incomingFECPacketHandler1(decoder->fColumnFECGroupsock);
+}
+
+void SMPTE2022FECDecoder::incomingRowFECPacketHandler(SMPTE2022FECDecoder* decoder, int /*mask*/) {
+  decoder->incomingFECPacketHandler1(decoder->fRowFECGroupsock);
+}
+
+void SMPTE2022FECDecoder::incomingFECPacketHandler1(Groupsock* gs) {
+  // Read the FEC packet into the next slot in our ring of pending FEC packets:
+  PendingFECPacket& fecPacket = fPendingFECPackets[fNextPendingFECPacketIndex];
+  if (fecPacket.bufferSize < MAX_FEC_PACKET_SIZE) {
+    delete[] fecPacket.data;
+    fecPacket.data = new unsigned char[MAX_FEC_PACKET_SIZE];
+    fecPacket.bufferSize = MAX_FEC_PACKET_SIZE;
+  }
+
+  struct sockaddr_in fromAddress;
+  unsigned bytesRead;
+  if (!gs->handleRead(fecPacket.data, fecPacket.bufferSize, bytesRead, fromAddress)) return;
+
+  // Check that this is a (XOR) FEC packet that we can use:
+  if (fecPacket.isPending) { // we're overwriting an old FEC packet that we never got to use
+    fecPacket.isPending = False;
+    --fNumPendingFECPackets;
+  }
+  if (bytesRead < 12 + FEC_HEADER_SIZE || (fecPacket.data[0]&0xC0) != 0x80) return;
+  fecPacket.size = bytesRead;
+  if ((fecPacket.data[24]&0x38) != 0 /*not XOR*/ || fecPacket.offset() == 0 || fecPacket.numProtected() == 0) return;
+
+  ++fNumFECPacketsReceived;
+  fecPacket.isPending = True;
+  ++fNumPendingFECPackets;
+  fNextPendingFECPacketIndex = (fNextPendingFECPacketIndex + 1)%NUM_PENDING_FEC_PACKETS;
+
+  tryToRecoverPackets();
+}
+
+void SMPTE2022FECDecoder::tryToRecoverPackets(void* clientData) {
+  SMPTE2022FECDecoder* decoder = (SMPTE2022FECDecoder*)clientData;
+  decoder->fRecoveryTask = NULL;
+  decoder->tryToRecoverPackets();
+}
+
+void SMPTE2022FECDecoder::tryToRecoverPackets() {
+  // Because each recovered packet may allow another FEC packet (e.g., one for a crossing row or column) to be used,
+  // keep trying until nothing more can be recovered:
+  Boolean recoveredSomething;
+  do {
+    recoveredSomething = False;
+    for (unsigned i = 0; i < NUM_PENDING_FEC_PACKETS; ++i) {
+      PendingFECPacket& fecPacket = fPendingFECPackets[i];
+      if (!fecPacket.isPending) continue;
+
+      Boolean fecPacketIsDone;
+      if (tryToRecoverPacket(fecPacket, fecPacketIsDone)) recoveredSomething = True;
+      if (fecPacketIsDone) {
+	fecPacket.isPending = False;
+	--fNumPendingFECPackets;
+      }
+    }
+  } while (recoveredSomething && fNumPendingFECPackets > 0);
+}
+
+Boolean SMPTE2022FECDecoder::tryToRecoverPacket(PendingFECPacket& fecPacket, Boolean& fecPacketIsDone) {
+  fecPacketIsDone = False;
+
+  // Check how many of the media packets that this FEC packet protects are missing.  (A packet that we don't have
+  // counts as missing only once we've seen a later packet; until then, it may still be on its way.)
+  u_int16_t const snBase = fecPacket.snBase();
+  unsigned const offset = fecPacket.offset(), numProtected = fecPacket.numProtected();
+  unsigned numMissing = 0;
+  u_int16_t missingSeqNum = 0;
+  for (unsigned i = 0; i < numProtected; ++i) {
+    u_int16_t seqNum = snBase + i*offset;
+    if (!fMediaPackets->hasPacket(seqNum)) {
+      if (!fHaveSeenMediaPacket || !seqNumLT(seqNum, fHighestSeqNumSeen)) return False; // not yet overdue
+      missingSeqNum = seqNum;
+      if (++numMissing > 1) return False; // we can't recover anything (yet)
+    }
+  }
+  fecPacketIsDone = True; // because either nothing is missing, or we'll now recover the one missing packet
+  if (numMissing == 0) return False;
+
+  // Recover the missing packet, by XORing the FEC packet with each of the other media packets that it protects:
+  unsigned const payloadSize = fecPacket.payloadSize();
+  unsigned char* to = &fRecoveredPacket[12];
+  memmove(to, fecPacket.payload(), payloadSize);
+  u_int8_t byte0 = fecPacket.data[0], byte1 = (fecPacket.data[1]&0x80)|fecPacket.ptRecovery();
+  u_int16_t length = fecPacket.lengthRecovery();
+  u_int32_t timestamp = fecPacket.timestampRecovery();
+  for (unsigned i = 0; i < numProtected; ++i) {
+    u_int16_t seqNum = snBase + i*offset;
+    if (seqNum == missingSeqNum) continue;
+
+    unsigned packetSize;
+    unsigned char const* packet = fMediaPackets->lookupPacket(seqNum, packetSize);
+    unsigned packetDataSize = packetSize - 12;
+    if (packetDataSize > payloadSize) return False; // inconsistent FEC packet
+    xorInto(to, &packet[12], packetDataSize);
+    byte0 ^= packet[0]; byte1 ^= packet[1];
+    length ^= packetDataSize;
+    timestamp ^= (packet[4]<<24)|(packet[5]<<16)|(packet[6]<<8)|packet[7];
+  }
+  if (length > payloadSize) return False; // inconsistent FEC packet
+
+  unsigned char* p = fRecoveredPacket;
+  *p++ = 0x80|(byte0&0x3F);
+  *p++ = byte1;
+  *p++ = missingSeqNum>>8; *p++ = missingSeqNum;
+  *p++ = timestamp>>24; *p++ = timestamp>>16; *p++ = timestamp>>8; *p++ = timestamp;
+  u_int32_t SSRC = fMediaSource.lastReceivedSSRC();
+  *p++ = SSRC>>24; *p++ = SSRC>>16; *p++ = SSRC>>8; *p++ = SSRC;
+  unsigned const recoveredPacketSize = 12 + length;
+#ifdef DEBUG
+  fprintf(stderr, "SMPTE2022FECDecoder[%p]: recovered packet with seq num %u (%u bytes)\n", this, missingSeqNum, recoveredPacketSize);
+#endif
+
+  ++fNumPacketsRecovered;
+  fMediaPackets->savePacket(fRecoveredPacket, recoveredPacketSize);
+  fMediaSource.injectPacket(fRecoveredPacket, recoveredPacketSize);
+  return True;
+}
@@ -0,0 +1,175 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A per-environment allocator of the (UDP) port numbers used by servers' RTP and RTCP 'groupsocks'.
+// Implementation
+
+#include "ServerPortAllocator.hh"
+
+#define NUM_PORT_NUMS 65536
+#define BITMAP_SIZE (NUM_PORT_NUMS/32) // in 32-bit words
+
+#define isBitSet(bitmap, portNum) (((bitmap)[(portNum)>>5]&(1U<<((portNum)&31))) != 0)
+
+ServerPortAllocator* ServerPortAllocator::ourAllocator(UsageEnvironment& env, Boolean createIfNotPresent) {
+  _Tables* ourTables = _Tables::getOurTables(env, createIfNotPresent);
+  if (ourTables == NULL) return NULL;
+
+  if (ourTables->serverPortAllocator == NULL && createIfNotPresent) {
+    ourTables->serverPortAllocator = new ServerPortAllocator(env);
+  }
+  return (ServerPortAllocator*)(ourTables->serverPortAllocator);
+}
+
+ServerPortAllocator::ServerPortAllocator(UsageEnvironment& env)
+  : fEnv(env), fMinPortNum(0), fMaxPortNum(NUM_PORT_NUMS-1),
+    fNumInUse(0), fNumUnavailable(0), fLowestPossiblyFreePortNum(0) {
+  fInUse = new u_int32_t[BITMAP_SIZE];
+  fUnavailable = new u_int32_t[BITMAP_SIZE];
+  for (unsigned i = 0; i < BITMAP_SIZE; ++i) fInUse[i] = fUnavailable[i] = 0;
+}
+
+ServerPortAllocator::~ServerPortAllocator() {
+  delete[] fInUse;
+  delete[] fUnavailable;
+}
+
+void ServerPortAllocator::reclaimIfPossible() {
+  // We can delete ourself if we have no state worth remembering:
+  if (fNumInUse > 0 || fNumUnavailable > 0 || fMinPortNum != 0 || fMaxPortNum != NUM_PORT_NUMS-1) return;
+
+  _Tables* ourTables = _Tables::getOurTables(fEnv, False);
+  if (ourTables != NULL) {
+    ourTables->serverPortAllocator = NULL;
+    ourTables->reclaimIfPossible();
+  }
+  delete this;
+}
+
+void ServerPortAllocator
+::setPortRange(UsageEnvironment& env, portNumBits minPortNum, portNumBits maxPortNum) {
+  if (minPortNum > maxPortNum) return; // sanity check
+
+  ServerPortAllocator* allocator = ourAllocator(env);
+  allocator->fMinPortNum = minPortNum;
+  allocator->fMaxPortNum = maxPortNum;
+  allocator->reclaimIfPossible(); // in case we've just been reset to the default range
+}
+
+Boolean ServerPortAllocator::allocate(UsageEnvironment& env, portNumBits initialPortNum, unsigned numPorts,
+				      Boolean rtpPortIsEven, portNumBits& resultPortNum) {
+  if (numPorts < 1 || numPorts > 2) return False; // sanity check
+  ServerPortAllocator* allocator = ourAllocator(env);
+
+  unsigned portNum;
+  if (!allocator->findFreePorts(initialPortNum, numPorts, rtpPortIsEven, portNum)) {
+    // There are no free ports.  If this is because of ports that we've been unable to bind to in the past,
+    // then forget about those (they might be usable now), and try again:
+    if (allocator->fNumUnavailable == 0) {
+      allocator->reclaimIfPossible();
+      return False;
+    }
+    allocator->forgetUnavailablePorts();
+    if (!allocator->findFreePorts(initialPortNum, numPorts, rtpPortIsEven, portNum)) {
+      allocator->reclaimIfPossible();
+      return False;
+    }
+  }
+
+  for (unsigned i = 0; i < numPorts; ++i) allocator->setBit(allocator->fInUse, portNum+i);
+  allocator->fNumInUse += numPorts;
+  resultPortNum = (portNumBits)portNum;
+  return True;
+}
+
+void ServerPortAllocator::markUnavailable(UsageEnvironment& env, portNumBits portNum) {
+  ServerPortAllocator* allocator = ourAllocator(env, False);
+  if (allocator == NULL || !isBitSet(allocator->fInUse, portNum)) return;
+
+  allocator->clearBit(allocator->fInUse, portNum);
+  --allocator->fNumInUse;
+  if (!isBitSet(allocator->fUnavailable, portNum)) {
+    allocator->setBit(allocator->fUnavailable, portNum);
+    ++allocator->fNumUnavailable;
+  }
+}
+
+void ServerPortAllocator::release(UsageEnvironment& env, portNumBits portNum) {
+  ServerPortAllocator* allocator = ourAllocator(env, False);
+  if (allocator == NULL || !isBitSet(allocator->fInUse, portNum)) return;
+
+  allocator->clearBit(allocator->fInUse, portNum);
+  if (portNum < allocator->fLowestPossiblyFreePortNum) allocator->fLowestPossiblyFreePortNum = portNum;
+  if (--allocator->fNumInUse == 0) {
+    // None of our streams are using ports now, so don't bother remembering those that we couldn't bind to:
+    allocator->forgetUnavailablePorts();
+    allocator->reclaimIfPossible();
+  }
+}
+
+void ServerPortAllocator::forgetUnavailablePorts() {
+  for (unsigned i = 0; i < BITMAP_SIZE; ++i) fUnavailable[i] = 0;
+  fNumUnavailable = 0;
+  fLowestPossiblyFreePortNum = 0;
+}
+
+Boolean ServerPortAllocator::isFree(unsigned portNum) const {
+  return !isBitSet(fInUse, portNum) && !isBitSet(fUnavailable, portNum);
+}
+
+Boolean ServerPortAllocator::findFreePorts(unsigned initialPortNum, unsigned numPorts, Boolean rtpPortIsEven,
+					   unsigned& resultPortNum) const {
+  unsigned portNum = initialPortNum;
+  if (portNum < fMinPortNum) portNum = fMinPortNum;
+  if (portNum < fLowestPossiblyFreePortNum) portNum = fLowestPossiblyFreePortNum;
+  unsigned const step = rtpPortIsEven ? 2 : 1;
+  if (rtpPortIsEven) portNum = (portNum+1)&~1;
+
+  while (portNum + numPorts-1 <= fMaxPortNum) {
+    unsigned wordIndex = portNum>>5;
+    if ((portNum&31) == 0 && (fInUse[wordIndex]|fUnavailable[wordIndex]) == 0xFFFFFFFF) {
+      // Skip over this entire word of ports, because none of them are free:
+      portNum += 32;
+      continue;
+    }
+
+    Boolean allFree = True;
+    for (unsigned i = 0; i < numPorts; ++i) {
+      if (!isFree(portNum+i)) { allFree = False; break; }
+    }
+    if (allFree) {
+      resultPortNum = portNum;
+      return True;
+    }
+    portNum += step;
+  }
+
+  return False;
+}
+
+void ServerPortAllocator::setBit(u_int32_t* bitmap, unsigned portNum) {
+  bitmap[portNum>>5] |= 1U<<(portNum&31);
+
+  // Keep "fLowestPossiblyFreePortNum" up-to-date:
+  while (fLowestPossiblyFreePortNum < NUM_PORT_NUMS && !isFree(fLowestPossiblyFreePortNum)) {
+    ++fLowestPossiblyFreePortNum;
+  }
+}
+
+void ServerPortAllocator::clearBit(u_int32_t* bitmap, unsigned portNum) {
+  bitmap[portNum>>5] &=~ (1U<<(portNum&31));
+}
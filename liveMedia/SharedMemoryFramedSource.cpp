@@ -0,0 +1,218 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A "FramedSource" that delivers frames (e.g., H.264 NAL units, or audio frames) that another process
+// - such as an encoder - writes into a shared memory ring buffer ("SharedMemoryRing")
+// Implementation
+
+#include "SharedMemoryFramedSource.hh"
+#include <GroupsockHelper.hh>
+#if defined(__linux__)
+#include <sys/un.h>
+#include <sys/stat.h>
+#define HAVE_SHARED_MEMORY_RING 1
+#endif
+
+SharedMemoryFramedSource*
+SharedMemoryFramedSource::createNew(UsageEnvironment& env, char const* ringFileName, unsigned ringDataSize) {
+#ifdef HAVE_SHARED_MEMORY_RING
+  char* socketPath = new char[strlen(ringFileName) + 5 + 1];
+  sprintf(socketPath, "%s.sock", ringFileName);
+
+  int listenSocket = -1;
+  SharedMemoryRing* ring = NULL;
+  do {
+    // Create the UNIX-domain socket from which producers will fetch our "eventfd" descriptor:
+    struct sockaddr_un addr;
+    if (strlen(socketPath) >= sizeof addr.sun_path || strlen(socketPath) >= SHARED_MEMORY_RING_SOCKET_PATH_SIZE) {
+      env.setResultMsg("Shared memory ring file name \"", ringFileName, "\" is too long");
+      break;
+    }
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socketPath);
+
+    ring = SharedMemoryRing::createNew(ringFileName, ringDataSize, socketPath);
+    struct stat ringFileStatus;
+    if (ring == NULL || stat(ringFileName, &ringFileStatus) < 0) {
+      env.setResultErrMsg("unable to create shared memory ring: ");
+      break;
+    }
+
+    listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenSocket < 0) {
+      env.setResultErrMsg("unable to create UNIX-domain socket: ");
+      break;
+    }
+    unlink(socketPath); // in case it was left over from an earlier run
+    if (bind(listenSocket, (struct sockaddr*)&addr, sizeof addr) < 0) {
+      env.setResultErrMsg("unable to bind UNIX-domain socket: ");
+      break;
+    }
+    // Anyone who can connect to the socket gets our "eventfd" descriptor, so give the socket the same permissions
+    // as the ring file (rather than those from our umask).  Do this before we listen, so that no one can connect before:
+    if (chmod(socketPath, ringFileStatus.st_mode&0777) < 0 || listen(listenSocket, 4) < 0) {
+      env.setResultErrMsg("unable to set the permissions of, or listen on, UNIX-domain socket: ");
+      unlink(socketPath);
+      break;
+    }
+    makeSocketNonBlocking(listenSocket);
+
+    SharedMemoryFramedSource* source
+      = new SharedMemoryFramedSource(env, ring, ringFileName, socketPath, listenSocket);
+    delete[] socketPath;
+    return source;
+  } while (0);
+
+  // An error occurred:
+  if (listenSocket >= 0) ::closeSocket(listenSocket);
+  if (ring != NULL) {
+    delete ring;
+    unlink(ringFileName);
+  }
+  delete[] socketPath;
+  return NULL;
+#else
+  env.setResultMsg("\"SharedMemoryFramedSource\" is not supported on this platform");
+  return NULL;
+#endif
+}
+
+SharedMemoryFramedSource
+::SharedMemoryFramedSource(UsageEnvironment& env, SharedMemoryRing* ring,
+			   char const* ringFileName, char const* socketPath, int listenSocket)
+  : FramedSource(env),
+    fRing(ring), fRingFileName(strDup(ringFileName)), fSocketPath(strDup(socketPath)), fListenSocket(listenSocket) {
+  envir().taskScheduler().setBackgroundHandling(fListenSocket, SOCKET_READABLE,
+						incomingConnectionHandler, this);
+  envir().taskScheduler().setBackgroundHandling(fRing->eventFd(), SOCKET_READABLE, eventFdHandler, this);
+}
+
+SharedMemoryFramedSource::~SharedMemoryFramedSource() {
+  envir().taskScheduler().disableBackgroundHandling(fRing->eventFd());
+  envir().taskScheduler().disableBackgroundHandling(fListenSocket);
+  ::closeSocket(fListenSocket);
+
+#ifdef HAVE_SHARED_MEMORY_RING
+  // Remove the ring's file and socket names.  (Any producer that's still attached keeps its mapping, but
+  // can no longer wake us up.)
+  unlink(fSocketPath);
+  unlink(fRingFileName);
+#endif
+  delete fRing;
+  delete[] fSocketPath;
+  delete[] fRingFileName;
+}
+
+void SharedMemoryFramedSource::doGetNextFrame() {
+  if (deliverFrame() || (!fRing->prepareToWait() && deliverFrame())) {
+    // We delivered the frame synchronously, so complete delivery via the event loop, to avoid the possibility
+    // of infinite recursion (if the downstream object asks for the next frame from within its 'after getting' function):
+    nextTask() = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)FramedSource::afterGetting, this);
+  }
+  // Otherwise, "eventFdHandler()" will be called when the producer writes the next frame.
+}
+
+void SharedMemoryFramedSource::doStopGettingFrames() {
+  envir().taskScheduler().unscheduleDelayedTask(nextTask());
+  fRing->doneWaiting();
+}
+
+Boolean SharedMemoryFramedSource::deliverFrame() {
+  unsigned frameSize;
+  SharedMemoryRingFrameHeader const* frameHeader = fRing->nextFrame(frameSize);
+  if (frameHeader == NULL) return False;
+
+  // Copy the frame - our only copy of it - directly into the downstream object's buffer.  (We use the validated
+  // "frameSize", not the header's "frameSize" field, which the producer could have changed since.)
+  fFrameSize = frameSize;
+  if (fFrameSize > fMaxSize) {
+    fNumTruncatedBytes = fFrameSize - fMaxSize;
+    fFrameSize = fMaxSize;
+  } else {
+    fNumTruncatedBytes = 0;
+  }
+  memmove(fTo, &frameHeader[1], fFrameSize);
+
+  if (frameHeader->presentationTimeSec == 0 && frameHeader->presentationTimeUSec == 0) {
+    gettimeofday(&fPresentationTime, NULL); // the producer didn't give us a presentation time
+  } else {
+    fPresentationTime.tv_sec = frameHeader->presentationTimeSec;
+    fPresentationTime.tv_usec = frameHeader->presentationTimeUSec;
+  }
+  fDurationInMicroseconds = frameHeader->durationInMicroseconds;
+
+  fRing->releaseFrame();
+  return True;
+}
+
+void SharedMemoryFramedSource::eventFdHandler(void* clientData, int /*mask*/) {
+  ((SharedMemoryFramedSource*)clientData)->eventFdHandler1();
+}
+
+void SharedMemoryFramedSource::eventFdHandler1() {
+#ifdef HAVE_SHARED_MEMORY_RING
+  u_int64_t counter;
+  if (read(fRing->eventFd(), &counter, sizeof counter) < 0) {} // resets the counter
+#endif
+  if (!isCurrentlyAwaitingData()) return; // we're not ready for the frame yet; it'll stay in the ring until we are
+
+  fRing->doneWaiting();
+  if (deliverFrame()) {
+    // Because we were called from the event loop, we can call the 'after getting' function directly:
+    FramedSource::afterGetting(this);
+  } else if (!fRing->prepareToWait() && deliverFrame()) {
+    FramedSource::afterGetting(this);
+  }
+}
+
+void SharedMemoryFramedSource::incomingConnectionHandler(void* clientData, int /*mask*/) {
+  ((SharedMemoryFramedSource*)clientData)->incomingConnectionHandler1();
+}
+
+void SharedMemoryFramedSource::incomingConnectionHandler1() {
+#ifdef HAVE_SHARED_MEMORY_RING
+  // A producer has connected.  Send it our "eventfd" descriptor (as ancillary data), then close the connection:
+  int sock = accept(fListenSocket, NULL, NULL);
+  if (sock < 0) return;
+
+  char dummy = 0;
+  struct iovec iov;
+  iov.iov_base = &dummy;
+  iov.iov_len = 1;
+  union { struct cmsghdr align; char buf[CMSG_SPACE(sizeof (int))]; } control;
+  memset(&control, 0, sizeof control);
+  struct msghdr msg;
+  memset(&msg, 0, sizeof msg);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof control.buf;
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof (int));
+  int eventFd = fRing->eventFd();
+  memcpy(CMSG_DATA(cmsg), &eventFd, sizeof eventFd);
+
+  if (sendmsg(sock, &msg, 0) < 0) {
+    envir() << "SharedMemoryFramedSource: failed to send our eventfd to a producer (errno " << envir().getErrno() << ")\n";
+  }
+  ::closeSocket(sock);
+#endif
+}
@@ -0,0 +1,326 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A single-producer, single-consumer ring buffer of frames, in a shared memory file, used to pass
+// frames (e.g., H.264 NAL units, or audio frames) from an encoder process to a "SharedMemoryFramedSource".
+// Implementation
+
+#include "SharedMemoryRing.hh"
+#include <string.h>
+#include <errno.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include <fcntl.h>
+#define HAVE_SHARED_MEMORY_RING 1
+#endif
+
+#ifdef HAVE_SHARED_MEMORY_RING
+// The producer and the consumer are in different processes (and perhaps on different CPUs), so each
+// access to a ring position must be ordered with respect to the frame data that it describes:
+#define LOAD_ACQUIRE(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#define FULL_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#define FRAME_HEADER_SIZE ((u_int32_t)sizeof (SharedMemoryRingFrameHeader))
+static u_int32_t paddedFrameSize(u_int32_t frameSize) { return FRAME_HEADER_SIZE + ((frameSize + 7)&~7); }
+
+static int receiveEventFd(char const* socketPath); // forward
+#endif
+
+SharedMemoryRing* SharedMemoryRing::createNew(char const* fileName, unsigned dataSize, char const* socketPath) {
+#ifdef HAVE_SHARED_MEMORY_RING
+  if (socketPath == NULL || strlen(socketPath) >= SHARED_MEMORY_RING_SOCKET_PATH_SIZE) {
+    errno = ENAMETOOLONG;
+    return NULL;
+  }
+  unsigned roundedDataSize = 4096;
+  while (roundedDataSize < dataSize && roundedDataSize < 0x40000000) roundedDataSize <<= 1;
+  unsigned const headerSize = sizeof (SharedMemoryRingHeader);
+
+  // Create a new file (rather than reusing any existing one, which might still be mapped by an old producer):
+  unlink(fileName);
+  int fd = open(fileName, O_RDWR|O_CREAT|O_EXCL, 0660);
+  if (fd < 0) return NULL;
+  if (ftruncate(fd, headerSize + roundedDataSize) < 0) {
+    close(fd);
+    return NULL;
+  }
+  void* mapping = mmap(NULL, headerSize + roundedDataSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) return NULL;
+
+  int eventFd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+  if (eventFd < 0) {
+    munmap(mapping, headerSize + roundedDataSize);
+    return NULL;
+  }
+
+  SharedMemoryRingHeader* header = (SharedMemoryRingHeader*)mapping;
+  header->version = SHARED_MEMORY_RING_VERSION;
+  header->headerSize = headerSize;
+  header->dataSize = roundedDataSize;
+  strcpy(header->socketPath, socketPath);
+  STORE_RELEASE(&header->magic, (u_int32_t)SHARED_MEMORY_RING_MAGIC); // last, so a producer never sees a partial header
+
+  return new SharedMemoryRing(header, eventFd);
+#else
+  errno = ENOSYS;
+  return NULL;
+#endif
+}
+
+SharedMemoryRing* SharedMemoryRing::openExisting(char const* fileName) {
+#ifdef HAVE_SHARED_MEMORY_RING
+  int fd = open(fileName, O_RDWR);
+  if (fd < 0) return NULL;
+  struct stat sb;
+  if (fstat(fd, &sb) < 0 || (u_int64_t)sb.st_size < sizeof (SharedMemoryRingHeader)) {
+    close(fd);
+    errno = EINVAL;
+    return NULL;
+  }
+  void* mapping = mmap(NULL, sb.st_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) return NULL;
+
+  // Check that the file really is a ring that we understand:
+  SharedMemoryRingHeader* header = (SharedMemoryRingHeader*)mapping;
+  if (LOAD_ACQUIRE(&header->magic) != SHARED_MEMORY_RING_MAGIC || header->version != SHARED_MEMORY_RING_VERSION
+      || header->headerSize != sizeof (SharedMemoryRingHeader) || header->dataSize < 4096
+      || (header->dataSize&(header->dataSize-1)) != 0
+      || (u_int64_t)sb.st_size != (u_int64_t)header->headerSize + header->dataSize) {
+    munmap(mapping, sb.st_size);
+    errno = EINVAL;
+    return NULL;
+  }
+
+  char socketPath[SHARED_MEMORY_RING_SOCKET_PATH_SIZE];
+  memcpy(socketPath, header->socketPath, sizeof socketPath);
+  socketPath[sizeof socketPath - 1] = '\0';
+  int eventFd = receiveEventFd(socketPath);
+  if (eventFd < 0) {
+    int savedErrno = errno;
+    munmap(mapping, sb.st_size);
+    errno = savedErrno;
+    return NULL;
+  }
+
+  return new SharedMemoryRing(header, eventFd);
+#else
+  errno = ENOSYS;
+  return NULL;
+#endif
+}
+
+SharedMemoryRing::SharedMemoryRing(SharedMemoryRingHeader* header, int eventFd)
+  : fHeader(header), fData((u_int8_t*)header + header->headerSize), fEventFd(eventFd),
+    fReservedPos(0), fReservedSize(0), fNextReadPos(0) {
+}
+
+SharedMemoryRing::~SharedMemoryRing() {
+#ifdef HAVE_SHARED_MEMORY_RING
+  close(fEventFd);
+  munmap(fHeader, fHeader->headerSize + fHeader->dataSize);
+#endif
+}
+
+u_int8_t* SharedMemoryRing::reserveFrame(unsigned maxFrameSize) {
+#ifdef HAVE_SHARED_MEMORY_RING
+  u_int32_t const dataSize = fHeader->dataSize;
+  u_int32_t needed = paddedFrameSize(maxFrameSize);
+  if (maxFrameSize >= dataSize || needed > dataSize) {
+    ++fHeader->numFramesDropped;
+    return NULL;
+  }
+
+  u_int32_t writePos = fHeader->writePos; // only we change this
+  u_int32_t readPos = LOAD_ACQUIRE(&fHeader->readPos);
+  u_int32_t offset = writePos&(dataSize-1);
+  u_int32_t spaceAtEnd = dataSize - offset;
+  u_int32_t numBytesToSkip = needed > spaceAtEnd ? spaceAtEnd : 0; // because frames don't wrap around
+  if ((writePos - readPos) + numBytesToSkip + needed > dataSize) {
+    // The consumer hasn't kept up:
+    ++fHeader->numFramesDropped;
+    return NULL;
+  }
+
+  if (numBytesToSkip > 0) {
+    // Tell the consumer to skip to the start of the data area.  (If there's no room even for a frame header,
+    // the consumer will know to skip anyway.)
+    if (spaceAtEnd >= FRAME_HEADER_SIZE) {
+      ((SharedMemoryRingFrameHeader*)&fData[offset])->frameSize = SHARED_MEMORY_RING_WRAP;
+    }
+    offset = 0;
+  }
+  fReservedPos = writePos + numBytesToSkip;
+  fReservedSize = maxFrameSize;
+
+  return &fData[offset + FRAME_HEADER_SIZE];
+#else
+  return NULL;
+#endif
+}
+
+void SharedMemoryRing::commitFrame(unsigned frameSize, struct timeval const& presentationTime,
+				   unsigned durationInMicroseconds) {
+#ifdef HAVE_SHARED_MEMORY_RING
+  if (frameSize > fReservedSize) frameSize = fReservedSize; // sanity check
+  fReservedSize = 0;
+
+  SharedMemoryRingFrameHeader* frameHeader
+    = (SharedMemoryRingFrameHeader*)&fData[fReservedPos&(fHeader->dataSize-1)];
+  frameHeader->frameSize = frameSize;
+  frameHeader->durationInMicroseconds = durationInMicroseconds;
+  frameHeader->presentationTimeSec = presentationTime.tv_sec;
+  frameHeader->presentationTimeUSec = presentationTime.tv_usec;
+
+  // Publish the frame (and any 'wrap' header in front of it).  Then, if the consumer is waiting for it, wake it up.
+  // (The full barrier - paired with the one in "prepareToWait()" - ensures that either we see "consumerIsWaiting",
+  // or the consumer sees our new "writePos"; otherwise, the consumer could end up waiting forever.)
+  STORE_RELEASE(&fHeader->writePos, fReservedPos + paddedFrameSize(frameSize));
+  FULL_BARRIER();
+  if (__atomic_load_n(&fHeader->consumerIsWaiting, __ATOMIC_RELAXED)) {
+    u_int64_t one = 1;
+    if (write(fEventFd, &one, sizeof one) < 0) {} // the consumer will be woken up anyway, if the counter is full
+  }
+#endif
+}
+
+Boolean SharedMemoryRing::writeFrame(u_int8_t const* frame, unsigned frameSize,
+				     struct timeval const& presentationTime, unsigned durationInMicroseconds) {
+  u_int8_t* to = reserveFrame(frameSize);
+  if (to == NULL) return False;
+
+  memmove(to, frame, frameSize);
+  commitFrame(frameSize, presentationTime, durationInMicroseconds);
+  return True;
+}
+
+SharedMemoryRingFrameHeader const* SharedMemoryRing::nextFrame(unsigned& frameSize) {
+  frameSize = 0;
+#ifdef HAVE_SHARED_MEMORY_RING
+  u_int32_t const dataSize = fHeader->dataSize;
+  u_int32_t writePos = LOAD_ACQUIRE(&fHeader->writePos);
+  u_int32_t readPos = fHeader->readPos; // only we change this
+
+  while (readPos != writePos) {
+    u_int32_t offset = readPos&(dataSize-1);
+    u_int32_t spaceAtEnd = dataSize - offset;
+    SharedMemoryRingFrameHeader const* frameHeader = (SharedMemoryRingFrameHeader const*)&fData[offset];
+    if (spaceAtEnd < FRAME_HEADER_SIZE) {
+      // The next frame is at the start of the data area:
+      readPos += spaceAtEnd;
+      continue;
+    }
+
+    // Read the frame's size exactly once (because the producer can still write to it):
+    u_int32_t const thisFrameSize = __atomic_load_n(&frameHeader->frameSize, __ATOMIC_RELAXED);
+    if (thisFrameSize == SHARED_MEMORY_RING_WRAP) {
+      // The next frame is at the start of the data area:
+      readPos += spaceAtEnd;
+      continue;
+    }
+    if (thisFrameSize >= dataSize || paddedFrameSize(thisFrameSize) > spaceAtEnd
+	|| paddedFrameSize(thisFrameSize) > writePos - readPos) {
+      // The producer is buggy (or malicious).  Discard everything that it has written:
+      STORE_RELEASE(&fHeader->readPos, writePos);
+      return NULL;
+    }
+
+    if (readPos != fHeader->readPos) STORE_RELEASE(&fHeader->readPos, readPos); // we skipped to the start
+    fNextReadPos = readPos + paddedFrameSize(thisFrameSize);
+    frameSize = thisFrameSize; // this fits within the data area (after the frame header)
+    return frameHeader;
+  }
+
+  return NULL;
+#else
+  return NULL;
+#endif
+}
+
+void SharedMemoryRing::releaseFrame() {
+#ifdef HAVE_SHARED_MEMORY_RING
+  STORE_RELEASE(&fHeader->readPos, fNextReadPos);
+#endif
+}
+
+Boolean SharedMemoryRing::prepareToWait() {
+#ifdef HAVE_SHARED_MEMORY_RING
+  __atomic_store_n(&fHeader->consumerIsWaiting, 1, __ATOMIC_RELAXED);
+  FULL_BARRIER();
+  if (LOAD_ACQUIRE(&fHeader->writePos) != fHeader->readPos) {
+    // A frame arrived before the producer could have seen our flag:
+    doneWaiting();
+    return False;
+  }
+  return True;
+#else
+  return False;
+#endif
+}
+
+void SharedMemoryRing::doneWaiting() {
+#ifdef HAVE_SHARED_MEMORY_RING
+  __atomic_store_n(&fHeader->consumerIsWaiting, 0, __ATOMIC_RELAXED);
+#endif
+}
+
+#ifdef HAVE_SHARED_MEMORY_RING
+static int receiveEventFd(char const* socketPath) {
+  // Connect to the consumer's UNIX-domain socket, and receive (as ancillary data) its "eventfd" descriptor:
+  int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock < 0) return -1;
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof addr);
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, socketPath, sizeof addr.sun_path - 1);
+  if (connect(sock, (struct sockaddr*)&addr, sizeof addr) < 0) {
+    int savedErrno = errno;
+    close(sock);
+    errno = savedErrno;
+    return -1;
+  }
+
+  char dummy;
+  struct iovec iov;
+  iov.iov_base = &dummy;
+  iov.iov_len = 1;
+  union { struct cmsghdr align; char buf[CMSG_SPACE(sizeof (int))]; } control;
+  struct msghdr msg;
+  memset(&msg, 0, sizeof msg);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof control.buf;
+
+  int eventFd = -1;
+  if (recvmsg(sock, &msg, 0) > 0) {
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      memcpy(&eventFd, CMSG_DATA(cmsg), sizeof eventFd);
+    }
+  }
+  close(sock);
+  if (eventFd < 0) errno = EPROTO;
+  return eventFd;
+}
+#endif
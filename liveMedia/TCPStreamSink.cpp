@@ -20,6 +20,10 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "TCPStreamSink.hh"
 #include <GroupsockHelper.hh> // for "ignoreSigPipeOnSocket()"
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#define HAVE_SENDFILE 1
+#endif
 
 TCPStreamSink* TCPStreamSink::createNew(UsageEnvironment& env, int socketNum) {
   return new TCPStreamSink(env, socketNum);
@@ -29,7 +33,9 @@ TCPStreamSink::TCPStreamSink(UsageEnvironment& env, int socketNum)
   : MediaSink(env),
     fUnwrittenBytesStart(0), fUnwrittenBytesEnd(0),
     fInputSourceIsOpen(False), fOutputSocketIsWritable(True),
-    fOutputSocketNum(socketNum) {
+    fOutputSocketNum(socketNum),
+    fSendingFromFile(False), fFileDescriptor(-1), fFileOffset(0), fNumFileBytesRemaining(0),
+    fNumFileBytesSent(0), fNumSourceBytesToSkip(0) {
   ignoreSigPipeOnSocket(socketNum);
 }
 
@@ -38,7 +44,34 @@ TCPStreamSink::~TCPStreamSink() {
   envir().taskScheduler().disableBackgroundHandling(fOutputSocketNum);
 }
 
+Boolean TCPStreamSink::sendFromFileDirectly(int fileDescriptor, u_int64_t offset, u_int64_t numBytes) {
+#ifdef HAVE_SENDFILE
+  fSendingFromFile = True;
+  fFileDescriptor = fileDescriptor;
+  fFileOffset = offset;
+  fNumFileBytesRemaining = numBytes;
+  fNumFileBytesSent = 0;
+  return True;
+#else
+  return False;
+#endif
+}
+
+void TCPStreamSink::stopPlaying() {
+  if (fSendingFromFile) {
+    fSendingFromFile = False;
+    envir().taskScheduler().disableBackgroundHandling(fOutputSocketNum);
+  }
+
+  MediaSink::stopPlaying();
+}
+
 Boolean TCPStreamSink::continuePlaying() {
+  if (fSendingFromFile) {
+    sendFromFile();
+    return True;
+  }
+
   fInputSourceIsOpen = fSource != NULL;
   processBuffer();
 
@@ -78,6 +111,52 @@ void TCPStreamSink::processBuffer() {
   }
 }
 
+#define TCP_STREAM_SINK_MAX_SENDFILE_SIZE (1024*1024)
+
+void TCPStreamSink::sendFromFile() {
+#ifdef HAVE_SENDFILE
+  // Send as much as the socket will take now (but no more than a maximum, so as not to hog the event loop):
+  size_t numBytesToSend = fNumFileBytesRemaining < TCP_STREAM_SINK_MAX_SENDFILE_SIZE
+    ? (size_t)fNumFileBytesRemaining : TCP_STREAM_SINK_MAX_SENDFILE_SIZE;
+  off_t offset = (off_t)fFileOffset;
+  ssize_t numBytesSent = sendfile(fOutputSocketNum, fFileDescriptor, &offset, numBytesToSend);
+  if (numBytesSent > 0) {
+    fFileOffset += numBytesSent;
+    fNumFileBytesRemaining -= numBytesSent;
+    fNumFileBytesSent += numBytesSent;
+  } else if (numBytesSent == 0) {
+    // We've reached the end of the file, so we're done:
+    fNumFileBytesRemaining = 0;
+  } else {
+    int const err = envir().getErrno();
+    if (err == EPIPE || err == ECONNRESET || err == ENOTCONN) {
+      // The socket is no longer usable, so we're done:
+      fNumFileBytesRemaining = 0;
+    } else if (err != EAGAIN && err != EWOULDBLOCK && err != EINTR) {
+      // "sendfile()" doesn't work for this file and socket (e.g., "EINVAL" or "ENOSYS").  Because we've already told
+      // the client how much data to expect, we don't stop; instead, we send the rest of the data by reading it from our
+      // source (which has not yet read any of it), after skipping over the data that we've already sent:
+      fSendingFromFile = False;
+      fNumSourceBytesToSkip = fNumFileBytesSent;
+      fInputSourceIsOpen = fSource != NULL;
+      processBuffer();
+      return;
+    }
+  }
+#else
+  fNumFileBytesRemaining = 0; // shouldn't happen
+#endif
+
+  if (fNumFileBytesRemaining > 0) {
+    // Send more when the socket is next writable:
+    envir().taskScheduler().setBackgroundHandling(fOutputSocketNum, SOCKET_WRITABLE, socketWritableHandler, this);
+  } else {
+    // We're now done:
+    fSendingFromFile = False;
+    onSourceClosure(); // Note: This might cause us to be deleted
+  }
+}
+
 void TCPStreamSink::socketWritableHandler(void* clientData, int /*mask*/) {
   TCPStreamSink* sink = (TCPStreamSink*)clientData;
   sink->socketWritableHandler1();
@@ -86,6 +165,11 @@ void TCPStreamSink::socketWritableHandler(void* clientData, int /*mask*/) {
 void TCPStreamSink::socketWritableHandler1() {
   envir().taskScheduler().disableBackgroundHandling(fOutputSocketNum); // disable this handler until the next time it's needed
 
+  if (fSendingFromFile) {
+    sendFromFile();
+    return;
+  }
+
   fOutputSocketIsWritable = True;
   processBuffer();
 }
@@ -102,6 +186,13 @@ void TCPStreamSink::afterGettingFrame(unsigned frameSize, unsigned numTruncatedB
 	    << numTruncatedBytes
 	    << " bytes of trailing data was dropped!  Correct this by increasing the definition of \"TCP_STREAM_SINK_BUFFER_SIZE\" in \"include/TCPStreamSink.hh\".\n";
   }
+  if (fNumSourceBytesToSkip > 0) {
+    // This data (or some of it) has already been sent by "sendfile()", so discard it:
+    unsigned numBytesToSkip = fNumSourceBytesToSkip < frameSize ? (unsigned)fNumSourceBytesToSkip : frameSize;
+    memmove(&fBuffer[fUnwrittenBytesEnd], &fBuffer[fUnwrittenBytesEnd + numBytesToSkip], frameSize - numBytesToSkip);
+    frameSize -= numBytesToSkip;
+    fNumSourceBytesToSkip -= numBytesToSkip;
+  }
   fUnwrittenBytesEnd += frameSize;
   processBuffer();
 }
@@ -0,0 +1,76 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A per-environment interface for reading from files without blocking the event loop
+// C++ header
+
+#ifndef _ASYNC_FILE_READER_HH
+#define _ASYNC_FILE_READER_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+
+// Regular files are always 'readable' to "select()", so the event loop can't wait for their data the way
+// it waits for sockets; a read that must fetch data from (possibly remote) storage would stall every stream.
+// Instead, "FramedFileSource"s read seekable files through their environment's "AsyncFileReader", which
+// calls a completion function - later, from the event loop - when each read has been done.
+//
+// By default, each environment uses a reader that needs no threads: it reads whatever data is already
+// cached by the OS, and otherwise asks the OS to fetch the data in the background, and tries again later.
+// (It reads synchronously - i.e., blocks - only if the data still hasn't arrived after "maxWaitTime".)
+// Applications may instead plug in their own reader (e.g., one that uses "io_uring", or a pool of threads
+// that signal the event loop using "TaskScheduler::triggerEvent()").
+
+class AsyncFileReader {
+public:
+  static AsyncFileReader& forEnvironment(UsageEnvironment& env);
+      // Returns the reader that's used by "env" (creating the default reader if necessary)
+  static void setForEnvironment(UsageEnvironment& env, AsyncFileReader* reader);
+      // Makes "env" use "reader" for subsequent reads.  "reader" remains owned by the caller, and must
+      // outlive its use; call "setForEnvironment(env, NULL)" (to return to the default reader) before deleting it.
+
+  typedef void (completionFunc)(void* clientData, int result);
+      // "result" is the number of bytes read (0 at end-of-file), or -1 on error
+
+  virtual void read(int fileDescriptor, u_int64_t offset, u_int8_t* to, unsigned size,
+		    completionFunc* completionFunc, void* clientData) = 0;
+      // Reads up to "size" bytes of the file, starting at "offset" (the file position is not used).
+      // "completionFunc" is always called from the event loop - never from within "read()" itself.
+      // Each "clientData" may have at most one read outstanding.
+  virtual void cancel(void* clientData) = 0;
+      // Cancels the outstanding read (if any) for "clientData"; its completion function will not be called.
+  virtual void prefetch(int fileDescriptor, u_int64_t offset, u_int64_t size);
+      // Tells the reader that this data will probably be read soon.  (By default, this asks the OS to read it.)
+
+  static unsigned maxWaitTime; // in microseconds (default: 2 seconds); used only by the default reader
+
+protected:
+  AsyncFileReader(UsageEnvironment& env); // abstract base class
+  virtual ~AsyncFileReader();
+
+  virtual void noLongerCurrent();
+      // Called when another reader has replaced us (in "setForEnvironment()").  (The default reader then deletes
+      // itself, once its outstanding reads have completed.)
+
+  UsageEnvironment& envir() const { return fEnv; }
+
+private:
+  UsageEnvironment& fEnv;
+};
+
+#endif
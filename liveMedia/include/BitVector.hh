@@ -39,6 +39,7 @@ public:
   void put1Bit(unsigned bit);
 
   unsigned getBits(unsigned numBits); // "numBits" <= 32
+  unsigned peekBits(unsigned numBits) const; // like "getBits()", but doesn't advance
   unsigned get1Bit();
   Boolean get1BitBoolean() { return get1Bit() != 0; }
 
@@ -49,6 +49,31 @@ public:
   void seekToByteRelative(int64_t offset, u_int64_t numBytesToStream = 0);
   void seekToEnd(); // to force EOF handling on the next read
 
+  Boolean getFileDescriptorAndPosition(int& fileDescriptor, u_int64_t& position);
+      // Returns the underlying file descriptor, and the position (in the file) of the next byte that we'd read.
+      // This lets the caller send data directly from the file (e.g., using "sendfile()"), rather than by reading us.
+      // (Returns False if the file isn't seekable.)
+
+  Boolean useAsynchronousReads(unsigned estBitrate = 0);
+      // Reads the (seekable) file through our environment's "AsyncFileReader", so that reads of data that's not yet
+      // been cached by the OS don't block the event loop, and has the OS fetch data ahead of us - by an amount
+      // based on "estBitrate" (in kbps; 0 means unknown).  Unless READ_FROM_FILES_SYNCHRONOUSLY is #defined, we
+      // already do this (with a default prefetch size) for seekable files.
+      // Returns False - leaving us reading normally - if the file isn't seekable, or its size is unknown (or 0).
+  Boolean useMemoryMapping(unsigned estBitrate = 0);
+      // Reads the file through a sliding window of memory-mapped pages (rather than "fread()"ing each chunk), with
+      // prefetching as above.  This is faster when the file's data is usually cached (e.g., on local storage), but
+      // - unlike "useAsynchronousReads()" - blocks the event loop whenever it isn't.
+      // Returns False - leaving us reading as before - if the file can't be mapped (e.g., it's not a regular file).
+      // This is never done by default (and none of our "ServerMediaSubsession"s do it), because the file may grow
+      // while we're reading it, but must not be truncated: Accessing a mapped page beyond the new end of the file
+      // would crash the process (with SIGBUS).  So use this only for files that you know won't be truncated.
+
+  static u_int64_t mappedMemoryBudget;
+      // The maximum number of bytes that all "ByteStreamFileSource"s (in this process) may have mapped at once.
+      // (When mapping a new window would exceed this, we read that data normally instead.)
+  static u_int64_t mappedMemoryInUse() { return fMappedMemoryInUse; }
+
 protected:
   ByteStreamFileSource(UsageEnvironment& env,
 		       FILE* fid,
@@ -58,13 +83,25 @@ protected:
 
   virtual ~ByteStreamFileSource();
 
+  void readAsynchronouslyIfSeekable(); // called by createNew(), once "fFileSize" is known
+
   static void fileReadableHandler(ByteStreamFileSource* source, int mask);
   void doReadFromFile();
 
+private:
+  Boolean limitReadToFileSize(); // returns False (having handled closure) if there's nothing left to read
+  void setPresentationTimeAndDeliver();
+  void doReadAsynchronously();
+  void doReadFromMappedFile();
+  Boolean mapWindow(); // maps the window that contains "fReadPosition"
+  void unmapWindow();
+
 private:
   // redefined virtual functions:
+  virtual Boolean isByteStreamFileSource() const;
   virtual void doGetNextFrame();
   virtual void doStopGettingFrames();
+  virtual void afterReadingFile(int result);
 
 protected:
   u_int64_t fFileSize;
@@ -77,6 +114,13 @@ private:
   Boolean fHaveStartedReading;
   Boolean fLimitNumBytesToStream;
   u_int64_t fNumBytesToStream; // used iff "fLimitNumBytesToStream" is True
+
+  Boolean fUseAsynchronousReads, fUseMemoryMapping;
+  u_int64_t fReadPosition; // replaces the "FILE" position, iff "fUseAsynchronousReads" or "fUseMemoryMapping"
+  // Used iff "fUseMemoryMapping" is True:
+  u_int8_t* fMapping; // the current window (or NULL)
+  u_int64_t fMappingOffset, fMappingSize;
+  static u_int64_t fMappedMemoryInUse;
 };
 
 #endif
@@ -53,6 +53,7 @@ private:
   // redefined virtual functions:
   virtual void doGetNextFrame();
   //virtual void doStopGettingFrames(); // optional
+  //virtual void requestKeyFrame(); // optional: have the encoder emit a key frame (e.g., after a client's RTCP PLI)
 
 private:
   static void deliverFrame0(void* clientData);
@@ -0,0 +1,120 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A per-environment cache of file data, shared by all "FramedFileSource"s that read the same file
+// C++ header
+
+#ifndef _FILE_BLOCK_CACHE_HH
+#define _FILE_BLOCK_CACHE_HH
+
+#ifndef _ASYNC_FILE_READER_HH
+#include "AsyncFileReader.hh"
+#endif
+
+// When many streams play the same (e.g., popular) file, each reads the same data independently.
+// Once enabled (by "setMaxSize()"), the cache holds fixed-size blocks of file data - keyed by the file's
+// identity (so that separately-opened copies of a file share them) and offset - which "FramedFileSource"s
+// read through, rather than through their own file.  Each block is read from storage just once (even if
+// several streams want it at the same time), and is then kept until it becomes the least recently used
+// block, and more space is needed.
+// (A file's identity includes its size and modification time, so a file that's opened after it has changed
+// - even by appending - doesn't get the old blocks; and a file's blocks are dropped when it's closed, if it
+// has since changed.  However, files should not be modified - other than by appending - while they're being
+// streamed.  A file's final, partial block is never kept.)
+
+#define FILE_BLOCK_SIZE (64*1024)
+
+class CachedFile; // forward; defined in "FileBlockCache.cpp"
+
+class FileBlockCache {
+public:
+  static void setMaxSize(UsageEnvironment& env, u_int64_t maxSize);
+      // Sets the maximum number of bytes of file data that the cache for "env" may hold.  0 (the default)
+      // means 'no cache'; files that are opened after this are read directly.
+  static FileBlockCache* forEnvironment(UsageEnvironment& env);
+      // Returns the cache for "env" (e.g., to get its statistics), or NULL if there isn't one
+
+  u_int64_t maxSize() const { return fMaxSize; }
+  u_int64_t size() const { return fSize; } // the number of bytes that are being held, or being loaded
+  unsigned numOpenFiles() const { return fNumOpenFiles; }
+
+  // Statistics (since the cache was created, or "resetStatistics()" was last called).  Each 'lookup' is a
+  // read (of data from a single block) by a "FramedFileSource":
+  u_int64_t numLookups() const { return fNumLookups; }
+  u_int64_t numHits() const { return fNumHits; } // lookups that found their block already loaded
+  u_int64_t numSharedLoads() const { return fNumSharedLoads; } // lookups that waited for another's load
+  u_int64_t numMisses() const { return fNumMisses; } // lookups that had to load their block from storage
+  u_int64_t numBypasses() const { return fNumBypasses; } // lookups that had to read directly, because
+      // every block in the cache was being loaded
+  u_int64_t numBytesLoaded() const { return fNumBytesLoaded; } // the number of bytes read from storage
+  u_int64_t numBlocksEvicted() const { return fNumBlocksEvicted; }
+  double hitRate() const; // the fraction of lookups (0.0 if none) that didn't need a read from storage
+  void resetStatistics();
+
+  // Used by "FramedFileSource":
+  static CachedFile* openFile(UsageEnvironment& env, int fileDescriptor);
+      // Returns NULL if there's no cache (or the file can't be cached - e.g., because it's not a regular file)
+  static void closeFile(CachedFile* file);
+#define FILE_BLOCK_CACHE_PENDING (-2) // "completionFunc" will be called later
+#define FILE_BLOCK_CACHE_BYPASS (-3) // the data must be read directly
+  static int read(CachedFile* file, u_int64_t position, u_int8_t* to, unsigned size,
+		  AsyncFileReader::completionFunc* completionFunc, void* clientData);
+      // Copies up to "size" bytes, from the block that contains "position", and returns the number of bytes copied
+      // (0 at end-of-file), -1 on error, or FILE_BLOCK_CACHE_PENDING or FILE_BLOCK_CACHE_BYPASS.
+      // If FILE_BLOCK_CACHE_PENDING, then "completionFunc" will be called - from the event loop - once the block
+      // has been loaded and the data copied, with the result.
+  static void cancel(CachedFile* file, void* clientData);
+
+private:
+  class Block;
+  class Waiter;
+
+  FileBlockCache(UsageEnvironment& env);
+  virtual ~FileBlockCache();
+  void reclaimIfPossible();
+
+  int readFromBlock(CachedFile* file, u_int64_t position, u_int8_t* to, unsigned size,
+		    AsyncFileReader::completionFunc* completionFunc, void* clientData);
+  Block* newBlock(CachedFile* file, unsigned const* key);
+  void loadMore(Block* block);
+  static void blockLoadCompletionHandler(void* clientData, int result);
+  void blockLoadCompletionHandler1(Block* block, int result);
+  void cancelLoadsFor(CachedFile* file);
+  void removeLoadedBlocksFor(unsigned const* fileKey, Boolean otherVersionsOnly);
+      // Removes the loaded (and unreferenced) blocks of the file whose key is "fileKey" - or, if "otherVersionsOnly",
+      // the blocks of any other version of the same file (i.e., one with the same device and inode numbers)
+  void removeBlock(Block* block);
+  void evictBlocksAsNeeded(u_int64_t numBytesNeeded);
+      // Evicts least recently used (unreferenced) blocks until there's room for "numBytesNeeded" more bytes, or
+      // there are no more blocks that can be evicted
+  void useBlock(Block* block); // moves it to the head of the LRU list
+
+private:
+  UsageEnvironment& fEnv;
+  u_int64_t fMaxSize, fSize;
+  HashTable* fFiles; // indexed by file identity
+  HashTable* fBlocks; // indexed by file identity + block number
+  Block* fLRUHead; // most recently used (loaded blocks only)
+  Block* fLRUTail; // least recently used
+  Block* fLoadingBlocks;
+  Waiter* fWaiters; // for blocks being loaded, in the order in which they were added
+  unsigned fNumOpenFiles;
+  u_int64_t fNumLookups, fNumHits, fNumSharedLoads, fNumMisses, fNumBypasses;
+  u_int64_t fNumBytesLoaded, fNumBlocksEvicted;
+};
+
+#endif
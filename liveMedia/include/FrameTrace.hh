@@ -0,0 +1,89 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A ring buffer that records - for each "FramedSource" - when frames were requested and delivered.
+// (This is used only if the library was compiled with FRAME_TRACING #defined.)
+// C++ header
+
+#ifndef _FRAME_TRACE_HH
+#define _FRAME_TRACE_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+
+// If the library is compiled with FRAME_TRACING #defined, then "FramedSource::getNextFrame()" and
+// "FramedSource::afterGetting()" (plus "handleClosure()" and "stopGettingFrames()") add a record to the
+// "FrameTraceBuffer" for the source's "UsageEnvironment".  Because each "UsageEnvironment" (and thus each
+// buffer) is used by only one thread, no locking is needed.  Otherwise, no records are added (and the
+// buffer is never created).
+
+enum FrameTraceEventType {
+  FRAME_TRACE_REQUESTED, // "getNextFrame()" was called; "frameSize" is the maximum size requested
+  FRAME_TRACE_DELIVERED, // "afterGetting()" was called; "frameSize" is the size of the frame delivered
+  FRAME_TRACE_CLOSED, // the source was closed (e.g., at the end of a file), instead of delivering a frame
+  FRAME_TRACE_STOPPED // "stopGettingFrames()" was called
+};
+
+// The format of each record (both in the buffer, and in a file written by "FrameTraceBuffer::writeToFile()"):
+struct FrameTraceRecord {
+  u_int32_t timeSec, timeUSec; // when the event occurred (using "gettimeofday()")
+  u_int32_t frameSize;
+  u_int8_t eventType; // a "FrameTraceEventType"
+  char mediumName[mediumNameMaxLen]; // the name of the source
+};
+
+// Files written by "FrameTraceBuffer::writeToFile()" consist of this header, followed by "numRecords"
+// "FrameTraceRecord"s (in the order in which they occurred):
+#define FRAME_TRACE_FILE_MAGIC "LMFT"
+struct FrameTraceFileHeader {
+  char magic[4];
+  u_int32_t recordSize; // sizeof (FrameTraceRecord), for sanity checking
+  u_int32_t numRecords;
+  u_int32_t numRecordsLost; // because the ring buffer overflowed
+};
+
+class FrameTraceBuffer {
+public:
+  static FrameTraceBuffer* ourBuffer(UsageEnvironment& env, Boolean createIfNotPresent = True);
+  static void close(UsageEnvironment& env); // deletes our buffer (if any)
+
+  void setMaxNumRecords(unsigned maxNumRecords); // also discards any existing records
+  void reset(); // discards any existing records
+
+  void addRecord(Medium const& medium, FrameTraceEventType eventType, unsigned frameSize);
+
+  unsigned numRecords() const { return fNumRecords; }
+  unsigned numRecordsLost() const { return fNumRecordsLost; }
+
+  Boolean writeToFile(char const* fileName) const;
+  Boolean writeToFile(FILE* fid) const;
+
+protected:
+  FrameTraceBuffer(UsageEnvironment& env, unsigned maxNumRecords);
+  virtual ~FrameTraceBuffer();
+
+private:
+  UsageEnvironment& fEnv;
+  FrameTraceRecord* fRecords;
+  unsigned fMaxNumRecords;
+  unsigned fNextIndex; // where the next record will be written
+  unsigned fNumRecords; // <= fMaxNumRecords
+  unsigned fNumRecordsLost;
+};
+
+#endif
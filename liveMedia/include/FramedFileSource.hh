@@ -25,13 +25,50 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "FramedSource.hh"
 #endif
 
+class AsyncFileReader; // forward
+class CachedFile; // forward
+
 class FramedFileSource: public FramedSource {
 protected:
   FramedFileSource(UsageEnvironment& env, FILE* fid); // abstract base class
   virtual ~FramedFileSource();
 
+  // Reading (seekable) files without blocking the event loop, using our environment's "AsyncFileReader"
+  // (and its "FileBlockCache", if it has one):
+  void readFileAsynchronously(u_int64_t position, u_int8_t* to, unsigned size);
+      // Reads up to "size" bytes from "position" (without using the "FILE" position), then - from the
+      // event loop - calls "afterReadingFile()"
+  virtual void afterReadingFile(int result);
+      // "result" is the number of bytes read (0 at end-of-file), or -1 on error
+  void cancelFileRead(); // so that "afterReadingFile()" won't be called for the outstanding read (if any)
+
+  void setPrefetchSize(u_int64_t prefetchSize) { fPrefetchSize = prefetchSize; }
+  void prefetchFrom(u_int64_t position);
+      // Called before reading sequentially from "position".  Once we've read half of the data that we last
+      // prefetched (or have moved outside it), asks for the next "fPrefetchSize" bytes to be fetched ahead of us.
+
 protected:
   FILE* fFid;
+
+private:
+  void continueReadingFromCache(Boolean calledFromEventLoop);
+  void startReadingDirectly();
+  void completeFileRead(int lastResult, Boolean calledFromEventLoop);
+  static void cachedReadCompletionHandler(void* clientData, int result);
+  static void fileReadCompletionHandler(void* clientData, int result);
+  static void fileReadCompletionTask(void* clientData);
+
+private:
+  Boolean fHaveOpenedCachedFile;
+  CachedFile* fCachedFile; // non-NULL iff we read through our environment's "FileBlockCache"
+  AsyncFileReader* fPendingFileReader; // the reader that's doing our outstanding (direct) read, if any
+  Boolean fIsAwaitingCache;
+  TaskToken fFileReadCompletionTask;
+  u_int64_t fFileReadPosition;
+  u_int8_t* fFileReadTo;
+  unsigned fFileReadSize, fNumBytesReadFromFile;
+  int fFileReadResult;
+  u_int64_t fPrefetchSize, fPrefetchPosition, fNextPrefetchPosition;
 };
 
 #endif
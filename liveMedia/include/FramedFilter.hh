@@ -44,6 +44,7 @@ protected:
   virtual char const* MIMEtype() const;
   virtual void getAttributes() const;
   virtual void doStopGettingFrames();
+  virtual void requestKeyFrame();
 
 protected:
   FramedSource* fInputSource;
@@ -55,6 +55,11 @@ public:
       // size of the largest possible frame that we may serve, or 0
       // if no such maximum is known (default)
 
+  virtual void requestKeyFrame();
+      // called (e.g., by a "RTPSink", on receipt of a RTCP PLI or FIR) to ask
+      // that the next frame delivered be a key (random-access) frame, if possible.
+      // The default implementation does nothing.
+
   virtual void doGetNextFrame() = 0;
       // called by getNextFrame()
 
@@ -151,10 +151,21 @@ protected:
     HashTable::Iterator* fOurIterator;
   };
 
+  // An iterator over our "ClientSession" objects:
+  class ClientSessionIterator {
+  public:
+    ClientSessionIterator(GenericMediaServer& server);
+    virtual ~ClientSessionIterator();
+    ClientSession* next();
+  private:
+    HashTable::Iterator* fOurIterator;
+  };
+
 protected:
   friend class ClientConnection;
   friend class ClientSession;	
   friend class ServerMediaSessionIterator;
+  friend class ClientSessionIterator;
   int fServerSocket;
   Port fServerPort;
   unsigned fReclamationSeconds;
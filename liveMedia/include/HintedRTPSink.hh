@@ -0,0 +1,61 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A RTP sink that sends pre-packetized payloads from a RTP hint file (delivered by a "RTPHintFileSource"),
+// one per packet.  Only the per-client RTP header fields (SSRC, sequence number, timestamp base)
+// are generated here; the payloads, marker bits and timing come from the hint file.
+// C++ header
+
+#ifndef _HINTED_RTP_SINK_HH
+#define _HINTED_RTP_SINK_HH
+
+#ifndef _MULTI_FRAMED_RTP_SINK_HH
+#include "MultiFramedRTPSink.hh"
+#endif
+#ifndef _RTP_HINT_FILE_HH
+#include "RTPHintFile.hh"
+#endif
+
+class HintedRTPSink: public MultiFramedRTPSink {
+public:
+  static HintedRTPSink* createNew(UsageEnvironment& env, Groupsock* RTPgs, RTPHintFile* hintFile,
+				  unsigned char rtpPayloadTypeIfDynamic);
+      // Note: "hintFile" is not owned by us; it must outlive this object.
+
+protected:
+  HintedRTPSink(UsageEnvironment& env, Groupsock* RTPgs, RTPHintFile* hintFile,
+		unsigned char rtpPayloadType);
+      // called only by createNew()
+  virtual ~HintedRTPSink();
+
+private: // redefined virtual functions:
+  virtual Boolean sourceIsCompatibleWithUs(MediaSource& source);
+  virtual void doSpecialFrameHandling(unsigned fragmentationOffset,
+                                      unsigned char* frameStart,
+                                      unsigned numBytesInFrame,
+                                      struct timeval framePresentationTime,
+                                      unsigned numRemainingBytes);
+  virtual Boolean frameCanAppearAfterPacketStart(unsigned char const* frameStart,
+						 unsigned numBytesInFrame) const;
+  virtual char const* sdpMediaType() const;
+  virtual char const* auxSDPLine();
+
+private:
+  RTPHintFile* fHintFile;
+};
+
+#endif
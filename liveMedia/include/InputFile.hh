@@ -64,4 +64,30 @@ int64_t TellFile64(FILE *fid);
 Boolean FileIsSeekable(FILE *fid);
     // Tests whether "fid" is seekable, by trying to seek within it.
 
+u_int8_t* MapInputFile(int fileDescriptor, u_int64_t fileSize);
+    // Maps the whole of an open file (of size "fileSize") into memory (read-only), so that its data can then be
+    // accessed without further system calls.  The mapping remains valid after the file is closed.
+    // Returns NULL if this is not possible (e.g., if the OS doesn't support "mmap()", or the file is too large).
+u_int8_t* MapInputFileRegion(int fileDescriptor, u_int64_t offset, u_int64_t size);
+    // Like "MapInputFile()", except that only "size" bytes of the file, starting at "offset", are mapped.
+    // "offset" must be a multiple of the page size.  (This lets a file that's too large to map at once be
+    // accessed a 'window' at a time.)
+void UnmapInputFile(u_int8_t* mapping, u_int64_t fileSize);
+    // also used to unmap a region mapped by "MapInputFileRegion()" (with "fileSize" being the region's size)
+
+void AdviseSequentialAccess(u_int8_t* mapping, u_int64_t size);
+    // Tells the OS that a region mapped by "MapInputFileRegion()" will be read sequentially (so that it
+    // can read ahead further, and free pages behind us sooner).
+void AdviseReadahead(int fileDescriptor, u_int64_t offset, u_int64_t size);
+    // Asks the OS to start reading "size" bytes of the file (from "offset") into its cache, without waiting.
+    // (Both of these are just hints; they do nothing on OSs that don't support them.)
+
+#define READ_WOULD_BLOCK (-2)
+int ReadInputFileAt(int fileDescriptor, u_int64_t offset, u_int8_t* to, unsigned size, Boolean onlyIfCached = False);
+    // Reads up to "size" bytes of the file, starting at "offset", without using (or changing) the file position.
+    // Returns the number of bytes read (0 at end-of-file), or -1 on error.
+    // If "onlyIfCached" is True, and the data would first have to be fetched from storage, then - rather than
+    // waiting for this - we read nothing, and return READ_WOULD_BLOCK.  (Fewer than "size" bytes may be read
+    // if only some of the data is cached.  On OSs where we can't tell what's cached, we just read the data.)
+
 #endif
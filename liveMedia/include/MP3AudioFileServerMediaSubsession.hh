@@ -32,6 +32,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _MP3_ADU_HH
 #include "MP3ADU.hh"
 #endif
+#ifndef _MP3_SEEK_TABLE_HH
+#include "MP3SeekTable.hh"
+#endif
 
 class MP3AudioFileServerMediaSubsession: public FileServerMediaSubsession{
 public:
@@ -68,6 +71,7 @@ protected:
   Boolean fGenerateADUs;
   Interleaving* fInterleaving;
   float fFileDuration;
+  MP3SeekTable* fSeekTable; // shared by all of our "MP3FileSource"s (if any)
 };
 
 #endif
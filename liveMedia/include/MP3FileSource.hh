@@ -26,6 +26,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #endif
 
 class MP3StreamState; // forward
+class MP3SeekTable; // forward
 
 class MP3FileSource: public FramedFileSource {
 public:
@@ -36,6 +37,8 @@ public:
   void setPresentationTimeScale(unsigned scale);
   void seekWithinFile(double seekNPT, double streamDuration);
       // if "streamDuration" is >0.0, then we limit the stream to that duration, before treating it as EOF
+  void setSeekTable(MP3SeekTable* seekTable) { fSeekTable = seekTable; }
+      // If "seekTable" (which we don't own) is complete, then we use it for exact seeking, and for our duration
 
 protected:
   MP3FileSource(UsageEnvironment& env, FILE* fid);
@@ -60,6 +63,7 @@ private:
 
 private:
   MP3StreamState* fStreamState;
+  MP3SeekTable* fSeekTable;
   Boolean fHaveJustInitialized;
   struct timeval fFirstFramePresentationTime; // set on stream init
   Boolean fLimitNumBytesToStream;
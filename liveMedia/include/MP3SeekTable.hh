@@ -0,0 +1,77 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A table of the byte offsets of each frame in a MPEG (1 or 2) audio file, allowing exact seeking
+// by time - even within VBR files that have no Xing 'table of contents'.
+// C++ header
+
+#ifndef _MP3_SEEK_TABLE_HH
+#define _MP3_SEEK_TABLE_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+
+class MP3SeekTable: public Medium {
+public:
+  static MP3SeekTable* createNew(UsageEnvironment& env, char const* mp3FileName,
+				 Boolean scanInBackground = True);
+      // Reads the table from the file "<mp3FileName>x" (as written by "writeToFile()"), if this exists
+      // and matches the MP3 file.  Otherwise, builds the table by scanning the MP3 file's frame headers:
+      // in the background (i.e., a chunk at a time, from the event loop) if "scanInBackground" is True.
+      // Returns NULL if the MP3 file cannot be opened.
+
+  Boolean isComplete() const { return fScanFid == NULL; }
+      // Note: The table cannot be used until it's complete
+  unsigned numFrames() const { return fNumFrames; }
+  float duration() const; // in seconds
+  unsigned byteNumberFromNPT(double npt) const;
+      // Returns the offset of the frame that's playing at "npt" (or the file size, if "npt" >= duration())
+
+  Boolean writeToFile(char const* fileName);
+
+protected:
+  MP3SeekTable(UsageEnvironment& env, FILE* mp3Fid, unsigned mp3FileSize);
+      // called only by createNew()
+  virtual ~MP3SeekTable();
+
+private:
+  Boolean readFromFile(char const* fileName);
+  Boolean setFrameDuration(unsigned hdr);
+  static void scanTask(void* clientData);
+  void scanSomeFrames();
+  Boolean scanNextFrame();
+  Boolean haveScanBytes(unsigned numBytes);
+  void finishScan();
+  void addFrame(unsigned byteNumber);
+
+private:
+  unsigned fFileSize;
+  u_int32_t* fFrameOffsets;
+  unsigned fNumFrames, fFrameOffsetsArraySize;
+  unsigned fFrameDurationInMicroseconds; // we assume that all frames have the same duration
+
+  // Used while scanning the MP3 file:
+  FILE* fScanFid;
+  TaskToken fScanTask;
+  u_int8_t* fScanBuffer;
+  unsigned fScanBufferFileOffset, fScanBufferSize;
+  unsigned fScanOffset;
+  unsigned fNumBytesSkipped; // while looking for a valid frame header
+};
+
+#endif
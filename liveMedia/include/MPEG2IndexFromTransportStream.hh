@@ -33,12 +33,47 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #define MAX_PES_PACKET_SIZE 65536
 #endif
 
+#define INDEX_RECORD_SIZE 11 // the size of each record that we deliver
+
 class IndexRecord; // forward
 
 class MPEG2IFrameIndexFromTransportStream: public FramedFilter {
 public:
   static MPEG2IFrameIndexFromTransportStream*
   createNew(UsageEnvironment& env, FramedSource* inputSource);
+      // "inputSource" may be NULL, if only the synchronous interface (below) is used
+
+  // A synchronous interface, for indexing Transport Stream packets that are already in
+  // memory (e.g., from a "mmap()"ed file), without using an input source or the event loop.
+  // After each call to "indexTransportPacket()", call "getNextIndexRecord()" until it
+  // returns False.
+  Boolean indexTransportPacket(unsigned char const* pkt, Boolean analyzeOnly = False);
+      // Returns False if "pkt" was bad (in which case "indexEndOfStream()" should be called next).
+      // If "analyzeOnly" is True, then we update only our stream state (see below);
+      // the packet's video data (if any) is not indexed.
+  Boolean indexEndOfStream();
+      // Call this at the end of the input, or after a bad packet.  Returns True iff indexing
+      // should then continue with any following packets (as our event loop-based indexing
+      // does after the first bad packet).
+  Boolean getNextIndexRecord(u_int8_t* to); // "to" must have room for INDEX_RECORD_SIZE bytes
+  Boolean parseBufferOverflowed() const { return fParseBufferOverflowed; }
+  void setReportWarnings(Boolean reportWarnings) { fReportWarnings = reportWarnings; }
+
+  // The state - other than buffered video data - that the indexing of each Transport
+  // Stream packet depends upon.  Saving and restoring this lets different parts of a
+  // Transport Stream be indexed independently (and concurrently):
+  struct StreamState {
+    unsigned long lastTransportPacketNumber;
+    float firstPCR, lastPCR;
+    Boolean haveSeenFirstPCR;
+    u_int16_t PMT_PID, video_PID;
+    u_int8_t lastContinuityCounter;
+    Boolean isH264, isH265;
+    unsigned closureNumber;
+  };
+  void getStreamState(StreamState& state) const;
+  void setStreamState(StreamState const& state);
+  static Boolean streamStatesAreEqual(StreamState const& s1, StreamState const& s2);
 
 protected:
   MPEG2IFrameIndexFromTransportStream(UsageEnvironment& env,
@@ -63,9 +98,12 @@ private:
   static void handleInputClosure(void* clientData);
   void handleInputClosure1();
 
-  void analyzePAT(unsigned char* pkt, unsigned size);
-  void analyzePMT(unsigned char* pkt, unsigned size);
+  Boolean analyzeTransportPacket(unsigned char const* pkt, Boolean saveVideoData);
+  Boolean appendEndOfStreamCode();
+  void analyzePAT(unsigned char const* pkt, unsigned size);
+  void analyzePMT(unsigned char const* pkt, unsigned size);
 
+  IndexRecord* removeParsedIndexRecord();
   Boolean deliverIndexRecord();
   Boolean parseFrame();
   Boolean parseToNextCode(unsigned char& nextCode);
@@ -88,8 +126,11 @@ private:
   unsigned fParseBufferFrameStart;
   unsigned fParseBufferParseEnd;
   unsigned fParseBufferDataEnd;
+  unsigned fNumInitialBadBytes; // skipped (before the first frame), but not yet tagged as such
   IndexRecord* fHeadIndexRecord;
   IndexRecord* fTailIndexRecord;
+  Boolean fParseBufferOverflowed;
+  Boolean fReportWarnings;
 };
 
 #endif
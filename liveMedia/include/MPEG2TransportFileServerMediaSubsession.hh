@@ -89,7 +89,6 @@ private:
 
 private:
   MPEG2TransportStreamIndexFile* fIndexFile;
-  float fDuration;
   HashTable* fClientSessionHashTable; // indexed by client session id
 };
 
@@ -27,10 +27,6 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "FramedFilter.hh"
 #endif
 
-#ifndef _HASH_TABLE_HH
-#include "HashTable.hh"
-#endif
-
 class MPEG2TransportStreamFramer: public FramedFilter {
 public:
   static MPEG2TransportStreamFramer*
@@ -44,6 +40,11 @@ public:
   void setNumTSPacketsToStream(unsigned long numTSRecordsToStream);
   void setPCRLimit(float pcrLimit);
 
+  void enableCBRPacing(unsigned numTSPacketsPerFrame = 7);
+      // Delivers exactly "numTSPacketsPerFrame" packets at a time (7 fill a RTP/UDP packet), with durations
+      // interpolated from the PCRs of one PID, and accumulated so that the output stays locked to the PCR timeline.
+      // (This gives a constant-bitrate, low-jitter output from a CBR file; don't use it with a live input.)
+
 protected:
   MPEG2TransportStreamFramer(UsageEnvironment& env, FramedSource* inputSource);
       // called only by createNew()
@@ -51,6 +52,7 @@ protected:
 
 private:
   // Redefined virtual functions:
+  virtual Boolean isMPEG2TransportStreamFramer() const;
   virtual void doGetNextFrame();
   virtual void doStopGettingFrames();
 
@@ -61,18 +63,32 @@ private:
 				unsigned durationInMicroseconds);
   void afterGettingFrame1(unsigned frameSize,
 			  struct timeval presentationTime);
+  static void handleInputClosure(void* clientData);
+  void handleInputClosure1();
 
   Boolean updateTSPacketDurationEstimate(unsigned char* pkt, double timeNow);
+  void updatePacingClock(u_int16_t pid, double clock, Boolean isDiscontinuity);
+  unsigned pacedFrameDuration(unsigned numTSPackets);
 
 private:
   u_int64_t fTSPacketCount;
   double fTSPacketDurationEstimate;
-  HashTable* fPIDStatusTable;
+  class PIDStatus** fPIDStatusTable; // indexed by PID
   u_int64_t fTSPCRCount;
   Boolean fLimitNumTSPacketsToStream;
   unsigned long fNumTSPacketsToStream; // used iff "fLimitNumTSPacketsToStream" is True
   Boolean fLimitTSPacketsToStreamByPCR;
   float fPCRLimit; // used iff "fLimitTSPacketsToStreamByPCR" is True
+
+  // Used iff "fNumTSPacketsPerPacedFrame" > 0 (i.e., CBR pacing is enabled):
+  unsigned fNumTSPacketsPerPacedFrame;
+  int fPacingPID; // the PID whose PCRs we pace from; -1 until we've seen a PCR
+  double fPacingPCR; // the last PCR seen on "fPacingPID"
+  double fPacingClock; // the same PCR, on our own (continuous) timeline
+  u_int64_t fPacingPacketNum; // the packet that carried it
+  double fPacingPacketDuration; // from PCR interpolation; 0.0 until we've seen two PCRs
+  double fPacingTime; // the timeline position up to which we've already delivered durations
+  Boolean fHavePacingTime;
 };
 
 #endif
@@ -33,7 +33,11 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 class MPEG2TransportStreamIndexFile: public Medium {
 public:
   static MPEG2TransportStreamIndexFile* createNew(UsageEnvironment& env,
-						  char const* indexFileName);
+						  char const* indexFileName,
+						  Boolean useMemoryMapping = True);
+      // If "useMemoryMapping" is True (the default), the index file is mapped into memory (if the OS allows), so that
+      // index record lookups don't each need a seek+read.  (Set it to False if the index file might be truncated or
+      // replaced - rather than appended to - while it's being used.)
 
   virtual ~MPEG2TransportStreamIndexFile();
 
@@ -56,21 +60,48 @@ public:
   Boolean readIndexRecordValues(unsigned long indexRecordNum,
 				unsigned long& transportPacketNum, u_int8_t& offset,
 				u_int8_t& size, float& pcr, u_int8_t& recordType);
+  Boolean findNextFrameStart(unsigned long& indexRecordNum, int direction);
+      // Moves "indexRecordNum" forward (if "direction" > 0) or backward (if "direction" < 0) - if necessary - to
+      // the nearest index record that begins a (I- or non-I) video frame.  Returns False iff there is no such record.
+      // (If the index file cannot be mapped into memory, then "indexRecordNum" is left unchanged.)
   float getPlayingDuration();
   void stopReading() { closeFid(); }
 
+  // Classify an index record, by its "recordType":
+  static Boolean isIFrameStart(u_int8_t recordType) {
+    return recordType == 0x81/*actually, a VSH*/ || recordType == 0x85/*actually, a SPS, for H.264*/
+      || recordType == 0x8B/*actually, a VPS, for H.265*/;
+    // This relies upon I-frames always being preceded by a VSH+GOP (for MPEG-2 data),
+    // by a SPS (for H.264 data), or by a VPS (for H.265 data)
+  }
+  static Boolean isNonIFrameStart(u_int8_t recordType) {
+    return recordType == 0x83 || recordType == 0x88/*for H.264*/ || recordType == 0x8E/*for H.265*/;
+  }
+  static Boolean isFrameStart(u_int8_t recordType) {
+    return isIFrameStart(recordType) || isNonIFrameStart(recordType);
+  }
+
+  Boolean checkForNewIndexRecords();
+      // Checks whether the index file has grown since we last looked at it (e.g., because it's
+      // being written - by a "MPEG2TransportStreamIndexingFilter" - while its Transport Stream
+      // file is still being recorded).  If so, the new index records become available for lookups.
+      // Returns True iff new index records were found.
+
   int mpegVersion();
       // returns the best guess for the version of MPEG being used for data within the underlying Transport Stream file.
       // (1,2,4, or 5 (representing H.264).  0 means 'don't know' (usually because the index file is empty))
 
 private:
-  MPEG2TransportStreamIndexFile(UsageEnvironment& env, char const* indexFileName);
+  MPEG2TransportStreamIndexFile(UsageEnvironment& env, char const* indexFileName, Boolean useMemoryMapping);
 
   Boolean openFid();
   Boolean seekToIndexRecord(unsigned long indexRecordNumber);
   Boolean readIndexRecord(unsigned long indexRecordNum); // into "fBuf"
   Boolean readOneIndexRecord(unsigned long indexRecordNum); // closes "fFid" at end
   void closeFid();
+  Boolean buildFrameStartTable();
+  void addToFrameStartTable(unsigned long fromIndexRecordNum);
+  void mapIndexRecords();
 
   u_int8_t recordTypeFromBuf() { return fBuf[0]; }
   u_int8_t offsetFromBuf() { return fBuf[1]; }
@@ -91,6 +122,12 @@ private:
   unsigned long fCachedTSPacketNumber, fCachedIndexRecordNumber;
   unsigned long fNumIndexRecords;
   unsigned char fBuf[INDEX_RECORD_SIZE]; // used for reading index records from file
+  u_int8_t* fMappedIndexRecords; // the whole index file, if it could be mapped into memory; otherwise NULL
+  u_int64_t fMappedSize;
+  unsigned long* fFrameStartRecordNums; // the (sorted) numbers of the index records that begin a frame
+  unsigned long fNumFrameStarts;
+  Boolean fHaveTriedToBuildFrameStartTable;
+  Boolean fUseMemoryMapping;
 };
 
 #endif
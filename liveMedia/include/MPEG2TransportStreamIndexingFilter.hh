@@ -0,0 +1,85 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A filter that passes a Transport Stream through unchanged (e.g., to a "FileSink" that's
+// recording it), while also writing an index file (".tsx") for the Transport Stream as it grows.
+// C++ header
+
+#ifndef _MPEG2_TRANSPORT_STREAM_INDEXING_FILTER_HH
+#define _MPEG2_TRANSPORT_STREAM_INDEXING_FILTER_HH
+
+#ifndef _FRAMED_FILTER_HH
+#include "FramedFilter.hh"
+#endif
+
+#ifndef TRANSPORT_PACKET_SIZE
+#define TRANSPORT_PACKET_SIZE 188
+#endif
+
+class MPEG2IFrameIndexFromTransportStream; // forward
+
+class MPEG2TransportStreamIndexingFilter: public FramedFilter {
+public:
+  static MPEG2TransportStreamIndexingFilter* createNew(UsageEnvironment& env,
+						       FramedSource* inputSource,
+						       char const* indexFileName);
+      // "inputSource" should deliver the Transport Stream from its start (i.e., from the start
+      // of the file that it's being recorded to).  Index records for this data are appended to
+      // "indexFileName" as they become available, so that - while the recording continues - a
+      // "MPEG2TransportStreamIndexFile" can be used to seek within (or 'trick play') the data
+      // that has been recorded so far.
+
+protected:
+  MPEG2TransportStreamIndexingFilter(UsageEnvironment& env,
+				     FramedSource* inputSource, FILE* indexFid);
+      // called only by createNew()
+  virtual ~MPEG2TransportStreamIndexingFilter();
+
+private:
+  // redefined virtual functions:
+  virtual void doGetNextFrame();
+
+private:
+  static void afterGettingFrame(void* clientData, unsigned frameSize,
+                                unsigned numTruncatedBytes,
+                                struct timeval presentationTime,
+                                unsigned durationInMicroseconds);
+  void afterGettingFrame1(unsigned frameSize,
+                          unsigned numTruncatedBytes,
+                          struct timeval presentationTime,
+                          unsigned durationInMicroseconds);
+
+  static void handleInputClosure(void* clientData);
+  void handleInputClosure1();
+
+  void indexData(unsigned char const* data, unsigned dataSize);
+  void indexPacket(unsigned char const* pkt);
+  void finishIndexing();
+  void saveIndexRecords(); // from "fIndexer", into "fPendingIndexRecords"
+  void writePendingIndexRecords();
+
+private:
+  MPEG2IFrameIndexFromTransportStream* fIndexer;
+  FILE* fIndexFid;
+  Boolean fHaveFinishedIndexing;
+  unsigned char fPartialPacket[TRANSPORT_PACKET_SIZE]; // data left over from an unaligned input frame
+  unsigned fPartialPacketSize;
+  u_int8_t* fPendingIndexRecords; // not yet written, because their data hasn't yet been handled downstream
+  unsigned fPendingIndexRecordsSize, fPendingIndexRecordsBufferSize;
+};
+
+#endif
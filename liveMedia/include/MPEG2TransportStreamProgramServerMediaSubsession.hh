@@ -0,0 +1,57 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A 'ServerMediaSubsession' object that creates new, unicast, "RTPSink"s
+// on demand, from one program of a MPEG-2 Transport Stream multiplex
+// (using a "MPEG2TransportStreamProgramSplitter" that may be shared by many such subsessions)
+// C++ header
+
+#ifndef _MPEG2_TRANSPORT_STREAM_PROGRAM_SERVER_MEDIA_SUBSESSION_HH
+#define _MPEG2_TRANSPORT_STREAM_PROGRAM_SERVER_MEDIA_SUBSESSION_HH
+
+#ifndef _ON_DEMAND_SERVER_MEDIA_SUBSESSION_HH
+#include "OnDemandServerMediaSubsession.hh"
+#endif
+#ifndef _MPEG2_TRANSPORT_STREAM_PROGRAM_SPLITTER_HH
+#include "MPEG2TransportStreamProgramSplitter.hh"
+#endif
+
+class MPEG2TransportStreamProgramServerMediaSubsession: public OnDemandServerMediaSubsession {
+public:
+  static MPEG2TransportStreamProgramServerMediaSubsession*
+  createNew(UsageEnvironment& env, MPEG2TransportStreamProgramSplitter& splitter,
+	    u_int16_t programNumber);
+      // Note: "splitter" must outlive this subsession.
+protected:
+  MPEG2TransportStreamProgramServerMediaSubsession(UsageEnvironment& env,
+						   MPEG2TransportStreamProgramSplitter& splitter,
+						   u_int16_t programNumber);
+      // called only by createNew();
+  virtual ~MPEG2TransportStreamProgramServerMediaSubsession();
+
+protected: // redefined virtual functions
+  virtual FramedSource* createNewStreamSource(unsigned clientSessionId,
+					      unsigned& estBitrate);
+  virtual RTPSink* createNewRTPSink(Groupsock* rtpGroupsock,
+				    unsigned char rtpPayloadTypeIfDynamic,
+				    FramedSource* inputSource);
+protected:
+  MPEG2TransportStreamProgramSplitter& fSplitter;
+  u_int16_t fProgramNumber;
+};
+
+#endif
@@ -0,0 +1,155 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// Splits a MPEG-2 Transport Stream multiplex - in a single pass - into separate output
+// Transport Streams, one per program (or into raw packet streams, one per PID)
+// C++ header
+
+#ifndef _MPEG2_TRANSPORT_STREAM_PROGRAM_SPLITTER_HH
+#define _MPEG2_TRANSPORT_STREAM_PROGRAM_SPLITTER_HH
+
+#ifndef _FRAMED_SOURCE_HH
+#include "FramedSource.hh"
+#endif
+
+class MPEG2TransportStreamSplitterOutput; // forward
+
+typedef void MPEG2TransportStreamNewProgramHandler(void* clientData, u_int16_t programNumber);
+
+class MPEG2TransportStreamProgramSplitter: public Medium {
+public:
+  static MPEG2TransportStreamProgramSplitter*
+  createNew(UsageEnvironment& env, FramedSource* inputSource,
+	    Boolean inputSourceIsLive = True,
+	    unsigned maxQueuedPacketsPerOutput = 500);
+      // "inputSource" delivers Transport Stream packets (it need not deliver them aligned on
+      // packet boundaries).  It is closed when we are.
+      // If "inputSourceIsLive" is True (e.g., for a UDP input), the input is read continuously,
+      // and packets that arrive for an output whose queue is full are dropped.
+      // Otherwise (e.g., for a file input), the input is read only as our outputs need data
+      // (and until all of the multiplex's programs are known), and never while any output's queue is full - so
+      // no packets are dropped, but each output must be read, or it will eventually stall the others.
+
+  FramedSource* newProgramSource(u_int16_t programNumber);
+      // Returns a new source that delivers a single-program Transport Stream: the program's PMT,
+      // PCR and elementary stream packets, plus a PAT that lists only this program.
+      // The program need not have been seen yet.
+  FramedSource* newPIDSource(u_int16_t pid);
+      // Returns a new source that delivers (unmodified) all packets that have this PID.
+
+  void setNewProgramHandler(MPEG2TransportStreamNewProgramHandler* handler, void* clientData);
+      // "handler" will be called once for each program, when we first see its PMT.
+      // (It may call "newProgramSource()".)
+
+  unsigned numPrograms() const;
+  u_int16_t transportStreamId() const { return fTransportStreamId; }
+
+private:
+  MPEG2TransportStreamProgramSplitter(UsageEnvironment& env, FramedSource* inputSource,
+				      Boolean inputSourceIsLive, unsigned maxQueuedPacketsPerOutput);
+      // called only by createNew()
+  virtual ~MPEG2TransportStreamProgramSplitter();
+
+  class PIDEntry; class ProgramInfo; // forward
+
+  void readInput();
+  static void afterGettingInput(void* clientData, unsigned frameSize,
+				unsigned numTruncatedBytes,
+				struct timeval presentationTime,
+				unsigned durationInMicroseconds);
+  void afterGettingInput1(unsigned frameSize);
+  static void handleInputClosure(void* clientData);
+  void handleInputClosure1();
+
+  void handlePacket(u_int8_t const* packet);
+  void parsePSIPacket(u_int16_t pid, u_int8_t const* packet);
+  void addToSection(PIDEntry& entry, u_int8_t const* data, unsigned dataSize);
+  void parseSection(u_int16_t pid, u_int8_t const* section, unsigned sectionSize);
+  void parsePAT(u_int8_t const* section, unsigned sectionSize);
+  void parsePMT(u_int8_t const* section, unsigned sectionSize);
+
+  ProgramInfo* lookupProgram(u_int16_t programNumber) const;
+  Boolean programTableIsComplete() const;
+  Boolean someOutputNeedsData() const;
+  Boolean someOutputQueueIsFull() const;
+  void rebuildPIDTable();
+
+private:
+  friend class MPEG2TransportStreamSplitterOutput;
+  FramedSource* addOutput(MPEG2TransportStreamSplitterOutput* output);
+  void removeOutput(MPEG2TransportStreamSplitterOutput* output);
+
+private:
+  FramedSource* fInputSource;
+  Boolean fInputSourceIsLive;
+  unsigned fMaxQueuedPacketsPerOutput;
+  unsigned char* fInputBuffer;
+  unsigned fNumLeftoverBytes; // of a partial packet, at the start of "fInputBuffer"
+  Boolean fIsReadingInput, fIsProcessingInput, fInputIsClosed;
+
+  PIDEntry* fPIDTable; // indexed by PID; tells us what to do with each incoming packet
+  HashTable* fPrograms; // maps program_number to "ProgramInfo"
+  int fPATVersion; // -1 until we've seen a PAT
+  u_int16_t fTransportStreamId;
+
+  MPEG2TransportStreamSplitterOutput* fOutputs; // a linked list
+  MPEG2TransportStreamNewProgramHandler* fNewProgramHandler;
+  void* fNewProgramHandlerClientData;
+};
+
+class MPEG2TransportStreamSplitterOutput: public FramedSource {
+public:
+  u_int16_t programNumber() const { return fProgramNumber; } // 0 for a per-PID output
+  u_int16_t pid() const { return fPID; }
+  unsigned numPacketsDropped() const { return fNumPacketsDropped; }
+      // because our queue was full when they arrived (this happens only with a live input)
+
+private: // We are created only by a MPEG2TransportStreamProgramSplitter (a friend)
+  MPEG2TransportStreamSplitterOutput(UsageEnvironment& env,
+				     MPEG2TransportStreamProgramSplitter& splitter,
+				     u_int16_t programNumber, u_int16_t pid);
+  virtual ~MPEG2TransportStreamSplitterOutput();
+
+  void setPMTPID(u_int16_t pmtPID);
+  void enqueuePacket(u_int8_t const* packet);
+  void scheduleDelivery();
+  static void deliver(void* clientData);
+  void deliverQueuedPackets();
+
+private:
+  // redefined virtual functions:
+  virtual void doGetNextFrame();
+  virtual void doStopGettingFrames();
+
+private:
+  friend class MPEG2TransportStreamProgramSplitter;
+  MPEG2TransportStreamProgramSplitter* fSplitter; // NULL if the splitter has gone away
+  MPEG2TransportStreamSplitterOutput* fNext;
+  u_int16_t fProgramNumber, fPID, fPMTPID;
+
+  // Our own (single-program) PAT, which replaces the multiplex's PAT:
+  unsigned char fPATPacket[188];
+  Boolean fHavePATPacket;
+  u_int8_t fPATVersion, fPATContinuityCounter;
+
+  // A ring buffer of queued Transport Stream packets:
+  unsigned char* fQueue;
+  unsigned fQueueSize, fQueueHead, fNumQueuedPackets; // in packets
+  unsigned fNumPacketsDropped;
+};
+
+#endif
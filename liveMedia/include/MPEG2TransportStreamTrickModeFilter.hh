@@ -39,7 +39,10 @@ class MPEG2TransportStreamTrickModeFilter: public FramedFilter {
 public:
   static MPEG2TransportStreamTrickModeFilter*
   createNew(UsageEnvironment& env, FramedSource* inputSource,
-	    MPEG2TransportStreamIndexFile* indexFile, int scale);
+	    MPEG2TransportStreamIndexFile* indexFile, int scale, Boolean useMemoryMapping = True);
+      // If "useMemoryMapping" is True (the default), the input Transport Stream file is mapped into memory (if the OS
+      // allows), so that we can deliver data from it without a seek+read of each Transport Stream packet.  (Set it to
+      // False if the file might be truncated or replaced - rather than appended to - while it's being played.)
 
   Boolean seekTo(unsigned long tsPacketNumber, unsigned long indexRecordNumber);
 
@@ -50,7 +53,7 @@ public:
 
 protected:
   MPEG2TransportStreamTrickModeFilter(UsageEnvironment& env, FramedSource* inputSource,
-				      MPEG2TransportStreamIndexFile* indexFile, int scale);
+				      MPEG2TransportStreamIndexFile* indexFile, int scale, Boolean useMemoryMapping);
       // called only by createNew()
   virtual ~MPEG2TransportStreamTrickModeFilter();
 
@@ -60,7 +63,11 @@ private:
   virtual void doStopGettingFrames();
 
 private:
+  Boolean haveNextIndexRecord();
+      // reads index records until one needs to be delivered (returns True), or the index file ends (returns False)
   void attemptDeliveryToClient();
+  Boolean canDeliverFromMappedFile(unsigned long tsPacketNum, u_int8_t dataOffset, u_int8_t dataSize) const;
+  void deliverFromMappedFile();
   void seekToTransportPacket(unsigned long tsPacketNum);
   void readTransportPacket(unsigned long tsPacketNum); // asynchronously
 
@@ -94,6 +101,8 @@ private:
   unsigned long fSavedFrameIndexRecordStart;
   unsigned long fSavedSequentialIndexRecordNum;
   Boolean fUseSavedFrameNextTime;
+  u_int8_t* fMappedTSFile; // the input Transport Stream file, if it could be mapped into memory; otherwise NULL
+  u_int64_t fMappedTSFileSize;
 };
 
 #endif
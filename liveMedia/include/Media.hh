@@ -125,6 +125,11 @@ public:
 
   MediaLookupTable* mediaTable;
   void* socketTable;
+  void* rtcpReportScheduler;
+  void* frameTraceBuffer;
+  void* serverPortAllocator;
+  void* asyncFileReader;
+  void* fileBlockCache;
 
 protected:
   _Tables(UsageEnvironment& env);
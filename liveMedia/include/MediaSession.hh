@@ -180,6 +180,9 @@ public:
   RTCPInstance* rtcpInstance() { return fRTCPInstance; }
   unsigned rtpTimestampFrequency() const { return fRTPTimestampFrequency; }
   Boolean rtcpIsMuxed() const { return fMultiplexRTCPWithRTP; }
+  Boolean senderSupportsNACKs() const { return fSenderSupportsNACKs; }
+      // True iff the SDP description had a "a=rtcp-fb:... nack" line.  If so, "initiate()" has our
+      // "RTCPInstance" send NACKs for lost packets (see "RTCPInstance::enableNACKs()").
   FramedSource* readSource() { return fReadSource; }
     // This is the source that client sinks read from.  It is usually
     // (but not necessarily) the same as "rtpSource()"
@@ -283,6 +286,7 @@ protected:
   Boolean parseSDPLine_b(char const* sdpLine);
   Boolean parseSDPAttribute_rtpmap(char const* sdpLine);
   Boolean parseSDPAttribute_rtcpmux(char const* sdpLine);
+  Boolean parseSDPAttribute_rtcpfb(char const* sdpLine);
   Boolean parseSDPAttribute_control(char const* sdpLine);
   Boolean parseSDPAttribute_range(char const* sdpLine);
   Boolean parseSDPAttribute_fmtp(char const* sdpLine);
@@ -309,6 +313,7 @@ protected:
   char* fProtocolName;
   unsigned fRTPTimestampFrequency;
   Boolean fMultiplexRTCPWithRTP;
+  Boolean fSenderSupportsNACKs;
   char* fControlPath; // holds optional a=control: string
   struct in_addr fSourceFilterAddr; // used for SSM
   unsigned fBandwidth; // in kilobits-per-second, from b= line
@@ -46,6 +46,9 @@ public:
   virtual Boolean isJPEGVideoSource() const;
   virtual Boolean isAMRAudioSource() const;
   virtual Boolean isMPEG2TransportStreamMultiplexor() const;
+  virtual Boolean isMPEG2TransportStreamFramer() const;
+  virtual Boolean isByteStreamFileSource() const;
+  virtual Boolean isRTPHintFileSource() const;
 
 protected:
   MediaSource(UsageEnvironment& env); // abstract base class
@@ -30,6 +30,11 @@ class BufferedPacket; // forward
 class BufferedPacketFactory; // forward
 
 class MultiFramedRTPSource: public RTPSource {
+public:
+  void injectPacket(unsigned char const* packet, unsigned packetSize);
+      // Processes "packet" (a complete RTP packet) as if it had just been read from the network.
+      // (This is used, for example, to deliver packets that have been recovered using FEC.)
+
 protected:
   MultiFramedRTPSource(UsageEnvironment& env, Groupsock* RTPgs,
 		       unsigned char rtpPayloadFormat,
@@ -59,6 +64,9 @@ protected:
 private:
   // redefined virtual functions:
   virtual void setPacketReorderingThresholdTime(unsigned uSeconds);
+  virtual void setAdaptivePacketReorderingThresholdTime(unsigned minUSeconds, unsigned maxUSeconds);
+  virtual unsigned packetReorderingThresholdTime() const;
+  virtual unsigned numLatePacketsDropped() const;
 
 private:
   void reset();
@@ -69,6 +77,8 @@ private:
 
   Boolean fAreDoingNetworkReads;
   BufferedPacket* fPacketReadInProgress;
+  unsigned char const* fPacketToInject;
+  unsigned fPacketToInjectSize;
   Boolean fNeedDelivery;
   Boolean fPacketLossInFragmentedFrame;
   unsigned char* fSavedTo;
@@ -92,6 +102,7 @@ public:
   unsigned useCount() const { return fUseCount; }
 
   Boolean fillInData(RTPInterface& rtpInterface, struct sockaddr_in& fromAddress, Boolean& packetReadWasIncomplete);
+  Boolean fillInData(unsigned char const* packet, unsigned packetSize);
   void assignMiscParams(unsigned short rtpSeqNo, unsigned rtpTimestamp,
 			struct timeval presentationTime,
 			Boolean hasBeenSyncedUsingRTCP,
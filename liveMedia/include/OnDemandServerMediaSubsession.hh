@@ -109,6 +109,23 @@ public:
   void multiplexRTCPWithRTP() { fMultiplexRTCPWithRTP = True; }
     // An alternative to passing the "multiplexRTCPWithRTP" parameter as True in the constructor
 
+  void useSharedServerPorts() { fUseSharedServerPorts = True; }
+    // Makes all future clients that stream RTP over UDP (if "reuseFirstSource" was False) share a single pair of
+    // server ports (and thus sockets), rather than each client having its own.  Each client's RTP and RTCP packets
+    // are sent only to it, and incoming RTCP reports are given to the appropriate client's stream, based on the
+    // address and port that they came from.  This keeps the number of sockets constant, however many clients we have.
+
+  void enableCongestionResponse() { fEnableCongestionResponse = True; }
+    // Makes the "RTPSink"s that we create for future clients respond to congestion (as reported by each client's RTCP
+    // "RR"s, or by its TCP send queue) by sending less - e.g., by dropping non-reference H.264/5 frames.
+    // (See "RTPCongestionMonitor.hh".)  Only some "RTPSink"s (currently, only H.264 and H.265 "RTPSink"s that
+    // packetize frames themselves) can do this; for others (e.g., "HintedRTPSink"), this has no effect.
+
+  void enableRetransmissions() { fEnableRetransmissions = True; }
+    // Makes the "RTPSink"s that we create for future clients keep a short history of sent packets, and resend those
+    // that a client reports lost (in a RTCP generic NACK).  Our SDP description then also advertises
+    // "a=rtcp-fb:... nack" and "a=rtcp-fb:... nack pli".
+
   void setRTCPAppPacketHandler(RTCPAppHandlerFunc* handler, void* clientData);
     // Sets a handler to be called if a RTCP "APP" packet arrives from any future client.
     // (Any current clients are not affected; any "APP" packets from them will continue to be
@@ -129,6 +146,15 @@ private:
   void setSDPLinesFromRTPSink(RTPSink* rtpSink, FramedSource* inputSource,
 			      unsigned estBitrate);
       // used to implement "sdpLines()"
+  void createRTPandRTCPGroupsocks(Groupsock*& rtpGroupsock, Groupsock*& rtcpGroupsock,
+				  Port& serverRTPPort, Port& serverRTCPPort);
+      // used to implement "getStreamParameters()"
+
+  // Used to implement "useSharedServerPorts()":
+  void startReadingSharedRTCPGroupsock();
+  static void incomingSharedRTCPHandler(OnDemandServerMediaSubsession* subsession, int mask);
+  void incomingSharedRTCPHandler1();
+  void releaseSharedGroupsocks();
 
 protected:
   char* fSDPLines;
@@ -142,6 +168,14 @@ private:
   char fCNAME[100]; // for RTCP
   RTCPAppHandlerFunc* fAppHandlerTask;
   void* fAppHandlerClientData;
+  Boolean fUseSharedServerPorts;
+  Groupsock* fSharedRTPgs;
+  Groupsock* fSharedRTCPgs;
+  Port fSharedServerRTPPort, fSharedServerRTCPPort;
+  unsigned fNumSharedGroupsockUsers;
+  AddressPortLookupTable* fSharedRTCPClientTable; // maps each client's RTCP address+port to its "StreamState"
+  Boolean fEnableCongestionResponse;
+  Boolean fEnableRetransmissions;
   friend class StreamState;
 };
 
@@ -203,6 +237,8 @@ public:
   FramedSource* mediaSource() const { return fMediaSource; }
   float& startNPT() { return fStartNPT; }
 
+  Boolean usesSharedGroupsocks() const { return fRTPgs != NULL && fRTPgs == fMaster.fSharedRTPgs; }
+
 private:
   OnDemandServerMediaSubsession& fMaster;
   Boolean fAreCurrentlyPlaying;
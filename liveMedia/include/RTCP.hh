@@ -104,6 +104,17 @@ public:
       // of "name" are used.  (If "name" has fewer than 4 bytes, or is NULL,
       // then the remaining bytes are '\0'.)
 
+  // Feedback messages (RFC 4585), used by receivers (i.e., if we have a "RTPSource"):
+  void sendNACK(u_int16_t firstLostSeqNum, unsigned numLostPackets);
+      // Sends a generic NACK, asking the sender to retransmit the given (consecutive) RTP packets.
+  void sendPLI();
+      // Sends a 'Picture Loss Indication', asking the sender for a new key frame.
+  void enableNACKs(Boolean enable = True);
+      // If enabled, we send a generic NACK as soon as our "RTPSource" sees a gap in the incoming RTP sequence
+      // numbers.  (For retransmitted packets to be useful, the source's 'packet reordering threshold time'
+      // should be at least the round-trip time to the sender; see "RTPSource::setPacketReorderingThresholdTime()".)
+  // (Incoming NACKs, PLIs and FIRs are handled automatically, if we have a "RTPSink".)
+
   Groupsock* RTCPgs() const { return fRTCPInterface.gs(); }
 
   void setStreamSocket(int sockNum, unsigned char streamChannelId);
@@ -113,6 +124,12 @@ public:
   }
     // hacks to allow sending RTP over TCP (RFC 2236, section 10.12)
 
+  void setUnicastDestination(struct in_addr const& addr, Port const& port) {
+    fRTCPInterface.setUnicastDestination(addr, port);
+  }
+    // used if our 'groupsock' is shared with other "RTCPInstance"s (each sending to a different client).
+    // (Incoming reports must then be given to us using "injectReport()".)
+
   void setAuxilliaryReadHandler(AuxHandlerFunc* handlerFunc,
                                 void* handlerClientData) {
     fRTCPInterface.setAuxilliaryReadHandler(handlerFunc,
@@ -149,17 +166,21 @@ private:
         void enqueueReportBlock(RTPReceptionStats* receptionStats);
   void addSDES();
   void addBYE(char const* reason);
+  void addFeedbackPrefix(unsigned char packetType, u_int8_t fmt, unsigned numFCIWords);
 
   void sendBuiltPacket();
 
   static void onExpire(RTCPInstance* instance);
   void onExpire1();
+  friend class RTCPReportScheduler;
 
   static void incomingReportHandler(RTCPInstance* instance, int /*mask*/);
   void processIncomingReport(unsigned packetSize, struct sockaddr_in const& fromAddressAndPort,
 			     int tcpSocketNum, unsigned char tcpStreamChannelId);
   void onReceive(int typeOfPacket, int totPacketSize, u_int32_t ssrc);
 
+  static void packetLossHandler(void* clientData, u_int16_t firstLostSeqNum, unsigned numLostPackets);
+
 private:
   u_int8_t* fInBuf;
   unsigned fNumBytesAlreadyRead;
@@ -178,6 +199,7 @@ private:
   int fIsInitial;
   double fPrevReportTime;
   double fNextReportTime;
+  int fReportSchedulerIndex; // our position in our environment's "RTCPReportScheduler" (-1 if not scheduled)
   int fPrevNumMembers;
 
   int fLastSentSize;
@@ -199,6 +221,7 @@ private:
   AddressPortLookupTable* fSpecificRRHandlerTable;
   RTCPAppHandlerFunc* fAppHandlerTask;
   void* fAppHandlerClientData;
+  Boolean fNACKsAreEnabled;
 
 public: // because this stuff is used by an external "C" function
   void schedule(double nextTime);
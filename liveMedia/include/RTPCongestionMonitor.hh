@@ -0,0 +1,96 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A per-"RTPSink" monitor that decides - from RTCP "RR" reports (loss and jitter) and, for RTP-over-TCP,
+// the depth of the TCP send queue - how much (if at all) the sender should reduce what it sends.
+// C++ header
+
+#ifndef _RTP_CONGESTION_MONITOR_HH
+#define _RTP_CONGESTION_MONITOR_HH
+
+#ifndef _BOOLEAN_HH
+#include "Boolean.hh"
+#endif
+#ifndef _NET_COMMON_H
+#include "NetCommon.h"
+#endif
+
+// Congestion response levels (each includes the ones before it):
+#define CONGESTION_RESPONSE_NONE 0
+#define CONGESTION_RESPONSE_DROP_DISPOSABLE 1 // drop frames that no other frame refers to
+#define CONGESTION_RESPONSE_KEY_FRAMES_ONLY 2 // drop everything but key frames (and parameter sets)
+
+class RTPSink; // forward
+class RTPTransmissionStats; // forward
+
+typedef void CongestionLevelChangeHandler(void* clientData, unsigned newLevel);
+
+class RTPCongestionMonitor {
+public:
+  unsigned level();
+      // The current response level (one of the "CONGESTION_RESPONSE_*" values).  This is the higher of the level
+      // implied by recent "RR" reports, and the level implied by the current TCP send queue depth (if any).
+
+  void setLevelChangeHandler(CongestionLevelChangeHandler* handler, void* clientData);
+      // "handler" is called whenever the level changes - e.g., so that the application can switch this
+      // client to a lower- (or back to a higher-) bitrate rendition of the stream.
+
+  // Thresholds (with reasonable defaults):
+  void setLossThresholds(u_int8_t highLossRatio, u_int8_t lowLossRatio) {
+    fHighLossRatio = highLossRatio; fLowLossRatio = lowLossRatio;
+  }
+      // 8-bit fixed-point fractions (as in RTCP "RR"s): A "RR" reporting loss >= "highLossRatio" raises the level;
+      // one reporting loss <= "lowLossRatio" (and no jitter problem) counts towards lowering it.
+  void setHighJitter(unsigned highJitterMs) { fHighJitterMs = highJitterMs; }
+      // A "RR" reporting jitter >= this (or a jitter that keeps rising beyond half of this) raises the level.
+  void setTCPSendQueueThreshold(unsigned numBytes) { fTCPSendQueueThreshold = numBytes; }
+      // A TCP send queue at least this deep implies "CONGESTION_RESPONSE_KEY_FRAMES_ONLY";
+      // one at least a quarter this deep implies "CONGESTION_RESPONSE_DROP_DISPOSABLE".
+  void setNumGoodReportsToRelax(unsigned numReports) { fNumGoodReportsToRelax = numReports; }
+      // How many consecutive 'good' "RR"s are needed to lower the level by one.
+
+  // Statistics:
+  void noteFrameDropped() { ++fNumFramesDropped; }
+  unsigned numFramesDropped() const { return fNumFramesDropped; }
+
+private: // called only by "RTPSink" and "RTPTransmissionStats":
+  friend class RTPSink;
+  friend class RTPTransmissionStats;
+  RTPCongestionMonitor(RTPSink& rtpSink);
+  virtual ~RTPCongestionMonitor();
+
+  void noteIncomingRR(RTPTransmissionStats const& stats);
+
+private:
+  unsigned tcpLevel();
+  void checkForLevelChange();
+
+private:
+  RTPSink& fOurRTPSink;
+  u_int8_t fHighLossRatio, fLowLossRatio;
+  unsigned fHighJitterMs, fTCPSendQueueThreshold, fNumGoodReportsToRelax;
+  unsigned fRRLevel, fNumGoodReports;
+  unsigned fPrevJitterMs, fNumJitterRises;
+  unsigned fTCPLevel, fPrevNumTCPBlockingSends;
+  struct timeval fLastTCPCheckTime;
+  unsigned fCurrentLevel;
+  CongestionLevelChangeHandler* fLevelChangeHandler;
+  void* fLevelChangeHandlerClientData;
+  unsigned fNumFramesDropped;
+};
+
+#endif
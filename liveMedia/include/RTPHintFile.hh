@@ -0,0 +1,166 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// RTP 'hint files': pre-packetized RTP payloads (with their timestamps and marker bits) for a media file,
+// built once, so that a server can stream the file without re-parsing and re-packetizing it for each client.
+// (This is similar in spirit to a QuickTime/MP4 'hint track'.)
+// C++ header
+
+#ifndef _RTP_HINT_FILE_HH
+#define _RTP_HINT_FILE_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+#ifndef _RTP_SINK_HH
+#include "RTPSink.hh"
+#endif
+
+// The layout of a hint file (by convention, named "<media-file-name>.rtph") is:
+//   - a "RTPHintFileHeader" (RTP_HINT_FILE_HEADER_SIZE bytes)
+//   - the RTP payloads (i.e., without RTP headers), back-to-back
+//   - the record table ("numRecords" "RTPHintRecord"s, one per packet), starting at "recordsOffset"
+//   - the SDP 'a=' line(s) (if any) that the original "RTPSink" added, '\0'-terminated, at "auxSDPLineOffset"
+// All integers are in host byte order (hint files are built on the server that will use them).
+// The header also records the size and modification time of the media file, so that a hint file that's older than
+// its media file can be recognized - and ignored.
+// The RTP header fields that differ between clients (SSRC, sequence number, timestamp base) are not stored;
+// the streaming "RTPSink" generates these itself.
+
+#define RTP_HINT_FILE_MAGIC "LRTH"
+#define RTP_HINT_FILE_VERSION 2
+#define RTP_HINT_FILE_HEADER_SIZE 128
+
+typedef struct RTPHintFileHeader {
+  char magic[4];
+  u_int32_t version;
+  u_int32_t headerSize;
+  u_int32_t recordSize;
+  u_int64_t recordsOffset;
+  u_int64_t auxSDPLineOffset;
+  u_int32_t numRecords;
+  u_int32_t maxPayloadSize;
+  u_int64_t durationUSecs;
+  u_int64_t totalPayloadBytes;
+  u_int32_t timestampFrequency;
+  u_int32_t auxSDPLineSize; // including the trailing '\0'; 0 if there's no such line
+  u_int8_t rtpPayloadType; // as used when the file was built; >= 96 means 'dynamic'
+  u_int8_t numChannels;
+  u_int8_t pad[6];
+  char mediumName[16]; // '\0'-terminated, e.g. "video"
+  char rtpPayloadFormatName[24]; // '\0'-terminated, e.g. "H264"
+  u_int64_t sourceFileSize; // of the media file, when the hint file was built
+  int64_t sourceFileModTime; // of the media file (in seconds since the epoch), when the hint file was built
+} RTPHintFileHeader;
+
+// Record flags:
+#define RTP_HINT_MARKER 0x01 // the packet had the RTP 'M' bit set
+#define RTP_HINT_FRAME_START 0x02 // the packet is the first with its RTP timestamp
+#define RTP_HINT_RANDOM_ACCESS 0x04 // a client can start decoding at this packet (e.g., a H.264/5 key frame)
+
+typedef struct RTPHintRecord {
+  u_int64_t payloadOffset; // within the hint file
+  u_int64_t presentationTimeUSecs; // relative to the first packet
+  u_int16_t payloadSize;
+  u_int8_t flags;
+  u_int8_t pad[5];
+} RTPHintRecord;
+
+
+class RTPHintFile: public Medium {
+public:
+  static RTPHintFile* createNew(UsageEnvironment& env, char const* hintFileName,
+			        char const* sourceFileName = NULL);
+      // Maps the hint file into memory.  Returns NULL (after setting the result message) if the file
+      // cannot be opened or mapped, or isn't a valid hint file.
+      // If "sourceFileName" (the media file that the hint file was built from) is given, we also return NULL if that
+      // file's size or modification time differs from that recorded in the hint file (i.e., if the hint file is stale).
+
+  RTPHintFileHeader const& header() const { return *fHeader; }
+  unsigned numRecords() const { return fHeader->numRecords; }
+  RTPHintRecord const& record(unsigned recordNum) const { return fRecords[recordNum]; }
+  u_int8_t const* payload(RTPHintRecord const& rec) const { return &fMapping[rec.payloadOffset]; }
+  char const* auxSDPLine() const; // NULL if none
+  double duration() const { return fHeader->durationUSecs/1000000.0; }
+
+  unsigned lookupRecordNumFromNPT(double& npt) const;
+      // Returns the number of the latest 'random access' record whose presentation time is <= "npt"
+      // (or 0, if there's none), and updates "npt" to that record's presentation time.
+
+protected:
+  RTPHintFile(UsageEnvironment& env, u_int8_t* mapping, u_int64_t fileSize);
+      // called only by createNew()
+  virtual ~RTPHintFile();
+
+private:
+  u_int8_t* fMapping;
+  u_int64_t fFileSize;
+  RTPHintFileHeader const* fHeader;
+  RTPHintRecord const* fRecords;
+};
+
+
+// A "Groupsock" that - rather than sending the RTP packets that are written to it - records them in a
+// new hint file.  To build a hint file, create one of these, create the usual "RTPSink" for the media
+// type using it, play the sink (as fast as possible) from the media file, then call "finishHintFile()":
+
+class RTPHintFileWriter: public Groupsock {
+public:
+  static RTPHintFileWriter* createNew(UsageEnvironment& env, char const* hintFileName,
+				      char const* rtpPayloadFormatName, char const* sourceFileName = NULL);
+      // "rtpPayloadFormatName" is used only to recognize 'random access' packets (for "H264" and "H265";
+      // for other formats, each frame is a random access point).  Returns NULL if the file can't be created.
+      // "sourceFileName" is the media file that's being hinted; its current size and modification time are recorded
+      // in the hint file.
+  virtual ~RTPHintFileWriter();
+
+  Boolean finishHintFile(RTPSink& sink);
+      // Writes the record table, aux SDP line, and header (from "sink"'s parameters), and closes the file.
+      // Returns False if a write failed.
+
+  unsigned numRecords() const { return fNumRecords; }
+
+protected:
+  RTPHintFileWriter(UsageEnvironment& env, struct in_addr const& dummyAddr, FILE* fid,
+		    char const* rtpPayloadFormatName, u_int64_t sourceFileSize, int64_t sourceFileModTime);
+      // called only by createNew()
+
+private: // redefined virtual functions:
+  virtual Boolean output(UsageEnvironment& env, unsigned char* buffer, unsigned bufferSize,
+			 DirectedNetInterface* interfaceNotToFwdBackTo = NULL);
+
+private:
+  Boolean isRandomAccessPayload(u_int8_t const* payload, unsigned payloadSize) const;
+  void addRecord(RTPHintRecord const& rec);
+
+private:
+  FILE* fFid;
+  int fCodec; // 0: other; 264: H.264; 265: H.265
+  u_int64_t fNextPayloadOffset;
+  u_int32_t fMaxPayloadSize;
+  Boolean fHaveSeenPacket, fWriteFailed;
+  u_int32_t fPrevTimestamp;
+  int64_t fTimestampOffset; // in RTP timestamp units, relative to the first packet
+  unsigned fCurFrameStartRecordNum;
+  unsigned fNumFrames;
+  u_int64_t fSourceFileSize;
+  int64_t fSourceFileModTime;
+  RTPHintRecord* fRecords; // note: "presentationTimeUSecs" holds the timestamp offset until "finishHintFile()"
+  unsigned fNumRecords, fRecordsSize;
+};
+
+#endif
@@ -0,0 +1,59 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A 'ServerMediaSubsession' object that creates new, unicast, "RTPSink"s
+// on demand, from a RTP hint file (i.e., from payloads that were packetized in advance)
+// C++ header
+
+#ifndef _RTP_HINT_FILE_SERVER_MEDIA_SUBSESSION_HH
+#define _RTP_HINT_FILE_SERVER_MEDIA_SUBSESSION_HH
+
+#ifndef _FILE_SERVER_MEDIA_SUBSESSION_HH
+#include "FileServerMediaSubsession.hh"
+#endif
+#ifndef _RTP_HINT_FILE_HH
+#include "RTPHintFile.hh"
+#endif
+
+class RTPHintFileServerMediaSubsession: public FileServerMediaSubsession {
+public:
+  static RTPHintFileServerMediaSubsession*
+  createNew(UsageEnvironment& env, char const* hintFileName, Boolean reuseFirstSource,
+	    char const* sourceFileName = NULL);
+      // Returns NULL if "hintFileName" is not a valid hint file - or, if "sourceFileName" (the media file that the
+      // hint file was built from) is given, if that file has changed since the hint file was built.
+
+protected:
+  RTPHintFileServerMediaSubsession(UsageEnvironment& env, char const* hintFileName,
+				   RTPHintFile* hintFile, Boolean reuseFirstSource);
+      // called only by createNew();
+  virtual ~RTPHintFileServerMediaSubsession();
+
+protected: // redefined virtual functions
+  virtual void seekStreamSource(FramedSource* inputSource, double& seekNPT, double streamDuration, u_int64_t& numBytes);
+  virtual float duration() const;
+  virtual FramedSource* createNewStreamSource(unsigned clientSessionId,
+					      unsigned& estBitrate);
+  virtual RTPSink* createNewRTPSink(Groupsock* rtpGroupsock,
+                                    unsigned char rtpPayloadTypeIfDynamic,
+				    FramedSource* inputSource);
+
+private:
+  RTPHintFile* fHintFile; // mapped once, and shared by all of our clients
+};
+
+#endif
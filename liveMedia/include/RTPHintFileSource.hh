@@ -0,0 +1,64 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A source that delivers - one at a time - the pre-packetized RTP payloads from a RTP hint file.
+// (Used with a "HintedRTPSink".)
+// C++ header
+
+#ifndef _RTP_HINT_FILE_SOURCE_HH
+#define _RTP_HINT_FILE_SOURCE_HH
+
+#ifndef _FRAMED_SOURCE_HH
+#include "FramedSource.hh"
+#endif
+#ifndef _RTP_HINT_FILE_HH
+#include "RTPHintFile.hh"
+#endif
+
+class RTPHintFileSource: public FramedSource {
+public:
+  static RTPHintFileSource* createNew(UsageEnvironment& env, RTPHintFile* hintFile);
+      // Note: "hintFile" is not owned by us; it must outlive this object.
+
+  void seekToTime(double& seekNPT);
+      // Moves to the latest random access point at or before "seekNPT" (and updates "seekNPT" to its time).
+
+  u_int8_t lastPayloadFlags() const { return fLastPayloadFlags; }
+      // the "RTP_HINT_*" flags of the most recently delivered payload
+
+  RTPHintFile* hintFile() const { return fHintFile; }
+
+protected:
+  RTPHintFileSource(UsageEnvironment& env, RTPHintFile* hintFile);
+      // called only by createNew()
+  virtual ~RTPHintFileSource();
+
+private:
+  // redefined virtual functions:
+  virtual void doGetNextFrame();
+  virtual Boolean isRTPHintFileSource() const;
+
+private:
+  RTPHintFile* fHintFile;
+  unsigned fNextRecordNum;
+  Boolean fNeedBaseTime;
+  struct timeval fBaseTime; // the presentation time of record "fBaseRecordNum"
+  u_int64_t fBasePTUSecs; // that record's (relative) presentation time
+  u_int8_t fLastPayloadFlags;
+};
+
+#endif
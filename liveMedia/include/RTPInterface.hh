@@ -66,6 +66,11 @@ public:
 						     ServerRequestAlternativeByteHandler* handler, void* clientData);
   static void clearServerRequestAlternativeByteHandler(UsageEnvironment& env, int socketNum);
 
+  void setUnicastDestination(struct in_addr const& addr, Port const& port);
+      // Used if our 'groupsock' is shared with other "RTPInterface"s (each sending to a different client).
+      // We then send UDP packets only to this destination (rather than to all of the groupsock's destinations),
+      // and we never start or stop reading from the groupsock's socket (the groupsock's owner does that).
+
   Boolean sendPacket(unsigned char* packet, unsigned packetSize);
   void startNetworkReading(TaskScheduler::BackgroundHandlerProc*
                            handlerProc);
@@ -91,6 +96,12 @@ public:
     fAuxReadHandlerClientData = handlerClientData;
   }
 
+  // Statistics about RTP/RTCP-over-TCP sending (e.g., for monitoring):
+  unsigned tcpSendQueueDepth() const;
+      // the number of bytes currently queued (unsent) in the OS for our TCP sockets (if known; otherwise 0)
+  unsigned numTCPBlockingSends() const { return fNumTCPBlockingSends; }
+      // the number of times that a TCP send buffer filled up, so that we had to wait (blocking) to send
+
   void forgetOurGroupsock() { fGS = NULL; }
     // This may be called - *only immediately prior* to deleting this - to prevent our destructor
     // from turning off background reading on the 'groupsock'.  (This is in case the 'groupsock'
@@ -116,6 +127,12 @@ private:
 
   AuxHandlerFunc* fAuxReadHandlerFunc;
   void* fAuxReadHandlerClientData;
+
+  unsigned fNumTCPBlockingSends;
+
+  Boolean fHaveUnicastDestination;
+  struct in_addr fUnicastDestinationAddr;
+  Port fUnicastDestinationPort;
 };
 
 #endif
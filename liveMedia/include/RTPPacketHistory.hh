@@ -0,0 +1,58 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A ring of recently sent (or received) RTP packets, indexed by RTP sequence number
+// (used for retransmission, and for FEC recovery).
+// C++ header
+
+#ifndef _RTP_PACKET_HISTORY_HH
+#define _RTP_PACKET_HISTORY_HH
+
+#ifndef _NET_COMMON_H
+#include "NetCommon.h"
+#endif
+#ifndef _BOOLEAN_HH
+#include "Boolean.hh"
+#endif
+
+class RTPPacketHistory {
+public:
+  RTPPacketHistory(unsigned maxNumPackets, unsigned maxPacketAgeMs = 0);
+      // "maxPacketAgeMs" == 0 means that packets never get too old to be looked up (until they're overwritten)
+  virtual ~RTPPacketHistory();
+
+  void savePacket(unsigned char const* packet, unsigned packetSize);
+      // "packet" is a complete RTP packet (including the RTP header)
+  unsigned char const* lookupPacket(u_int16_t seqNum, unsigned& packetSize) const;
+      // returns NULL if the packet is no longer (or was never) in the history
+  Boolean hasPacket(u_int16_t seqNum) const {
+    unsigned packetSize; return lookupPacket(seqNum, packetSize) != NULL;
+  }
+
+private:
+  struct Slot {
+    unsigned char* data;
+    unsigned size, bufferSize;
+    u_int16_t seqNum;
+    struct timeval timeSaved;
+  };
+  Slot* fSlots;
+  unsigned fNumSlots;
+  unsigned fMaxPacketAgeMs;
+};
+
+#endif
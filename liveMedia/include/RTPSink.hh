@@ -29,6 +29,8 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #endif
 
 class RTPTransmissionStatsDB; // forward
+class RTPCongestionMonitor; // forward
+class RTPPacketHistory; // forward
 
 class RTPSink: public MediaSink {
 public:
@@ -84,11 +86,45 @@ public:
   void removeStreamSocket(int sockNum, unsigned char streamChannelId) {
     fRTPInterface.removeStreamSocket(sockNum, streamChannelId);
   }
+  void setUnicastDestination(struct in_addr const& addr, Port const& port) {
+    fRTPInterface.setUnicastDestination(addr, port);
+  }
+    // used if our 'groupsock' is shared with other "RTPSink"s (each sending to a different client)
   unsigned& estimatedBitrate() { return fEstimatedBitrate; } // kbps; usually 0 (i.e., unset)
 
   u_int32_t SSRC() const {return fSSRC;}
      // later need a means of changing the SSRC if there's a collision #####
 
+  // Statistics about our transmission (e.g., for monitoring):
+  unsigned numPacketsSent() const { return fPacketCount; }
+  unsigned numOctetsSent() const { return fOctetCount; } // payload only (not incl RTP hdr)
+  unsigned numPacketsDropped() const { return fNumPacketsDropped; } // packets that we failed to send
+  unsigned numTruncatedFrames() const { return fNumTruncatedFrames; } // input frames too large for our buffer
+  unsigned tcpSendQueueDepth() const { return fRTPInterface.tcpSendQueueDepth(); } // bytes; RTP-over-TCP only
+  unsigned numTCPBlockingSends() const { return fRTPInterface.numTCPBlockingSends(); } // RTP-over-TCP only
+
+  // Sender-side congestion response (off by default):
+  void enableCongestionResponse(Boolean enable = True);
+      // If enabled, we monitor RTCP "RR"s (and the TCP send queue, if any), and subclasses that know how may then
+      // reduce what they send (e.g., by dropping non-reference frames) when the receiver(s) appear to be congested.
+  RTPCongestionMonitor* congestionMonitor() const { return fCongestionMonitor; } // NULL if not enabled
+
+  // Sender-side retransmission of lost packets (off by default):
+  void enableRetransmissions(unsigned maxNumPackets = 512, unsigned maxPacketAgeMs = 1000);
+      // If enabled, we keep a copy of (up to) the most recent "maxNumPackets" packets that we sent, and resend
+      // (unchanged) any that a receiver reports lost - in a RTCP generic NACK (RFC 4585) - within "maxPacketAgeMs".
+      // (Calling this with "maxNumPackets" == 0 disables retransmissions.)
+  Boolean retransmissionsAreEnabled() const { return fPacketHistory != NULL; }
+  unsigned numNACKedPackets() const { return fNumNACKedPackets; } // packets that receivers reported lost
+  unsigned numPacketsRetransmitted() const { return fNumPacketsRetransmitted; }
+  unsigned numKeyFrameRequests() const { return fNumKeyFrameRequests; } // RTCP PLIs and FIRs received
+
+  // Used (e.g., by "SMPTE2022FECEncoder") to see each RTP packet (including its RTP header) as it is sent:
+  typedef void (sentPacketHandlerFunc)(void* clientData, unsigned char const* packet, unsigned packetSize);
+  void setSentPacketHandler(sentPacketHandlerFunc* handlerFunc, void* handlerClientData) {
+    fSentPacketHandlerFunc = handlerFunc; fSentPacketHandlerClientData = handlerClientData;
+  }
+
 protected:
   RTPSink(UsageEnvironment& env,
 	  Groupsock* rtpGS, unsigned char rtpPayloadType,
@@ -105,11 +141,18 @@ protected:
   u_int32_t convertToRTPTimestamp(struct timeval tv);
   unsigned packetCount() const {return fPacketCount;}
   unsigned octetCount() const {return fOctetCount;}
+  void noteIncomingNACK(u_int16_t firstSeqNum, u_int16_t bitmaskOfFollowingLostPackets);
+  void noteIncomingKeyFrameRequest();
+
+  // used by subclasses (after each packet is sent), to record the packet for possible retransmission (and to
+  // pass it to our 'sent packet handler', if any):
+  void noteSentPacket(unsigned char const* packet, unsigned packetSize);
 
 protected:
   RTPInterface fRTPInterface;
   unsigned char fRTPPayloadType;
   unsigned fPacketCount, fOctetCount, fTotalOctetCount /*incl RTP hdr*/;
+  unsigned fNumPacketsDropped, fNumTruncatedFrames;
   struct timeval fTotalOctetCountStartTime, fInitialPresentationTime, fMostRecentPresentationTime;
   u_int32_t fCurrentTimestamp;
   u_int16_t fSeqNo;
@@ -129,6 +172,11 @@ private:
   unsigned fEstimatedBitrate; // set on creation if known; otherwise 0
 
   RTPTransmissionStatsDB* fTransmissionStatsDB;
+  RTPCongestionMonitor* fCongestionMonitor;
+  RTPPacketHistory* fPacketHistory;
+  unsigned fNumNACKedPackets, fNumPacketsRetransmitted, fNumKeyFrameRequests;
+  sentPacketHandlerFunc* fSentPacketHandlerFunc;
+  void* fSentPacketHandlerClientData;
 };
 
 
@@ -44,6 +44,25 @@ public:
   Groupsock* RTPgs() const { return fRTPInterface.gs(); }
 
   virtual void setPacketReorderingThresholdTime(unsigned uSeconds) = 0;
+  virtual void setAdaptivePacketReorderingThresholdTime(unsigned minUSeconds, unsigned maxUSeconds);
+      // Instead of a fixed threshold time, adapt it - within ["minUSeconds","maxUSeconds"] - to the reordering delay
+      // and interarrival jitter that we see in incoming packets.  (A later call to
+      // "setPacketReorderingThresholdTime()" returns to a fixed threshold time.)
+      // (The default implementation - for subclasses that don't adapt - just sets a fixed threshold time of
+      // "maxUSeconds".)
+  virtual unsigned packetReorderingThresholdTime() const; // the current threshold time, in uSeconds (0 if unknown)
+  virtual unsigned numLatePacketsDropped() const;
+      // the number of packets that arrived only after we'd given up waiting for them (0 if not counted)
+
+  // Used (e.g., by "RTCPInstance") to learn of gaps in the sequence numbers of incoming RTP packets - e.g., to
+  // request their retransmission.  The handler is called as soon as the gap is seen, for at most
+  // "maxPacketLossToReport" consecutive lost packets (larger gaps are not reported).
+  typedef void (packetLossHandlerFunc)(void* clientData, u_int16_t firstLostSeqNum, unsigned numLostPackets);
+  void setPacketLossHandler(packetLossHandlerFunc* handlerFunc, void* handlerClientData,
+			    unsigned maxPacketLossToReport = 64) {
+    fPacketLossHandlerFunc = handlerFunc; fPacketLossHandlerClientData = handlerClientData;
+    fMaxPacketLossToReport = maxPacketLossToReport;
+  }
 
   // used by RTCP:
   u_int32_t SSRC() const { return fSSRC; }
@@ -90,6 +109,9 @@ protected:
       // abstract base class
   virtual ~RTPSource();
 
+  void noteIncomingSeqNum(u_int16_t seqNum, Boolean SSRCHasChanged);
+      // called by subclasses for each incoming RTP packet that they accept
+
 protected:
   RTPInterface fRTPInterface;
   u_int16_t fCurPacketRTPSeqNum;
@@ -109,6 +131,11 @@ private:
   unsigned fTimestampFrequency;
   u_int32_t fSSRC;
   Boolean fEnableRTCPReports; // whether RTCP "RR" reports should be sent for this source (default: True)
+  packetLossHandlerFunc* fPacketLossHandlerFunc;
+  void* fPacketLossHandlerClientData;
+  unsigned fMaxPacketLossToReport;
+  Boolean fHaveSeenSeqNum;
+  u_int16_t fHighestSeqNumSeen;
 
   RTPReceptionStatsDB* fReceptionStatsDB;
 };
@@ -136,7 +163,8 @@ public:
         // NULL if none
 
   private:
-    HashTable::Iterator* fIter;
+    RTPReceptionStatsDB& fOurDB;
+    unsigned fNextIndex;
   };
 
   // The following is called whenever a RTP packet is received:
@@ -151,7 +179,8 @@ public:
   // The following is called whenever a RTCP SR packet is received:
   void noteIncomingSR(u_int32_t SSRC,
 		      u_int32_t ntpTimestampMSW, u_int32_t ntpTimestampLSW,
-		      u_int32_t rtpTimestamp);
+		      u_int32_t rtpTimestamp,
+		      u_int32_t senderPacketCount = 0, u_int32_t senderOctetCount = 0);
 
   // The following is called when a RTCP BYE packet is received:
   void removeRecord(u_int32_t SSRC);
@@ -171,7 +200,16 @@ protected:
   unsigned fNumActiveSourcesSinceLastReset;
 
 private:
-  HashTable* fTable;
+  unsigned lookupIndex(u_int32_t SSRC, Boolean& wasFound) const;
+      // binary search of "fStats"; if not found, returns the index at which "SSRC" would be inserted
+
+private:
+  // The per-SSRC records are kept in a compact array, sorted by SSRC.  (Almost all sessions
+  // have just one (or a few) SSRCs, so we also remember the most recently looked-up record,
+  // to avoid searching at all in the common case.)
+  RTPReceptionStats** fStats;
+  unsigned fNumStats, fStatsArraySize;
+  mutable RTPReceptionStats* fLastLookedUpStats;
   unsigned fTotNumPacketsReceived; // for all SSRCs
 };
 
@@ -203,6 +241,9 @@ public:
   struct timeval const& lastReceivedSR_time() const {
     return fLastReceivedSR_time;
   }
+  u_int32_t lastReceivedSR_senderPacketCount() const { return fLastReceivedSR_senderPacketCount; }
+  u_int32_t lastReceivedSR_senderOctetCount() const { return fLastReceivedSR_senderOctetCount; }
+      // the number of RTP packets (and payload bytes) that the sender says - in its last SR - that it has sent
 
   unsigned minInterPacketGapUS() const { return fMinInterPacketGapUS; }
   unsigned maxInterPacketGapUS() const { return fMaxInterPacketGapUS; }
@@ -225,7 +266,8 @@ private:
 			  Boolean& resultHasBeenSyncedUsingRTCP,
 			  unsigned packetSize /* payload only */);
   void noteIncomingSR(u_int32_t ntpTimestampMSW, u_int32_t ntpTimestampLSW,
-		      u_int32_t rtpTimestamp);
+		      u_int32_t rtpTimestamp,
+		      u_int32_t senderPacketCount, u_int32_t senderOctetCount);
   void init(u_int32_t SSRC);
   void initSeqNum(u_int16_t initialSeqNum);
   void reset();
@@ -248,6 +290,7 @@ protected:
   unsigned fLastReceivedSR_NTPmsw; // NTP timestamp (from SR), most-signif
   unsigned fLastReceivedSR_NTPlsw; // NTP timestamp (from SR), least-signif
   struct timeval fLastReceivedSR_time;
+  u_int32_t fLastReceivedSR_senderPacketCount, fLastReceivedSR_senderOctetCount;
   struct timeval fLastPacketReceptionTime;
   unsigned fMinInterPacketGapUS, fMaxInterPacketGapUS;
   struct timeval fTotalInterPacketGaps;
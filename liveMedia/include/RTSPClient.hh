@@ -92,6 +92,22 @@ public:
       // Issues a RTSP "SETUP" command, then returns the "CSeq" sequence number that was used in the command.
       // (The "responseHandler" and "authenticator" parameters are as described for "sendDescribeCommand".)
 
+  unsigned sendSetupAndPlayCommands(MediaSession& session, responseHandler* responseHandler,
+				    Boolean streamUsingTCP = False,
+				    double start = 0.0f, double end = -1.0f, float scale = 1.0f,
+				    Authenticator* authenticator = NULL);
+      // Sets up - then plays - each of "session"'s subsessions that has been initiated (i.e., has a "readSource()"),
+      // using 'pipelined' requests, to reduce the time taken to start streaming:
+      //     A "SETUP" command is sent for the first such subsession.  Once its response (and thus the server's session id)
+      //     arrives, "SETUP" commands for all of the remaining subsessions - and then an aggregate "PLAY" command - are sent
+      //     back-to-back, without waiting for each other's responses.
+      // This takes 2 round trips, rather than the (#subsessions + 1) that separate "SETUP"s and a "PLAY" would take.
+      // "responseHandler" is called just once: with the result of the "PLAY" command, or else with the first error
+      //     that occurred.  (Each subsession that was set up successfully will have a non-NULL "sessionId()".)
+      // Returns the "CSeq" sequence number that was used in the first "SETUP" command (or 0, if no command could be sent).
+      // (Note: Only one such operation may be in progress (on each "RTSPClient") at a time.)
+      // (The "authenticator" parameter is as described for "sendDescribeCommand".)
+
   unsigned sendPlayCommand(MediaSession& session, responseHandler* responseHandler,
 			   double start = 0.0f, double end = -1.0f, float scale = 1.0f,
 			   Authenticator* authenticator = NULL);
@@ -176,6 +192,13 @@ public:
       // Parses "url" as "rtsp://[<username>[:<password>]@]<server-address-or-name>[:<port>][/<stream-name>]"
       // (Note that the returned "username" and "password" are either NULL, or heap-allocated strings that the caller must later delete[].)
 
+  void setCachedSDPDescription(char const* sdpDescription, char const* baseURL = NULL);
+      // Gives us a SDP description - typically one returned by an earlier "DESCRIBE" command on the same stream - to reuse
+      // (e.g., when reconnecting to a server).  While this is set, "sendDescribeCommand()" does not send anything to the
+      // server; instead, its "responseHandler" is called (from the event loop) with a copy of "sdpDescription" as its result.
+      // If "baseURL" is non-NULL, it replaces our base URL (in case the original response had a "Content-Base:" header).
+      // (Call with a "sdpDescription" of NULL to stop using a cached SDP description.)
+
   void setUserAgentString(char const* userAgentName);
       // sets an alternative string to be used in RTSP "User-Agent:" headers
 
@@ -316,6 +339,18 @@ private:
   void incomingDataHandler1();
   void handleResponseBytes(int newBytesRead);
 
+  // Support for pipelined "SETUP" and "PLAY" commands ("sendSetupAndPlayCommands()"):
+  void sendPipelinedSetupAndPlayCommands();
+  void finishPipelinedSetupAndPlay(int resultCode, char* resultString);
+  static void continueAfterPipelinedSETUP(RTSPClient* rtspClient, int resultCode, char* resultString);
+  void continueAfterPipelinedSETUP1(int resultCode, char* resultString);
+  static void continueAfterPipelinedPLAY(RTSPClient* rtspClient, int resultCode, char* resultString);
+  void continueAfterPipelinedPLAY1(int resultCode, char* resultString);
+
+  // Support for using a cached SDP description instead of sending "DESCRIBE":
+  static void handleCachedDescribeResponse(void* clientData);
+  void handleCachedDescribeResponse1();
+
 public:
   u_int16_t desiredMaxIncomingPacketSize;
     // If set to a value >0, then a "Blocksize:" header with this value (minus an allowance for
@@ -345,6 +380,22 @@ private:
   char fSessionCookie[33];
   unsigned fSessionCookieCounter;
   Boolean fHTTPTunnelingConnectionIsPending;
+
+  // Support for pipelined "SETUP" and "PLAY" commands:
+  MediaSession* fPipelinedSession;
+  responseHandler* fPipelinedResponseHandler;
+  Boolean fPipelinedStreamUsingTCP;
+  double fPipelinedStart, fPipelinedEnd;
+  float fPipelinedScale;
+  unsigned fNumPipelinedSETUPsPending;
+  Boolean fPipelinedPLAYWasSent;
+  int fPipelinedResultCode; // the first error that occurred (if any)
+  char* fPipelinedResultString;
+
+  // Support for using a cached SDP description instead of sending "DESCRIBE":
+  char* fCachedSDPDescription;
+  RequestQueue fRequestsAwaitingCachedResponse;
+  TaskToken fCachedDescribeResponseTask;
 };
 
 
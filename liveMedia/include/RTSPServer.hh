@@ -97,6 +97,11 @@ public:
       //  and http://images.apple.com/br/quicktime/pdf/QTSS_Modules.pdf
   portNumBits httpServerPortNum() const; // in host byte order.  (Returns 0 if not present.)
 
+  virtual char* generateMetricsReport();
+      // Returns a report - in Prometheus text format - describing the current state of the server: its event loop,
+      // and the RTP streams being sent for each track of each stream (packets and bytes sent, drops, TCP send queue depth, etc.)
+      // This string is dynamically allocated; caller should delete[]
+
 protected:
   RTSPServer(UsageEnvironment& env,
 	     int ourSocket, Port ourPort,
@@ -39,6 +39,10 @@ public:
 
   Boolean setHTTPPort(Port httpPort) { return setUpTunnelingOverHTTP(httpPort); }
 
+  void setMetricsURLSuffix(char const* urlSuffix);
+      // If "urlSuffix" is non-NULL (e.g., "metrics"), then a HTTP "GET" of this URL suffix will return the output of
+      // "generateMetricsReport()", rather than a stream.  (By default, this is disabled.)
+
 protected:
   RTSPServerSupportingHTTPStreaming(UsageEnvironment& env,
 				    int ourSocket, Port ourPort,
@@ -50,6 +54,9 @@ protected:
 protected: // redefined virtual functions
   virtual ClientConnection* createNewClientConnection(int clientSocket, struct sockaddr_in clientAddr);
 
+private:
+  char* fMetricsURLSuffix;
+
 public: // should be protected, but some old compilers complain otherwise
   class RTSPClientConnectionSupportingHTTPStreaming: public RTSPServer::RTSPClientConnection {
   public:
@@ -60,6 +67,7 @@ public: // should be protected, but some old compilers complain otherwise
     virtual void handleHTTPCmd_StreamingGET(char const* urlSuffix, char const* fullRequestStr);
 
   protected:
+    void handleHTTPCmd_MetricsGET();
     static void afterStreaming(void* clientData);
 
   private:
@@ -0,0 +1,129 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// Forward error correction (FEC) for RTP streams, using XOR parity packets, as in SMPTE 2022-1 (based on RFC 2733).
+// Successive media packets are viewed as a matrix of "numRows" (D) rows of "numColumns" (L) packets.
+// A 'column' FEC packet protects each column (D packets, each L apart); a 'row' FEC packet protects each row
+// (L consecutive packets).  Any single lost packet in a column (e.g., from a burst of up to L losses), or in a row,
+// can be recovered.  FEC packets are sent as separate RTP streams - conventionally, columns to the media port + 2,
+// and rows to the media port + 4.  Unlike retransmission, this works for multicast (and one-to-many) streams.
+// C++ header
+
+#ifndef _SMPTE_2022_FEC_HH
+#define _SMPTE_2022_FEC_HH
+
+#ifndef _RTP_SINK_HH
+#include "RTPSink.hh"
+#endif
+#ifndef _MULTI_FRAMED_RTP_SOURCE_HH
+#include "MultiFramedRTPSource.hh"
+#endif
+
+class FECAccumulator; // forward
+class PendingFECPacket; // forward
+class RTPPacketHistory; // forward
+
+////////// SMPTE2022FECEncoder //////////
+
+class SMPTE2022FECEncoder: public Medium {
+public:
+  static SMPTE2022FECEncoder* createNew(UsageEnvironment& env, RTPSink& mediaSink,
+					 Groupsock* columnFECGroupsock, Groupsock* rowFECGroupsock,
+					 unsigned numColumns /*L*/, unsigned numRows /*D*/);
+      // Either "columnFECGroupsock" or "rowFECGroupsock" may be NULL (if that kind of FEC is not wanted).
+      // "numColumns" and "numRows" must each be in the range [1,255].  (SMPTE 2022-1 receivers may also
+      // require that L <= 20, 4 <= D <= 20, and L*D <= 100.)
+      // We see each packet that "mediaSink" sends (using its 'sent packet handler'), so we must be closed
+      // before "mediaSink" is.
+
+  unsigned numFECPacketsSent() const { return fNumFECPacketsSent; }
+
+protected:
+  SMPTE2022FECEncoder(UsageEnvironment& env, RTPSink& mediaSink,
+		      Groupsock* columnFECGroupsock, Groupsock* rowFECGroupsock,
+		      unsigned numColumns, unsigned numRows);
+      // called only by createNew()
+  virtual ~SMPTE2022FECEncoder();
+
+private:
+  static void sentPacketHandler(void* clientData, unsigned char const* packet, unsigned packetSize);
+  void handleSentPacket(unsigned char const* packet, unsigned packetSize);
+  void sendFECPacket(FECAccumulator& accumulator, Boolean isRow);
+
+private:
+  RTPSink& fMediaSink;
+  Groupsock* fColumnFECGroupsock;
+  Groupsock* fRowFECGroupsock;
+  unsigned fNumColumns, fNumRows;
+  FECAccumulator* fColumnAccumulators; // an array of "fNumColumns"
+  FECAccumulator* fRowAccumulator;
+  Boolean fHaveMatrixBase;
+  u_int16_t fMatrixBaseSeqNum; // the seq num of the first media packet in the current matrix
+  u_int16_t fNextColumnFECSeqNum, fNextRowFECSeqNum;
+  unsigned char* fOutBuf;
+  unsigned fOutBufSize;
+  unsigned fNumFECPacketsSent;
+};
+
+////////// SMPTE2022FECDecoder //////////
+
+class SMPTE2022FECDecoder: public Medium {
+public:
+  static SMPTE2022FECDecoder* createNew(UsageEnvironment& env, MultiFramedRTPSource& mediaSource,
+					 Groupsock* columnFECGroupsock, Groupsock* rowFECGroupsock,
+					 unsigned maxNumMediaPacketsToKeep = 1024);
+      // Either "columnFECGroupsock" or "rowFECGroupsock" may be NULL.
+      // We see incoming media packets using "mediaSource"s 'auxilliary read handler', and give it any packets that
+      // we recover (using "MultiFramedRTPSource::injectPacket()").  We must be closed before "mediaSource" is.
+      // Note: Because a column FEC packet can arrive only after the last row of its matrix, the media source's
+      // 'packet reordering threshold time' should be at least the duration of one matrix (L*D packets);
+      // see "RTPSource::setPacketReorderingThresholdTime()".
+
+  unsigned numFECPacketsReceived() const { return fNumFECPacketsReceived; }
+  unsigned numPacketsRecovered() const { return fNumPacketsRecovered; }
+
+protected:
+  SMPTE2022FECDecoder(UsageEnvironment& env, MultiFramedRTPSource& mediaSource,
+		      Groupsock* columnFECGroupsock, Groupsock* rowFECGroupsock,
+		      unsigned maxNumMediaPacketsToKeep);
+      // called only by createNew()
+  virtual ~SMPTE2022FECDecoder();
+
+private:
+  static void incomingMediaPacketHandler(void* clientData, unsigned char* packet, unsigned& packetSize);
+  static void incomingColumnFECPacketHandler(SMPTE2022FECDecoder* decoder, int /*mask*/);
+  static void incomingRowFECPacketHandler(SMPTE2022FECDecoder* decoder, int /*mask*/);
+  void incomingFECPacketHandler1(Groupsock* gs);
+  static void tryToRecoverPackets(void* clientData);
+  void tryToRecoverPackets();
+  Boolean tryToRecoverPacket(PendingFECPacket& fecPacket, Boolean& fecPacketIsDone);
+
+private:
+  MultiFramedRTPSource& fMediaSource;
+  Groupsock* fColumnFECGroupsock;
+  Groupsock* fRowFECGroupsock;
+  RTPPacketHistory* fMediaPackets; // recently received (or recovered) media packets
+  PendingFECPacket* fPendingFECPackets; // a ring of recently received FEC packets that we might still use
+  unsigned fNextPendingFECPacketIndex, fNumPendingFECPackets;
+  TaskToken fRecoveryTask;
+  Boolean fHaveSeenMediaPacket;
+  u_int16_t fHighestSeqNumSeen; // among media packets received from the network
+  unsigned char* fRecoveredPacket;
+  unsigned fNumFECPacketsReceived, fNumPacketsRecovered;
+};
+
+#endif
@@ -0,0 +1,79 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A per-environment allocator of the (UDP) port numbers used by servers' RTP and RTCP 'groupsocks'.
+// C++ header
+
+#ifndef _SERVER_PORT_ALLOCATOR_HH
+#define _SERVER_PORT_ALLOCATOR_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+#ifndef _NET_ADDRESS_HH
+#include "NetAddress.hh"
+#endif
+
+// "OnDemandServerMediaSubsession"s use this to choose the port number(s) for each new stream.  The allocator
+// remembers which ports are currently in use by our streams (and which ports we have recently failed to bind to),
+// so that - usually - only one attempt to bind each new port is made, regardless of how many streams already exist.
+// There is one allocator for each "UsageEnvironment" (not one for the whole process), because - like the rest of
+// this library's state - it is used only by the thread that runs that environment's event loop, and so needs no
+// locking.  Servers in different environments (and different processes) can still share a port range: a port
+// that's being used by another environment just fails to bind, and is then skipped, as described below.
+
+class ServerPortAllocator {
+public:
+  static void setPortRange(UsageEnvironment& env, portNumBits minPortNum, portNumBits maxPortNum);
+      // Restricts the port numbers that we allocate to the range [minPortNum, maxPortNum].
+      // (By default, all port numbers can be allocated.)
+
+  static Boolean allocate(UsageEnvironment& env, portNumBits initialPortNum, unsigned numPorts,
+			  Boolean rtpPortIsEven, portNumBits& resultPortNum);
+      // Allocates the lowest "numPorts" (1 or 2) consecutive port numbers - not below "initialPortNum" - that are
+      // not known to be in use.  (If "rtpPortIsEven" is True, the first of these will be even.)
+      // Returns False iff there are no such ports in our range.
+  static void markUnavailable(UsageEnvironment& env, portNumBits portNum);
+      // Called if we couldn't bind to a port that we allocated (because something else is using it).
+      // The port is then skipped by subsequent allocations, until no other ports are available.
+      // (If one of a pair of allocated ports couldn't be bound, "release()" the other one first.)
+  static void release(UsageEnvironment& env, portNumBits portNum);
+      // Called when a port that we allocated is no longer being used.
+
+private:
+  static ServerPortAllocator* ourAllocator(UsageEnvironment& env, Boolean createIfNotPresent = True);
+  ServerPortAllocator(UsageEnvironment& env);
+  virtual ~ServerPortAllocator();
+  void reclaimIfPossible();
+  void forgetUnavailablePorts();
+
+  Boolean isFree(unsigned portNum) const;
+  Boolean findFreePorts(unsigned initialPortNum, unsigned numPorts, Boolean rtpPortIsEven,
+			unsigned& resultPortNum) const;
+  void setBit(u_int32_t* bitmap, unsigned portNum);
+  void clearBit(u_int32_t* bitmap, unsigned portNum);
+
+private:
+  UsageEnvironment& fEnv;
+  unsigned fMinPortNum, fMaxPortNum;
+  u_int32_t* fInUse; // a bitmap of the ports that we've allocated (and not yet released)
+  u_int32_t* fUnavailable; // a bitmap of the ports that we couldn't bind to
+  unsigned fNumInUse, fNumUnavailable;
+  unsigned fLowestPossiblyFreePortNum; // all ports below this are in use or unavailable
+};
+
+#endif
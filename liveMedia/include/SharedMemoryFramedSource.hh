@@ -0,0 +1,72 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A "FramedSource" that delivers frames (e.g., H.264 NAL units, or audio frames) that another process
+// - such as an encoder - writes into a shared memory ring buffer ("SharedMemoryRing")
+// C++ header
+
+#ifndef _SHARED_MEMORY_FRAMED_SOURCE_HH
+#define _SHARED_MEMORY_FRAMED_SOURCE_HH
+
+#ifndef _FRAMED_SOURCE_HH
+#include "FramedSource.hh"
+#endif
+#ifndef _SHARED_MEMORY_RING_HH
+#include "SharedMemoryRing.hh"
+#endif
+
+class SharedMemoryFramedSource: public FramedSource {
+public:
+  static SharedMemoryFramedSource* createNew(UsageEnvironment& env, char const* ringFileName,
+					     unsigned ringDataSize = 1000000);
+      // Creates a new ring buffer, in the file "ringFileName" (typically in "/dev/shm"), plus a UNIX-domain socket
+      // (named "<ringFileName>.sock") from which producers fetch the "eventfd" descriptor that they use to wake us up.
+      // A producer (e.g., an encoder) then uses "SharedMemoryRing::openExisting(ringFileName)" to attach to the ring,
+      // and writes each frame into it (if possible, directly, using "reserveFrame()" and "commitFrame()").
+      // Each frame is delivered intact (so, for H.264 or H.265 video, each should be a NAL unit - without a start code -
+      // suitable for feeding to a "H264VideoStreamDiscreteFramer" or "H265VideoStreamDiscreteFramer").
+      // (This is currently supported only on Linux.)
+
+  unsigned numFramesDropped() const { return fRing->numFramesDropped(); }
+      // the number of frames that the producer could not write, because the ring was full
+
+protected:
+  SharedMemoryFramedSource(UsageEnvironment& env, SharedMemoryRing* ring,
+			   char const* ringFileName, char const* socketPath, int listenSocket);
+      // called only by createNew(), or by subclass constructors
+  virtual ~SharedMemoryFramedSource();
+
+private:
+  // redefined virtual functions:
+  virtual void doGetNextFrame();
+  virtual void doStopGettingFrames();
+
+private:
+  Boolean deliverFrame(); // returns False if there was no frame to deliver
+  static void eventFdHandler(void* clientData, int mask);
+  void eventFdHandler1();
+  static void incomingConnectionHandler(void* clientData, int mask);
+  void incomingConnectionHandler1();
+
+private:
+  SharedMemoryRing* fRing;
+  char* fRingFileName;
+  char* fSocketPath;
+  int fListenSocket;
+};
+
+#endif
@@ -0,0 +1,130 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2019 Live Networks, Inc.  All rights reserved.
+// A single-producer, single-consumer ring buffer of frames, in a shared memory file, used to pass
+// frames (e.g., H.264 NAL units, or audio frames) from an encoder process to a "SharedMemoryFramedSource".
+// C++ header
+
+#ifndef _SHARED_MEMORY_RING_HH
+#define _SHARED_MEMORY_RING_HH
+
+#ifndef _BOOLEAN_HH
+#include "Boolean.hh"
+#endif
+#ifndef _NET_COMMON_H
+#include "NetCommon.h"
+#endif
+
+// The layout of the shared memory file (all fields are in the host's byte order):
+//
+//   A "SharedMemoryRingHeader" (of size "headerSize"), followed by a data area (of size "dataSize").
+//
+//   The data area holds a sequence of frames.  Each frame is a "SharedMemoryRingFrameHeader", followed by
+//   "frameSize" bytes of data, padded (to keep each frame header 8-byte aligned) to a multiple of 8 bytes.
+//   A frame is never split across the end of the data area: If there's not enough room at the end for the next
+//   frame, the producer writes a frame header with "frameSize" == SHARED_MEMORY_RING_WRAP (or, if there's no room
+//   even for that, nothing), and the frame begins at the start of the data area instead.
+//
+//   "writePos" and "readPos" count (modulo 2^32) the bytes - including frame headers and padding - that have been
+//   written and read since the ring was created.  "dataSize" is a power of 2, so each maps to offset
+//   (pos & (dataSize-1)) in the data area.  The ring is empty when readPos == writePos.  Only the producer changes "writePos", and only after the frame is completely written;
+//   only the consumer changes "readPos", and only after it has finished with the frame.
+//
+//   The consumer - the process that creates the file - also creates an "eventfd" descriptor, and hands it
+//   to each producer that connects to the UNIX-domain socket named by "socketPath".  After writing a frame, the
+//   producer writes to this descriptor if "consumerIsWaiting" is set, to wake up the consumer's event loop.
+
+#define SHARED_MEMORY_RING_MAGIC 0x4C353552 /* "L55R" */
+#define SHARED_MEMORY_RING_VERSION 1
+#define SHARED_MEMORY_RING_WRAP 0xFFFFFFFF
+#define SHARED_MEMORY_RING_SOCKET_PATH_SIZE 104 /* fits in a "struct sockaddr_un" on all platforms */
+
+struct SharedMemoryRingHeader {
+  u_int32_t magic; // SHARED_MEMORY_RING_MAGIC
+  u_int32_t version; // SHARED_MEMORY_RING_VERSION
+  u_int32_t headerSize; // the offset of the data area from the start of the file
+  u_int32_t dataSize; // a power of 2
+  char socketPath[SHARED_MEMORY_RING_SOCKET_PATH_SIZE]; // '\0'-terminated
+  u_int8_t pad0[8];
+  // The following fields are each in a separate 64-byte cache line, to avoid 'false sharing':
+  u_int32_t writePos; // written only by the producer
+  u_int32_t numFramesDropped; // by the producer, because the ring was full
+  u_int8_t pad1[64 - 8];
+  u_int32_t readPos; // written only by the consumer
+  u_int32_t consumerIsWaiting; // written only by the consumer
+  u_int8_t pad2[64 - 8];
+};
+
+struct SharedMemoryRingFrameHeader {
+  u_int32_t frameSize; // or SHARED_MEMORY_RING_WRAP
+  u_int32_t durationInMicroseconds;
+  u_int32_t presentationTimeSec, presentationTimeUSec;
+};
+
+class SharedMemoryRing {
+public:
+  static SharedMemoryRing* createNew(char const* fileName, unsigned dataSize, char const* socketPath);
+      // Used by the consumer (i.e., "SharedMemoryFramedSource"): Creates - and maps - a new shared memory file.
+      // (Typically, "fileName" is in "/dev/shm"; "dataSize" is rounded up to a power of 2.)
+  static SharedMemoryRing* openExisting(char const* fileName);
+      // Used by the producer (i.e., the encoder): Maps an existing shared memory file (created by a consumer),
+      // and fetches the consumer's "eventfd" descriptor (from its UNIX-domain socket).
+      // Returns NULL (with "errno" set) if this fails (e.g., because the consumer is not yet running).
+  virtual ~SharedMemoryRing();
+
+  // Producer operations:
+  u_int8_t* reserveFrame(unsigned maxFrameSize);
+      // Returns a pointer into the ring at which a frame of up to "maxFrameSize" bytes can be written
+      // (e.g., directly by an encoder), or NULL if the ring doesn't currently have room for it.
+  void commitFrame(unsigned frameSize, struct timeval const& presentationTime, unsigned durationInMicroseconds = 0);
+      // Makes the frame written at the pointer returned by the most recent (successful) "reserveFrame()"
+      // available to the consumer.  ("frameSize" must be <= the "maxFrameSize" that was reserved.)
+  Boolean writeFrame(u_int8_t const* frame, unsigned frameSize,
+		     struct timeval const& presentationTime, unsigned durationInMicroseconds = 0);
+      // Copies a frame into the ring (a convenience function that uses "reserveFrame()" and "commitFrame()").
+      // Returns False (and counts the frame as having been dropped) if the ring doesn't currently have room for it.
+
+  // Consumer operations:
+  SharedMemoryRingFrameHeader const* nextFrame(unsigned& frameSize);
+      // Returns the oldest frame that has not yet been released (its data follows the header), or NULL if there is none.
+      // "frameSize" is set to the frame's size, as validated against the ring's data area.  (Use this, rather than the
+      // header's "frameSize" field, which a buggy or malicious producer could change after it has been validated.)
+  void releaseFrame();
+      // Releases the frame most recently returned by "nextFrame()", so that its space can be reused by the producer
+  Boolean prepareToWait();
+      // Tells the producer that we're about to wait for a new frame (on "eventFd()").
+      // Returns False - in which case we shouldn't wait - if a new frame arrived in the meantime.
+  void doneWaiting();
+
+  int eventFd() const { return fEventFd; }
+  unsigned dataSize() const { return fHeader->dataSize; }
+  unsigned numFramesDropped() const { return fHeader->numFramesDropped; }
+
+protected:
+  SharedMemoryRing(SharedMemoryRingHeader* header, int eventFd);
+      // called only by "createNew()" and "openExisting()"
+
+private:
+  SharedMemoryRingHeader* fHeader;
+  u_int8_t* fData;
+  int fEventFd;
+  u_int32_t fReservedPos; // producer: the position of the frame header for the most recent "reserveFrame()"
+  u_int32_t fReservedSize; // producer: the "maxFrameSize" for the most recent "reserveFrame()"
+  u_int32_t fNextReadPos; // consumer: the position that follows the frame most recently returned by "nextFrame()"
+};
+
+#endif
@@ -33,6 +33,17 @@ public:
   // "socketNum" is the socket number of an existing, writable TCP socket (which should be non-blocking).
   // The caller is responsible for closing this socket later (when this object no longer exists).
 
+  Boolean sendFromFileDirectly(int fileDescriptor, u_int64_t offset, u_int64_t numBytes);
+  // If called before "startPlaying()", then - rather than reading data from our source - we send "numBytes" bytes of
+  // the (seekable) file "fileDescriptor", beginning at "offset".  This is done using "sendfile()", so the data is never
+  // copied into our buffer.  (The source - which should be reading the same file - just keeps the file open.)
+  // Returns False (and does nothing) if this is not supported on this OS.
+  // (If "sendfile()" turns out not to work for this file and socket, we instead send the rest of the data by reading
+  // it from our source, as usual.)
+
+  // Redefined virtual functions:
+  virtual void stopPlaying();
+
 protected:
   TCPStreamSink(UsageEnvironment& env, int socketNum); // called only by "createNew()"
   virtual ~TCPStreamSink();
@@ -43,6 +54,7 @@ protected:
 
 private:
   void processBuffer(); // common routine, called from both the 'socket writable' and 'incoming data' handlers below
+  void sendFromFile(); // used instead of "processBuffer()" if "sendFromFileDirectly()" was called
 
   static void socketWritableHandler(void* clientData, int mask);
   void socketWritableHandler1();
@@ -62,6 +74,13 @@ private:
   unsigned fUnwrittenBytesStart, fUnwrittenBytesEnd;
   Boolean fInputSourceIsOpen, fOutputSocketIsWritable;
   int fOutputSocketNum;
+
+  // Used iff "sendFromFileDirectly()" was called:
+  Boolean fSendingFromFile;
+  int fFileDescriptor;
+  u_int64_t fFileOffset, fNumFileBytesRemaining;
+  u_int64_t fNumFileBytesSent;
+  u_int64_t fNumSourceBytesToSkip; // if we fell back to reading from our source, after "sendfile()" failed
 };
 
 #endif
@@ -99,9 +99,11 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "MPEG1or2VideoStreamDiscreteFramer.hh"
 #include "MPEG4VideoStreamDiscreteFramer.hh"
 #include "DeviceSource.hh"
+#include "SharedMemoryFramedSource.hh"
 #include "AudioInputDevice.hh"
 #include "WAVAudioFileSource.hh"
 #include "StreamReplicator.hh"
+#include "FrameTrace.hh"
 #include "RTSPRegisterSender.hh"
 #include "RTSPServerSupportingHTTPStreaming.hh"
 #include "RTSPClient.hh"
@@ -132,6 +134,18 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "OggFileServerDemux.hh"
 #include "MPEG2TransportStreamDemux.hh"
 #include "ProxyServerMediaSession.hh"
+#include "ServerPortAllocator.hh"
 #include "HLSSegmenter.hh"
+#include "RTPCongestionMonitor.hh"
+#include "RTPHintFileServerMediaSubsession.hh"
+#include "RTPHintFileSource.hh"
+#include "HintedRTPSink.hh"
+#include "SMPTE2022FEC.hh"
+#include "MPEG2TransportStreamIndexingFilter.hh"
+#include "MP3SeekTable.hh"
+#include "MPEG2TransportStreamProgramSplitter.hh"
+#include "MPEG2TransportStreamProgramServerMediaSubsession.hh"
+#include "AsyncFileReader.hh"
+#include "FileBlockCache.hh"
 
 #endif
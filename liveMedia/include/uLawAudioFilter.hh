@@ -36,6 +36,11 @@ public:
   // "byteOrdering" == 1 => little-endian order
   // "byteOrdering" == 2 => network (i.e., big-endian) order
 
+  // Conversion functions (used to implement this filter, but also usable on their own):
+  static unsigned char uLawFrom16BitLinear(u_int16_t sample); // converts a single sample
+  static void uLawFromPCM(u_int8_t* to, u_int8_t const* from, unsigned numSamples, int byteOrdering = 0);
+      // "from" holds "numSamples" 16-bit PCM samples, with "byteOrdering" as above
+
 protected:
   uLawFromPCMAudioSource(UsageEnvironment& env, FramedSource* inputSource,
 			 int byteOrdering);
@@ -70,6 +75,11 @@ public:
   static PCMFromuLawAudioSource*
   createNew(UsageEnvironment& env, FramedSource* inputSource);
 
+  // Conversion functions (used to implement this filter, but also usable on their own):
+  static u_int16_t linear16FromuLaw(unsigned char uLawByte); // converts a single sample
+  static void PCMFromuLaw(u_int16_t* to, u_int8_t const* from, unsigned numSamples);
+      // "to" (host order) may be the same buffer as "from" (i.e., the conversion may be done in place)
+
 protected:
   PCMFromuLawAudioSource(UsageEnvironment& env,
 			 FramedSource* inputSource);
@@ -89,10 +99,6 @@ private:
 			  unsigned numTruncatedBytes,
 			  struct timeval presentationTime,
 			  unsigned durationInMicroseconds);
-
-private:
-  unsigned char* fInputBuffer;
-  unsigned fInputBufferSize;
 };
 
 
@@ -158,6 +164,8 @@ class EndianSwap16: public FramedFilter {
 public:
   static EndianSwap16* createNew(UsageEnvironment& env, FramedSource* inputSource);
 
+  static void swapBytes(u_int8_t* buf, unsigned numValues); // swaps "numValues" 16-bit values, in place
+
 protected:
   EndianSwap16(UsageEnvironment& env, FramedSource* inputSource);
       // called only by createNew()
@@ -185,6 +193,8 @@ class EndianSwap24: public FramedFilter {
 public:
   static EndianSwap24* createNew(UsageEnvironment& env, FramedSource* inputSource);
 
+  static void swapBytes(u_int8_t* buf, unsigned numValues); // swaps "numValues" 24-bit values, in place
+
 protected:
   EndianSwap24(UsageEnvironment& env, FramedSource* inputSource);
       // called only by createNew()
@@ -19,6 +19,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "uLawAudioFilter.hh"
+#include <string.h>
+
+static Boolean hostIsBigEndian(); // forward
 
 ////////// 16-bit PCM (in various byte orders) -> 8-bit u-Law //////////
 
@@ -71,7 +74,7 @@ void uLawFromPCMAudioSource
 #define BIAS 0x84   // the add-in bias for 16 bit samples
 #define CLIP 32635
 
-static unsigned char uLawFrom16BitLinear(u_int16_t sample) {
+unsigned char uLawFromPCMAudioSource::uLawFrom16BitLinear(u_int16_t sample) {
   static int const exp_lut[256] = {0,0,1,1,2,2,2,2,3,3,3,3,3,3,3,3,
 				   4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,
 				   5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,
@@ -109,29 +112,7 @@ void uLawFromPCMAudioSource
   // Translate raw 16-bit PCM samples (in the input buffer)
   // into uLaw samples (in the output buffer).
   unsigned numSamples = frameSize/2;
-  switch (fByteOrdering) {
-    case 0: { // host order
-      u_int16_t* inputSample = (u_int16_t*)fInputBuffer;
-      for (unsigned i = 0; i < numSamples; ++i) {
-	fTo[i] = uLawFrom16BitLinear(inputSample[i]);
-      }
-      break;
-    }
-    case 1: { // little-endian order
-      for (unsigned i = 0; i < numSamples; ++i) {
-	u_int16_t const newValue = (fInputBuffer[2*i+1]<<8)|fInputBuffer[2*i];
-	fTo[i] = uLawFrom16BitLinear(newValue);
-      }
-      break;
-    }
-    case 2: { // network (i.e., big-endian) order
-      for (unsigned i = 0; i < numSamples; ++i) {
-	u_int16_t const newValue = (fInputBuffer[2*i]<<8)|fInputBuffer[2*i+i];
-	fTo[i] = uLawFrom16BitLinear(newValue);
-      }
-      break;
-    }
-  }
+  uLawFromPCM(fTo, fInputBuffer, numSamples, fByteOrdering);
 
   // Complete delivery to the client:
   fFrameSize = numSamples;
@@ -152,25 +133,18 @@ PCMFromuLawAudioSource* PCMFromuLawAudioSource
 PCMFromuLawAudioSource
 ::PCMFromuLawAudioSource(UsageEnvironment& env,
 			 FramedSource* inputSource)
-  : FramedFilter(env, inputSource),
-    fInputBuffer(NULL), fInputBufferSize(0) {
+  : FramedFilter(env, inputSource) {
 }
 
 PCMFromuLawAudioSource::~PCMFromuLawAudioSource() {
-  delete[] fInputBuffer;
 }
 
 void PCMFromuLawAudioSource::doGetNextFrame() {
-  // Figure out how many bytes of input data to ask for, and increase
-  // our input buffer if necessary:
+  // Figure out how many bytes of input data to ask for:
   unsigned bytesToRead = fMaxSize/2; // because we're converting 8 bits->16
-  if (bytesToRead > fInputBufferSize) {
-    delete[] fInputBuffer; fInputBuffer = new unsigned char[bytesToRead];
-    fInputBufferSize = bytesToRead;
-  }
 
-  // Arrange to read samples into the input buffer:
-  fInputSource->getNextFrame(fInputBuffer, bytesToRead,
+  // Arrange to read samples directly into the client's buffer.  (We then convert them in place.)
+  fInputSource->getNextFrame(fTo, bytesToRead,
 			     afterGettingFrame, this,
                              FramedSource::handleClosure, this);
 }
@@ -185,7 +159,7 @@ void PCMFromuLawAudioSource
 			     presentationTime, durationInMicroseconds);
 }
 
-static u_int16_t linear16FromuLaw(unsigned char uLawByte) {
+u_int16_t PCMFromuLawAudioSource::linear16FromuLaw(unsigned char uLawByte) {
   static int const exp_lut[8] = {0,132,396,924,1980,4092,8316,16764};
   uLawByte = ~uLawByte;
 
@@ -202,13 +176,10 @@ void PCMFromuLawAudioSource
 ::afterGettingFrame1(unsigned frameSize, unsigned numTruncatedBytes,
 		     struct timeval presentationTime,
 		     unsigned durationInMicroseconds) {
-  // Translate uLaw samples (in the input buffer)
+  // Translate uLaw samples (at the start of the output buffer)
   // into 16-bit PCM samples (in the output buffer), in host order.
   unsigned numSamples = frameSize;
-  u_int16_t* outputSample = (u_int16_t*)fTo;
-  for (unsigned i = 0; i < numSamples; ++i) {
-    outputSample[i] = linear16FromuLaw(fInputBuffer[i]);
-  }
+  PCMFromuLaw((u_int16_t*)fTo, fTo, numSamples);
 
   // Complete delivery to the client:
   fFrameSize = numSamples*2;
@@ -259,10 +230,7 @@ void NetworkFromHostOrder16
   // Translate the 16-bit values that we have just read from host
   // to network order (in-place)
   unsigned numValues = frameSize/2;
-  u_int16_t* value = (u_int16_t*)fTo;
-  for (unsigned i = 0; i < numValues; ++i) {
-    value[i] = htons(value[i]);
-  }
+  if (!hostIsBigEndian()) EndianSwap16::swapBytes(fTo, numValues);
 
   // Complete delivery to the client:
   fFrameSize = numValues*2;
@@ -313,10 +281,7 @@ void HostFromNetworkOrder16
   // Translate the 16-bit values that we have just read from network
   // to host order (in-place):
   unsigned numValues = frameSize/2;
-  u_int16_t* value = (u_int16_t*)fTo;
-  for (unsigned i = 0; i < numValues; ++i) {
-    value[i] = ntohs(value[i]);
-  }
+  if (!hostIsBigEndian()) EndianSwap16::swapBytes(fTo, numValues);
 
   // Complete delivery to the client:
   fFrameSize = numValues*2;
@@ -363,11 +328,7 @@ void EndianSwap16::afterGettingFrame1(unsigned frameSize, unsigned numTruncatedB
 				      unsigned durationInMicroseconds) {
   // Swap the byte order of the 16-bit values that we have just read (in place):
   unsigned numValues = frameSize/2;
-  u_int16_t* value = (u_int16_t*)fTo;
-  for (unsigned i = 0; i < numValues; ++i) {
-    u_int16_t const orig = value[i];
-    value[i] = ((orig&0xFF)<<8) | ((orig&0xFF00)>>8);
-  }
+  swapBytes(fTo, numValues);
 
   // Complete delivery to the client:
   fFrameSize = numValues*2;
@@ -414,13 +375,7 @@ void EndianSwap24::afterGettingFrame1(unsigned frameSize, unsigned numTruncatedB
 				      unsigned durationInMicroseconds) {
   // Swap the byte order of the 24-bit values that we have just read (in place):
   unsigned const numValues = frameSize/3;
-  u_int8_t* p = fTo;
-  for (unsigned i = 0; i < numValues; ++i) {
-    u_int8_t tmp = p[0];
-    p[0] = p[2];
-    p[2] = tmp;
-    p += 3;
-  }
+  swapBytes(fTo, numValues);
 
   // Complete delivery to the client:
   fFrameSize = numValues*3;
@@ -429,3 +384,103 @@ void EndianSwap24::afterGettingFrame1(unsigned frameSize, unsigned numTruncatedB
   fDurationInMicroseconds = durationInMicroseconds;
   afterGetting(this);
 }
+
+
+////////// Buffer conversion functions //////////
+
+static u_int8_t uLawEncodingTable[65536]; // indexed by 16-bit PCM sample
+static Boolean uLawEncodingTableIsSetUp = False;
+
+static void setUpuLawEncodingTable() {
+  for (unsigned sample = 0; sample < 65536; ++sample) {
+    uLawEncodingTable[sample] = uLawFromPCMAudioSource::uLawFrom16BitLinear((u_int16_t)sample);
+  }
+  uLawEncodingTableIsSetUp = True;
+}
+
+static u_int16_t const uLawDecodingTable[256] = { // == linear16FromuLaw(i), for each i
+  0x8284, 0x8684, 0x8A84, 0x8E84, 0x9284, 0x9684, 0x9A84, 0x9E84,
+  0xA284, 0xA684, 0xAA84, 0xAE84, 0xB284, 0xB684, 0xBA84, 0xBE84,
+  0xC184, 0xC384, 0xC584, 0xC784, 0xC984, 0xCB84, 0xCD84, 0xCF84,
+  0xD184, 0xD384, 0xD584, 0xD784, 0xD984, 0xDB84, 0xDD84, 0xDF84,
+  0xE104, 0xE204, 0xE304, 0xE404, 0xE504, 0xE604, 0xE704, 0xE804,
+  0xE904, 0xEA04, 0xEB04, 0xEC04, 0xED04, 0xEE04, 0xEF04, 0xF004,
+  0xF0C4, 0xF144, 0xF1C4, 0xF244, 0xF2C4, 0xF344, 0xF3C4, 0xF444,
+  0xF4C4, 0xF544, 0xF5C4, 0xF644, 0xF6C4, 0xF744, 0xF7C4, 0xF844,
+  0xF8A4, 0xF8E4, 0xF924, 0xF964, 0xF9A4, 0xF9E4, 0xFA24, 0xFA64,
+  0xFAA4, 0xFAE4, 0xFB24, 0xFB64, 0xFBA4, 0xFBE4, 0xFC24, 0xFC64,
+  0xFC94, 0xFCB4, 0xFCD4, 0xFCF4, 0xFD14, 0xFD34, 0xFD54, 0xFD74,
+  0xFD94, 0xFDB4, 0xFDD4, 0xFDF4, 0xFE14, 0xFE34, 0xFE54, 0xFE74,
+  0xFE8C, 0xFE9C, 0xFEAC, 0xFEBC, 0xFECC, 0xFEDC, 0xFEEC, 0xFEFC,
+  0xFF0C, 0xFF1C, 0xFF2C, 0xFF3C, 0xFF4C, 0xFF5C, 0xFF6C, 0xFF7C,
+  0xFF88, 0xFF90, 0xFF98, 0xFFA0, 0xFFA8, 0xFFB0, 0xFFB8, 0xFFC0,
+  0xFFC8, 0xFFD0, 0xFFD8, 0xFFE0, 0xFFE8, 0xFFF0, 0xFFF8, 0x0000,
+  0x7D7C, 0x797C, 0x757C, 0x717C, 0x6D7C, 0x697C, 0x657C, 0x617C,
+  0x5D7C, 0x597C, 0x557C, 0x517C, 0x4D7C, 0x497C, 0x457C, 0x417C,
+  0x3E7C, 0x3C7C, 0x3A7C, 0x387C, 0x367C, 0x347C, 0x327C, 0x307C,
+  0x2E7C, 0x2C7C, 0x2A7C, 0x287C, 0x267C, 0x247C, 0x227C, 0x207C,
+  0x1EFC, 0x1DFC, 0x1CFC, 0x1BFC, 0x1AFC, 0x19FC, 0x18FC, 0x17FC,
+  0x16FC, 0x15FC, 0x14FC, 0x13FC, 0x12FC, 0x11FC, 0x10FC, 0x0FFC,
+  0x0F3C, 0x0EBC, 0x0E3C, 0x0DBC, 0x0D3C, 0x0CBC, 0x0C3C, 0x0BBC,
+  0x0B3C, 0x0ABC, 0x0A3C, 0x09BC, 0x093C, 0x08BC, 0x083C, 0x07BC,
+  0x075C, 0x071C, 0x06DC, 0x069C, 0x065C, 0x061C, 0x05DC, 0x059C,
+  0x055C, 0x051C, 0x04DC, 0x049C, 0x045C, 0x041C, 0x03DC, 0x039C,
+  0x036C, 0x034C, 0x032C, 0x030C, 0x02EC, 0x02CC, 0x02AC, 0x028C,
+  0x026C, 0x024C, 0x022C, 0x020C, 0x01EC, 0x01CC, 0x01AC, 0x018C,
+  0x0174, 0x0164, 0x0154, 0x0144, 0x0134, 0x0124, 0x0114, 0x0104,
+  0x00F4, 0x00E4, 0x00D4, 0x00C4, 0x00B4, 0x00A4, 0x0094, 0x0084,
+  0x0078, 0x0070, 0x0068, 0x0060, 0x0058, 0x0050, 0x0048, 0x0040,
+  0x0038, 0x0030, 0x0028, 0x0020, 0x0018, 0x0010, 0x0008, 0x0000
+};
+
+static Boolean hostIsBigEndian() {
+  u_int16_t const one = 1;
+  return *(u_int8_t const*)&one == 0;
+}
+
+void uLawFromPCMAudioSource::uLawFromPCM(u_int8_t* to, u_int8_t const* from, unsigned numSamples, int byteOrdering) {
+  if (!uLawEncodingTableIsSetUp) setUpuLawEncodingTable();
+
+  if (byteOrdering == 0) byteOrdering = hostIsBigEndian() ? 2 : 1;
+  if (byteOrdering == 1) { // little-endian order
+    for (unsigned i = 0; i < numSamples; ++i) {
+      to[i] = uLawEncodingTable[(from[2*i+1]<<8)|from[2*i]];
+    }
+  } else { // network (i.e., big-endian) order
+    for (unsigned i = 0; i < numSamples; ++i) {
+      to[i] = uLawEncodingTable[(from[2*i]<<8)|from[2*i+1]];
+    }
+  }
+}
+
+void PCMFromuLawAudioSource::PCMFromuLaw(u_int16_t* to, u_int8_t const* from, unsigned numSamples) {
+  // Convert from the end backwards, so that "to" and "from" may be the same buffer:
+  for (unsigned i = numSamples; i > 0; --i) {
+    to[i-1] = uLawDecodingTable[from[i-1]];
+  }
+}
+
+void EndianSwap16::swapBytes(u_int8_t* buf, unsigned numValues) {
+  // Swap two values at a time, using 32-bit words:
+  unsigned i;
+  for (i = 0; i+2 <= numValues; i += 2) {
+    u_int32_t w;
+    memcpy(&w, &buf[2*i], 4);
+    w = ((w&0x00FF00FF)<<8) | ((w>>8)&0x00FF00FF);
+    memcpy(&buf[2*i], &w, 4);
+  }
+  if (i < numValues) {
+    u_int8_t tmp = buf[2*i];
+    buf[2*i] = buf[2*i+1];
+    buf[2*i+1] = tmp;
+  }
+}
+
+void EndianSwap24::swapBytes(u_int8_t* buf, unsigned numValues) {
+  for (unsigned i = 0; i < numValues; ++i) {
+    u_int8_t tmp = buf[0];
+    buf[0] = buf[2];
+    buf[2] = tmp;
+    buf += 3;
+  }
+}
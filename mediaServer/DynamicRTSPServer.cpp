@@ -105,6 +105,21 @@ static void onOggDemuxCreation(OggFileServerDemux* newDemux, void* clientData) {
 }
 // END Special code for handling Ogg files:
 
+// Special code for handling files that have a RTP hint file (built by "RTPHintFileBuilder"):
+static OnDemandServerMediaSubsession* createHintedSubsession(UsageEnvironment& env,
+							     char const* fileName, Boolean reuseSource) {
+  // If "<fileName>.rtph" exists (and is valid, and was built from the current version of the file), stream the
+  // file's pre-packetized payloads from it:
+  char* hintFileName = new char[strlen(fileName) + 6];
+  sprintf(hintFileName, "%s.rtph", fileName);
+  OnDemandServerMediaSubsession* subsession
+    = RTPHintFileServerMediaSubsession::createNew(env, hintFileName, reuseSource, fileName);
+  delete[] hintFileName;
+
+  return subsession;
+}
+// END Special code for handling files that have a RTP hint file
+
 #define NEW_SMS(description) do {\
 char const* descStr = description\
     ", streamed by the LIVE555 Media Server";\
@@ -139,12 +154,26 @@ static ServerMediaSession* createNewSMS(UsageEnvironment& env,
     // Assumed to be a H.264 Video Elementary Stream file:
     NEW_SMS("H.264 Video");
     OutPacketBuffer::maxSize = 100000; // allow for some possibly large H.264 frames
-    sms->addSubsession(H264VideoFileServerMediaSubsession::createNew(env, fileName, reuseSource));
+    OnDemandServerMediaSubsession* subsession = createHintedSubsession(env, fileName, reuseSource);
+    if (subsession == NULL) {
+      subsession = H264VideoFileServerMediaSubsession::createNew(env, fileName, reuseSource);
+      subsession->enableCongestionResponse(); // drop non-reference frames for clients that report congestion
+          // (but not when streaming from a hint file, because its "HintedRTPSink" can't drop frames)
+    }
+    subsession->enableRetransmissions(); // resend packets that clients report lost (in RTCP NACKs)
+    sms->addSubsession(subsession);
   } else if (strcmp(extension, ".265") == 0) {
     // Assumed to be a H.265 Video Elementary Stream file:
     NEW_SMS("H.265 Video");
     OutPacketBuffer::maxSize = 100000; // allow for some possibly large H.265 frames
-    sms->addSubsession(H265VideoFileServerMediaSubsession::createNew(env, fileName, reuseSource));
+    OnDemandServerMediaSubsession* subsession = createHintedSubsession(env, fileName, reuseSource);
+    if (subsession == NULL) {
+      subsession = H265VideoFileServerMediaSubsession::createNew(env, fileName, reuseSource);
+      subsession->enableCongestionResponse(); // drop non-reference frames for clients that report congestion
+          // (but not when streaming from a hint file, because its "HintedRTPSink" can't drop frames)
+    }
+    subsession->enableRetransmissions(); // resend packets that clients report lost (in RTCP NACKs)
+    sms->addSubsession(subsession);
   } else if (strcmp(extension, ".mp3") == 0) {
     // Assumed to be a MPEG-1 or 2 Audio file:
     NEW_SMS("MPEG-1 or 2 Audio");
@@ -0,0 +1,71 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2019, Live Networks, Inc.  All rights reserved
+// A program that scans a MPEG (1 or 2) audio file (e.g., a MP3 file), and records the byte offset of each
+// of its frames in a 'seek table' file (named by appending "x" to the input file's name).  Our RTSP server
+// ("live555MediaServer") will then use this file to seek exactly within the MP3 file, without first having
+// to scan it.
+// main program
+
+#include <liveMedia.hh>
+#include <BasicUsageEnvironment.hh>
+
+UsageEnvironment* env;
+char const* programName;
+
+void usage() {
+  *env << "usage: " << programName << " <mp3-file-name>\n";
+  exit(1);
+}
+
+int main(int argc, char const** argv) {
+  // Begin by setting up our usage environment:
+  TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+  env = BasicUsageEnvironment::createNew(*scheduler);
+
+  // Parse the command line:
+  programName = argv[0];
+  if (argc != 2) usage();
+  char const* inputFileName = argv[1];
+
+  // The output file name is the same as the input file name, except with suffix "x" appended:
+  int len = strlen(inputFileName);
+  char* outputFileName = new char[len+2];
+  sprintf(outputFileName, "%sx", inputFileName);
+
+  // Scan the input file (now, rather than in the background).  (We remove any existing seek table
+  // file first, so that it doesn't get read instead.):
+  remove(outputFileName);
+  MP3SeekTable* seekTable = MP3SeekTable::createNew(*env, inputFileName, False);
+  if (seekTable == NULL) {
+    *env << "Failed to open input file \"" << inputFileName << "\" (does it exist?)\n";
+    exit(1);
+  }
+  if (seekTable->numFrames() == 0) {
+    *env << "No MPEG audio frames were found in \"" << inputFileName << "\"\n";
+    exit(1);
+  }
+
+  if (!seekTable->writeToFile(outputFileName)) {
+    *env << "Failed to write \"" << outputFileName << "\": " << env->getResultMsg() << "\n";
+    exit(1);
+  }
+  *env << "Wrote seek table file \"" << outputFileName << "\" (" << seekTable->numFrames() << " frames; "
+       << seekTable->duration() << " seconds)\n";
+
+  Medium::close(seekTable);
+  return 0;
+}
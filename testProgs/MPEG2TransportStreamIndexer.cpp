@@ -18,19 +18,44 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // and generates a separate index file that can be used - by our RTSP server
 // implementation - to support 'trick play' operations when streaming the
 // Transport Stream file.
+// Unless the "-s" option is given, the file is "mmap()"ed, and split into
+// (Transport Stream packet-aligned) chunks that are indexed concurrently,
+// by separate processes.  The resulting index file is identical to the one
+// that's generated (more slowly) by the event loop-based indexer.
 // main program
 
 #include <liveMedia.hh>
 #include <BasicUsageEnvironment.hh>
+#include <GroupsockHelper.hh> // for "gettimeofday()"
+#include <InputFile.hh>
+#include <OutputFile.hh>
+#if !defined(__WIN32__) && !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define USE_MAPPED_INDEXER 1
+#endif
 
 void afterPlaying(void* clientData); // forward
+void reportDone(); // forward
+#ifdef USE_MAPPED_INDEXER
+Boolean indexMappedFile(); // forward
+#endif
 
 UsageEnvironment* env;
 char const* programName;
+char const* inputFileName;
+char* outputFileName;
+unsigned numProcesses = 0; // 0 means: one per CPU
+Boolean useEventLoop = False;
+struct timeval startTime;
 
 void usage() {
-  *env << "usage: " << programName << " <transport-stream-file-name>\n";
+  *env << "usage: " << programName << " [-j <num-processes>] [-s] <transport-stream-file-name>\n";
   *env << "\twhere <transport-stream-file-name> ends with \".ts\"\n";
+  *env << "\t-j <num-processes>: index the file using this many processes (default: one per CPU)\n";
+  *env << "\t-s: index the file using the (slower) event loop-based indexer\n";
   exit(1);
 }
 
@@ -41,9 +66,21 @@ int main(int argc, char const** argv) {
 
   // Parse the command line:
   programName = argv[0];
+  while (argc > 2 && argv[1][0] == '-') {
+    char const* opt = argv[1];
+    if (strcmp(opt, "-j") == 0 && argc > 3) {
+      if (sscanf(argv[2], "%u", &numProcesses) != 1 || numProcesses == 0) usage();
+      ++argv; --argc;
+    } else if (strcmp(opt, "-s") == 0) {
+      useEventLoop = True;
+    } else {
+      usage();
+    }
+    ++argv; --argc;
+  }
   if (argc != 2) usage();
 
-  char const* inputFileName = argv[1];
+  inputFileName = argv[1];
   // Check whether the input file name ends with ".ts":
   int len = strlen(inputFileName);
   if (len < 4 || strcmp(&inputFileName[len-3], ".ts") != 0) {
@@ -52,6 +89,21 @@ int main(int argc, char const** argv) {
     usage();
   }
 
+  // The output file name is the same as the input file name, except with suffix ".tsx":
+  outputFileName = new char[len+2]; // allow for trailing x\0
+  sprintf(outputFileName, "%sx", inputFileName);
+
+  gettimeofday(&startTime, NULL);
+#ifdef USE_MAPPED_INDEXER
+  if (!useEventLoop) {
+    if (indexMappedFile()) {
+      reportDone();
+      return 0;
+    }
+    *env << "...failed; using the event loop-based indexer instead\n";
+  }
+#endif
+
   // Open the input file (as a 'byte stream file source'):
   FramedSource* input
     = ByteStreamFileSource::createNew(*env, inputFileName, TRANSPORT_PACKET_SIZE);
@@ -64,10 +116,6 @@ int main(int argc, char const** argv) {
   FramedSource* indexer
     = MPEG2IFrameIndexFromTransportStream::createNew(*env, input);
 
-  // The output file name is the same as the input file name, except with suffix ".tsx":
-  char* outputFileName = new char[len+2]; // allow for trailing x\0
-  sprintf(outputFileName, "%sx", inputFileName);
-
   // Open the output file (for writing), as a 'file sink':
   MediaSink* output = FileSink::createNew(*env, outputFileName);
   if (output == NULL) {
@@ -85,6 +133,394 @@ int main(int argc, char const** argv) {
 }
 
 void afterPlaying(void* /*clientData*/) {
-  *env << "...done\n";
+  reportDone();
   exit(0);
 }
+
+void reportDone() {
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+  double secs = (timeNow.tv_sec - startTime.tv_sec) + (timeNow.tv_usec - startTime.tv_usec)/1000000.0;
+  double fileSize = (double)GetFileSize(inputFileName, NULL);
+
+  *env << "...done (" << secs << " seconds";
+  if (secs > 0.0) *env << "; " << fileSize/secs/1.0e9 << " GB/s";
+  *env << ")\n";
+}
+
+#ifdef USE_MAPPED_INDEXER
+////////// Indexing a "mmap()"ed file, in concurrently-indexed chunks //////////
+
+typedef MPEG2IFrameIndexFromTransportStream::StreamState IndexerState;
+
+// Don't make chunks smaller than this (about 10 MBytes), because each process does some
+// extra work at each end of its chunk:
+#define MIN_PACKETS_PER_CHUNK 50000
+
+// To find its chunk's starting state, each process (other than the first) analyzes the
+// stream up to its first PCR, and then this many packets before the chunk:
+#define NUM_WARMUP_PACKETS 20000
+
+// Each process also keeps indexing beyond the end of its chunk, until it has seen the
+// start of this many more frames.  The frames that both it and the next chunk's process
+// have indexed are used to stitch the two chunks' index records together:
+#define NUM_OVERLAP_FRAMES 16
+
+// We map the file a 'window' at a time (because it may be too large to map all at once
+// into a 32-bit address space).  Each window starts at a multiple of this many packets,
+// which keeps it aligned to any page size up to 64 KBytes:
+#define WINDOW_ALIGNMENT_PACKETS 16384
+#define PACKETS_PER_WINDOW (16*WINDOW_ALIGNMENT_PACKETS) // about 48 MBytes
+
+class TransportStreamMap {
+public:
+  TransportStreamMap(int fd, u_int64_t numPackets);
+  virtual ~TransportStreamMap();
+
+  unsigned char const* packet(u_int64_t packetNum) {
+    // Returns NULL if the packet couldn't be mapped
+    if (packetNum - fWindowStart >= fWindowSize) mapWindow(packetNum);
+    return fWindow == NULL ? NULL : &fWindow[(packetNum - fWindowStart)*TRANSPORT_PACKET_SIZE];
+  }
+
+private:
+  void mapWindow(u_int64_t packetNum);
+
+private:
+  int fFD;
+  u_int64_t fNumPackets;
+  u_int8_t* fWindow;
+  u_int64_t fWindowStart;
+  unsigned fWindowSize; // in packets
+};
+
+enum ChunkStatus {
+  CHUNK_FAILED = 0, // (or not yet indexed)
+  CHUNK_OVERLAPPED, // indexed (and overlapped with the next chunk's frames)
+  CHUNK_REACHED_END // indexed, up to the end of the stream
+};
+
+// The result of indexing each chunk.  These are kept in memory that's shared with the
+// processes that do the indexing:
+struct ChunkResult {
+  int status;
+  IndexerState startState; // as assumed when indexing began
+  IndexerState endState; // the state just before the next chunk's first packet
+};
+
+static void estimateStartState(TransportStreamMap& map, u_int64_t firstPacket, IndexerState& state) {
+  // Without indexing all of the stream before this chunk, we can't know its state for sure,
+  // but in most streams it's just the state at the first PCR, updated by the most recent PCR,
+  // PAT, PMT and video packet.  (If we guess wrong, then the chunk will be indexed again,
+  // once the state at the end of the previous chunk is known.)
+  MPEG2IFrameIndexFromTransportStream* analyzer
+    = MPEG2IFrameIndexFromTransportStream::createNew(*env, NULL);
+  analyzer->setReportWarnings(False);
+  IndexerState initialState;
+  analyzer->getStreamState(initialState);
+
+  u_int64_t p;
+  for (p = 0; p < firstPacket; ++p) {
+    unsigned char const* pkt = map.packet(p);
+    if (pkt == NULL) break;
+    if (!analyzer->indexTransportPacket(pkt, True)) analyzer->indexEndOfStream();
+
+    analyzer->getStreamState(state);
+    if (state.haveSeenFirstPCR) { ++p; break; }
+  }
+  if (firstPacket > NUM_WARMUP_PACKETS && p < firstPacket - NUM_WARMUP_PACKETS) {
+    p = firstPacket - NUM_WARMUP_PACKETS;
+  }
+  for (; p < firstPacket; ++p) {
+    unsigned char const* pkt = map.packet(p);
+    if (pkt == NULL) break;
+    if (!analyzer->indexTransportPacket(pkt, True)) analyzer->indexEndOfStream();
+  }
+
+  analyzer->getStreamState(state);
+  state.lastTransportPacketNumber = (unsigned long)(initialState.lastTransportPacketNumber + firstPacket);
+  Medium::close(analyzer);
+}
+
+static u_int64_t recordPacketNumber(u_int8_t const* record, u_int64_t latestPacketNum) {
+  // An index record holds only the low 32 bits of its packet number.  Recover the rest from
+  // the number of a packet at (or after) it:
+  u_int32_t tpn = record[7]|(record[8]<<8)|(record[9]<<16)|(record[10]<<24);
+  return latestPacketNum - (u_int32_t)((u_int32_t)latestPacketNum - tpn);
+}
+
+static int indexChunkPackets(MPEG2IFrameIndexFromTransportStream* indexer,
+			     TransportStreamMap& map, u_int64_t firstPacket,
+			     u_int64_t nextChunkPacket, u_int64_t numPackets,
+			     FILE* mainFile, FILE* overlapFile, ChunkResult& result) {
+  u_int8_t record[INDEX_RECORD_SIZE];
+  unsigned numOverlapFrames = 0;
+  Boolean indexToEnd = False;
+  u_int64_t p;
+
+  for (p = firstPacket; ; ++p) {
+    if (p == nextChunkPacket) {
+      // Note our state here, so that it can be checked against the next chunk's starting state:
+      indexer->getStreamState(result.endState);
+      indexer->setReportWarnings(False); // because the next chunk's process will report them
+    }
+
+    Boolean continueIndexing = True;
+    if (p == numPackets) {
+      indexer->indexEndOfStream();
+      continueIndexing = False;
+    } else {
+      unsigned char const* pkt = map.packet(p);
+      if (pkt == NULL) return CHUNK_FAILED;
+      if (!indexer->indexTransportPacket(pkt)) {
+	if (indexer->parseBufferOverflowed()) return CHUNK_FAILED;
+	continueIndexing = indexer->indexEndOfStream();
+	// If indexing continues after the bad packet, it does so (as with our event loop-based
+	// indexing) with an extra code in the parse buffer.  Because this affects all of the
+	// following index records, no other process can index them, so we index them ourself:
+	indexToEnd = True;
+      }
+    }
+
+    while (indexer->getNextIndexRecord(record)) {
+      if (recordPacketNumber(record, p) < nextChunkPacket) {
+	fwrite(record, 1, sizeof record, mainFile);
+      } else {
+	fwrite(record, 1, sizeof record, overlapFile);
+	if ((record[0]&0x80) != 0) ++numOverlapFrames; // the record begins a frame
+      }
+    }
+    if (!continueIndexing) return CHUNK_REACHED_END;
+    if (numOverlapFrames >= NUM_OVERLAP_FRAMES && !indexToEnd) return CHUNK_OVERLAPPED;
+  }
+}
+
+static void indexChunk(TransportStreamMap& map, u_int64_t firstPacket,
+		       u_int64_t nextChunkPacket, u_int64_t numPackets,
+		       IndexerState const* startState, // NULL means: the state at the start of the stream
+		       FILE* mainFile, FILE* overlapFile, ChunkResult& result) {
+  MPEG2IFrameIndexFromTransportStream* indexer
+    = MPEG2IFrameIndexFromTransportStream::createNew(*env, NULL);
+  if (startState != NULL) indexer->setStreamState(*startState);
+  indexer->getStreamState(result.startState);
+
+  result.status = indexChunkPackets(indexer, map, firstPacket, nextChunkPacket, numPackets,
+				    mainFile, overlapFile, result);
+  Medium::close(indexer);
+
+  if (fflush(mainFile) != 0 || fflush(overlapFile) != 0) result.status = CHUNK_FAILED;
+}
+
+// The records that the most recent chunk indexed beyond its end:
+static u_int8_t* overlapRecords = NULL;
+static unsigned numOverlapRecords = 0;
+
+static Boolean isSameFrame(u_int8_t const* record1, u_int8_t const* record2) {
+  // Both records begin a frame, at the same place:
+  return (record1[0]&0x80) != 0 && (record2[0]&0x80) != 0 && record1[1] == record2[1]
+    && memcmp(&record1[7], &record2[7], 4) == 0;
+}
+
+static Boolean copyRecords(FILE* fromFid, u_int64_t numRecords, FILE* toFid) {
+  u_int8_t buffer[INDEX_RECORD_SIZE*4096];
+  while (numRecords > 0) {
+    size_t n = numRecords < 4096 ? (size_t)numRecords : 4096;
+    if (fread(buffer, INDEX_RECORD_SIZE, n, fromFid) != n
+	|| fwrite(buffer, INDEX_RECORD_SIZE, n, toFid) != n) return False;
+    numRecords -= n;
+  }
+  return True;
+}
+
+static Boolean appendChunkRecords(FILE* outFid, FILE* mainFile, FILE* overlapFile,
+				  ChunkResult const& result, Boolean isFirstChunk) {
+  // A chunk's records are those in its 'main' file, followed by those in its 'overlap' file:
+  u_int64_t numMainRecords = TellFile64(mainFile)/INDEX_RECORD_SIZE;
+  u_int64_t numChunkOverlapRecords = TellFile64(overlapFile)/INDEX_RECORD_SIZE;
+  u_int64_t numRecords = numMainRecords + numChunkOverlapRecords;
+  rewind(mainFile); rewind(overlapFile);
+
+  u_int64_t j = 0; // the first of this chunk's records that we use
+  if (!isFirstChunk) {
+    // This chunk's first records (up until its first complete frame) are probably wrong,
+    // because its process began indexing part-way through a frame.  Find the first frame
+    // that also begins in the previous chunk's overlap records:
+    if (numOverlapRecords == 0) return False;
+    u_int8_t const* lastOverlapRecord = &overlapRecords[(numOverlapRecords-1)*INDEX_RECORD_SIZE];
+    u_int8_t record[INDEX_RECORD_SIZE];
+    unsigned i = numOverlapRecords;
+    for (j = 0; j < numRecords; ++j) {
+      if (fread(record, 1, INDEX_RECORD_SIZE, j < numMainRecords ? mainFile : overlapFile)
+	  != INDEX_RECORD_SIZE) return False;
+      for (i = 0; i < numOverlapRecords; ++i) {
+	if (isSameFrame(record, &overlapRecords[i*INDEX_RECORD_SIZE])) break;
+      }
+      if (i < numOverlapRecords) break; // found
+      if ((int32_t)(recordPacketNumber(record, 0) - recordPacketNumber(lastOverlapRecord, 0)) > 0) {
+	return False; // we're now past the previous chunk's overlap records, so there's no common frame
+      }
+    }
+    if (i == numOverlapRecords) return False;
+
+    // Use the previous chunk's records up until the common frame; then use ours.
+    // Where the two overlap, they should be the same:
+    fwrite(overlapRecords, INDEX_RECORD_SIZE, i, outFid);
+    while (1) {
+      if (memcmp(record, &overlapRecords[i*INDEX_RECORD_SIZE], INDEX_RECORD_SIZE) != 0) return False;
+      if (j < numMainRecords) fwrite(record, 1, INDEX_RECORD_SIZE, outFid);
+      ++i; ++j;
+      if (i == numOverlapRecords || j == numRecords) break;
+
+      if (fread(record, 1, INDEX_RECORD_SIZE, j < numMainRecords ? mainFile : overlapFile)
+	  != INDEX_RECORD_SIZE) return False;
+    }
+  }
+
+  // Copy the rest of our main records:
+  if (j < numMainRecords && !copyRecords(mainFile, numMainRecords - j, outFid)) return False;
+  u_int64_t numRemainingRecords = j < numMainRecords ? numChunkOverlapRecords : numRecords - j;
+
+  delete[] overlapRecords; overlapRecords = NULL;
+  numOverlapRecords = 0;
+  if (result.status == CHUNK_REACHED_END) {
+    // Our overlap records are the last of the stream's records:
+    return copyRecords(overlapFile, numRemainingRecords, outFid);
+  }
+
+  // Our (remaining) overlap records are what the next chunk gets stitched to.
+  // (There aren't many of them, so we keep them in memory.)
+  numOverlapRecords = (unsigned)numRemainingRecords;
+  overlapRecords = new u_int8_t[numOverlapRecords*INDEX_RECORD_SIZE + 1];
+  return fread(overlapRecords, INDEX_RECORD_SIZE, numOverlapRecords, overlapFile) == numOverlapRecords;
+}
+
+Boolean indexMappedFile() {
+  int fd = open(inputFileName, O_RDONLY);
+  if (fd < 0) {
+    *env << "Failed to open input file \"" << inputFileName << "\" (does it exist?)\n";
+    exit(1);
+  }
+  u_int64_t numPackets = GetFileSize(inputFileName, NULL)/TRANSPORT_PACKET_SIZE;
+
+  FILE* outFid = OpenOutputFile(*env, outputFileName);
+  if (outFid == NULL) {
+    *env << "Failed to open output file \"" << outputFileName << "\"\n";
+    exit(1);
+  }
+
+  // Decide how many chunks to split the file into (one per process):
+  unsigned numChunks = numProcesses;
+  if (numChunks == 0) {
+    long numCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+    numChunks = numCPUs > 0 ? (unsigned)numCPUs : 1;
+  }
+  if (numChunks > numPackets/MIN_PACKETS_PER_CHUNK) numChunks = (unsigned)(numPackets/MIN_PACKETS_PER_CHUNK);
+  if (numChunks == 0) numChunks = 1;
+
+  *env << "Writing index file \"" << outputFileName << "\" (using " << numChunks
+       << (numChunks == 1 ? " process" : " processes") << ")...";
+
+  u_int64_t* chunkStart = new u_int64_t[numChunks+1];
+  FILE** mainFiles = new FILE*[numChunks];
+  FILE** overlapFiles = new FILE*[numChunks];
+  unsigned k;
+  for (k = 0; k <= numChunks; ++k) chunkStart[k] = (numPackets/numChunks)*k;
+  chunkStart[numChunks] = numPackets;
+  for (k = 0; k < numChunks; ++k) {
+    mainFiles[k] = tmpfile();
+    overlapFiles[k] = tmpfile();
+    if (mainFiles[k] == NULL || overlapFiles[k] == NULL) {
+      *env << "Failed to create a temporary file\n";
+      exit(1);
+    }
+  }
+  ChunkResult* results
+    = (ChunkResult*)mmap(NULL, numChunks*sizeof (ChunkResult), PROT_READ|PROT_WRITE,
+			 MAP_SHARED|MAP_ANONYMOUS, -1, 0); // initially zero => CHUNK_FAILED
+  if (results == MAP_FAILED) {
+    *env << "mmap() failed: " << env->getResultMsg() << "\n";
+    exit(1);
+  }
+
+  // Index each chunk (except the first, which we index ourself) in its own process:
+  for (k = 1; k < numChunks; ++k) {
+    pid_t pid = fork();
+    if (pid < 0) break; // we'll index the remaining chunks ourself, below
+    if (pid == 0) {
+      TransportStreamMap map(fd, numPackets);
+      IndexerState startState;
+      estimateStartState(map, chunkStart[k], startState);
+      indexChunk(map, chunkStart[k], chunkStart[k+1], numPackets, &startState,
+		 mainFiles[k], overlapFiles[k], results[k]);
+      _exit(0);
+    }
+  }
+
+  TransportStreamMap map(fd, numPackets);
+  indexChunk(map, 0, chunkStart[1], numPackets, NULL, mainFiles[0], overlapFiles[0], results[0]);
+  while (wait(NULL) > 0) {}
+
+  // Stitch the chunks' index records together, in order:
+  Boolean success = True;
+  for (k = 0; k < numChunks; ++k) {
+    ChunkResult& result = results[k];
+    if (k > 0) {
+      ChunkResult& prevResult = results[k-1];
+      if (prevResult.status == CHUNK_REACHED_END) break; // the previous chunk's records cover the rest
+
+      if (result.status == CHUNK_FAILED
+	  || !MPEG2IFrameIndexFromTransportStream::streamStatesAreEqual(result.startState,
+									 prevResult.endState)) {
+	// This chunk's process guessed its starting state wrongly (or failed).  Index it again,
+	// starting from the previous chunk's end state (which we now know is correct):
+	fclose(mainFiles[k]); fclose(overlapFiles[k]);
+	mainFiles[k] = tmpfile(); overlapFiles[k] = tmpfile();
+	if (mainFiles[k] == NULL || overlapFiles[k] == NULL) { success = False; break; }
+	indexChunk(map, chunkStart[k], chunkStart[k+1], numPackets, &prevResult.endState,
+		   mainFiles[k], overlapFiles[k], result);
+      }
+    }
+    if (result.status == CHUNK_FAILED
+	|| !appendChunkRecords(outFid, mainFiles[k], overlapFiles[k], result, k == 0)) {
+      success = False;
+      break;
+    }
+  }
+  if (fclose(outFid) != 0) success = False;
+
+  for (k = 0; k < numChunks; ++k) {
+    if (mainFiles[k] != NULL) fclose(mainFiles[k]);
+    if (overlapFiles[k] != NULL) fclose(overlapFiles[k]);
+  }
+  delete[] overlapRecords; overlapRecords = NULL; numOverlapRecords = 0;
+  munmap(results, numChunks*sizeof (ChunkResult));
+  delete[] overlapFiles; delete[] mainFiles; delete[] chunkStart;
+  close(fd);
+
+  return success;
+}
+
+TransportStreamMap::TransportStreamMap(int fd, u_int64_t numPackets)
+  : fFD(fd), fNumPackets(numPackets), fWindow(NULL), fWindowStart(0), fWindowSize(0) {
+}
+
+TransportStreamMap::~TransportStreamMap() {
+  UnmapInputFile(fWindow, (u_int64_t)fWindowSize*TRANSPORT_PACKET_SIZE);
+}
+
+void TransportStreamMap::mapWindow(u_int64_t packetNum) {
+  UnmapInputFile(fWindow, (u_int64_t)fWindowSize*TRANSPORT_PACKET_SIZE);
+  fWindow = NULL; fWindowStart = 0; fWindowSize = 0;
+  if (packetNum >= fNumPackets) return;
+
+  u_int64_t windowStart = packetNum - packetNum%WINDOW_ALIGNMENT_PACKETS;
+  u_int64_t windowSize = fNumPackets - windowStart;
+  if (windowSize > PACKETS_PER_WINDOW) windowSize = PACKETS_PER_WINDOW;
+
+  fWindow = MapInputFileRegion(fFD, windowStart*TRANSPORT_PACKET_SIZE, windowSize*TRANSPORT_PACKET_SIZE);
+  if (fWindow != NULL) {
+    fWindowStart = windowStart;
+    fWindowSize = (unsigned)windowSize;
+  }
+}
+#endif
@@ -0,0 +1,123 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2019, Live Networks, Inc.  All rights reserved
+// A program that reads an existing H.264 or H.265 Video Elementary Stream file, packetizes it into RTP
+// (exactly as our RTSP server would), and records the resulting RTP payloads - with their timestamps and
+// marker bits - in a separate 'hint file'.  Our RTSP server ("live555MediaServer") will then stream the
+// file from this hint file, without having to re-parse and re-packetize it for each client.
+// main program
+
+#include <liveMedia.hh>
+#include <BasicUsageEnvironment.hh>
+
+// A task scheduler that runs delayed tasks immediately, so that the "RTPSink" packetizes the whole
+// file as fast as possible, rather than in real time:
+class UnpacedTaskScheduler: public BasicTaskScheduler {
+public:
+  static UnpacedTaskScheduler* createNew() { return new UnpacedTaskScheduler(); }
+
+protected:
+  UnpacedTaskScheduler(): BasicTaskScheduler(0) {}
+
+private: // redefined virtual functions:
+  virtual TaskToken scheduleDelayedTask(int64_t /*microseconds*/, TaskFunc* proc, void* clientData) {
+    return BasicTaskScheduler::scheduleDelayedTask(0, proc, clientData);
+  }
+};
+
+void afterPlaying(void* clientData); // forward
+
+UsageEnvironment* env;
+char const* programName;
+RTPHintFileWriter* hintFileWriter;
+RTPSink* videoSink;
+char* outputFileName;
+
+void usage() {
+  *env << "usage: " << programName << " <video-file-name>\n";
+  *env << "\twhere <video-file-name> ends with \".264\" or \".265\"\n";
+  exit(1);
+}
+
+int main(int argc, char const** argv) {
+  // Begin by setting up our usage environment:
+  TaskScheduler* scheduler = UnpacedTaskScheduler::createNew();
+  env = BasicUsageEnvironment::createNew(*scheduler);
+
+  // Parse the command line:
+  programName = argv[0];
+  if (argc != 2) usage();
+
+  char const* inputFileName = argv[1];
+  // Check whether the input file name ends with ".264" or ".265":
+  int len = strlen(inputFileName);
+  Boolean isH265 = False;
+  if (len >= 5 && strcmp(&inputFileName[len-4], ".265") == 0) {
+    isH265 = True;
+  } else if (len < 5 || strcmp(&inputFileName[len-4], ".264") != 0) {
+    *env << "ERROR: input file name \"" << inputFileName
+	 << "\" does not end with \".264\" or \".265\"\n";
+    usage();
+  }
+
+  // Open the input file (as a 'byte stream file source'):
+  ByteStreamFileSource* fileSource = ByteStreamFileSource::createNew(*env, inputFileName);
+  if (fileSource == NULL) {
+    *env << "Failed to open input file \"" << inputFileName << "\" (does it exist?)\n";
+    exit(1);
+  }
+
+  // The output file name is the same as the input file name, except with suffix ".rtph" appended:
+  outputFileName = new char[len+6];
+  sprintf(outputFileName, "%s.rtph", inputFileName);
+
+  // Create the 'groupsock' that records RTP packets in the hint file:
+  hintFileWriter = RTPHintFileWriter::createNew(*env, outputFileName, isH265 ? "H265" : "H264", inputFileName);
+  if (hintFileWriter == NULL) {
+    *env << "Failed to open output file \"" << outputFileName << "\": " << env->getResultMsg() << "\n";
+    exit(1);
+  }
+
+  // Create the framer and "RTPSink" - the same as "H264/5VideoFileServerMediaSubsession" would:
+  OutPacketBuffer::maxSize = 100000; // allow for some possibly large H.264/5 frames
+  FramedSource* videoSource;
+  if (isH265) {
+    videoSource = H265VideoStreamFramer::createNew(*env, fileSource);
+    videoSink = H265VideoRTPSink::createNew(*env, hintFileWriter, 96);
+  } else {
+    videoSource = H264VideoStreamFramer::createNew(*env, fileSource);
+    videoSink = H264VideoRTPSink::createNew(*env, hintFileWriter, 96);
+  }
+
+  // Start playing, to generate the output hint file:
+  *env << "Writing hint file \"" << outputFileName << "\"...";
+  videoSink->startPlaying(*videoSource, afterPlaying, NULL);
+
+  env->taskScheduler().doEventLoop(); // does not return
+
+  return 0; // only to prevent compiler warning
+}
+
+void afterPlaying(void* /*clientData*/) {
+  // Note: We finish the hint file before closing the sink, because the sink gets its SDP parameters
+  // (e.g., the H.264/5 'sprop' parameter sets) from its framer.
+  if (!hintFileWriter->finishHintFile(*videoSink)) {
+    *env << "\nFailed to write \"" << outputFileName << "\": " << env->getResultMsg() << "\n";
+    exit(1);
+  }
+  *env << "...done (" << hintFileWriter->numRecords() << " packets)\n";
+  exit(0);
+}
@@ -0,0 +1,182 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2019, Live Networks, Inc.  All rights reserved
+// A program that reads a frame trace file - written by "FrameTraceBuffer::writeToFile()" in an application
+// that uses a library compiled with FRAME_TRACING #defined - and converts it to a JSON file in
+// "Chrome trace" format (which can be viewed using "chrome://tracing" or "https://ui.perfetto.dev").
+// Each "FramedSource" is shown as a separate 'thread'; each frame is shown as an event that begins when
+// the frame was requested (by "getNextFrame()"), and ends when it was delivered.
+// main program
+
+#include <liveMedia.hh>
+#include <BasicUsageEnvironment.hh>
+#include <InputFile.hh>
+#include <OutputFile.hh>
+
+UsageEnvironment* env;
+char const* programName;
+
+void usage() {
+  *env << "usage: " << programName << " <frame-trace-file-name> [<output-json-file-name>]\n";
+  *env << "\t(if <output-json-file-name> is omitted, the output is written to stdout)\n";
+  exit(1);
+}
+
+// The state that we keep for each source:
+class SourceState {
+public:
+  SourceState(unsigned id): fId(id), fHavePendingRequest(False) {}
+
+  unsigned fId; // the 'thread id' that we use in the output
+  Boolean fHavePendingRequest;
+  double fRequestTime; // in microseconds
+  unsigned fRequestMaxSize;
+};
+
+static FILE* outFid;
+static Boolean isFirstEvent = True;
+
+static void beginEvent(char const* name, char const* phase, double timestamp, unsigned tid) {
+  fprintf(outFid, "%s\n{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%.0f,\"pid\":1,\"tid\":%u",
+	  isFirstEvent ? "" : ",", name, phase, timestamp, tid);
+  isFirstEvent = False;
+}
+
+static void outputFrame(char const* name, SourceState& source, double endTime, int frameSize) {
+  beginEvent(name, "X", source.fRequestTime, source.fId);
+  fprintf(outFid, ",\"dur\":%.0f,\"args\":{\"maxSize\":%u", endTime - source.fRequestTime, source.fRequestMaxSize);
+  if (frameSize >= 0) fprintf(outFid, ",\"frameSize\":%d", frameSize);
+  fprintf(outFid, "}}");
+  source.fHavePendingRequest = False;
+}
+
+static void outputInstant(char const* name, SourceState& source, double timestamp) {
+  beginEvent(name, "i", timestamp, source.fId);
+  fprintf(outFid, ",\"s\":\"t\"}");
+}
+
+int main(int argc, char const** argv) {
+  // Begin by setting up our usage environment:
+  TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+  env = BasicUsageEnvironment::createNew(*scheduler);
+
+  // Parse the command line:
+  programName = argv[0];
+  if (argc != 2 && argc != 3) usage();
+
+  char const* inputFileName = argv[1];
+  FILE* inFid = OpenInputFile(*env, inputFileName);
+  if (inFid == NULL) {
+    *env << "Failed to open input file \"" << inputFileName << "\" (does it exist?)\n";
+    exit(1);
+  }
+
+  FrameTraceFileHeader header;
+  if (fread(&header, sizeof header, 1, inFid) != 1
+      || strncmp(header.magic, FRAME_TRACE_FILE_MAGIC, sizeof header.magic) != 0) {
+    *env << "\"" << inputFileName << "\" is not a frame trace file\n";
+    exit(1);
+  }
+  if (header.recordSize != sizeof (FrameTraceRecord)) {
+    *env << "\"" << inputFileName << "\" was written by a different version (or build) of the library\n";
+    exit(1);
+  }
+
+  char const* outputFileName = argc == 3 ? argv[2] : "stdout";
+  outFid = OpenOutputFile(*env, outputFileName);
+  if (outFid == NULL) {
+    *env << "Failed to open output file \"" << outputFileName << "\"\n";
+    exit(1);
+  }
+
+  fprintf(outFid, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"numRecordsLost\":%u},\"traceEvents\":[", header.numRecordsLost);
+
+  // Read each record, in turn, and output the corresponding event(s).  (Timestamps are relative to the first record.)
+  HashTable* sources = HashTable::create(STRING_HASH_KEYS);
+  unsigned numSources = 0;
+  u_int32_t firstTimeSec = 0, firstTimeUSec = 0;
+  double timestamp = 0.0;
+  FrameTraceRecord record;
+  for (unsigned i = 0; i < header.numRecords; ++i) {
+    if (fread(&record, sizeof record, 1, inFid) != 1) {
+      *env << "Warning: \"" << inputFileName << "\" was truncated\n";
+      break;
+    }
+    record.mediumName[sizeof record.mediumName - 1] = '\0'; // sanity check
+
+    if (i == 0) {
+      firstTimeSec = record.timeSec;
+      firstTimeUSec = record.timeUSec;
+    }
+    timestamp = ((double)record.timeSec - (double)firstTimeSec)*1000000.0 + ((double)record.timeUSec - (double)firstTimeUSec);
+
+    SourceState* source = (SourceState*)(sources->Lookup(record.mediumName));
+    if (source == NULL) {
+      // This is a new source.  Give it a 'thread' of its own, named after the source:
+      source = new SourceState(++numSources);
+      sources->Add(record.mediumName, source);
+      beginEvent("thread_name", "M", 0.0, source->fId);
+      fprintf(outFid, ",\"args\":{\"name\":\"%s\"}}", record.mediumName);
+    }
+
+    switch (record.eventType) {
+      case FRAME_TRACE_REQUESTED: {
+	if (source->fHavePendingRequest) outputFrame("frame (no delivery)", *source, timestamp, -1);
+	source->fHavePendingRequest = True;
+	source->fRequestTime = timestamp;
+	source->fRequestMaxSize = record.frameSize;
+	break;
+      }
+      case FRAME_TRACE_DELIVERED: {
+	if (source->fHavePendingRequest) {
+	  outputFrame("frame", *source, timestamp, record.frameSize);
+	} else {
+	  outputInstant("frame (unrequested)", *source, timestamp);
+	}
+	break;
+      }
+      case FRAME_TRACE_CLOSED: {
+	if (source->fHavePendingRequest) outputFrame("frame (closed)", *source, timestamp, -1);
+	outputInstant("closed", *source, timestamp);
+	break;
+      }
+      case FRAME_TRACE_STOPPED: {
+	if (source->fHavePendingRequest) outputFrame("frame (stopped)", *source, timestamp, -1);
+	break;
+      }
+    }
+  }
+
+  // Any requests that are still pending at the end of the trace are where the pipeline stalled.  Show them as such:
+  HashTable::Iterator* iter = HashTable::Iterator::create(*sources);
+  char const* key;
+  SourceState* source;
+  while ((source = (SourceState*)(iter->next(key))) != NULL) {
+    if (source->fHavePendingRequest) outputFrame("frame (pending at end of trace)", *source, timestamp, -1);
+    delete source;
+  }
+  delete iter;
+  delete sources;
+
+  fprintf(outFid, "\n]}\n");
+  CloseOutputFile(outFid);
+  CloseInputFile(inFid);
+
+  if (header.numRecordsLost > 0) {
+    *env << "Note: The oldest " << header.numRecordsLost << " records were lost, because the trace buffer overflowed\n";
+  }
+  return 0;
+}
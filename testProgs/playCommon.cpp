@@ -1368,6 +1368,8 @@ void printQOSData(int exitCode) {
 	       << (totNumPacketsReceived == 0 ? 0.0 : totalGapsMS/totNumPacketsReceived) << "\n";
 	  *env << "inter_packet_gap_ms_max\t" << stats->maxInterPacketGapUS()/1000.0 << "\n";
 	}
+	*env << "reordering_threshold_ms\t" << src->packetReorderingThresholdTime()/1000.0 << "\n";
+	*env << "num_late_packets_dropped\t" << src->numLatePacketsDropped() << "\n";
 	
 	curQOSRecord = curQOSRecord->fNext;
       }
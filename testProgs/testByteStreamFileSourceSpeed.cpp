@@ -0,0 +1,202 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2019, Live Networks, Inc.  All rights reserved
+// A program that measures how fast a set of "ByteStreamFileSource"s - all reading at once, as in a
+// VOD server - read their files, both asynchronously (the default) and using memory mapping, and with
+// both a cold and a warm OS page cache.
+// main program
+
+#include <liveMedia.hh>
+#include <BasicUsageEnvironment.hh>
+#include <GroupsockHelper.hh> // for "gettimeofday()"
+#if !defined(__WIN32__) && !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/resource.h>
+#endif
+
+#define DEFAULT_CHUNK_SIZE (7*188) // what our Transport Stream RTSP server reads at a time
+
+UsageEnvironment* env;
+char eventLoopWatchVariable;
+unsigned numActiveSinks;
+
+// A sink that reads its source as fast as it can, and discards the data:
+class DiscardSink: public MediaSink {
+public:
+  DiscardSink(UsageEnvironment& env, unsigned bufferSize)
+    : MediaSink(env), numBytesRead(0), fBufferSize(bufferSize) {
+    fBuffer = new unsigned char[bufferSize];
+  }
+  virtual ~DiscardSink() { delete[] fBuffer; }
+
+  u_int64_t numBytesRead;
+
+private:
+  virtual Boolean continuePlaying() {
+    if (fSource == NULL) return False;
+
+    fSource->getNextFrame(fBuffer, fBufferSize, afterGettingFrame, this, onSourceClosure, this);
+    return True;
+  }
+
+  static void afterGettingFrame(void* clientData, unsigned frameSize, unsigned /*numTruncatedBytes*/,
+				struct timeval /*presentationTime*/, unsigned /*durationInMicroseconds*/) {
+    DiscardSink* sink = (DiscardSink*)clientData;
+    sink->numBytesRead += frameSize;
+    sink->continuePlaying();
+  }
+
+private:
+  unsigned char* fBuffer;
+  unsigned fBufferSize;
+};
+
+static void afterPlaying(void* /*clientData*/) {
+  if (--numActiveSinks == 0) eventLoopWatchVariable = 1;
+}
+
+static Boolean dropFromPageCache(char const* fileName) {
+#if !defined(__WIN32__) && !defined(_WIN32) && defined(POSIX_FADV_DONTNEED)
+  FILE* fid = fopen(fileName, "rb");
+  if (fid == NULL) return False;
+  int result = posix_fadvise(fileno(fid), 0, 0, POSIX_FADV_DONTNEED);
+  fclose(fid);
+  return result == 0;
+#else
+  return False;
+#endif
+}
+
+static double cpuSeconds(long& numMajorFaults) {
+#if !defined(__WIN32__) && !defined(_WIN32)
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  numMajorFaults = usage.ru_majflt;
+  return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec/1000000.0
+    + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec/1000000.0;
+#else
+  numMajorFaults = 0;
+  return 0.0;
+#endif
+}
+
+static void run(int numFiles, char** fileNames, unsigned chunkSize, unsigned estBitrate,
+		u_int64_t blockCacheSize, Boolean useMemoryMapping, Boolean coldCache) {
+  if (coldCache) {
+    // Start with an empty block cache, as well as an empty page cache:
+    FileBlockCache::setMaxSize(*env, 0);
+    for (int i = 0; i < numFiles; ++i) {
+      if (!dropFromPageCache(fileNames[i])) {
+	*env << "(Unable to drop \"" << fileNames[i] << "\" from the page cache, so the 'cold' result will be warm)\n";
+      }
+    }
+  }
+
+  FileBlockCache::setMaxSize(*env, blockCacheSize);
+  FileBlockCache* blockCache = FileBlockCache::forEnvironment(*env);
+  if (blockCache != NULL) blockCache->resetStatistics();
+
+  ByteStreamFileSource** sources = new ByteStreamFileSource*[numFiles];
+  DiscardSink** sinks = new DiscardSink*[numFiles];
+  for (int i = 0; i < numFiles; ++i) {
+    sources[i] = ByteStreamFileSource::createNew(*env, fileNames[i], chunkSize);
+    if (sources[i] == NULL) {
+      *env << "Unable to open \"" << fileNames[i] << "\": " << env->getResultMsg() << "\n";
+      exit(1);
+    }
+    if (useMemoryMapping) {
+      if (!sources[i]->useMemoryMapping(estBitrate)) {
+	*env << "Unable to memory-map \"" << fileNames[i] << "\"; reading it normally\n";
+      }
+    } else {
+      sources[i]->useAsynchronousReads(estBitrate);
+    }
+    sinks[i] = new DiscardSink(*env, chunkSize);
+  }
+
+  struct timeval startTime;
+  gettimeofday(&startTime, NULL);
+  long startMajorFaults, endMajorFaults;
+  double startCPUSeconds = cpuSeconds(startMajorFaults);
+
+  numActiveSinks = numFiles;
+  eventLoopWatchVariable = 0;
+  for (int i = 0; i < numFiles; ++i) sinks[i]->startPlaying(*sources[i], afterPlaying, NULL);
+  env->taskScheduler().doEventLoop(&eventLoopWatchVariable);
+
+  struct timeval endTime;
+  gettimeofday(&endTime, NULL);
+  double elapsedSeconds
+    = (endTime.tv_sec - startTime.tv_sec) + (endTime.tv_usec - startTime.tv_usec)/1000000.0;
+  double usedCPUSeconds = cpuSeconds(endMajorFaults) - startCPUSeconds;
+
+  u_int64_t numBytesRead = 0;
+  for (int i = 0; i < numFiles; ++i) {
+    numBytesRead += sinks[i]->numBytesRead;
+    Medium::close(sinks[i]);
+    Medium::close(sources[i]);
+  }
+  delete[] sinks; delete[] sources;
+
+  double const mBytes = (double)(int64_t)numBytesRead/1000000.0;
+  fprintf(stderr, "%-6s %-4s cache: %9.1f MB/s, %8.3f CPU seconds (%5.3f per 100 MB), %6ld major page faults\n",
+	  useMemoryMapping ? "mapped" : "async", coldCache ? "cold" : "warm",
+	  mBytes/elapsedSeconds, usedCPUSeconds, usedCPUSeconds*100.0/mBytes, endMajorFaults - startMajorFaults);
+  if (blockCache != NULL && blockCache->numLookups() > 0) { // (mapped files don't use the block cache)
+    fprintf(stderr, "\tblock cache: %5.1f%% hit rate, %.1f MB read from storage, %u blocks evicted\n",
+	    blockCache->hitRate()*100.0, (double)(int64_t)blockCache->numBytesLoaded()/1000000.0,
+	    (unsigned)blockCache->numBlocksEvicted());
+  }
+}
+
+static void usage(char const* progName) {
+  fprintf(stderr, "usage: %s [-c <chunk-size>] [-b <bitrate-in-kbps>] [-k <block-cache-size-in-MB>] <file> ...\n", progName);
+  fprintf(stderr, "\t(Name the same file more than once to see how well its readers share the block cache.)\n");
+  exit(1);
+}
+
+int main(int argc, char** argv) {
+  TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+  env = BasicUsageEnvironment::createNew(*scheduler);
+
+  char const* progName = argv[0];
+  unsigned chunkSize = DEFAULT_CHUNK_SIZE;
+  unsigned estBitrate = 0; // unknown
+  unsigned blockCacheMBytes = 0; // no block cache
+  while (argc > 1 && argv[1][0] == '-') {
+    if (argc < 3) usage(progName);
+    if (strcmp(argv[1], "-c") == 0) {
+      if (sscanf(argv[2], "%u", &chunkSize) != 1 || chunkSize == 0) usage(progName);
+    } else if (strcmp(argv[1], "-b") == 0) {
+      if (sscanf(argv[2], "%u", &estBitrate) != 1) usage(progName);
+    } else if (strcmp(argv[1], "-k") == 0) {
+      if (sscanf(argv[2], "%u", &blockCacheMBytes) != 1) usage(progName);
+    } else {
+      usage(progName);
+    }
+    argc -= 2; argv += 2;
+  }
+  if (argc < 2) usage(progName);
+
+  fprintf(stderr, "Reading %d file(s) at once, %u bytes at a time:\n", argc-1, chunkSize);
+  u_int64_t const blockCacheSize = (u_int64_t)blockCacheMBytes*1024*1024;
+  for (int useMemoryMapping = 0; useMemoryMapping <= 1; ++useMemoryMapping) {
+    run(argc-1, &argv[1], chunkSize, estBitrate, blockCacheSize, useMemoryMapping, True);
+    run(argc-1, &argv[1], chunkSize, estBitrate, blockCacheSize, useMemoryMapping, False);
+  }
+
+  return 0;
+}
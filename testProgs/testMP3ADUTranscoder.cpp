@@ -0,0 +1,114 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2019, Live Networks, Inc.  All rights reserved
+// A program that benchmarks our MP3 'ADU' code: It transcodes each MP3 file named on the command line
+// into ADUs ("Application Data Units") and back again - optionally changing the bitrate along the way -
+// and reports how long this took.
+// main program
+
+#include <liveMedia.hh>
+#include <BasicUsageEnvironment.hh>
+#include <GroupsockHelper.hh> // for "gettimeofday()"
+
+UsageEnvironment* env;
+char const* programName;
+
+void usage() {
+  *env << "usage: " << programName << " [-b <output-bitrate-in-kbps>] [-w] <mp3-file-name> ...\n";
+  *env << "\t-b: also transcode the ADUs to the given bitrate (this exercises Huffman decoding of the MP3 data)\n";
+  *env << "\t-w: write each result to \"<mp3-file-name>.out\" (otherwise it's discarded)\n";
+  exit(1);
+}
+
+char doneFlag;
+void afterPlaying(void* /*clientData*/) {
+  doneFlag = ~0;
+}
+
+int main(int argc, char const** argv) {
+  // Begin by setting up our usage environment:
+  TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+  env = BasicUsageEnvironment::createNew(*scheduler);
+
+  // Parse the command line:
+  programName = argv[0];
+  unsigned outBitrate = 0;
+  Boolean writeOutput = False;
+  while (argc > 1 && argv[1][0] == '-') {
+    if (strcmp(argv[1], "-b") == 0 && argc > 2) {
+      if (sscanf(argv[2], "%u", &outBitrate) != 1) usage();
+      ++argv; --argc;
+    } else if (strcmp(argv[1], "-w") == 0) {
+      writeOutput = True;
+    } else {
+      usage();
+    }
+    ++argv; --argc;
+  }
+  if (argc < 2) usage();
+
+  double totPlayTime = 0.0, totElapsedTime = 0.0;
+  for (int i = 1; i < argc; ++i) {
+    char const* inputFileName = argv[i];
+    MP3FileSource* fileSource = MP3FileSource::createNew(*env, inputFileName);
+    if (fileSource == NULL) {
+      *env << "Failed to open \"" << inputFileName << "\" as a MP3 file: " << env->getResultMsg() << "\n";
+      continue;
+    }
+    float playTime = fileSource->filePlayTime();
+
+    // MP3 -> ADUs [-> transcoded ADUs] -> MP3:
+    FramedSource* source;
+    if (outBitrate > 0) {
+      source = MP3Transcoder::createNew(*env, outBitrate, fileSource);
+    } else {
+      source = MP3FromADUSource::createNew(*env, ADUFromMP3Source::createNew(*env, fileSource));
+    }
+
+    char* outputFileName = new char[strlen(inputFileName) + 5];
+    sprintf(outputFileName, "%s.out", inputFileName);
+    MediaSink* sink = FileSink::createNew(*env, writeOutput ? outputFileName : "/dev/null");
+    delete[] outputFileName;
+    if (sink == NULL) {
+      *env << "Failed to create output file sink: " << env->getResultMsg() << "\n";
+      exit(1);
+    }
+
+    struct timeval startTime, endTime;
+    gettimeofday(&startTime, NULL);
+    doneFlag = 0;
+    sink->startPlaying(*source, afterPlaying, NULL);
+    env->taskScheduler().doEventLoop(&doneFlag);
+    gettimeofday(&endTime, NULL);
+
+    double elapsedTime = (endTime.tv_sec - startTime.tv_sec) + (endTime.tv_usec - startTime.tv_usec)/1000000.0;
+    *env << inputFileName << ":\t" << playTime << " seconds of audio in " << elapsedTime << " seconds";
+    if (elapsedTime > 0.0) *env << " (" << playTime/elapsedTime << "x real time)";
+    *env << "\n";
+    totPlayTime += playTime; totElapsedTime += elapsedTime;
+
+    Medium::close(sink);
+    Medium::close(source); // also closes the upstream sources
+  }
+
+  if (argc > 2) {
+    *env << "total:\t" << totPlayTime << " seconds of audio in " << totElapsedTime << " seconds";
+    if (totElapsedTime > 0.0) *env << " (" << totPlayTime/totElapsedTime << "x real time)";
+    *env << "\n";
+  }
+
+  return 0; // only to prevent compiler warning
+}
@@ -26,6 +26,14 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // To receive a "source-specific multicast" (SSM) stream, uncomment this:
 //#define USE_SSM 1
 
+// To use SMPTE 2022-1 FEC packets - from ports rtpPortNum+2 (columns) and rtpPortNum+4 (rows) - to recover lost
+// packets, uncomment this:
+//#define USE_FEC 1
+
+// To also write an index file for the Transport Stream - so that it can be seeked within (or 'trick played') by a
+// server while it's still being received - uncomment this, and redirect 'stdout' to the corresponding ".ts" file:
+//#define INDEX_FILE_NAME "out.tsx"
+
 void afterPlaying(void* clientData); // forward
 
 // A structure to hold the state of the current session.
@@ -34,6 +42,9 @@ struct sessionState_t {
   RTPSource* source;
   MediaSink* sink;
   RTCPInstance* rtcpInstance;
+#ifdef INDEX_FILE_NAME
+  MPEG2TransportStreamIndexingFilter* indexingFilter;
+#endif
 } sessionState;
 
 UsageEnvironment* env;
@@ -84,7 +95,22 @@ int main(int argc, char** argv) {
 #endif
 
   // Create the data source: a "MPEG-2 TransportStream RTP source" (which uses a 'simple' RTP payload format):
-  sessionState.source = SimpleRTPSource::createNew(*env, &rtpGroupsock, 33, 90000, "video/MP2T", 0, False /*no 'M' bit*/);
+  SimpleRTPSource* rtpSource
+    = SimpleRTPSource::createNew(*env, &rtpGroupsock, 33, 90000, "video/MP2T", 0, False /*no 'M' bit*/);
+  sessionState.source = rtpSource;
+
+#ifdef USE_FEC
+#ifdef USE_SSM
+  Groupsock columnFECGroupsock(*env, sessionAddress, sourceFilterAddress, Port(rtpPortNum+2));
+  Groupsock rowFECGroupsock(*env, sessionAddress, sourceFilterAddress, Port(rtpPortNum+4));
+#else
+  Groupsock columnFECGroupsock(*env, sessionAddress, Port(rtpPortNum+2), ttl);
+  Groupsock rowFECGroupsock(*env, sessionAddress, Port(rtpPortNum+4), ttl);
+#endif
+  SMPTE2022FECDecoder::createNew(*env, *rtpSource, &columnFECGroupsock, &rowFECGroupsock);
+  // Recovered packets can arrive up to one FEC 'matrix' late, so wait longer than usual for out-of-order packets:
+  sessionState.source->setPacketReorderingThresholdTime(500000); // 0.5 s
+#endif
 
   // Create (and start) a 'RTCP instance' for the RTP source:
   const unsigned estimatedSessionBandwidth = 5000; // in kbps; for RTCP b/w share
@@ -100,7 +126,17 @@ int main(int argc, char** argv) {
 
   // Finally, start receiving the multicast stream:
   *env << "Beginning receiving multicast stream...\n";
+#ifdef INDEX_FILE_NAME
+  sessionState.indexingFilter
+    = MPEG2TransportStreamIndexingFilter::createNew(*env, sessionState.source, INDEX_FILE_NAME);
+  if (sessionState.indexingFilter == NULL) {
+    *env << "Unable to open index file \"" << INDEX_FILE_NAME << "\": " << env->getResultMsg() << "\n";
+    exit(1);
+  }
+  sessionState.sink->startPlaying(*sessionState.indexingFilter, afterPlaying, NULL);
+#else
   sessionState.sink->startPlaying(*sessionState.source, afterPlaying, NULL);
+#endif
 
   env->taskScheduler().doEventLoop(); // does not return
 
@@ -114,5 +150,9 @@ void afterPlaying(void* /*clientData*/) {
   // End by closing the media:
   Medium::close(sessionState.rtcpInstance); // Note: Sends a RTCP BYE
   Medium::close(sessionState.sink);
+#ifdef INDEX_FILE_NAME
+  Medium::close(sessionState.indexingFilter); // also closes "sessionState.source"
+#else
   Medium::close(sessionState.source);
+#endif
 }
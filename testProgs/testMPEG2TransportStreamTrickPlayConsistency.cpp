@@ -0,0 +1,212 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2019, Live Networks, Inc.  All rights reserved
+// A program that checks that 'trick mode' operations on a MPEG-2 Transport Stream file deliver the same data
+// whether or not the Transport Stream and index files are mapped into memory.  (Mapped files are read - and
+// frames found - by different code from unmapped files.)
+// For each of a range of start times and scales, the program reads the output of a
+// "MPEG2TransportStreamTrickModeFilter" both ways, and compares the results.
+// (From mapped files, each delivery can contain several index records' data - all from the same frame - rather
+// than just one, so the number of deliveries - and the presentation times of the data that's batched like this -
+// can differ.  These differences are reported, but are not failures.)
+// As with "testMPEG2TransportStreamTrickPlay", there must also be an index file (with suffix ".tsx") present.
+// main program
+
+#include <liveMedia.hh>
+#include <BasicUsageEnvironment.hh>
+
+UsageEnvironment* env;
+char const* programName;
+char eventLoopWatchVariable;
+
+// A sink that collects all of the data that it receives, along with each delivery's size and presentation time:
+class CollectingSink: public MediaSink {
+public:
+  CollectingSink(UsageEnvironment& env)
+    : MediaSink(env), fBufferSize(1000000), fDataSize(0), fMaxNumDeliveries(1000), fNumDeliveries(0) {
+    fBuffer = new unsigned char[fBufferSize];
+    fDeliveries = new Delivery[fMaxNumDeliveries];
+  }
+  virtual ~CollectingSink() { delete[] fBuffer; delete[] fDeliveries; }
+
+  unsigned char const* data() const { return fBuffer; }
+  unsigned dataSize() const { return fDataSize; }
+  unsigned numDeliveries() const { return fNumDeliveries; }
+
+  unsigned numBytesWithDifferentPresentationTimes(CollectingSink const& other) const {
+    // Assumes that our data is the same as "other"s:
+    unsigned result = 0, i = 0, j = 0, offset = 0;
+    while (i < fNumDeliveries && j < other.fNumDeliveries) {
+      unsigned end = fDeliveries[i].end < other.fDeliveries[j].end ? fDeliveries[i].end : other.fDeliveries[j].end;
+      if (fDeliveries[i].presentationTime.tv_sec != other.fDeliveries[j].presentationTime.tv_sec
+	  || fDeliveries[i].presentationTime.tv_usec != other.fDeliveries[j].presentationTime.tv_usec) {
+	result += end - offset;
+      }
+      offset = end;
+      if (fDeliveries[i].end == end) ++i;
+      if (other.fDeliveries[j].end == end) ++j;
+    }
+    return result;
+  }
+
+private:
+  virtual Boolean continuePlaying() {
+    if (fSource == NULL) return False;
+
+    if (fBufferSize - fDataSize < READ_SIZE) { // make room for more data
+      unsigned char* newBuffer = new unsigned char[2*fBufferSize];
+      memmove(newBuffer, fBuffer, fDataSize);
+      delete[] fBuffer;
+      fBuffer = newBuffer;
+      fBufferSize *= 2;
+    }
+    fSource->getNextFrame(&fBuffer[fDataSize], READ_SIZE, afterGettingFrame, this, onSourceClosure, this);
+    return True;
+  }
+
+  static void afterGettingFrame(void* clientData, unsigned frameSize, unsigned /*numTruncatedBytes*/,
+				struct timeval presentationTime, unsigned /*durationInMicroseconds*/) {
+    CollectingSink* sink = (CollectingSink*)clientData;
+    sink->afterGettingFrame(frameSize, presentationTime);
+  }
+  void afterGettingFrame(unsigned frameSize, struct timeval presentationTime) {
+    fDataSize += frameSize;
+    if (frameSize > 0) {
+      if (fNumDeliveries == fMaxNumDeliveries) {
+	Delivery* newDeliveries = new Delivery[2*fMaxNumDeliveries];
+	memmove(newDeliveries, fDeliveries, fNumDeliveries*sizeof (Delivery));
+	delete[] fDeliveries;
+	fDeliveries = newDeliveries;
+	fMaxNumDeliveries *= 2;
+      }
+      fDeliveries[fNumDeliveries].end = fDataSize;
+      fDeliveries[fNumDeliveries].presentationTime = presentationTime;
+      ++fNumDeliveries;
+    }
+    continuePlaying();
+  }
+
+private:
+  enum { READ_SIZE = 100*TRANSPORT_PACKET_SIZE };
+  unsigned char* fBuffer;
+  unsigned fBufferSize, fDataSize;
+  struct Delivery {
+    unsigned end; // offset (in "fBuffer") of the end of this delivery's data
+    struct timeval presentationTime;
+  };
+  Delivery* fDeliveries;
+  unsigned fMaxNumDeliveries, fNumDeliveries;
+};
+
+static void afterPlaying(void* /*clientData*/) {
+  eventLoopWatchVariable = 1;
+}
+
+static CollectingSink* readTrickModeData(char const* inputFileName, char const* indexFileName,
+					 float startTime, int scale, Boolean useMemoryMapping) {
+  FramedSource* input = ByteStreamFileSource::createNew(*env, inputFileName, TRANSPORT_PACKET_SIZE);
+  MPEG2TransportStreamIndexFile* indexFile
+    = MPEG2TransportStreamIndexFile::createNew(*env, indexFileName, useMemoryMapping);
+  if (input == NULL || indexFile == NULL) {
+    *env << "Failed to open \"" << inputFileName << "\" or \"" << indexFileName << "\"\n";
+    exit(1);
+  }
+
+  MPEG2TransportStreamTrickModeFilter* trickModeFilter
+    = MPEG2TransportStreamTrickModeFilter::createNew(*env, input, indexFile, scale, useMemoryMapping);
+  if (startTime > 0.0f) {
+    unsigned long tsRecordNumber, indexRecordNumber;
+    indexFile->lookupTSPacketNumFromNPT(startTime, tsRecordNumber, indexRecordNumber);
+    trickModeFilter->seekTo(tsRecordNumber, indexRecordNumber);
+  }
+
+  CollectingSink* sink = new CollectingSink(*env);
+  eventLoopWatchVariable = 0;
+  sink->startPlaying(*trickModeFilter, afterPlaying, NULL);
+  env->taskScheduler().doEventLoop(&eventLoopWatchVariable);
+
+  sink->stopPlaying();
+  Medium::close(trickModeFilter); // also closes "input"
+  Medium::close(indexFile);
+  return sink;
+}
+
+void usage() {
+  *env << "usage: " << programName << " <input-transport-stream-file-name>\n";
+  *env << "\twhere\t<transport-stream-file-name> ends with \".ts\"\n";
+  exit(1);
+}
+
+int main(int argc, char const** argv) {
+  // Begin by setting up our usage environment:
+  TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+  env = BasicUsageEnvironment::createNew(*scheduler);
+
+  // Parse the command line:
+  programName = argv[0];
+  if (argc != 2) usage();
+
+  char const* inputFileName = argv[1];
+  int len = strlen(inputFileName);
+  if (len < 4 || strcmp(&inputFileName[len-3], ".ts") != 0) {
+    *env << "ERROR: input file name \"" << inputFileName
+	 << "\" does not end with \".ts\"\n";
+    usage();
+  }
+  char* indexFileName = new char[len+2]; // allow for trailing x\0
+  sprintf(indexFileName, "%sx", inputFileName);
+
+  MPEG2TransportStreamIndexFile* indexFile = MPEG2TransportStreamIndexFile::createNew(*env, indexFileName);
+  if (indexFile == NULL) {
+    *env << "Failed to open index file \"" << indexFileName << "\" (does it exist?)\n";
+    exit(1);
+  }
+  float const duration = indexFile->getPlayingDuration();
+  Medium::close(indexFile);
+
+  float const startFractions[] = { 0.0f, 0.25f, 0.5f, 0.9f };
+  int const scales[] = { 1, 2, 4, 8, 16, -1, -2, -4, -8, -16 };
+  unsigned numCases = 0, numMismatches = 0;
+  for (unsigned i = 0; i < sizeof startFractions/sizeof startFractions[0]; ++i) {
+    for (unsigned j = 0; j < sizeof scales/sizeof scales[0]; ++j) {
+      float const startTime = startFractions[i]*duration;
+      int const scale = scales[j];
+
+      CollectingSink* mapped = readTrickModeData(inputFileName, indexFileName, startTime, scale, True);
+      CollectingSink* unmapped = readTrickModeData(inputFileName, indexFileName, startTime, scale, False);
+      Boolean const match = mapped->dataSize() == unmapped->dataSize()
+	&& memcmp(mapped->data(), unmapped->data(), mapped->dataSize()) == 0;
+
+      *env << "start time " << startTime << ", scale " << scale << ": "
+	   << mapped->dataSize() << " bytes (mapped), " << unmapped->dataSize() << " bytes (unmapped): ";
+      if (match) {
+	*env << "same data (in " << mapped->numDeliveries() << " vs. " << unmapped->numDeliveries() << " deliveries; "
+	     << mapped->numBytesWithDifferentPresentationTimes(*unmapped) << " bytes with different presentation times)\n";
+      } else {
+	*env << "DIFFERENT data\n";
+      }
+      ++numCases;
+      if (!match) ++numMismatches;
+
+      Medium::close(mapped);
+      Medium::close(unmapped);
+    }
+  }
+  delete[] indexFileName;
+
+  *env << numMismatches << " of " << numCases << " cases differed\n";
+  return numMismatches == 0 ? 0 : 1;
+}
@@ -34,10 +34,20 @@ Boolean const isSSM = False;
 //#define IMPLEMENT_RTSP_SERVER 1
 // (Note that this RTSP server works for multicast only)
 
+// To also send SMPTE 2022-1 FEC packets - to ports rtpPortNum+2 (columns) and rtpPortNum+4 (rows) - uncomment the following:
+//#define USE_FEC 1
+// (The receiver ("testMPEG2TransportReceiver") must be built with the same setting to make use of them.)
+#define FEC_NUM_COLUMNS 10
+#define FEC_NUM_ROWS 10
+
 #define TRANSPORT_PACKET_SIZE 188
 #define TRANSPORT_PACKETS_PER_NETWORK_PACKET 7
 // The product of these two numbers must be enough to fit within a network packet
 
+// To send at a constant bit rate - exactly TRANSPORT_PACKETS_PER_NETWORK_PACKET packets per network packet,
+// paced from the stream's PCRs - uncomment the following:
+//#define USE_CBR_PACING 1
+
 UsageEnvironment* env;
 char const* inputFileName = "test.ts";
 FramedSource* videoSource;
@@ -82,6 +92,18 @@ int main(int argc, char** argv) {
     SimpleRTPSink::createNew(*env, &rtpGroupsock, 33, 90000, "video", "MP2T",
 			     1, True, False /*no 'M' bit*/);
 
+#ifdef USE_FEC
+  // Protect the RTP stream with FEC:
+  Groupsock columnFECGroupsock(*env, destinationAddress, Port(rtpPortNum+2), ttl);
+  Groupsock rowFECGroupsock(*env, destinationAddress, Port(rtpPortNum+4), ttl);
+#ifdef USE_SSM
+  columnFECGroupsock.multicastSendOnly();
+  rowFECGroupsock.multicastSendOnly();
+#endif
+  SMPTE2022FECEncoder::createNew(*env, *videoSink, &columnFECGroupsock, &rowFECGroupsock,
+				 FEC_NUM_COLUMNS, FEC_NUM_ROWS);
+#endif
+
   // Create (and start) a 'RTCP instance' for this RTP sink:
   const unsigned estimatedSessionBandwidth = 5000; // in kbps; for RTCP b/w share
   const unsigned maxCNAMElen = 100;
@@ -150,7 +172,11 @@ void play() {
   }
 
   // Create a 'framer' for the input source (to give us proper inter-packet gaps):
-  videoSource = MPEG2TransportStreamFramer::createNew(*env, fileSource);
+  MPEG2TransportStreamFramer* framer = MPEG2TransportStreamFramer::createNew(*env, fileSource);
+#ifdef USE_CBR_PACING
+  framer->enableCBRPacing(TRANSPORT_PACKETS_PER_NETWORK_PACKET);
+#endif
+  videoSource = framer;
 
   // Finally, start playing:
   *env << "Beginning to read from file...\n";
@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "liveMedia.hh"
 #include "BasicUsageEnvironment.hh"
+#include "GroupsockHelper.hh"
 
 UsageEnvironment* env;
 
@@ -33,6 +34,11 @@ Boolean reuseFirstSource = False;
 // change the following "False" to "True":
 Boolean iFramesOnly = False;
 
+// To have clients that play the same file share one in-memory copy of its data
+// (so that a popular file is read from storage just once, however many clients
+// are playing it), change the following 0 to the most memory (in bytes) to use for this:
+u_int64_t fileBlockCacheSize = 0;
+
 static void announceStream(RTSPServer* rtspServer, ServerMediaSession* sms,
 			   char const* streamName, char const* inputFileName); // fwd
 
@@ -50,10 +56,14 @@ static void onOggDemuxCreation(OggFileServerDemux* newDemux, void* /*clientData*
   newDemuxWatchVariable = 1;
 }
 
+static MPEG2TransportStreamProgramSplitter* programSplitter;
+static void onNewTransportStreamProgram(void* clientData, u_int16_t programNumber); // fwd
+
 int main(int argc, char** argv) {
   // Begin by setting up our usage environment:
   TaskScheduler* scheduler = BasicTaskScheduler::createNew();
   env = BasicUsageEnvironment::createNew(*scheduler);
+  FileBlockCache::setMaxSize(*env, fileBlockCacheSize);
 
   UserAuthenticationDatabase* authDB = NULL;
 #ifdef ACCESS_CONTROL
@@ -429,6 +439,30 @@ int main(int argc, char** argv) {
     delete[] url;
   }
 
+  // Each program of a (multi-program) MPEG-2 Transport Stream, coming from a live UDP source:
+  // (A single "MPEG2TransportStreamProgramSplitter" reads the multiplex once, and feeds a separate
+  // "ServerMediaSession" - added when the program is first seen - for each program.)
+  {
+    char const* inputAddressStr = "239.255.42.42";
+        // (Note: If the input UDP source is unicast rather than multicast, then change this to "0.0.0.0".)
+    portNumBits const inputPortNum = 1236;
+    Boolean const inputStreamIsRawUDP = True;
+    struct in_addr inputAddress;
+    inputAddress.s_addr = our_inet_addr(inputAddressStr);
+    Groupsock* inputGroupsock = new Groupsock(*env, inputAddress, Port(inputPortNum), 255);
+    FramedSource* transportStreamSource;
+    if (inputStreamIsRawUDP) {
+      transportStreamSource = BasicUDPSource::createNew(*env, inputGroupsock);
+    } else {
+      transportStreamSource = SimpleRTPSource::createNew(*env, inputGroupsock, 33, 90000, "video/MP2T", 0, False /*no 'M' bit*/);
+    }
+    programSplitter = MPEG2TransportStreamProgramSplitter::createNew(*env, transportStreamSource);
+    programSplitter->setNewProgramHandler(onNewTransportStreamProgram, rtspServer);
+
+    *env << "\nEach program of a UDP Transport Stream input source (IP multicast address " << inputAddressStr
+	 << ", port " << inputPortNum << ")\n\twill be added as a stream named \"mpeg2TransportStreamProgram-<program_number>\"\n";
+  }
+
   // Also, attempt to create a HTTP server for RTSP-over-HTTP tunneling.
   // Try first with the default HTTP port (80), and then with the alternative HTTP
   // port numbers (8000 and 8080).
@@ -444,6 +478,21 @@ int main(int argc, char** argv) {
   return 0; // only to prevent compiler warning
 }
 
+static void onNewTransportStreamProgram(void* clientData, u_int16_t programNumber) {
+  RTSPServer* rtspServer = (RTSPServer*)clientData;
+
+  char streamName[100];
+  sprintf(streamName, "mpeg2TransportStreamProgram-%u", programNumber);
+  ServerMediaSession* sms
+    = ServerMediaSession::createNew(*env, streamName, streamName,
+				    "Session streamed by \"testOnDemandRTSPServer\"");
+  sms->addSubsession(MPEG2TransportStreamProgramServerMediaSubsession
+		     ::createNew(*env, *programSplitter, programNumber));
+  rtspServer->addServerMediaSession(sms);
+
+  announceStream(rtspServer, sms, streamName, "a UDP Transport Stream multiplex");
+}
+
 static void announceStream(RTSPServer* rtspServer, ServerMediaSession* sms,
 			   char const* streamName, char const* inputFileName) {
   char* url = rtspServer->rtspURL(sms);
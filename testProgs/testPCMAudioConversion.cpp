@@ -0,0 +1,147 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2019, Live Networks, Inc.  All rights reserved
+// A program that checks our PCM audio conversion functions (u-Law encoding and decoding, and
+// byte swapping) against straightforward per-sample code - over every possible input value -
+// and then compares their speed.
+// main program
+
+#include <liveMedia.hh>
+#include <GroupsockHelper.hh> // for "gettimeofday()"
+
+#define NUM_SAMPLES 65536 // per buffer
+#define DEFAULT_NUM_ITERATIONS 2000
+
+unsigned numIterations = DEFAULT_NUM_ITERATIONS;
+unsigned numSamplesPerBuffer = NUM_SAMPLES;
+    // (not a constant, so that the compiler can't specialize the per-sample loops below for it)
+
+static double secondsSince(struct timeval const& startTime) {
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+  return (timeNow.tv_sec - startTime.tv_sec) + (timeNow.tv_usec - startTime.tv_usec)/1000000.0;
+}
+
+static void report(char const* name, double refSeconds, double seconds) {
+  double const mSamples = numSamplesPerBuffer*(double)numIterations/1000000.0;
+  fprintf(stderr, "%-28s per-sample: %8.1f Msamples/s  buffer: %8.1f Msamples/s (x%.1f)\n", name,
+	  mSamples/refSeconds, mSamples/seconds, refSeconds/seconds);
+}
+
+static unsigned numErrors = 0;
+static void check(char const* name, void const* result, void const* expected, unsigned size) {
+  if (memcmp(result, expected, size) != 0) {
+    fprintf(stderr, "%s: MISMATCH\n", name);
+    ++numErrors;
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && sscanf(argv[1], "%u", &numIterations) != 1) {
+    fprintf(stderr, "usage: %s [<number-of-iterations>]\n", argv[0]);
+    return 1;
+  }
+
+  u_int8_t* pcm = new u_int8_t[2*NUM_SAMPLES]; // every possible 16-bit value, in host order
+  u_int8_t* pcmLE = new u_int8_t[2*NUM_SAMPLES]; // the same values, little-endian
+  u_int8_t* pcmBE = new u_int8_t[2*NUM_SAMPLES]; // the same values, big-endian
+  u_int8_t* uLaw = new u_int8_t[NUM_SAMPLES];
+  u_int8_t* expected = new u_int8_t[3*NUM_SAMPLES];
+  u_int8_t* result = new u_int8_t[3*NUM_SAMPLES];
+  unsigned i, j;
+
+  for (i = 0; i < NUM_SAMPLES; ++i) {
+    u_int16_t value = (u_int16_t)i;
+    memcpy(&pcm[2*i], &value, 2);
+    pcmLE[2*i] = value&0xFF; pcmLE[2*i+1] = value>>8;
+    pcmBE[2*i] = value>>8; pcmBE[2*i+1] = value&0xFF;
+    uLaw[i] = (u_int8_t)i;
+  }
+
+  // Check each conversion function against per-sample code:
+  for (i = 0; i < NUM_SAMPLES; ++i) expected[i] = uLawFromPCMAudioSource::uLawFrom16BitLinear((u_int16_t)i);
+  uLawFromPCMAudioSource::uLawFromPCM(result, pcm, NUM_SAMPLES, 0);
+  check("uLawFromPCM (host order)", result, expected, NUM_SAMPLES);
+  uLawFromPCMAudioSource::uLawFromPCM(result, pcmLE, NUM_SAMPLES, 1);
+  check("uLawFromPCM (little-endian)", result, expected, NUM_SAMPLES);
+  uLawFromPCMAudioSource::uLawFromPCM(result, pcmBE, NUM_SAMPLES, 2);
+  check("uLawFromPCM (big-endian)", result, expected, NUM_SAMPLES);
+
+  for (i = 0; i < 256; ++i) ((u_int16_t*)expected)[i] = PCMFromuLawAudioSource::linear16FromuLaw((unsigned char)i);
+  PCMFromuLawAudioSource::PCMFromuLaw((u_int16_t*)result, uLaw, 256);
+  check("PCMFromuLaw", result, expected, 2*256);
+  memcpy(result, uLaw, 256);
+  PCMFromuLawAudioSource::PCMFromuLaw((u_int16_t*)result, result, 256);
+  check("PCMFromuLaw (in place)", result, expected, 2*256);
+
+  for (j = 0; j < 2; ++j) { // check an odd number of values also:
+    unsigned numValues = NUM_SAMPLES - j;
+    memcpy(result, pcmLE, 2*numValues);
+    EndianSwap16::swapBytes(result, numValues); check("EndianSwap16::swapBytes", result, pcmBE, 2*numValues);
+
+    for (i = 0; i < 3*numValues; ++i) result[i] = (u_int8_t)(7*i);
+    for (i = 0; i < 3*numValues; ++i) expected[i] = result[(i - i%3) + 2 - i%3];
+    EndianSwap24::swapBytes(result, numValues); check("EndianSwap24::swapBytes", result, expected, 3*numValues);
+  }
+  if (numErrors > 0) {
+    fprintf(stderr, "%u conversion function(s) gave unexpected results\n", numErrors);
+    return 1;
+  }
+  fprintf(stderr, "All conversion functions give the expected results\n");
+
+  // Then compare their speed:
+  struct timeval startTime;
+  double refSeconds, seconds;
+
+  gettimeofday(&startTime, NULL);
+  for (j = 0; j < numIterations; ++j) {
+    u_int16_t const* from = (u_int16_t const*)pcm;
+    for (i = 0; i < numSamplesPerBuffer; ++i) result[i] = uLawFromPCMAudioSource::uLawFrom16BitLinear(from[i]);
+  }
+  refSeconds = secondsSince(startTime);
+  gettimeofday(&startTime, NULL);
+  for (j = 0; j < numIterations; ++j) uLawFromPCMAudioSource::uLawFromPCM(result, pcm, numSamplesPerBuffer);
+  seconds = secondsSince(startTime);
+  report("u-Law encoding:", refSeconds, seconds);
+
+  gettimeofday(&startTime, NULL);
+  for (j = 0; j < numIterations; ++j) {
+    u_int16_t* to = (u_int16_t*)result;
+    for (i = 0; i < numSamplesPerBuffer; ++i) to[i] = PCMFromuLawAudioSource::linear16FromuLaw(pcm[i]);
+  }
+  refSeconds = secondsSince(startTime);
+  gettimeofday(&startTime, NULL);
+  for (j = 0; j < numIterations; ++j) {
+    PCMFromuLawAudioSource::PCMFromuLaw((u_int16_t*)result, pcm, numSamplesPerBuffer);
+  }
+  seconds = secondsSince(startTime);
+  report("u-Law decoding:", refSeconds, seconds);
+
+  memcpy(result, pcm, 2*NUM_SAMPLES);
+  gettimeofday(&startTime, NULL);
+  for (j = 0; j < numIterations; ++j) {
+    u_int16_t* value = (u_int16_t*)result;
+    for (i = 0; i < numSamplesPerBuffer; ++i) value[i] = ((value[i]&0xFF)<<8) | ((value[i]&0xFF00)>>8);
+  }
+  refSeconds = secondsSince(startTime);
+  gettimeofday(&startTime, NULL);
+  for (j = 0; j < numIterations; ++j) EndianSwap16::swapBytes(result, numSamplesPerBuffer);
+  seconds = secondsSince(startTime);
+  report("16-bit byte swapping:", refSeconds, seconds);
+
+  delete[] pcm; delete[] pcmLE; delete[] pcmBE; delete[] uLaw; delete[] expected; delete[] result;
+  return 0;
+}
@@ -0,0 +1,632 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2019, Live Networks, Inc.  All rights reserved
+// A program that generates load on a RTSP server, by running many concurrent RTSP client sessions (from one or more
+// processes), and then reports - for each session - its join time (the time until its first data arrived), its packet loss
+// and jitter (from "RTPReceptionStats"), its received data rate, and the data rate that the server says (in its RTCP
+// "SR" packets) that it sent, as CSV (or JSON).
+// The received data is discarded.
+// main program
+
+#include "liveMedia.hh"
+#include "BasicUsageEnvironment.hh"
+#include "GroupsockHelper.hh"
+#if !defined(__WIN32__) && !defined(_WIN32)
+#include <sys/wait.h>
+#define USE_WORKER_PROCESSES 1
+#endif
+
+UsageEnvironment* env;
+char const* progName;
+char const* rtspURL;
+unsigned numSessions = 1;
+double sessionsPerSecond = 10.0; // the ramp-up rate
+unsigned sessionDurationSecs = 30;
+unsigned percentUsingTCP = 0;
+unsigned seekIntervalSecs = 0; // 0 means: Don't seek
+unsigned pauseIntervalSecs = 0; // 0 means: Don't pause
+unsigned numWorkers = 1;
+unsigned ourWorkerNum = 0;
+Boolean outputJSON = False;
+int verbosityLevel = 0;
+
+void usage() {
+  *env << "Usage: " << progName << " [-n <num-sessions>] [-r <sessions-per-second>] [-d <session-duration-secs>]\n"
+       << "\t[-t <percent-using-TCP>] [-k <seek-interval-secs>] [-p <pause-interval-secs>]"
+#ifdef USE_WORKER_PROCESSES
+       << " [-w <num-worker-processes>]"
+#endif
+       << " [-j] [-v] <rtsp-url>\n";
+  *env << "\t-n: the total number of sessions to run (default: 1)\n";
+  *env << "\t-r: the rate at which new sessions are started (default: 10 per second)\n";
+  *env << "\t-d: how long each session lasts, unless its stream ends earlier (default: 30 seconds)\n";
+  *env << "\t-t: the percentage of sessions that request RTP-over-TCP streaming (default: 0)\n";
+  *env << "\t-k: each session seeks to a random position about this often (default: never)\n";
+  *env << "\t-p: each session pauses (for 1 second) about this often (default: never)\n";
+#ifdef USE_WORKER_PROCESSES
+  *env << "\t-w: the number of processes (each with its own event loop) to share the sessions among (default: 1)\n";
+#endif
+  *env << "\t-j: output JSON (one object per line), rather than CSV\n";
+  *env << "\t(\"server_kbits_per_second\" is computed from the server's RTCP \"SR\"s; it's -1 if fewer than two were received)\n";
+  *env << "\t-v: verbose output (from each \"RTSPClient\")\n";
+  exit(1);
+}
+
+// Forward function definitions:
+void runSessions();
+void startNextSession(void* clientData);
+void continueAfterDESCRIBE(RTSPClient* rtspClient, int resultCode, char* resultString);
+void continueAfterSETUPAndPLAY(RTSPClient* rtspClient, int resultCode, char* resultString);
+void continueAfterSeekOrResume(RTSPClient* rtspClient, int resultCode, char* resultString);
+void continueAfterPAUSE(RTSPClient* rtspClient, int resultCode, char* resultString);
+void subsessionAfterPlaying(void* clientData);
+void sessionTimerHandler(void* clientData);
+void randomActionHandler(void* clientData);
+void resumeHandler(void* clientData);
+void periodicStatsHandler(void* clientData);
+void scheduleRandomAction(RTSPClient* rtspClient);
+void endSession(RTSPClient* rtspClient, char const* result);
+
+int main(int argc, char** argv) {
+  // Begin by setting up our usage environment:
+  TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+  env = BasicUsageEnvironment::createNew(*scheduler);
+  progName = argv[0];
+
+  // unfortunately we can't use getopt() here, as Windoze doesn't have it
+  while (argc > 1) {
+    char* const opt = argv[1];
+    if (opt[0] != '-') {
+      if (argc == 2) break; // only the URL is left
+      usage();
+    }
+
+    switch (opt[1]) {
+    case 'n': case 'd': case 't': case 'k': case 'p': case 'w': {
+      unsigned value;
+      if (argc < 3 || sscanf(argv[2], "%u", &value) != 1) usage();
+      if (opt[1] == 'n') numSessions = value;
+      else if (opt[1] == 'd') sessionDurationSecs = value;
+      else if (opt[1] == 't') percentUsingTCP = value > 100 ? 100 : value;
+      else if (opt[1] == 'k') seekIntervalSecs = value;
+      else if (opt[1] == 'p') pauseIntervalSecs = value;
+      else numWorkers = value == 0 ? 1 : value;
+      ++argv; --argc;
+      break;
+    }
+
+    case 'r': {
+      if (argc < 3 || sscanf(argv[2], "%lf", &sessionsPerSecond) != 1 || sessionsPerSecond <= 0.0) usage();
+      ++argv; --argc;
+      break;
+    }
+
+    case 'j': {
+      outputJSON = True;
+      break;
+    }
+
+    case 'v': {
+      verbosityLevel = 1;
+      break;
+    }
+
+    default: {
+      usage();
+      break;
+    }
+    }
+
+    ++argv; --argc;
+  }
+  if (argc != 2) usage();
+  rtspURL = argv[1];
+
+  if (!outputJSON) {
+    fprintf(stdout, "worker,session,transport,result,join_ms,duration_secs,packets_received,packets_expected,"
+	    "packets_lost,loss_percent,max_jitter_ms,received_kbits_per_second,server_kbits_per_second,seeks,pauses\n");
+    fflush(stdout);
+  }
+
+#ifdef USE_WORKER_PROCESSES
+  if (numWorkers > 1) {
+    // Run each worker in its own process (with its own event loop).  Worker #i runs sessions #i, #i+numWorkers, etc.,
+    // starting them at the same times that they'd have been started had there been only one process:
+    for (unsigned i = 0; i < numWorkers; ++i) {
+      pid_t pid = fork();
+      if (pid < 0) {
+	*env << "fork() failed: " << env->getResultMsg() << "\n";
+	break;
+      }
+      if (pid == 0) {
+	// We're the worker process.  We need our own usage environment (and thus, event loop):
+	env->reclaim(); delete scheduler;
+	scheduler = BasicTaskScheduler::createNew();
+	env = BasicUsageEnvironment::createNew(*scheduler);
+	our_srandom(our_random32() + i); // so that each worker's random actions differ
+	ourWorkerNum = i;
+	runSessions();
+	return 0;
+      }
+    }
+    while (wait(NULL) > 0) {}
+    return 0;
+  }
+#endif
+
+  runSessions();
+  return 0;
+}
+
+// The RTCP "SR"s that we've seen for a subsession.  From these, we compute the data rate that the server sent
+// (as opposed to the rate at which we received data):
+class SenderReportHistory {
+public:
+  SenderReportHistory(): numSRs(0), firstNTPSecs(0.0), lastNTPSecs(0.0), firstOctetCount(0), lastOctetCount(0) {}
+
+  void noteSR(RTPReceptionStats const& stats) {
+    double ntpSecs = stats.lastReceivedSR_NTPmsw() + stats.lastReceivedSR_NTPlsw()/4294967296.0;
+    if (numSRs > 0 && ntpSecs == lastNTPSecs) return; // we've already seen this SR
+    if (numSRs++ == 0) {
+      firstNTPSecs = ntpSecs;
+      firstOctetCount = stats.lastReceivedSR_senderOctetCount();
+    }
+    lastNTPSecs = ntpSecs;
+    lastOctetCount = stats.lastReceivedSR_senderOctetCount();
+  }
+  Boolean getKBitsPerSecond(double& result) const {
+    if (numSRs < 2 || lastNTPSecs <= firstNTPSecs) return False;
+    result = 8*(u_int32_t)(lastOctetCount - firstOctetCount)/1000.0/(lastNTPSecs - firstNTPSecs);
+    return True;
+  }
+
+private:
+  unsigned numSRs;
+  double firstNTPSecs, lastNTPSecs;
+  u_int32_t firstOctetCount, lastOctetCount;
+};
+
+// The state that we keep for each session:
+class SessionState {
+public:
+  SessionState(unsigned sessionNum);
+  virtual ~SessionState();
+
+public:
+  unsigned sessionNum;
+  Boolean useTCP;
+  MediaSession* session;
+  double duration; // of the stream, from its SDP description (0 if unknown)
+  struct timeval startTime;
+  double joinMS; // <0 until the first data arrives
+  unsigned numSeeks, numPauses;
+  double maxJitterMS;
+  HashTable* srHistories; // maps each "MediaSubsession*" to its "SenderReportHistory*"
+  TaskToken sessionTimerTask, randomActionTask;
+};
+
+class LoadRTSPClient: public RTSPClient {
+public:
+  static LoadRTSPClient* createNew(UsageEnvironment& env, char const* rtspURL, unsigned sessionNum) {
+    return new LoadRTSPClient(env, rtspURL, sessionNum);
+  }
+
+protected:
+  LoadRTSPClient(UsageEnvironment& env, char const* rtspURL, unsigned sessionNum)
+    : RTSPClient(env, rtspURL, verbosityLevel, progName, 0, -1), ss(sessionNum) {
+  }
+    // called only by createNew();
+  virtual ~LoadRTSPClient() {
+  }
+
+public:
+  SessionState ss;
+};
+
+// A data sink that discards the data that it receives, except to note when the first data arrived:
+class DiscardSink: public MediaSink {
+public:
+  static DiscardSink* createNew(UsageEnvironment& env, LoadRTSPClient& client) {
+    return new DiscardSink(env, client);
+  }
+
+private:
+  DiscardSink(UsageEnvironment& env, LoadRTSPClient& client)
+    : MediaSink(env), fClient(client) {
+  }
+  virtual ~DiscardSink() {
+  }
+
+  static void afterGettingFrame(void* clientData, unsigned frameSize, unsigned numTruncatedBytes,
+				struct timeval presentationTime, unsigned durationInMicroseconds);
+
+private: // redefined virtual functions:
+  virtual Boolean continuePlaying();
+
+private:
+  LoadRTSPClient& fClient;
+  static u_int8_t fReceiveBuffer[100000]; // shared by all sinks, because the data gets discarded
+};
+
+u_int8_t DiscardSink::fReceiveBuffer[100000];
+
+LoadRTSPClient** activeClients; // indexed by (sessionNum/numWorkers)
+unsigned numSessionsForUs, numSessionsStarted = 0, numSessionsEnded = 0;
+unsigned numSessionsSucceeded = 0;
+double totalJoinMS = 0.0, totalKBytesReceived = 0.0;
+unsigned totalPacketsReceived = 0, totalPacketsExpected = 0;
+struct timeval firstStartTime;
+char eventLoopWatchVariable = 0;
+
+static double msSince(struct timeval const& tv) {
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+  return (timeNow.tv_sec - tv.tv_sec)*1000.0 + (timeNow.tv_usec - tv.tv_usec)/1000.0;
+}
+
+void runSessions() {
+  numSessionsForUs = numSessions/numWorkers + (ourWorkerNum < numSessions%numWorkers ? 1 : 0);
+  if (numSessionsForUs == 0) return;
+  activeClients = new LoadRTSPClient*[numSessionsForUs];
+  for (unsigned i = 0; i < numSessionsForUs; ++i) activeClients[i] = NULL;
+
+  gettimeofday(&firstStartTime, NULL);
+  env->taskScheduler().scheduleDelayedTask((int64_t)(ourWorkerNum*1000000/sessionsPerSecond), startNextSession, NULL);
+  env->taskScheduler().scheduleDelayedTask(1000000, periodicStatsHandler, NULL);
+
+  // All subsequent activity takes place within the event loop:
+  env->taskScheduler().doEventLoop(&eventLoopWatchVariable);
+
+  // Output a summary (for this process):
+  *env << "worker " << ourWorkerNum << ": " << numSessionsSucceeded << " of " << numSessionsForUs << " sessions succeeded";
+  if (numSessionsSucceeded > 0) {
+    double totalSecs = msSince(firstStartTime)/1000.0;
+    *env << "; mean join time " << totalJoinMS/numSessionsSucceeded << " ms; "
+	 << totalPacketsExpected - totalPacketsReceived << " of " << totalPacketsExpected << " packets lost; "
+	 << "mean aggregate received data rate " << (totalSecs == 0.0 ? 0.0 : 8*totalKBytesReceived/totalSecs) << " kbits/second";
+  }
+  *env << "\n";
+  delete[] activeClients;
+}
+
+void startNextSession(void* /*clientData*/) {
+  unsigned sessionNum = ourWorkerNum + numSessionsStarted*numWorkers;
+  LoadRTSPClient* rtspClient = LoadRTSPClient::createNew(*env, rtspURL, sessionNum);
+  activeClients[numSessionsStarted] = rtspClient;
+  ++numSessionsStarted;
+
+  // Give up on the session if it hasn't started playing within a reasonable time:
+  unsigned const joinTimeoutSecs = 10;
+  rtspClient->ss.sessionTimerTask
+    = env->taskScheduler().scheduleDelayedTask(joinTimeoutSecs*1000000, sessionTimerHandler, rtspClient);
+
+  rtspClient->sendDescribeCommand(continueAfterDESCRIBE);
+
+  if (numSessionsStarted < numSessionsForUs) {
+    // Schedule the start of our next session.  (We compute its start time from "firstStartTime", so that delays in
+    // handling this event don't accumulate.)
+    double nextStartMS = (ourWorkerNum + numSessionsStarted*numWorkers)*1000.0/sessionsPerSecond;
+    double delayMS = nextStartMS - msSince(firstStartTime);
+    env->taskScheduler().scheduleDelayedTask(delayMS < 0.0 ? 0 : (int64_t)(delayMS*1000), startNextSession, NULL);
+  }
+}
+
+void continueAfterDESCRIBE(RTSPClient* rtspClient, int resultCode, char* resultString) {
+  SessionState& ss = ((LoadRTSPClient*)rtspClient)->ss; // alias
+
+  if (resultCode != 0) {
+    delete[] resultString;
+    endSession(rtspClient, "DESCRIBE failed");
+    return;
+  }
+
+  ss.session = MediaSession::createNew(*env, resultString);
+  delete[] resultString;
+  if (ss.session == NULL || !ss.session->hasSubsessions()) {
+    endSession(rtspClient, "bad SDP description");
+    return;
+  }
+  // Note the stream's duration now, because the ranges in later "PLAY" responses may be open-ended:
+  ss.duration = ss.session->playEndTime() - ss.session->playStartTime();
+
+  MediaSubsessionIterator iter(*ss.session);
+  MediaSubsession* subsession;
+  while ((subsession = iter.next()) != NULL) {
+    if (subsession->initiate()) {
+      // Make sure that packets aren't dropped merely because we're slow to read them:
+      if (!ss.useTCP && subsession->rtpSource() != NULL) {
+	increaseReceiveBufferTo(*env, subsession->rtpSource()->RTPgs()->socketNum(), 200000);
+      }
+    }
+  }
+
+  // Send our "SETUP"s and "PLAY" pipelined, to minimize our join time:
+  rtspClient->sendSetupAndPlayCommands(*ss.session, continueAfterSETUPAndPLAY, ss.useTCP);
+}
+
+void continueAfterSETUPAndPLAY(RTSPClient* rtspClient, int resultCode, char* resultString) {
+  SessionState& ss = ((LoadRTSPClient*)rtspClient)->ss; // alias
+  delete[] resultString;
+
+  if (resultCode != 0) {
+    endSession(rtspClient, resultCode > 0 ? "SETUP or PLAY rejected" : "SETUP or PLAY failed");
+    return;
+  }
+
+  MediaSubsessionIterator iter(*ss.session);
+  MediaSubsession* subsession;
+  while ((subsession = iter.next()) != NULL) {
+    if (subsession->sessionId() == NULL) continue; // this subsession wasn't set up
+
+    subsession->sink = DiscardSink::createNew(*env, *(LoadRTSPClient*)rtspClient);
+    subsession->miscPtr = rtspClient;
+    subsession->sink->startPlaying(*(subsession->readSource()), subsessionAfterPlaying, subsession);
+    if (subsession->rtcpInstance() != NULL) {
+      subsession->rtcpInstance()->setByeHandler(subsessionAfterPlaying, subsession);
+    }
+  }
+
+  env->taskScheduler().rescheduleDelayedTask(ss.sessionTimerTask, sessionDurationSecs*1000000, sessionTimerHandler, rtspClient);
+  scheduleRandomAction(rtspClient);
+}
+
+void scheduleRandomAction(RTSPClient* rtspClient) {
+  SessionState& ss = ((LoadRTSPClient*)rtspClient)->ss; // alias
+
+  // Choose the interval (randomly, between 0.5 and 1.5 times the nominal interval) until our next seek or pause:
+  double intervalSecs;
+  if (seekIntervalSecs > 0 && pauseIntervalSecs > 0) {
+    intervalSecs = seekIntervalSecs*pauseIntervalSecs/(double)(seekIntervalSecs + pauseIntervalSecs);
+  } else {
+    intervalSecs = seekIntervalSecs + pauseIntervalSecs;
+  }
+  if (intervalSecs == 0.0) return;
+
+  int64_t uSecsToDelay = (int64_t)(intervalSecs*(500000 + our_random()%1000000));
+  ss.randomActionTask = env->taskScheduler().scheduleDelayedTask(uSecsToDelay, randomActionHandler, rtspClient);
+}
+
+void randomActionHandler(void* clientData) {
+  RTSPClient* rtspClient = (RTSPClient*)clientData;
+  SessionState& ss = ((LoadRTSPClient*)rtspClient)->ss; // alias
+  ss.randomActionTask = NULL;
+
+  // If we're doing both seeks and pauses, choose between them in proportion to how often each is requested:
+  Boolean doSeek;
+  if (seekIntervalSecs > 0 && pauseIntervalSecs > 0) {
+    doSeek = (unsigned)(our_random()%(seekIntervalSecs + pauseIntervalSecs)) < pauseIntervalSecs;
+  } else {
+    doSeek = seekIntervalSecs > 0;
+  }
+
+  if (doSeek && ss.duration > 0.0) {
+    double start = ss.duration*(our_random()%1000)/1000.0;
+    ++ss.numSeeks;
+    rtspClient->sendPlayCommand(*ss.session, continueAfterSeekOrResume, start);
+  } else {
+    ++ss.numPauses;
+    rtspClient->sendPauseCommand(*ss.session, continueAfterPAUSE);
+  }
+}
+
+void continueAfterSeekOrResume(RTSPClient* rtspClient, int resultCode, char* resultString) {
+  delete[] resultString;
+  if (resultCode != 0) {
+    endSession(rtspClient, "seek or resume failed");
+    return;
+  }
+
+  scheduleRandomAction(rtspClient);
+}
+
+void continueAfterPAUSE(RTSPClient* rtspClient, int resultCode, char* resultString) {
+  SessionState& ss = ((LoadRTSPClient*)rtspClient)->ss; // alias
+  delete[] resultString;
+  if (resultCode != 0) {
+    endSession(rtspClient, "PAUSE failed");
+    return;
+  }
+
+  ss.randomActionTask = env->taskScheduler().scheduleDelayedTask(1000000, resumeHandler, rtspClient);
+}
+
+void resumeHandler(void* clientData) {
+  RTSPClient* rtspClient = (RTSPClient*)clientData;
+  SessionState& ss = ((LoadRTSPClient*)rtspClient)->ss; // alias
+  ss.randomActionTask = NULL;
+
+  rtspClient->sendPlayCommand(*ss.session, continueAfterSeekOrResume, -1.0f); // resume
+}
+
+void subsessionAfterPlaying(void* clientData) {
+  MediaSubsession* subsession = (MediaSubsession*)clientData;
+  RTSPClient* rtspClient = (RTSPClient*)(subsession->miscPtr);
+
+  // Check whether all of this session's subsessions have now ended:
+  Medium::close(subsession->sink);
+  subsession->sink = NULL;
+  MediaSubsessionIterator iter(subsession->parentSession());
+  while ((subsession = iter.next()) != NULL) {
+    if (subsession->sink != NULL) return; // this subsession is still active
+  }
+
+  endSession(rtspClient, "ended");
+}
+
+void sessionTimerHandler(void* clientData) {
+  RTSPClient* rtspClient = (RTSPClient*)clientData;
+  SessionState& ss = ((LoadRTSPClient*)rtspClient)->ss; // alias
+  ss.sessionTimerTask = NULL;
+
+  endSession(rtspClient, ss.joinMS >= 0.0 ? "ok" : "timed out");
+}
+
+static void getReceptionStats(SessionState& ss, unsigned& packetsReceived, unsigned& packetsExpected,
+			      double& kBytesReceived, double& jitterMS, double& serverKBitsPerSecond) {
+  packetsReceived = packetsExpected = 0;
+  kBytesReceived = jitterMS = 0.0;
+  serverKBitsPerSecond = -1.0; // unknown
+
+  MediaSubsessionIterator iter(*ss.session);
+  MediaSubsession* subsession;
+  while ((subsession = iter.next()) != NULL) {
+    RTPSource* src = subsession->rtpSource();
+    if (src == NULL) continue;
+
+    SenderReportHistory* srHistory = (SenderReportHistory*)(ss.srHistories->Lookup((char const*)subsession));
+    if (srHistory == NULL) {
+      srHistory = new SenderReportHistory;
+      ss.srHistories->Add((char const*)subsession, srHistory);
+    }
+
+    RTPReceptionStatsDB::Iterator statsIter(src->receptionStatsDB());
+    RTPReceptionStats* stats;
+    while ((stats = statsIter.next(True)) != NULL) {
+      packetsReceived += stats->totNumPacketsReceived();
+      packetsExpected += stats->totNumPacketsExpected();
+      kBytesReceived += stats->totNumKBytesReceived();
+      if (src->timestampFrequency() > 0) {
+	double thisJitterMS = stats->jitter()*1000.0/src->timestampFrequency();
+	if (thisJitterMS > jitterMS) jitterMS = thisJitterMS;
+      }
+      if (stats->lastReceivedSR_time().tv_sec != 0) srHistory->noteSR(*stats);
+    }
+
+    double subsessionKBitsPerSecond;
+    if (srHistory->getKBitsPerSecond(subsessionKBitsPerSecond)) {
+      if (serverKBitsPerSecond < 0.0) serverKBitsPerSecond = 0.0;
+      serverKBitsPerSecond += subsessionKBitsPerSecond;
+    }
+  }
+}
+
+void periodicStatsHandler(void* /*clientData*/) {
+  // Update the maximum jitter (and the RTCP "SR"s) seen by each active session:
+  for (unsigned i = 0; i < numSessionsStarted; ++i) {
+    LoadRTSPClient* rtspClient = activeClients[i];
+    if (rtspClient == NULL || rtspClient->ss.session == NULL) continue;
+
+    unsigned packetsReceived, packetsExpected; double kBytesReceived, jitterMS, serverKBitsPerSecond;
+    getReceptionStats(rtspClient->ss, packetsReceived, packetsExpected, kBytesReceived, jitterMS,
+		      serverKBitsPerSecond);
+    if (jitterMS > rtspClient->ss.maxJitterMS) rtspClient->ss.maxJitterMS = jitterMS;
+  }
+
+  env->taskScheduler().scheduleDelayedTask(1000000, periodicStatsHandler, NULL);
+}
+
+void endSession(RTSPClient* rtspClient, char const* result) {
+  SessionState& ss = ((LoadRTSPClient*)rtspClient)->ss; // alias
+
+  unsigned packetsReceived = 0, packetsExpected = 0;
+  double kBytesReceived = 0.0, jitterMS = 0.0, serverKBitsPerSecond = -1.0;
+  Boolean someSubsessionsWereActive = False;
+  if (ss.session != NULL) {
+    getReceptionStats(ss, packetsReceived, packetsExpected, kBytesReceived, jitterMS, serverKBitsPerSecond);
+    if (jitterMS > ss.maxJitterMS) ss.maxJitterMS = jitterMS;
+
+    MediaSubsessionIterator iter(*ss.session);
+    MediaSubsession* subsession;
+    while ((subsession = iter.next()) != NULL) {
+      if (subsession->sessionId() != NULL) someSubsessionsWereActive = True;
+      if (subsession->sink != NULL) {
+	Medium::close(subsession->sink);
+	subsession->sink = NULL;
+	if (subsession->rtcpInstance() != NULL) subsession->rtcpInstance()->setByeHandler(NULL, NULL);
+      }
+    }
+  }
+
+  // Output a record for this session:
+  double durationSecs = msSince(ss.startTime)/1000.0;
+  double playSecs = ss.joinMS < 0.0 ? 0.0 : durationSecs - ss.joinMS/1000.0;
+  unsigned packetsLost = packetsExpected > packetsReceived ? packetsExpected - packetsReceived : 0;
+  double lossPercent = packetsExpected == 0 ? 0.0 : 100.0*packetsLost/packetsExpected;
+  double receivedKBitsPerSecond = playSecs <= 0.0 ? 0.0 : 8*kBytesReceived/playSecs;
+  char const* transport = ss.useTCP ? "TCP" : "UDP";
+  if (outputJSON) {
+    fprintf(stdout, "{\"worker\":%u,\"session\":%u,\"transport\":\"%s\",\"result\":\"%s\",\"join_ms\":%.3f,"
+	    "\"duration_secs\":%.3f,\"packets_received\":%u,\"packets_expected\":%u,\"packets_lost\":%u,"
+	    "\"loss_percent\":%.3f,\"max_jitter_ms\":%.3f,\"received_kbits_per_second\":%.1f,"
+	    "\"server_kbits_per_second\":%.1f,\"seeks\":%u,\"pauses\":%u}\n",
+	    ourWorkerNum, ss.sessionNum, transport, result, ss.joinMS, durationSecs, packetsReceived, packetsExpected,
+	    packetsLost, lossPercent, ss.maxJitterMS, receivedKBitsPerSecond, serverKBitsPerSecond,
+	    ss.numSeeks, ss.numPauses);
+  } else {
+    fprintf(stdout, "%u,%u,%s,%s,%.3f,%.3f,%u,%u,%u,%.3f,%.3f,%.1f,%.1f,%u,%u\n",
+	    ourWorkerNum, ss.sessionNum, transport, result, ss.joinMS, durationSecs, packetsReceived, packetsExpected,
+	    packetsLost, lossPercent, ss.maxJitterMS, receivedKBitsPerSecond, serverKBitsPerSecond,
+	    ss.numSeeks, ss.numPauses);
+  }
+  fflush(stdout); // so that output lines from different worker processes don't get interleaved
+
+  if (ss.joinMS >= 0.0) {
+    ++numSessionsSucceeded;
+    totalJoinMS += ss.joinMS;
+    totalKBytesReceived += kBytesReceived;
+    totalPacketsReceived += packetsReceived;
+    totalPacketsExpected += packetsExpected;
+  }
+
+  if (someSubsessionsWereActive) {
+    // Tell the server to shut down the stream.  (Don't bother handling the response.)
+    rtspClient->sendTeardownCommand(*ss.session, NULL);
+  }
+  activeClients[ss.sessionNum/numWorkers] = NULL;
+  Medium::close(rtspClient);
+    // Note that this will also cause this session's "SessionState" structure to get reclaimed.
+
+  if (++numSessionsEnded == numSessionsForUs) eventLoopWatchVariable = 1;
+}
+
+
+// Implementation of "SessionState":
+
+SessionState::SessionState(unsigned sessionNum)
+  : sessionNum(sessionNum), useTCP((sessionNum+1)*percentUsingTCP/100 > sessionNum*percentUsingTCP/100),
+    session(NULL), duration(0.0),
+    joinMS(-1.0), numSeeks(0), numPauses(0), maxJitterMS(0.0),
+    srHistories(HashTable::create(ONE_WORD_HASH_KEYS)), sessionTimerTask(NULL), randomActionTask(NULL) {
+  gettimeofday(&startTime, NULL);
+}
+
+SessionState::~SessionState() {
+  env->taskScheduler().unscheduleDelayedTask(sessionTimerTask);
+  env->taskScheduler().unscheduleDelayedTask(randomActionTask);
+  SenderReportHistory* srHistory;
+  while ((srHistory = (SenderReportHistory*)srHistories->RemoveNext()) != NULL) delete srHistory;
+  delete srHistories;
+  Medium::close(session);
+}
+
+
+// Implementation of "DiscardSink":
+
+void DiscardSink::afterGettingFrame(void* clientData, unsigned /*frameSize*/, unsigned /*numTruncatedBytes*/,
+				    struct timeval /*presentationTime*/, unsigned /*durationInMicroseconds*/) {
+  DiscardSink* sink = (DiscardSink*)clientData;
+  SessionState& ss = sink->fClient.ss; // alias
+  if (ss.joinMS < 0.0) ss.joinMS = msSince(ss.startTime);
+
+  sink->continuePlaying();
+}
+
+Boolean DiscardSink::continuePlaying() {
+  if (fSource == NULL) return False; // sanity check (should not happen)
+
+  fSource->getNextFrame(fReceiveBuffer, sizeof fReceiveBuffer, afterGettingFrame, this, onSourceClosure, this);
+  return True;
+}
@@ -0,0 +1,211 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2019, Live Networks, Inc.  All rights reserved
+// A program that checks a "SharedMemoryFramedSource" against a producer (in a child process) that writes frames
+// into its "SharedMemoryRing".  Each frame (of varying size, so that the ring wraps around - and fills up - often)
+// must be delivered intact, and in order.  Also, the ring's UNIX-domain socket must have the same permissions as
+// the ring file.
+// (This is currently supported only on Linux.)
+// main program
+
+#include <liveMedia.hh>
+#include <BasicUsageEnvironment.hh>
+#if defined(__linux__)
+#include <sys/stat.h>
+#include <sys/wait.h>
+#define HAVE_SHARED_MEMORY_RING 1
+#endif
+
+UsageEnvironment* env;
+char const* programName;
+char eventLoopWatchVariable = 0;
+
+#ifdef HAVE_SHARED_MEMORY_RING
+#define NUM_FRAMES 5000
+#define MAX_FRAME_SIZE 6000
+#define RING_DATA_SIZE 65536
+
+// The size and contents of each frame that the producer writes:
+static unsigned frameSize(unsigned frameNum) {
+  return 1 + (frameNum*7919)%MAX_FRAME_SIZE;
+}
+static u_int8_t frameByte(unsigned frameNum, unsigned i) {
+  return (u_int8_t)(frameNum + i*31);
+}
+
+static int runProducer(char const* ringFileName) {
+  SharedMemoryRing* ring = NULL;
+  for (unsigned i = 0; i < 500 && ring == NULL; ++i) {
+    ring = SharedMemoryRing::openExisting(ringFileName);
+    if (ring == NULL) usleep(10000);
+  }
+  if (ring == NULL) {
+    fprintf(stderr, "producer: failed to open \"%s\": %s\n", ringFileName, strerror(errno));
+    return 1;
+  }
+
+  u_int8_t frame[MAX_FRAME_SIZE];
+  for (unsigned frameNum = 0; frameNum < NUM_FRAMES; ++frameNum) {
+    unsigned const size = frameSize(frameNum);
+    struct timeval presentationTime;
+    presentationTime.tv_sec = frameNum + 1;
+    presentationTime.tv_usec = frameNum;
+
+    // Alternate between writing frames directly into the ring, and copying them in:
+    while (1) {
+      if (frameNum%2 == 0) {
+	u_int8_t* to = ring->reserveFrame(size);
+	if (to != NULL) {
+	  for (unsigned i = 0; i < size; ++i) to[i] = frameByte(frameNum, i);
+	  ring->commitFrame(size, presentationTime);
+	  break;
+	}
+      } else {
+	for (unsigned i = 0; i < size; ++i) frame[i] = frameByte(frameNum, i);
+	if (ring->writeFrame(frame, size, presentationTime)) break;
+      }
+      usleep(1000); // the ring is full; wait for the consumer to catch up
+    }
+  }
+
+  delete ring;
+  return 0;
+}
+
+// A sink that checks each frame that it receives:
+class CheckingSink: public MediaSink {
+public:
+  CheckingSink(UsageEnvironment& env): MediaSink(env), fNumFramesReceived(0), fNumBadFrames(0) {}
+
+  unsigned numFramesReceived() const { return fNumFramesReceived; }
+  unsigned numBadFrames() const { return fNumBadFrames; }
+
+private:
+  virtual Boolean continuePlaying() {
+    if (fSource == NULL) return False;
+
+    fSource->getNextFrame(fBuffer, sizeof fBuffer, afterGettingFrame, this, onSourceClosure, this);
+    return True;
+  }
+
+  static void afterGettingFrame(void* clientData, unsigned frameSize, unsigned numTruncatedBytes,
+				struct timeval presentationTime, unsigned /*durationInMicroseconds*/) {
+    CheckingSink* sink = (CheckingSink*)clientData;
+    sink->afterGettingFrame(frameSize, numTruncatedBytes, presentationTime);
+  }
+  void afterGettingFrame(unsigned size, unsigned numTruncatedBytes, struct timeval presentationTime) {
+    unsigned const frameNum = fNumFramesReceived++;
+    Boolean isGood = size == frameSize(frameNum) && numTruncatedBytes == 0
+      && presentationTime.tv_sec == (long)(frameNum + 1) && presentationTime.tv_usec == (long)frameNum;
+    for (unsigned i = 0; isGood && i < size; ++i) isGood = fBuffer[i] == frameByte(frameNum, i);
+    if (!isGood) {
+      if (fNumBadFrames++ == 0) {
+	*env << "Frame " << frameNum << " (" << size << " bytes, expected " << frameSize(frameNum) << ") is bad\n";
+      }
+    }
+
+    if (fNumFramesReceived == NUM_FRAMES) {
+      eventLoopWatchVariable = 1;
+    } else {
+      continuePlaying();
+    }
+  }
+
+private:
+  u_int8_t fBuffer[MAX_FRAME_SIZE];
+  unsigned fNumFramesReceived, fNumBadFrames;
+};
+
+static void timeoutHandler(void* /*clientData*/) {
+  *env << "Timed out\n";
+  eventLoopWatchVariable = 1;
+}
+
+#endif
+
+void usage() {
+  *env << "usage: " << programName << " [<ring-file-name>]\n";
+  *env << "\t(the default <ring-file-name> is \"/tmp/testSharedMemoryRing\")\n";
+  exit(1);
+}
+
+int main(int argc, char const** argv) {
+  // Begin by setting up our usage environment:
+  TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+  env = BasicUsageEnvironment::createNew(*scheduler);
+
+  // Parse the command line:
+  programName = argv[0];
+  if (argc > 2) usage();
+  char const* ringFileName = argc == 2 ? argv[1] : "/tmp/testSharedMemoryRing";
+
+#ifndef HAVE_SHARED_MEMORY_RING
+  *env << "\"SharedMemoryFramedSource\" is not supported on this platform (" << ringFileName << ")\n";
+  return 0;
+#else
+
+  SharedMemoryFramedSource* source = SharedMemoryFramedSource::createNew(*env, ringFileName, RING_DATA_SIZE);
+  if (source == NULL) {
+    *env << "Failed to create a shared memory ring in \"" << ringFileName << "\": " << env->getResultMsg() << "\n";
+    exit(1);
+  }
+  Boolean succeeded = True;
+
+  // Check the socket's permissions:
+  char* socketPath = new char[strlen(ringFileName) + 5 + 1];
+  sprintf(socketPath, "%s.sock", ringFileName);
+  struct stat ringFileStatus, socketStatus;
+  if (stat(ringFileName, &ringFileStatus) < 0 || stat(socketPath, &socketStatus) < 0
+      || (ringFileStatus.st_mode&0777) != (socketStatus.st_mode&0777)) {
+    *env << "The socket \"" << socketPath << "\" does not have the same permissions as the ring file\n";
+    succeeded = False;
+  }
+  delete[] socketPath;
+
+  fflush(stdout); fflush(stderr); // so that the producer doesn't inherit (and output again) any buffered output
+  pid_t producerPid = fork();
+  if (producerPid < 0) {
+    *env << "fork() failed\n";
+    exit(1);
+  }
+  if (producerPid == 0) _exit(runProducer(ringFileName)); // we're the producer
+
+  CheckingSink* sink = new CheckingSink(*env);
+  sink->startPlaying(*source, NULL, NULL);
+  TaskToken timeoutTask = env->taskScheduler().scheduleDelayedTask(60*1000000, timeoutHandler, NULL);
+  env->taskScheduler().doEventLoop(&eventLoopWatchVariable);
+  env->taskScheduler().unscheduleDelayedTask(timeoutTask);
+
+  int producerStatus;
+  if (waitpid(producerPid, &producerStatus, 0) < 0 || !WIFEXITED(producerStatus)
+      || WEXITSTATUS(producerStatus) != 0) {
+    *env << "The producer failed\n";
+    succeeded = False;
+  }
+
+  *env << "Received " << sink->numFramesReceived() << " of " << NUM_FRAMES << " frames ("
+       << sink->numBadFrames() << " bad); the producer found the ring full " << source->numFramesDropped()
+       << " times\n";
+  if (sink->numFramesReceived() != NUM_FRAMES || sink->numBadFrames() != 0) succeeded = False;
+
+  sink->stopPlaying();
+  Medium::close(sink);
+  Medium::close(source); // also removes the ring file, and its socket
+  *env << (succeeded ? "OK\n" : "FAILED\n");
+
+  return succeeded ? 0 : 1;
+#endif
+}